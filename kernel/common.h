@@ -70,6 +70,27 @@ bool is_qos_id_ok(qos_id_t id);
 /* ALWAYS use this function to get a bad id */
 qos_id_t qos_id_bad(void);
 
+/*
+ * Records of the "stats" binary sysfs file of a normal IPC Process, one per
+ * connection (keyed by source cep-id) and one per N-1 port (keyed by
+ * port-id). Userspace (rinad SysfsHelper) mirrors this layout.
+ */
+enum ipcp_stats_type {
+        IPCP_STATS_CONNECTION = 1,
+        IPCP_STATS_N1_PORT
+};
+
+#define IPCP_STATS_VALUES 7
+
+struct ipcp_stats_record {
+        uint32_t type;
+        int32_t  id;
+        /* Connection: tx_bytes, rx_bytes, tx_pdus, rx_pdus, drop_pdus,
+         * err_pdus. N-1 port: queued_pdus, drop_pdus, err_pdus, tx_pdus,
+         * rx_pdus, tx_bytes, rx_bytes */
+        uint32_t values[IPCP_STATS_VALUES];
+};
+
 struct uint_range {
         uint_t min;
         uint_t max;
@@ -232,6 +232,22 @@ struct dtp_config * dtp_config_get(struct dtp * dtp)
 	return dtp->cfg;
 }
 
+/* Copies all the counters at once, in the order of struct ipcp_stats_record */
+void dtp_stats_get(struct dtp * dtp, uint32_t * values)
+{
+	if (!dtp || !dtp->sv)
+		return;
+
+	spin_lock_bh(&dtp->sv->lock);
+	values[0] = dtp->sv->stats.tx_bytes;
+	values[1] = dtp->sv->stats.rx_bytes;
+	values[2] = dtp->sv->stats.tx_pdus;
+	values[3] = dtp->sv->stats.rx_pdus;
+	values[4] = dtp->sv->stats.drop_pdus;
+	values[5] = dtp->sv->stats.err_pdus;
+	spin_unlock_bh(&dtp->sv->lock);
+}
+
 int nxt_seq_reset(struct dtp_sv * sv, seq_num_t sn)
 {
         if (!sv)
@@ -89,4 +89,5 @@ struct dtp_sv * dtp_dtp_sv(struct dtp * dtp);
 struct connection * dtp_sv_connection(struct dtp_sv * sv);
 int nxt_seq_reset(struct dtp_sv * sv, seq_num_t sn);
 struct dtp_config * dtp_config_get(struct dtp * dtp);
+void dtp_stats_get(struct dtp * dtp, uint32_t * values);
 #endif
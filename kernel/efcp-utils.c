@@ -28,6 +28,8 @@
 #include "utils.h"
 #include "common.h"
 #include "efcp.h"
+#include "dt.h"
+#include "dtp.h"
 
 /*
  * IMAPs
@@ -137,6 +139,34 @@ int efcp_imap_address_change(struct efcp_imap *  map,
 }
 EXPORT_SYMBOL(efcp_imap_address_change);
 
+int efcp_imap_stats(struct efcp_imap *         map,
+                    struct ipcp_stats_record * records,
+                    int                        first,
+                    int                        max)
+{
+        struct efcp_imap_entry * entry;
+        int                      bucket;
+        int                      i;
+
+        ASSERT(map);
+
+        i = 0;
+        hash_for_each(map->table, bucket, entry, hlist) {
+                if (i >= first && i < first + max) {
+                        records[i - first].type = IPCP_STATS_CONNECTION;
+                        records[i - first].id   = entry->key;
+                        memset(records[i - first].values, 0,
+                               sizeof(records[i - first].values));
+                        dtp_stats_get(dt_dtp(efcp_dt(entry->value)),
+                                      records[i - first].values);
+                }
+                i++;
+        }
+
+        return i;
+}
+EXPORT_SYMBOL(efcp_imap_stats);
+
 int efcp_imap_update(struct efcp_imap * map,
                      cep_id_t           key,
                      struct efcp *      value)
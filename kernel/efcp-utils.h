@@ -44,4 +44,11 @@ int                efcp_imap_remove(struct efcp_imap * map,
 
 int		   efcp_imap_address_change(struct efcp_imap *  map,
 					    address_t address);
+
+/* Fills the records of the instances from the first-th on, up to max, and
+ * returns the number of instances */
+int                efcp_imap_stats(struct efcp_imap *         map,
+                                   struct ipcp_stats_record * records,
+                                   int                        first,
+                                   int                        max);
 #endif
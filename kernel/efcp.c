@@ -1030,3 +1030,23 @@ int efcp_address_change(struct efcp_container * efcpc,
 	return 0;
 }
 EXPORT_SYMBOL(efcp_address_change);
+
+int efcp_container_stats(struct efcp_container *    efcpc,
+                         struct ipcp_stats_record * records,
+                         int                        first,
+                         int                        max)
+{
+        int n;
+
+        if (!efcpc) {
+                LOG_ERR("Bogus container passed, bailing out");
+                return 0;
+        }
+
+        spin_lock_bh(&efcpc->lock);
+        n = efcp_imap_stats(efcpc->instances, records, first, max);
+        spin_unlock_bh(&efcpc->lock);
+
+        return n;
+}
+EXPORT_SYMBOL(efcp_container_stats);
@@ -97,4 +97,11 @@ int                     efcp_address_change(struct efcp_container * c,
 
 struct efcp_imap * efcp_container_get_instances(struct efcp_container *efcpc);
 
+/* Fills the statistics records of the connections from the first-th on, up
+ * to max, and returns the number of connections */
+int                     efcp_container_stats(struct efcp_container *    c,
+                                             struct ipcp_stats_record * records,
+                                             int                        first,
+                                             int                        max);
+
 #endif
@@ -137,6 +137,56 @@ RINA_SYSFS_OPS(normal_ipcp);
 RINA_ATTRS(normal_ipcp, name, type, dif, address);
 RINA_KTYPE(normal_ipcp);
 
+/*
+ * All the DTP and RMT counters of the IPC Process in one read: an array of
+ * struct ipcp_stats_record, first the connections and then the N-1 ports.
+ * Reads must be record aligned; records are regenerated on every read, so a
+ * connection or port may be missed or repeated if they change in between.
+ */
+static ssize_t normal_ipcp_stats_read(struct file *          filp,
+                                      struct kobject *       kobj,
+                                      struct bin_attribute * attr,
+                                      char *                 buf,
+                                      loff_t                 off,
+                                      size_t                 count)
+{
+        struct ipcp_instance *     instance;
+        struct ipcp_stats_record * records;
+        int                        first, max, n, filled;
+
+        instance = container_of(kobj, struct ipcp_instance, robj.kobj);
+        if (!instance || !instance->data)
+                return 0;
+
+        if (off % sizeof(*records))
+                return -EINVAL;
+
+        records = (struct ipcp_stats_record *) buf;
+        first   = off / sizeof(*records);
+        max     = count / sizeof(*records);
+        if (!max)
+                return -EINVAL;
+
+        n = efcp_container_stats(instance->data->efcpc, records, first, max);
+        filled = n > first ? min(n - first, max) : 0;
+        first  = n > first ? 0 : first - n;
+
+        if (filled < max) {
+                n = rmt_n1port_stats(instance->data->rmt, records + filled,
+                                     first, max - filled);
+                if (n > first)
+                        filled += min(n - first, max - filled);
+        }
+
+        return filled * sizeof(*records);
+}
+
+static struct bin_attribute normal_ipcp_stats_attr = {
+        .attr = {.name = "stats", .mode = S_IRUGO},
+        .size = 0,
+        .read = normal_ipcp_stats_read,
+};
+
 static struct normal_flow * find_flow(struct ipcp_instance_data * data,
                                       port_id_t                   port_id)
 {
@@ -1312,6 +1362,10 @@ static struct ipcp_instance * normal_create(struct ipcp_factory_data * data,
                 return NULL;
         }
 
+        if (sysfs_create_bin_file(&instance->robj.kobj,
+                                  &normal_ipcp_stats_attr))
+                LOG_WARN("Could not create the statistics sysfs file");
+
         instance->data->timers.use_naddress = rtimer_create(tf_use_naddress,
                                				    instance->data);
         instance->data->timers.kill_oaddress = rtimer_create(tf_kill_oaddress,
@@ -1365,6 +1419,7 @@ static int normal_destroy(struct ipcp_factory_data * data,
                 return -1;
         }
 
+        sysfs_remove_bin_file(&instance->robj.kobj, &normal_ipcp_stats_attr);
         robject_del(&instance->robj);
 
         efcp_container_destroy(tmp->efcpc);
@@ -1187,19 +1187,21 @@ static int notify_ipcp_modify_pffe(void *             data,
         }
 
         ASSERT(op);
+        result = 0;
         list_for_each_entry(entry, &attrs->pff_entries, next) {
                 ASSERT(entry);
 
-                if (op(ipc_process->data, entry)) {
-                        LOG_ERR("There were some problematic entries");
-                        rnl_msg_destroy(msg);
-                        return -1;
-                }
+                /* Keep applying the rest, they do not depend on it */
+                if (op(ipc_process->data, entry))
+                        result = -1;
         }
 
+        if (result)
+                LOG_ERR("There were some problematic entries");
+
         rnl_msg_destroy(msg);
 
-        return 0;
+        return result;
 }
 
 static int ipcp_dump_pff_free_and_reply(struct rnl_msg *   msg,
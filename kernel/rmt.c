@@ -1223,6 +1223,52 @@ int rmt_n1port_unbind(struct rmt *instance,
 }
 EXPORT_SYMBOL(rmt_n1port_unbind);
 
+int rmt_n1port_stats(struct rmt *instance,
+		     struct ipcp_stats_record *records,
+		     int first,
+		     int max)
+{
+	struct rmt_n1_port *n1_port;
+	struct ipcp_stats_record *record;
+	struct n1pmap *m;
+	int bucket;
+	int i;
+
+	if (!instance || !instance->n1_ports) {
+		LOG_ERR("Bogus instance passed");
+		return 0;
+	}
+
+	m = instance->n1_ports;
+	i = 0;
+	spin_lock_bh(&m->lock);
+	hash_for_each(m->n1_ports, bucket, n1_port, hlist) {
+		spin_lock(&n1_port->lock);
+		if (n1_port->state == N1_PORT_STATE_DEALLOCATED) {
+			spin_unlock(&n1_port->lock);
+			continue;
+		}
+		if (i >= first && i < first + max) {
+			record = &records[i - first];
+			record->type = IPCP_STATS_N1_PORT;
+			record->id = n1_port->port_id;
+			record->values[0] = n1_port->stats.plen;
+			record->values[1] = n1_port->stats.drop_pdus;
+			record->values[2] = n1_port->stats.err_pdus;
+			record->values[3] = n1_port->stats.tx_pdus;
+			record->values[4] = n1_port->stats.rx_pdus;
+			record->values[5] = n1_port->stats.tx_bytes;
+			record->values[6] = n1_port->stats.rx_bytes;
+		}
+		spin_unlock(&n1_port->lock);
+		i++;
+	}
+	spin_unlock_bh(&m->lock);
+
+	return i;
+}
+EXPORT_SYMBOL(rmt_n1port_stats);
+
 static inline int process_mgmt_pdu(struct rmt *rmt,
 				   port_id_t port_id,
 				   struct pdu *pdu)
@@ -103,6 +103,12 @@ int		   rmt_n1port_bind(struct rmt *instance,
 				   struct ipcp_instance *n1_ipcp);
 int		   rmt_n1port_unbind(struct rmt *instance,
 				     port_id_t id);
+/* Fills the statistics records of the N-1 ports from the first-th on, up to
+ * max, and returns the number of N-1 ports */
+int		   rmt_n1port_stats(struct rmt *instance,
+				    struct ipcp_stats_record *records,
+				    int first,
+				    int max);
 int		   rmt_pff_add(struct rmt *instance,
 			       struct mod_pff_entry *entry);
 int		   rmt_pff_remove(struct rmt *instance,
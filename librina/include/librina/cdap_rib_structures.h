@@ -104,7 +104,13 @@ typedef struct flags {
 	enum Flags {
 		NONE_FLAGS,
 		F_SYNC,
-		F_RD_INCOMPLETE
+		F_RD_INCOMPLETE,
+		/// On a scoped M_READ, the requester accepts replies
+		/// carrying several objects; on an M_READ_R, the reply
+		/// carries several objects. Unlike the others, it is a
+		/// bit that may be combined with them, and GPB carries it
+		/// in a field of its own.
+		F_RD_BATCH = 4
 	};
 	/// flags (enm, int32), conditional, may be required by CDAP.
 	/// set_ of Boolean values that modify the meaning of a
@@ -457,6 +457,11 @@ class CDAPSessionManagerInterface
 				       ser_obj_t& result) = 0;
 	virtual void decodeCDAPMessage(const ser_obj_t &cdap_message,
 			               cdap_m_t& result) = 0;
+	/// As decodeCDAPMessage, but the object value of result is lent
+	/// from cdap_message through value instead of copied
+	virtual void decodeCDAPMessage(const ser_obj_t &cdap_message,
+			               cdap_m_t& result,
+			               SerObjLoan& value) = 0;
 	virtual void removeCDAPSession(int portId) = 0;
 	virtual bool session_in_await_con_state(int portId) = 0;
 	virtual void encodeNextMessageToBeSent(const cdap_m_t &cdap_message,
@@ -465,6 +470,12 @@ class CDAPSessionManagerInterface
 	virtual void messageReceived(const ser_obj_t &encodedcdap_m_t,
 				     cdap_m_t& result,
 				     int portId) = 0;
+	/// As messageReceived, but the object value of result is lent
+	/// from encodedcdap_m_t through value instead of copied
+	virtual void messageReceived(const ser_obj_t &encodedcdap_m_t,
+				     cdap_m_t& result,
+				     SerObjLoan& value,
+				     int portId) = 0;
 	virtual void messageSent(const cdap_m_t &cdap_message,
 				 int port_id) = 0;
 	virtual int get_port_id(std::string destination_application_process_name) = 0;
@@ -739,12 +750,31 @@ public:
 	/// @throws CDAPException
 	virtual void deserializeMessage(const ser_obj_t &message,
 					cdap_m_t& result) = 0;
+	/// Convert from wire format to CDAPMessage, lending the object
+	/// value from message through value instead of copying it
+	/// @param message
+	/// @param result
+	/// @param value a loan to result.obj_value_
+	/// @throws CDAPException
+	virtual void deserializeMessage(const ser_obj_t &message,
+					cdap_m_t& result,
+					SerObjLoan& value) = 0;
 	/// Convert from CDAP messages to wire format
 	/// @param cdapMessage
 	/// @return
 	/// @throws CDAPException
 	virtual void serializeMessage(const cdap_m_t &cdapMessage,
 				      ser_obj_t& result) = 0;
+	/// Convert from CDAP messages to wire format, into a buffer
+	/// supplied by the caller
+	/// @param cdapMessage
+	/// @param buffer
+	/// @param size the size of buffer
+	/// @return the size of the encoded message; if it is larger than
+	/// size, nothing has been written to buffer
+	/// @throws CDAPException
+	virtual int serializeMessage(const cdap_m_t &cdapMessage,
+				     unsigned char * buffer, int size) = 0;
 };
 
 ///
@@ -792,7 +822,15 @@ public:
 	CDAPMessageEncoder(cdap_rib::concrete_syntax_t& syntax);
 	~CDAPMessageEncoder();
 	void encode(const cdap_m_t &obj, ser_obj_t& serobj);
+	/// Encodes obj into buffer, without allocating memory
+	/// @return the size of the encoded message; if it is larger than
+	/// size, nothing has been written to buffer
+	int encode(const cdap_m_t &obj, unsigned char * buffer, int size);
 	void decode(const ser_obj_t &serobj, cdap_m_t &des_obj);
+	/// Decodes serobj without copying the object value, which is lent
+	/// from serobj to des_obj through value
+	void decode(const ser_obj_t &serobj, cdap_m_t &des_obj,
+		    SerObjLoan& value);
 
 private:
 	SerializerInterface * serializer;
@@ -616,6 +616,15 @@ public:
 	 * time specified
 	 */
 	IPCEvent * eventTimedWait(int seconds, int nanoseconds);
+
+	/**
+	 * Retrieves up to max available events, blocking no more than
+	 * the time specified if there is none. Events are appended to
+	 * events; returns how many were retrieved.
+	 */
+	unsigned int eventTimedWaitBatch(std::vector<IPCEvent *>& events,
+					 unsigned int max,
+					 int seconds, int nanoseconds);
 };
 
 /**
@@ -668,6 +677,50 @@ typedef struct ser_obj {
 	}
 } ser_obj_t;
 
+/**
+ * Lends the buffer of a ser_obj_t to another one until it goes out of
+ * scope, instead of copying it. The lender must outlive the loan.
+ */
+class SerObjLoan {
+public:
+	/// An empty loan, for a buffer lent later with lend(). The borrower
+	/// must not own a buffer.
+	SerObjLoan(ser_obj_t& borrower) : borrower_(borrower)
+	{
+		borrower_.size_ = 0;
+		borrower_.message_ = 0;
+	}
+
+	SerObjLoan(ser_obj_t& borrower, const ser_obj_t& lender)
+		: borrower_(borrower)
+	{
+		borrower_.size_ = lender.size_;
+		borrower_.message_ = lender.message_;
+	}
+
+	SerObjLoan(ser_obj_t& borrower, const unsigned char * message,
+		   int size) : borrower_(borrower)
+	{
+		borrower_.size_ = size;
+		borrower_.message_ = const_cast<unsigned char *>(message);
+	}
+
+	~SerObjLoan()
+	{
+		borrower_.size_ = 0;
+		borrower_.message_ = 0;
+	}
+
+	void lend(const unsigned char * message, int size)
+	{
+		borrower_.size_ = size;
+		borrower_.message_ = const_cast<unsigned char *>(message);
+	}
+
+private:
+	ser_obj_t& borrower_;
+};
+
 struct UcharArray {
 	UcharArray();
 	UcharArray(int arrayLength);
@@ -804,6 +857,41 @@ struct irati_iodev_ctldata {
 };
 #define IRATI_FLOW_BIND _IOW(0xAF, 0x00, struct irati_iodev_ctldata)
 
+/**
+ * Counters of the Netlink messages received by this librina instance
+ */
+class NetlinkStatistics {
+public:
+	NetlinkStatistics();
+	std::string toString() const;
+
+	/** Netlink messages parsed successfully */
+	unsigned long long messages;
+
+	/** Bytes received */
+	unsigned long long bytes;
+
+	/** Datagrams received */
+	unsigned long long datagrams;
+
+	/** Receive system calls that returned at least one datagram */
+	unsigned long long batches;
+
+	/** Messages that could not be parsed, or truncated datagrams */
+	unsigned long long errors;
+
+	/** Total time spent parsing messages, in nanoseconds */
+	unsigned long long parse_time_ns;
+
+	/** Seconds since the counters started */
+	double elapsed;
+};
+
+/**
+ * Returns the Netlink receive counters of this librina instance
+ */
+NetlinkStatistics getNetlinkStatistics();
+
 /**
  * Initialize librina providing the local Netlink port-id where this librina
  * instantiation will be bound
@@ -26,9 +26,11 @@
 #ifdef __cplusplus
 
 #include <pthread.h>
+#include <sched.h>
 
 #include <list>
 #include <map>
+#include <vector>
 #include <string>
 #include <stdexcept>
 
@@ -388,6 +390,224 @@ private:
         std::list<T*> queue;
 };
 
+/**
+ * A bounded, lock-free FIFO queue of pointers that supports many
+ * concurrent producers and a single consumer (callers must serialize
+ * poll/takeBatch among themselves). Producers never block on a mutex;
+ * put() yields the CPU while the queue is full.
+ */
+template <class T> class LockFreeMPSCQueue : public NonCopyable {
+public:
+        LockFreeMPSCQueue(unsigned int capacity = 4096) {
+                size_ = 2;
+                while (size_ < capacity) {
+                        size_ <<= 1;
+                }
+                mask_ = size_ - 1;
+                cells_ = new Cell[size_];
+                for (unsigned long i = 0; i < size_; i++) {
+                        cells_[i].sequence = i;
+                        cells_[i].data = 0;
+                }
+                enqueue_pos_ = 0;
+                dequeue_pos_ = 0;
+        };
+
+        ~LockFreeMPSCQueue() throw() {
+                delete[] cells_;
+        };
+
+        /** Insert an element at the end of the queue, false if full */
+        bool try_put(T * element) {
+                Cell * cell;
+                unsigned long seq;
+                unsigned long pos;
+                long diff;
+
+                pos = __atomic_load_n(&enqueue_pos_, __ATOMIC_RELAXED);
+                for (;;) {
+                        cell = &cells_[pos & mask_];
+                        seq = __atomic_load_n(&cell->sequence,
+                                              __ATOMIC_ACQUIRE);
+                        diff = (long) seq - (long) pos;
+                        if (diff == 0) {
+                                if (__atomic_compare_exchange_n(&enqueue_pos_,
+                                                                &pos, pos + 1,
+                                                                true,
+                                                                __ATOMIC_RELAXED,
+                                                                __ATOMIC_RELAXED))
+                                        break;
+                        } else if (diff < 0) {
+                                return false;
+                        } else {
+                                pos = __atomic_load_n(&enqueue_pos_,
+                                                      __ATOMIC_RELAXED);
+                        }
+                }
+
+                cell->data = element;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+                return true;
+        }
+
+        /** Insert an element at the end of the queue, waiting for
+         *  the consumer to make room if the queue is full */
+        void put(T * element) {
+                while (!try_put(element)) {
+                        sched_yield();
+                }
+        }
+
+        /**
+         * Get the element at the begining of the queue. If the queue is
+         * empty it will return a NULL pointer.
+         */
+        T * poll() {
+                Cell * cell = &cells_[dequeue_pos_ & mask_];
+                unsigned long seq;
+                T * result;
+
+                seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+                if ((long) (seq - (dequeue_pos_ + 1)) < 0) {
+                        return 0;
+                }
+
+                result = cell->data;
+                __atomic_store_n(&cell->sequence, dequeue_pos_ + size_,
+                                 __ATOMIC_RELEASE);
+                __atomic_store_n(&dequeue_pos_, dequeue_pos_ + 1,
+                                 __ATOMIC_RELAXED);
+
+                return result;
+        }
+
+        /**
+         * Append up to max elements to result, in FIFO order.
+         * @return the number of elements taken
+         */
+        unsigned int takeBatch(std::vector<T*> & result, unsigned int max) {
+                unsigned int count = 0;
+                T * element;
+
+                while (count < max && (element = poll()) != 0) {
+                        result.push_back(element);
+                        count++;
+                }
+
+                return count;
+        }
+
+        /** Only meaningful when called by the consumer */
+        bool empty() const {
+                const Cell * cell = &cells_[dequeue_pos_ & mask_];
+
+                return (long) (__atomic_load_n(&cell->sequence,
+                                               __ATOMIC_ACQUIRE) -
+                               (dequeue_pos_ + 1)) < 0;
+        }
+
+        /** Approximate number of queued elements */
+        unsigned long size() const {
+                return __atomic_load_n(&enqueue_pos_, __ATOMIC_RELAXED) -
+                        __atomic_load_n(&dequeue_pos_, __ATOMIC_RELAXED);
+        }
+
+        unsigned long capacity() const {
+                return size_;
+        }
+
+private:
+        struct Cell {
+                unsigned long sequence;
+                T * data;
+        };
+
+        Cell * cells_;
+        unsigned long size_;
+        unsigned long mask_;
+        // Keep producer and consumer positions on different cache lines
+        char pad0_[64];
+        unsigned long enqueue_pos_;
+        char pad1_[64];
+        unsigned long dequeue_pos_;
+        char pad2_[64];
+};
+
+/**
+ * Epoch based reclamation, for data read without locks. Readers bracket
+ * their accesses with readLock()/readUnlock() (or an EpochScopedRead),
+ * which never block and can be nested. Writers unlink an object so that
+ * new readers cannot reach it, then retire() it; it is destroyed once
+ * all the readers that could have reached it have left.
+ */
+class EpochReclaimer : public NonCopyable {
+public:
+        EpochReclaimer();
+
+        /** Destroys all retired objects; there must be no readers */
+        ~EpochReclaimer() throw();
+
+        void readLock();
+        void readUnlock();
+
+        /**
+         * Destroy object with destroy(object) once it is safe. Objects
+         * are destroyed in the order they are retired.
+         */
+        void retire(void (*destroy)(void *), void * object);
+
+        /** Destroy the retired objects no reader can reach anymore */
+        void reclaim();
+
+        template <class T> static void destroy(void * object) {
+                delete static_cast<T *>(object);
+        };
+
+private:
+        struct Slot {
+                // Epoch in which the thread entered, 0 if outside
+                unsigned long epoch;
+                unsigned int nesting;
+                bool in_use;
+                Slot * next;
+        };
+
+        struct Retired {
+                void (*destroy)(void *);
+                void * object;
+                unsigned long epoch;
+        };
+
+        Slot * getSlot();
+        static void releaseSlot(void * slot);
+        void reclaimLocked();
+
+        unsigned long epoch_;
+        pthread_key_t key_;
+        // Slots are only added, and reused when their thread exits
+        Slot * slots_;
+        Lockable lock_;
+        std::list<Retired> retired_;
+};
+
+/**
+* Epoch read section (RAII)
+*/
+class EpochScopedRead {
+public:
+        EpochScopedRead(EpochReclaimer & reclaimer) :
+                reclaimer_(reclaimer)
+        { reclaimer_.readLock(); }
+
+        ~EpochScopedRead() throw() {
+                reclaimer_.readUnlock();
+        }
+
+private:
+        EpochReclaimer & reclaimer_;
+};
+
 /// Wrapper to sleep a thread
 class Sleep{
 public:
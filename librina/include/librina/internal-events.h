@@ -24,6 +24,8 @@
 
 #ifdef __cplusplus
 
+#include <vector>
+
 #include "librina/application.h"
 
 namespace rina {
@@ -31,23 +33,30 @@ namespace rina {
 /// Interface, an internal event
 class InternalEvent {
 public:
-	InternalEvent(const std::string& event_type) : type (event_type) {};
+	/// Event types, also the indexes of the listener table of the
+	/// event manager
+	enum EventType {
+		APP_CONNECTIVITY_TO_NEIGHBOR_LOST = 0,
+		APP_N_MINUS_1_FLOW_ALLOCATED,
+		APP_N_MINUS_1_FLOW_ALLOCATION_FAILED,
+		APP_N_MINUS_1_FLOW_DEALLOCATED,
+		APP_NEIGHBOR_DECLARED_DEAD,
+		APP_NEIGHBOR_ADDED,
+		ADDRESS_CHANGE,
+		NEIGHBOR_ADDRESS_CHANGE,
+		IPCP_INTERNAL_FLOW_ALLOCATED,
+		IPCP_INTERNAL_FLOW_ALLOCATION_FAILED,
+		IPCP_INTERNAL_FLOW_DEALLOCATED,
+		NUM_EVENT_TYPES
+	};
+
+	InternalEvent(EventType event_type) : type (event_type) {};
 	virtual ~InternalEvent(){};
 
-	/// Event types
-	static const std::string APP_CONNECTIVITY_TO_NEIGHBOR_LOST;
-	static const std::string APP_N_MINUS_1_FLOW_ALLOCATED;
-	static const std::string APP_N_MINUS_1_FLOW_ALLOCATION_FAILED;
-	static const std::string APP_N_MINUS_1_FLOW_DEALLOCATED;
-	static const std::string APP_NEIGHBOR_DECLARED_DEAD;
-	static const std::string APP_NEIGHBOR_ADDED;
-	static const std::string ADDRESS_CHANGE;
-	static const std::string NEIGHBOR_ADDRESS_CHANGE;
-	static const std::string IPCP_INTERNAL_FLOW_ALLOCATED;
-	static const std::string IPCP_INTERNAL_FLOW_ALLOCATION_FAILED;
-	static const std::string IPCP_INTERNAL_FLOW_DEALLOCATED;
-
-	std::string type;
+	/// The name of an event type, for logs
+	static const char * type_name(EventType type);
+
+	EventType type;
 };
 
 /// Interface. It is subscribed to events of certain type
@@ -70,13 +79,13 @@ public:
 	/// Subscribe to a single event
 	/// @param eventId The id of the event
 	/// @param eventListener The event listener
-	virtual void subscribeToEvent(const std::string& type, 
+	virtual void subscribeToEvent(InternalEvent::EventType type,
 				      InternalEventListener * eventListener) = 0;
 
 	/// Unubscribe from a single event
 	/// @param eventId The id of the event
 	/// @param eventListener The event listener
-	virtual void unsubscribeFromEvent(const std::string& type, 
+	virtual void unsubscribeFromEvent(InternalEvent::EventType type,
 					  InternalEventListener * eventListener) = 0;
 
 	/// Invoked when a certain event has happened.
@@ -88,19 +97,48 @@ public:
 	virtual void deliverEvent(InternalEvent * event) = 0;
 };
 
+/// Listeners are kept in a table indexed by event type. Each entry is a
+/// list that is copied on every (un)subscription and replaced, so events
+/// are delivered without taking any lock, and listeners can (un)subscribe
+/// while an event is delivered. A listener that unsubscribes may still get
+/// the events that were being delivered at that time.
 class SimpleInternalEventManager: public InternalEventManager {
 public:
-	SimpleInternalEventManager() { };
-		void set_application_process(ApplicationProcess * ap);
-        void subscribeToEvent(const std::string& type,
-        		      InternalEventListener * eventListener);
-        void unsubscribeFromEvent(const std::string& type,
-        			  InternalEventListener * eventListener);
-        void deliverEvent(InternalEvent * event);
+	/// @param async If true, events are delivered by a thread of the
+	/// manager instead of the one calling deliverEvent, so that slow
+	/// listeners do not stall it. Events are delivered in order.
+	SimpleInternalEventManager(bool async = false);
+	~SimpleInternalEventManager() throw();
+	void set_application_process(ApplicationProcess * ap);
+	void subscribeToEvent(InternalEvent::EventType type,
+			      InternalEventListener * eventListener);
+	void unsubscribeFromEvent(InternalEvent::EventType type,
+				  InternalEventListener * eventListener);
+	void deliverEvent(InternalEvent * event);
 
 private:
-        std::map<std::string, std::list<InternalEventListener *> > event_listeners_;
-        rina::Lockable events_lock_;
+	typedef std::vector<InternalEventListener *> ListenerList;
+
+	class Dispatcher : public SimpleThread {
+	public:
+		Dispatcher(ThreadAttributes * threadAttributes,
+			   SimpleInternalEventManager * manager);
+		~Dispatcher() throw() {};
+		int run();
+
+	private:
+		SimpleInternalEventManager * manager_;
+	};
+
+	void dispatch(InternalEvent * event);
+
+	ListenerList * event_listeners_[InternalEvent::NUM_EVENT_TYPES];
+	EpochReclaimer epochs_;
+	/// Serializes the writers of the listener table
+	rina::Lockable events_lock_;
+	/// A NULL event stops the dispatcher
+	BlockingFIFOQueue<InternalEvent> events_;
+	Dispatcher * dispatcher_;
 };
 
 /// Event that signals that an N-1 flow allocation failed
@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "librina/likely.h"
 
 #ifndef RINA_PREFIX
 #error You must define RINA_PREFIX before including this file
@@ -91,6 +92,23 @@ int setLogFile(const char* pathToFile);
  */
 void logFunc(enum LOG_LEVEL level, const char * fmt, ...);
 
+/**
+ * Enable or disable the asynchronous log backend. When enabled, log
+ * statements are formatted into per-thread buffers that a writer
+ * thread drains to the output stream periodically, with one flush per
+ * round instead of one per line.
+ *
+ * @param enable non-zero to enable it, 0 to flush and disable it
+ * @returns 0 if successful, -1 if the writer thread cannot be started
+ */
+int setLogAsync(int enable);
+
+/**
+ * Write out all the log statements buffered by the asynchronous
+ * backend (no-op if it is disabled)
+ */
+void flushLogs(void);
+
 //Extern C
 #ifdef __cplusplus
 }
@@ -99,9 +117,23 @@ void logFunc(enum LOG_LEVEL level, const char * fmt, ...);
 
 #define __STRINGIZE(x) #x
 
+/*
+ * The level is checked before evaluating any argument, so disabled log
+ * statements cost a single predictable branch. This is a function rather
+ * than a plain comparison so that a local variable named logLevel at the
+ * call site cannot shadow the global one.
+ */
+static inline int __logEnabled(enum LOG_LEVEL level)
+{
+        return level <= logLevel;
+}
+
+#define __LOG_ENABLED(LEVEL) unlikely(__logEnabled(LEVEL))
+
 #define __LOG(PREFIX, LEVEL, FMT, ARGS...)                                    \
         do {                                                                  \
-		logFunc(LEVEL,                                                    \
+		if (__LOG_ENABLED(LEVEL))                                         \
+			logFunc(LEVEL,                                            \
                     "%d(%ld)#" PREFIX " (" __STRINGIZE(LEVEL) "): " FMT "\n", \
                     getpid(), time(0), ##ARGS);                               \
 	} while (0)
@@ -117,7 +149,8 @@ void logFunc(enum LOG_LEVEL level, const char * fmt, ...);
 
 #define __LOGF(PREFIX, LEVEL, FMT, ARGS...)                                       \
         do {                                                                      \
-		logFunc(LEVEL,                                                        \
+		if (__LOG_ENABLED(LEVEL))                                             \
+			logFunc(LEVEL,                                                \
                     "%d(%ld)#" PREFIX " (" __STRINGIZE(LEVEL) ")[%s]: " FMT "\n", \
                     getpid(), time(0), __func__, ##ARGS);                         \
 	} while (0)
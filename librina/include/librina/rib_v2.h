@@ -809,6 +809,67 @@ public:
 
         int set_security_manager(ApplicationEntity * sec_man);
 
+        ///
+        /// Answer scoped reads in batches
+        ///
+        /// When a scoped M_READ carries the F_RD_BATCH flag, the RIB packs
+        /// the objects read into replies of up to max_size bytes instead of
+        /// sending one reply per object, and marks those replies with
+        /// F_RD_BATCH too. The RIB daemon of the requester unpacks them,
+        /// so its response handler still gets one
+        /// remoteReadResult() per object.
+        ///
+        /// @param handle The handle of the RIB
+        /// @param max_size Maximum size of a reply, usually the maximum SDU
+        /// size of the flows the RIB is reached through; 0 (the default)
+        /// disables batching
+        ///
+        /// @throws eRIBNotFound
+        ///
+        void setReadBatchSize(const rib_handle_t& handle,
+                              unsigned int max_size);
+
+        ///
+        /// Make a RIB read-mostly
+        ///
+        /// The objects of a read-mostly RIB are looked up and read without
+        /// taking any lock. Writers copy the (shared) object table, modify
+        /// the copy and publish it at once, so readers see either all the
+        /// changes of an update or none of them. The objects removed are
+        /// deleted once no reader can reach them, which may be after
+        /// removeObjRIB() returns. Their read() callbacks may run
+        /// concurrently with any other callback of the same object.
+        ///
+        /// Suits RIBs that are read much more often than they change;
+        /// prefer updateObjsRIB() to change many objects at once. A RIB
+        /// cannot go back to being locked.
+        ///
+        /// @param handle The handle of the RIB
+        ///
+        /// @throws eRIBNotFound
+        ///
+        void setReadMostly(const rib_handle_t& handle);
+
+        ///
+        /// Remove and add several objects in a single update
+        ///
+        /// Readers of a read-mostly RIB see all the changes at once.
+        /// Objects that do not exist or have children are not removed,
+        /// and objects that cannot be added (invalid names, missing
+        /// parents or existing objects) are skipped, leaving their pointers
+        /// untouched; the pointers of the objects added are set to NULL.
+        ///
+        /// @param handle The handle of the RIB
+        /// @param to_remove Fully qualified names of the objects to remove
+        /// @param to_add Fully qualified names and objects to add, after
+        /// removing the ones in to_remove
+        ///
+        /// @throws eRIBNotFound
+        ///
+        void updateObjsRIB(const rib_handle_t& handle,
+                           const std::list<std::string>& to_remove,
+                           std::list<std::pair<std::string, RIBObj*> >& to_add);
+
 
         //-------------------------------------------------------------------//
         //                         RIB Client                                //
@@ -24,7 +24,8 @@
 
 #ifdef __cplusplus
 
-#include <map>
+#include <deque>
+#include <vector>
 #include <sys/time.h>
 
 #include "librina/concurrency.h"
@@ -52,32 +53,128 @@ public:
 	timeval time_;
 };
 
-class TaskScheduler : public Lockable {
+struct TimerEntry;
+
+/// Reference to a scheduled task, cancels it without any lookup.
+/// Stale handles (task already run or cancelled) are harmless.
+class TimerHandle {
+public:
+	TimerHandle() : entry(0), generation(0) {};
+	bool is_valid() const { return entry != 0; };
+private:
+	friend class TaskScheduler;
+	TimerEntry * entry;
+	unsigned int generation;
+};
+
+/// Scheduled tasks, found by task pointer through an open addressing
+/// (linear probing) hash table
+class TimerTaskIndex {
+public:
+	TimerTaskIndex();
+	TimerEntry * find(TimerTask * task) const;
+	void insert(TimerTask * task, TimerEntry * entry);
+	void erase(TimerTask * task);
+
+	struct Bucket {
+		//NULL if empty
+		TimerTask * task;
+		TimerEntry * entry;
+	};
+
+	std::vector<Bucket> buckets;
+	size_t count;
+
+private:
+	static size_t hash(const TimerTask * task);
+};
+
+/// Hierarchical timing wheel with 1 ms resolution. A dispatcher
+/// thread sleeps until the next deadline and hands expired tasks to
+/// a pool of worker threads. The pool keeps up to core_workers threads;
+/// when a task expires and all of them are busy (e.g. a task sleeping or
+/// waiting for a lock) another one is started, up to MAX_WORKERS, and
+/// the extra ones exit after WORKER_IDLE_MS without work. Tasks may
+/// destroy the Timer that runs them.
+class TaskScheduler : public ConditionVariable {
 public:
-	TaskScheduler();
+	static const unsigned int ROOT_BITS = 8;
+	static const unsigned int LEVEL_BITS = 6;
+	static const unsigned int LEVELS = 4;
+	static const unsigned int ROOT_SIZE = 1 << ROOT_BITS;
+	static const unsigned int LEVEL_SIZE = 1 << LEVEL_BITS;
+	static const unsigned int MAX_WORKERS = 64;
+	static const unsigned int WORKER_IDLE_MS = 10000;
+
+	TaskScheduler(unsigned int core_workers);
 	~TaskScheduler() throw();
-	void insert(Time time, TimerTask* timer_task);
-	void runTasks();
+	TimerHandle insert(TimerTask* timer_task, long delay_ms);
 	void cancelTask(TimerTask *task);
+	void cancelTask(const TimerHandle& handle);
+	unsigned int pending();
+
+	/// Stop the dispatcher and workers. Returns false if the caller
+	/// is one of the workers; that worker will then delete the
+	/// scheduler once the task it is running returns.
+	bool stop();
+
+	/// Monotonic clock in milliseconds
+	static unsigned long now_ms();
+
+	void dispatcher_loop();
+	void worker_loop();
+
 private:
-	std::map<Time, std::list<TimerTask*>* > tasks_;
+	TimerEntry * alloc_entry();
+	void free_entry(TimerEntry * entry);
+	void add_entry(TimerEntry * entry);
+	void remove_entry(TimerEntry * entry);
+	unsigned int cascade(unsigned int level, unsigned int index);
+	void expire(unsigned long now);
+	unsigned long next_expiry();
+	void dispatch();
+	void join_exited();
+	void retire_worker();
+
+	TimerEntry * root_;
+	TimerEntry * levels_[LEVELS];
+	TimerEntry * free_entries_;
+	TimerTaskIndex index_;
+	unsigned long base_;
+	unsigned long next_wake_;
+	unsigned int pending_;
+	unsigned int root_pending_;
+	std::vector<TimerTask*> expired_;
+	bool stopping_;
+	Thread * dispatcher_;
+
+	ConditionVariable ready_cond_;
+	std::deque<TimerTask*> ready_;
+	std::vector<Thread*> workers_;
+	/// Extra workers that exited for being idle, to be joined
+	std::vector<Thread*> exited_;
+	unsigned int core_workers_;
+	unsigned int idle_workers_;
+	pthread_t orphan_;
+	bool has_orphan_;
 };
 
-/// Class that implements a timer which contains a thread
+/// Class that implements a timer, backed by a timing wheel and a
+/// pool of worker threads that run the expired tasks
 class Timer {
 public:
+	/// Workers kept when idle
+	static const unsigned int DEFAULT_WORKERS = 4;
+
 	Timer();
+	Timer(unsigned int core_workers);
 	~Timer();
-	void scheduleTask(TimerTask* task, long delay_ms);
+	TimerHandle scheduleTask(TimerTask* task, long delay_ms);
 	void cancelTask(TimerTask *task);
+	void cancelTask(const TimerHandle& handle);
 	TaskScheduler* get_task_scheduler() const;
-	bool execute_tasks();
 private:
-	void cancel();
-	Thread *thread_;
 	TaskScheduler *task_scheduler;
-	bool continue_;
-	Lockable continue_lock_;
 };
 
 }
@@ -21,6 +21,11 @@
  */
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <set>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #define RINA_PREFIX "cdap"
 
@@ -299,8 +304,43 @@ class ConnectionStateMachine
 	TimerTask * last_timer_task;
 };
 
+/// Set of the invoke ids in use, safe for concurrent use without locks.
+/// Ids below SIZE are bits of a three level bitmap, where each bit of a
+/// level flags a full word of the level below; allocating the lowest
+/// free id, reserving and releasing are O(1). Ids out of the bitmap,
+/// which only the peer can pick, are kept in a locked set.
+class InvokeIdSet
+{
+ public:
+	static const int SIZE = 1 << 18;
+
+	InvokeIdSet();
+	/// Returns the lowest id not in use (> 0) and marks it as used
+	int allocate();
+	/// Marks the id as used, it may already be
+	void reserve(int id);
+	/// Marks the id as free, it may already be
+	void release(int id);
+ private:
+	static const int LEVELS = 3;
+
+	bool set_bit(int id);
+	void mark_full(int level, unsigned int index);
+	void clear_upwards(int level, unsigned int index);
+	int overflow_allocate();
+
+	uint64_t leaves_[SIZE / 64];
+	uint64_t middle_[SIZE / (64 * 64)];
+	uint64_t top_;
+	uint64_t * levels_[LEVELS];
+
+	rina::Lockable overflow_lock_;
+	std::set<int> overflow_;
+	int overflow_size_;
+};
+
 /// It will always try to use short invokeIds (as close to 1 as possible)
-class CDAPInvokeIdManagerImpl : public CDAPInvokeIdManager, rina::Lockable
+class CDAPInvokeIdManagerImpl : public CDAPInvokeIdManager
 {
  public:
 	CDAPInvokeIdManagerImpl();
@@ -309,8 +349,8 @@ class CDAPInvokeIdManagerImpl : public CDAPInvokeIdManager, rina::Lockable
 	int newInvokeId(bool sent);
 	void reserveInvokeId(int invoke_id, bool sent);
  private:
-	std::list<int> used_invoke_sent_ids_;
-	std::list<int> used_invoke_recv_ids_;
+	InvokeIdSet used_invoke_sent_ids_;
+	InvokeIdSet used_invoke_recv_ids_;
 };
 
 /// Encapsulates an operation state
@@ -479,6 +519,9 @@ class CDAPSessionManager : public CDAPSessionManagerInterface
 			       ser_obj_t& result);
 	void decodeCDAPMessage(const ser_obj_t &cdap_message,
 			       cdap_m_t& result);
+	void decodeCDAPMessage(const ser_obj_t &cdap_message,
+			       cdap_m_t& result,
+			       SerObjLoan& value);
 	void removeCDAPSession(int portId);
 	bool session_in_await_con_state(int portId);
 	void encodeNextMessageToBeSent(const cdap_m_t &cdap_message,
@@ -487,6 +530,10 @@ class CDAPSessionManager : public CDAPSessionManagerInterface
 	void messageReceived(const ser_obj_t &encodedcdap_m_t,
 			     cdap_m_t& result,
 			     int portId);
+	void messageReceived(const ser_obj_t &encodedcdap_m_t,
+			     cdap_m_t& result,
+			     SerObjLoan& value,
+			     int portId);
 	void messageSent(const cdap_m_t &cdap_message,
 			 int port_id);
 	int get_port_id(std::string destination_application_process_name);
@@ -585,6 +632,7 @@ class CDAPSessionManager : public CDAPSessionManagerInterface
 	CDAPInvokeIdManagerImpl *invoke_id_manager_;
 	CDAPSession* internal_get_cdap_session(int port_id);
 	CDAPSession* internal_createCDAPSession(int port_id);
+	void internal_messageReceived(cdap_m_t& result, int port_id);
 	Timer timer;
 };
 
@@ -621,8 +669,22 @@ class GPBSerializer : public SerializerInterface
  public:
 	void deserializeMessage(const ser_obj_t &message,
 				cdap_m_t& result);
+	void deserializeMessage(const ser_obj_t &message,
+				cdap_m_t& result,
+				SerObjLoan& value);
 	void serializeMessage(const cdap_m_t &cdapMessage,
 			      ser_obj_t& result);
+	int serializeMessage(const cdap_m_t &cdapMessage,
+			     unsigned char * buffer, int size);
+
+ private:
+	void read(const messages::CDAPMessage& gpfCDAPMessage,
+		  cdap_m_t& result);
+	int prepare(const cdap_m_t &cdapMessage,
+		    messages::CDAPMessage& gpfCDAPMessage);
+	void write(const cdap_m_t &cdapMessage,
+		   const messages::CDAPMessage& gpfCDAPMessage,
+		   unsigned char * buffer);
 };
 
 // CLASS CDAPMessageFactory
@@ -903,49 +965,185 @@ void CDAPMessageFactory::getCancelReadResponseMessage(cdap_m_t & msg,
 	msg.result_reason_ = res.reason_;
 }
 
+// CLASS InvokeIdSet
+#define INVOKE_ID_WORD_FULL (~(uint64_t) 0)
+
+InvokeIdSet::InvokeIdSet()
+{
+	memset(leaves_, 0, sizeof(leaves_));
+	memset(middle_, 0, sizeof(middle_));
+	top_ = 0;
+	levels_[0] = leaves_;
+	levels_[1] = middle_;
+	levels_[2] = &top_;
+	overflow_size_ = 0;
+
+	// 0 means no invoke id
+	leaves_[0] = 1;
+}
+
+/// Sets the bit of index in the level above while the word at index is
+/// full, and so on up. The word is checked again after publishing the
+/// bit, so a release racing with this either sees the bit or is seen.
+void InvokeIdSet::mark_full(int level, unsigned int index)
+{
+	for (; level < LEVELS - 1; level++, index /= 64) {
+		uint64_t * parent = &levels_[level + 1][index / 64];
+		uint64_t bit = (uint64_t) 1 << (index % 64);
+		uint64_t old = __atomic_fetch_or(parent, bit, __ATOMIC_SEQ_CST);
+
+		if (__atomic_load_n(&levels_[level][index], __ATOMIC_SEQ_CST)
+				!= INVOKE_ID_WORD_FULL) {
+			clear_upwards(level, index);
+			return;
+		}
+		if ((old | bit) != INVOKE_ID_WORD_FULL)
+			return;
+	}
+}
+
+/// Clears the bits flagging the word at index, and its ancestors, as full
+void InvokeIdSet::clear_upwards(int level, unsigned int index)
+{
+	for (; level < LEVELS - 1; level++, index /= 64) {
+		uint64_t * parent = &levels_[level + 1][index / 64];
+		uint64_t bit = (uint64_t) 1 << (index % 64);
+
+		if (__atomic_load_n(parent, __ATOMIC_SEQ_CST) & bit)
+			__atomic_fetch_and(parent, ~bit, __ATOMIC_SEQ_CST);
+	}
+}
+
+bool InvokeIdSet::set_bit(int id)
+{
+	uint64_t bit = (uint64_t) 1 << (id % 64);
+	uint64_t old = __atomic_fetch_or(&leaves_[id / 64], bit,
+					 __ATOMIC_SEQ_CST);
+
+	if (old & bit)
+		return false;
+	if ((old | bit) == INVOKE_ID_WORD_FULL)
+		mark_full(0, id / 64);
+	return true;
+}
+
+int InvokeIdSet::allocate()
+{
+	for (;;) {
+		unsigned int index = 0;
+		uint64_t word = 0;
+		int level;
+
+		// Descend through the first word not flagged as full
+		for (level = LEVELS - 1; level >= 0; level--) {
+			word = __atomic_load_n(&levels_[level][index],
+					       __ATOMIC_SEQ_CST);
+			if (word == INVOKE_ID_WORD_FULL)
+				break;
+			if (level > 0)
+				index = index * 64 + __builtin_ctzll(~word);
+		}
+
+		if (level == LEVELS - 1)
+			return overflow_allocate();
+		if (level >= 0) {
+			// Stale flag in the level above, fix it and retry
+			mark_full(level, index);
+			continue;
+		}
+
+		uint64_t bit = (uint64_t) 1 << __builtin_ctzll(~word);
+		if (!__atomic_compare_exchange_n(&leaves_[index], &word,
+						 word | bit, false,
+						 __ATOMIC_SEQ_CST,
+						 __ATOMIC_SEQ_CST))
+			continue;
+		if ((word | bit) == INVOKE_ID_WORD_FULL)
+			mark_full(0, index);
+
+		return index * 64 + __builtin_ctzll(bit);
+	}
+}
+
+int InvokeIdSet::overflow_allocate()
+{
+	rina::ScopedLock g(overflow_lock_);
+	std::set<int>::iterator it = overflow_.lower_bound(SIZE);
+	int candidate = SIZE;
+
+	while (it != overflow_.end() && *it == candidate) {
+		++it;
+		candidate++;
+	}
+	overflow_.insert(candidate);
+	__atomic_store_n(&overflow_size_, (int) overflow_.size(),
+			 __ATOMIC_RELEASE);
+
+	return candidate;
+}
+
+void InvokeIdSet::reserve(int id)
+{
+	if (id > 0 && id < SIZE) {
+		set_bit(id);
+		return;
+	}
+	if (id == 0)
+		return;
+
+	rina::ScopedLock g(overflow_lock_);
+	overflow_.insert(id);
+	__atomic_store_n(&overflow_size_, (int) overflow_.size(),
+			 __ATOMIC_RELEASE);
+}
+
+void InvokeIdSet::release(int id)
+{
+	if (id > 0 && id < SIZE) {
+		uint64_t bit = (uint64_t) 1 << (id % 64);
+		uint64_t old = __atomic_fetch_and(&leaves_[id / 64], ~bit,
+						  __ATOMIC_SEQ_CST);
+
+		if (old == INVOKE_ID_WORD_FULL)
+			clear_upwards(0, id / 64);
+		return;
+	}
+	if (id == 0 || !__atomic_load_n(&overflow_size_, __ATOMIC_ACQUIRE))
+		return;
+
+	rina::ScopedLock g(overflow_lock_);
+	overflow_.erase(id);
+	__atomic_store_n(&overflow_size_, (int) overflow_.size(),
+			 __ATOMIC_RELEASE);
+}
+
 // CLASS CDAPSessionInvokeIdManagerImpl
 CDAPInvokeIdManagerImpl::CDAPInvokeIdManagerImpl()
 {
 }
 CDAPInvokeIdManagerImpl::~CDAPInvokeIdManagerImpl() throw ()
 {
-	used_invoke_sent_ids_.clear();
-	used_invoke_recv_ids_.clear();
 }
 void CDAPInvokeIdManagerImpl::freeInvokeId(int invoke_id, bool sent)
 {
-	lock();
 	if (!sent)
-		used_invoke_sent_ids_.remove(invoke_id);
+		used_invoke_sent_ids_.release(invoke_id);
 	else
-		used_invoke_recv_ids_.remove(invoke_id);
-	unlock();
+		used_invoke_recv_ids_.release(invoke_id);
 }
 int CDAPInvokeIdManagerImpl::newInvokeId(bool sent)
 {
-	lock();
-	int candidate = 1;
-	std::list<int> * invoke_ids;
 	if (sent)
-		invoke_ids = &used_invoke_sent_ids_;
+		return used_invoke_sent_ids_.allocate();
 	else
-		invoke_ids = &used_invoke_recv_ids_;
-	while (std::find(invoke_ids->begin(), invoke_ids->end(), candidate)
-			!= invoke_ids->end()) {
-		candidate = candidate + 1;
-	}
-	invoke_ids->push_back(candidate);
-	unlock();
-	return candidate;
+		return used_invoke_recv_ids_.allocate();
 }
 void CDAPInvokeIdManagerImpl::reserveInvokeId(int invoke_id, bool sent)
 {
-	lock();
 	if (sent)
-		used_invoke_sent_ids_.push_back(invoke_id);
+		used_invoke_sent_ids_.reserve(invoke_id);
 	else
-		used_invoke_recv_ids_.push_back(invoke_id);
-	unlock();
+		used_invoke_recv_ids_.reserve(invoke_id);
 }
 
 // CLASS CDAPOperationState
@@ -1935,7 +2133,8 @@ void CDAPSession::freeOrReserveInvokeId(const cdap_m_t &cdap_message, bool sent)
 			|| cdap_message.op_code_ == cdap_m_t::M_WRITE_R
 			|| cdap_message.op_code_ == cdap_m_t::M_CANCELREAD_R
 			|| (cdap_message.op_code_ == cdap_m_t::M_READ_R
-					&& cdap_message.flags_
+					&& (cdap_message.flags_
+						& ~cdap_rib::flags_t::F_RD_BATCH)
 							== cdap_rib::flags_t::NONE_FLAGS)) {
 		invoke_id_manager_->freeInvokeId(cdap_message.invoke_id_,
 						 sent);
@@ -2127,7 +2326,8 @@ void CDAPSession::responseMessageSentOrReceived(const cdap_m_t &cdap_message,
 		pending_messages = &pending_messages_recv_;
 
 	if (cdap_message.op_code_ == cdap_m_t::M_READ_R) {
-		if (cdap_message.flags_ == cdap_rib::flags_t::F_RD_INCOMPLETE) {
+		if ((cdap_message.flags_ & ~cdap_rib::flags_t::F_RD_BATCH)
+				== cdap_rib::flags_t::F_RD_INCOMPLETE) {
 			operation_complete = false;
 		}
 	}
@@ -2324,6 +2524,13 @@ void CDAPSessionManager::decodeCDAPMessage(const ser_obj_t &cdap_message,
 	encoder->decode(cdap_message, result);
 }
 
+void CDAPSessionManager::decodeCDAPMessage(const ser_obj_t &cdap_message,
+					   cdap_m_t& result,
+					   SerObjLoan& value)
+{
+	encoder->decode(cdap_message, result, value);
+}
+
 void CDAPSessionManager::removeCDAPSession(int portId)
 {
 	ScopedLock g(lock);
@@ -2383,6 +2590,23 @@ void CDAPSessionManager::messageReceived(const ser_obj_t &encoded_cdap_message,
 	ScopedLock g(lock);
 
 	decodeCDAPMessage(encoded_cdap_message, result);
+	internal_messageReceived(result, port_id);
+}
+
+void CDAPSessionManager::messageReceived(const ser_obj_t &encoded_cdap_message,
+					 cdap_m_t& result,
+					 SerObjLoan& value,
+					 int port_id)
+{
+	ScopedLock g(lock);
+
+	decodeCDAPMessage(encoded_cdap_message, result, value);
+	internal_messageReceived(result, port_id);
+}
+
+void CDAPSessionManager::internal_messageReceived(cdap_m_t& result,
+						  int port_id)
+{
 	CDAPSession *cdap_session = internal_get_cdap_session(port_id);
 	switch (result.op_code_) {
 		case CDAPMessage::M_CONNECT:
@@ -2706,12 +2930,191 @@ cdap_rib::con_handle_t & CDAPSessionManager::get_con_handle(int port_id)
 }
 
 // CLASS GPBWireMessageProvider
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+// Tags of the length delimited CDAPMessage.objValue and objVal_t.byteval
+// fields, which write() encodes by hand
+static const unsigned int OBJ_VALUE_TAG =
+		(messages::CDAPMessage::kObjValueFieldNumber << 3) | 2;
+static const unsigned int BYTE_VAL_TAG =
+		(messages::objVal_t::kBytevalFieldNumber << 3) | 2;
+
+// Size of an objVal_t holding size bytes in byteval, 0 if there are none
+static int objValueSize(int size)
+{
+	if (size <= 0)
+		return 0;
+
+	return 1 + CodedOutputStream::VarintSize32(size) + size;
+}
+
+// Every thread encodes and decodes through its own GPB message, cleared
+// before each use, so that the strings and submessages allocated for a
+// message are recycled for the next one instead of freed
+static pthread_key_t scratch_message_key;
+static pthread_once_t scratch_message_key_once = PTHREAD_ONCE_INIT;
+
+static void scratch_message_release(void * arg)
+{
+	delete static_cast<messages::CDAPMessage *>(arg);
+}
+
+static void scratch_message_key_create(void)
+{
+	pthread_key_create(&scratch_message_key, scratch_message_release);
+}
+
+static messages::CDAPMessage& scratchMessage(void)
+{
+	messages::CDAPMessage * message;
+
+	pthread_once(&scratch_message_key_once, scratch_message_key_create);
+	message = static_cast<messages::CDAPMessage *>(
+			pthread_getspecific(scratch_message_key));
+	if (message) {
+		message->Clear();
+		return *message;
+	}
+
+	message = new messages::CDAPMessage();
+	pthread_setspecific(scratch_message_key, message);
+
+	return *message;
+}
+
+// Reads a varint at pos, not beyond end, and advances pos past it
+static bool readVarint(const unsigned char * buffer, int end, int& pos,
+		       uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+		unsigned char byte = buffer[pos++];
+
+		value |= (uint64_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+// Advances pos past the fields in [pos, end), or only past the first
+// one if first_only. If one of them has the given length delimited tag,
+// field and field_end delimit it (tag included) and data and data_size
+// its contents; as when parsing, the last one wins. Returns false if the
+// fields are malformed.
+static bool findField(const unsigned char * buffer, int end, int& pos,
+		      uint32_t tag, int& field, int& field_end,
+		      int& data, int& data_size, bool first_only)
+{
+	uint64_t key, len;
+	int start;
+
+	while (pos < end) {
+		start = pos;
+		if (!readVarint(buffer, end, pos, key))
+			return false;
+
+		switch (key & 7) {
+		case WireFormatLite::WIRETYPE_VARINT:
+			if (!readVarint(buffer, end, pos, len))
+				return false;
+			len = 0;
+			break;
+		case WireFormatLite::WIRETYPE_FIXED64:
+			len = 8;
+			break;
+		case WireFormatLite::WIRETYPE_FIXED32:
+			len = 4;
+			break;
+		case WireFormatLite::WIRETYPE_LENGTH_DELIMITED:
+			if (!readVarint(buffer, end, pos, len))
+				return false;
+			break;
+		default:
+			// No CDAP message has groups
+			return false;
+		}
+		if (len > (uint64_t) (end - pos))
+			return false;
+		if (key == tag) {
+			field = start;
+			field_end = pos + len;
+			data = pos;
+			data_size = len;
+		}
+		pos += len;
+		if (first_only)
+			break;
+	}
+
+	return true;
+}
+
 void GPBSerializer::deserializeMessage(const ser_obj_t &message,
 				       cdap_m_t& result)
 {
-	messages::CDAPMessage gpfCDAPMessage;
+	messages::CDAPMessage& gpfCDAPMessage = scratchMessage();
 
 	gpfCDAPMessage.ParseFromArray(message.message_, message.size_);
+	read(gpfCDAPMessage, result);
+	// OBJ_VALUE
+	if (gpfCDAPMessage.has_objvalue()) {
+		const std::string& byte_val =
+				gpfCDAPMessage.objvalue().byteval();
+		result.obj_value_.message_ = new unsigned char[byte_val.size()];
+		memcpy(result.obj_value_.message_, byte_val.data(),
+		       byte_val.size());
+		result.obj_value_.size_ = byte_val.size();
+	}
+}
+
+void GPBSerializer::deserializeMessage(const ser_obj_t &message,
+				       cdap_m_t& result,
+				       SerObjLoan& value)
+{
+	messages::CDAPMessage& gpfCDAPMessage = scratchMessage();
+	int pos = 0, begin = 0, end = 0, obj_val = 0, obj_val_size = 0;
+	int unused, byte_val = 0, byte_val_size = 0;
+	bool ok;
+
+	// GPB would copy the value into the message, so it only parses
+	// what follows the objValue field, which the encoder writes first,
+	// and lends the value from message
+	if (!findField(message.message_, message.size_, pos, OBJ_VALUE_TAG,
+		       begin, end, obj_val, obj_val_size, true)) {
+		throw CDAPException("Malformed CDAP message");
+	}
+	if (begin < end) {
+		ok = gpfCDAPMessage.ParsePartialFromArray(message.message_ + end,
+							  message.size_ - end);
+	} else {
+		// Another encoder: only if there is a value the message is
+		// walked to find it, and its copy in gpfCDAPMessage ignored
+		ok = gpfCDAPMessage.ParsePartialFromArray(message.message_,
+							  message.size_);
+		if (ok && gpfCDAPMessage.has_objvalue()) {
+			pos = 0;
+			ok = findField(message.message_, message.size_, pos,
+				       OBJ_VALUE_TAG, begin, end, obj_val,
+				       obj_val_size, false);
+		}
+	}
+	if (!ok || !findField(message.message_, obj_val + obj_val_size,
+			      obj_val, BYTE_VAL_TAG, unused, unused,
+			      byte_val, byte_val_size, false)) {
+		throw CDAPException("Malformed CDAP message");
+	}
+	read(gpfCDAPMessage, result);
+	// OBJ_VALUE
+	if (byte_val_size > 0)
+		value.lend(message.message_ + byte_val, byte_val_size);
+}
+
+void GPBSerializer::read(const messages::CDAPMessage& gpfCDAPMessage,
+			 cdap_m_t& result)
+{
 	// ABS_SYNTAX
 	if (gpfCDAPMessage.has_abssyntax())
 		result.abs_syntax_ = gpfCDAPMessage.abssyntax();
@@ -2753,6 +3156,10 @@ void GPBSerializer::deserializeMessage(const ser_obj_t &message,
 				static_cast<cdap_rib::flags_t::Flags>(flag_value);
 		result.flags_ = flags;
 	}
+	if (gpfCDAPMessage.has_rdbatch() && gpfCDAPMessage.rdbatch()) {
+		result.flags_ = static_cast<cdap_rib::flags_t::Flags>(
+				result.flags_ | cdap_rib::flags_t::F_RD_BATCH);
+	}
 	// INVOKE_ID
 	if (gpfCDAPMessage.has_invokeid())
 		result.invoke_id_ = gpfCDAPMessage.invokeid();
@@ -2765,16 +3172,6 @@ void GPBSerializer::deserializeMessage(const ser_obj_t &message,
 	// OBJ_NAME
 	if (gpfCDAPMessage.has_objname())
 		result.obj_name_ = gpfCDAPMessage.objname();
-	// OBJ_VALUE
-	if (gpfCDAPMessage.has_objvalue()) {
-		messages::objVal_t obj_val_t = gpfCDAPMessage.objvalue();
-		char unsigned *byte_val = new
-				unsigned char[obj_val_t.byteval().size()];
-		memcpy(byte_val, obj_val_t.byteval().data(),
-		       obj_val_t.byteval().size());
-		result.obj_value_.message_ = byte_val;
-		result.obj_value_.size_ = obj_val_t.byteval().size();
-	}
 	// OP_CODE
 	if (gpfCDAPMessage.has_opcode()) {
 		int opcode_val = gpfCDAPMessage.opcode();
@@ -2808,29 +3205,28 @@ void GPBSerializer::deserializeMessage(const ser_obj_t &message,
 		result.version_ = gpfCDAPMessage.version();
 }
 // FIXME: check existanc of fields before seting
-void GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
-				     ser_obj_t& result)
+int GPBSerializer::prepare(const cdap_m_t &cdapMessage,
+			   messages::CDAPMessage& gpfCDAPMessage)
 {
-	messages::CDAPMessage gpfCDAPMessage;
+	int value_size;
+
 	// ABS_SYNTAX
 	gpfCDAPMessage.set_abssyntax(cdapMessage.abs_syntax_);
 	// AUTH_POLICY
-	messages::authPolicy_t *gpb_auth_policy = new messages::authPolicy_t();
+	messages::authPolicy_t *gpb_auth_policy =
+			gpfCDAPMessage.mutable_authpolicy();
 	gpb_auth_policy->set_name(cdapMessage.auth_policy_.name);
-	std::list<std::string> versions = cdapMessage.auth_policy_.versions;
-	for(std::list<std::string>::iterator it = versions.begin();
+	const std::list<std::string>& versions =
+			cdapMessage.auth_policy_.versions;
+	for(std::list<std::string>::const_iterator it = versions.begin();
 		it != versions.end(); ++it) {
 		gpb_auth_policy->add_versions(*it);
 	}
 	if (cdapMessage.auth_policy_.options.size_ > 0) {
-		char * gpb_opts = new char[cdapMessage.auth_policy_.options.size_];
-		memcpy(gpb_opts,
-		       cdapMessage.auth_policy_.options.message_,
-		       cdapMessage.auth_policy_.options.size_);
-		gpb_auth_policy->set_options(gpb_opts,
-					     cdapMessage.auth_policy_.options.size_);
-	}
-	gpfCDAPMessage.set_allocated_authpolicy(gpb_auth_policy);
+		gpb_auth_policy->set_options(
+				cdapMessage.auth_policy_.options.message_,
+				cdapMessage.auth_policy_.options.size_);
+	}
 	// DEST_AE_INST
 	gpfCDAPMessage.set_destaeinst(cdapMessage.dest_ae_inst_);
 	// DEST_AE_NAME
@@ -2843,13 +3239,17 @@ void GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
 	if (cdapMessage.filter_ != 0) {
 		gpfCDAPMessage.set_filter(cdapMessage.filter_);
 	}
-        // FLAGS
-        if (cdapMessage.flags_ != 0) {
-                int flag_value = cdapMessage.flags_;
-                rina::messages::flagValues_t flag =
-                    static_cast<rina::messages::flagValues_t>(flag_value);
-                gpfCDAPMessage.set_flags(flag);
-        }
+	// FLAGS, F_RD_BATCH travels in a field of its own
+	int flag_value = cdapMessage.flags_ & ~cdap_rib::flags_t::F_RD_BATCH;
+	if (flag_value != 0) {
+		if (!messages::flagValues_t_IsValid(flag_value)) {
+			throw CDAPException("Serializing Message: Not valid flags");
+		}
+		gpfCDAPMessage.set_flags((messages::flagValues_t) flag_value);
+	}
+	if (cdapMessage.flags_ & cdap_rib::flags_t::F_RD_BATCH) {
+		gpfCDAPMessage.set_rdbatch(true);
+	}
 	// INVOKE_ID
 	gpfCDAPMessage.set_invokeid(cdapMessage.invoke_id_);
 	// OBJ_CLASS
@@ -2858,17 +3258,7 @@ void GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
 	gpfCDAPMessage.set_objinst(cdapMessage.obj_inst_);
 	// OBJ_NAME
 	gpfCDAPMessage.set_objname(cdapMessage.obj_name_);
-	// OBJ_VALUE
-	if (cdapMessage.obj_value_.size_ > 0) {
-		messages::objVal_t *gpb_obj_val = new messages::objVal_t();
-		char * gpb_val = new char[cdapMessage.obj_value_.size_];
-		memcpy(gpb_val,
-		       cdapMessage.obj_value_.message_,
-		       cdapMessage.obj_value_.size_);
-		gpb_obj_val->set_byteval(gpb_val,
-					 cdapMessage.obj_value_.size_);
-		gpfCDAPMessage.set_allocated_objvalue(gpb_obj_val);
-	}
+	// OBJ_VALUE is appended by write()
 	// OP_CODE
 	if (!messages::opCode_t_IsValid(cdapMessage.op_code_)) {
 		throw CDAPException("Serializing Message: Not a valid OpCode");
@@ -2891,10 +3281,61 @@ void GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
 	// VERSION
 	gpfCDAPMessage.set_version(cdapMessage.version_);
 
-	int size = gpfCDAPMessage.ByteSize();
+	value_size = objValueSize(cdapMessage.obj_value_.size_);
+	if (value_size == 0)
+		return gpfCDAPMessage.ByteSize();
+
+	return gpfCDAPMessage.ByteSize() + 1 +
+		CodedOutputStream::VarintSize32(value_size) + value_size;
+}
+
+void GPBSerializer::write(const cdap_m_t &cdapMessage,
+			  const messages::CDAPMessage& gpfCDAPMessage,
+			  unsigned char * buffer)
+{
+	int value_size = objValueSize(cdapMessage.obj_value_.size_);
+
+	// Fields may come in any order, so the object value goes first,
+	// copied straight from the message into the buffer, where the
+	// decoder finds it without walking the message
+	if (value_size > 0) {
+		buffer = CodedOutputStream::WriteTagToArray(OBJ_VALUE_TAG,
+							    buffer);
+		buffer = CodedOutputStream::WriteVarint32ToArray(value_size,
+								 buffer);
+		buffer = CodedOutputStream::WriteTagToArray(BYTE_VAL_TAG,
+							    buffer);
+		buffer = CodedOutputStream::WriteVarint32ToArray(
+				cdapMessage.obj_value_.size_, buffer);
+		memcpy(buffer, cdapMessage.obj_value_.message_,
+		       cdapMessage.obj_value_.size_);
+		buffer += cdapMessage.obj_value_.size_;
+	}
+
+	gpfCDAPMessage.SerializeWithCachedSizesToArray(buffer);
+}
+
+void GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
+				     ser_obj_t& result)
+{
+	messages::CDAPMessage& gpfCDAPMessage = scratchMessage();
+	int size = prepare(cdapMessage, gpfCDAPMessage);
+
 	result.message_ = new unsigned char[size];
 	result.size_ = size;
-	gpfCDAPMessage.SerializeToArray(result.message_, size);
+	write(cdapMessage, gpfCDAPMessage, result.message_);
+}
+
+int GPBSerializer::serializeMessage(const cdap_m_t &cdapMessage,
+				    unsigned char * buffer, int size)
+{
+	messages::CDAPMessage& gpfCDAPMessage = scratchMessage();
+	int needed = prepare(cdapMessage, gpfCDAPMessage);
+
+	if (needed <= size)
+		write(cdapMessage, gpfCDAPMessage, buffer);
+
+	return needed;
 }
 
 class CDAPProvider : public CDAPProviderInterface
@@ -3541,12 +3982,14 @@ void AppCDAPIOHandler::process_message(ser_obj_t &message,
 {
 	(void) cdap_dest;
 	cdap_m_t m_rcv;
+	// The object value is not copied, it points into message
+	SerObjLoan value(m_rcv.obj_value_);
 	bool is_auth_message = false;
 
 	atomic_send_lock_.lock();
 	try {
 		sdup_->unprotect_sdu(message, port);
-		manager_->messageReceived(message, m_rcv, port);
+		manager_->messageReceived(message, m_rcv, value, port);
 	} catch (rina::Exception &e) {
 		atomic_send_lock_.unlock();
 		throw e;
@@ -3578,10 +4021,8 @@ void AppCDAPIOHandler::invoke_callback(rina::cdap_rib::con_handle_t& con,
 	obj.class_ = m_rcv.obj_class_;
 	obj.inst_ = m_rcv.obj_inst_;
 	obj.name_ = m_rcv.obj_name_;
-	obj.value_.size_ = m_rcv.obj_value_.size_;
-	obj.value_.message_ = new unsigned char[obj.value_.size_];
-	memcpy(obj.value_.message_, m_rcv.obj_value_.message_,
-	       m_rcv.obj_value_.size_);
+	// The callbacks only see the value while m_rcv is alive
+	SerObjLoan value(obj.value_, m_rcv.obj_value_);
 	// Filter
 	cdap_rib::filt_info_t filt;
 	filt.filter_ = m_rcv.filter_;
@@ -4086,12 +4527,25 @@ void CDAPMessageEncoder::encode(const cdap_m_t &obj,
 	serializer->serializeMessage(obj, serobj);
 }
 
+int CDAPMessageEncoder::encode(const cdap_m_t &obj,
+			       unsigned char * buffer, int size)
+{
+	return serializer->serializeMessage(obj, buffer, size);
+}
+
 void CDAPMessageEncoder::decode(const ser_obj_t &serobj,
 				cdap_m_t &des_obj)
 {
 	serializer->deserializeMessage(serobj, des_obj);
 }
 
+void CDAPMessageEncoder::decode(const ser_obj_t &serobj,
+				cdap_m_t &des_obj,
+				SerObjLoan& value)
+{
+	serializer->deserializeMessage(serobj, des_obj, value);
+}
+
 void StringEncoder::encode(const std::string& obj, ser_obj_t& serobj)
 {
 	messages::string_t s;
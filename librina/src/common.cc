@@ -763,18 +763,30 @@ IPCEvent * getIPCEvent(){
 	return event;
 }
 
+#if !STUB_API
+static IPCEvent * takeOneEvent(int timeout_ms)
+{
+	std::vector<IPCEvent *> events;
+
+	if (rinaManager->takeEvents(events, 1, timeout_ms) == 0) {
+		return 0;
+	}
+
+	return events.front();
+}
+
+static int toTimeoutMs(int seconds, int nanoseconds)
+{
+	return seconds * 1000 + nanoseconds / 1000000;
+}
+#endif
+
 IPCEvent * IPCEventProducer::eventPoll()
 {
 #if STUB_API
 	return getIPCEvent();
 #else
-	IPCEvent * event = rinaManager->getEventQueue()->poll();
-
-	if (event) {
-		rinaManager->eventQueuePopped();
-	}
-
-	return event;
+	return takeOneEvent(0);
 #endif
 }
 
@@ -783,13 +795,7 @@ IPCEvent * IPCEventProducer::eventWait()
 #if STUB_API
 	return getIPCEvent();
 #else
-	IPCEvent *event = rinaManager->getEventQueue()->take();
-
-	if (event) {
-		rinaManager->eventQueuePopped();
-	}
-
-	return event;
+	return takeOneEvent(-1);
 #endif
 }
 
@@ -799,13 +805,26 @@ IPCEvent * IPCEventProducer::eventTimedWait(int seconds,
 #if STUB_API
 	return getIPCEvent();
 #else
-	IPCEvent * event = rinaManager->getEventQueue()->timedtake(seconds,
-								nanoseconds);
-	if (event) {
-		rinaManager->eventQueuePopped();
+	return takeOneEvent(toTimeoutMs(seconds, nanoseconds));
+#endif
+}
+
+unsigned int IPCEventProducer::eventTimedWaitBatch(
+		std::vector<IPCEvent *>& events, unsigned int max,
+		int seconds, int nanoseconds)
+{
+#if STUB_API
+	IPCEvent * event = getIPCEvent();
+
+	if (!event || max == 0) {
+		return 0;
 	}
+	events.push_back(event);
 
-	return event;
+	return 1;
+#else
+	return rinaManager->takeEvents(events, max,
+				       toTimeoutMs(seconds, nanoseconds));
 #endif
 }
 
@@ -1093,6 +1112,45 @@ const std::string Neighbor::toString(){
 bool librinaInitialized = false;
 Lockable librinaInitializationLock;
 
+/* CLASS NETLINK STATISTICS */
+NetlinkStatistics::NetlinkStatistics() :
+		messages(0), bytes(0), datagrams(0), batches(0), errors(0),
+		parse_time_ns(0), elapsed(0)
+{ }
+
+std::string NetlinkStatistics::toString() const
+{
+	std::stringstream ss;
+
+	ss << "Messages: " << messages << "; Bytes: " << bytes
+	   << "; Errors: " << errors << std::endl;
+	ss << "Datagrams: " << datagrams << "; Receive calls: " << batches;
+	if (batches) {
+		ss << " (" << (double) datagrams / batches
+		   << " datagrams/call)";
+	}
+	ss << std::endl;
+	if (elapsed > 0) {
+		ss << "Average rate: " << messages / elapsed << " messages/s, "
+		   << bytes / elapsed << " bytes/s" << std::endl;
+	}
+	if (messages) {
+		ss << "Average parse time: " << parse_time_ns / messages
+		   << " ns/message" << std::endl;
+	}
+
+	return ss.str();
+}
+
+NetlinkStatistics getNetlinkStatistics()
+{
+#if STUB_API
+	return NetlinkStatistics();
+#else
+	return rinaManager->getNetlinkManager()->getStatistics();
+#endif
+}
+
 void initialize(unsigned int localPort, const std::string& logLevel,
                 const std::string& pathToLogFile) {
 
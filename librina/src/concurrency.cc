@@ -651,6 +651,139 @@ void ConditionVariable::timedwait(long seconds, long nanoseconds){
 			ConcurrentException::error_wait_cond);
 }
 
+/* CLASS EPOCH RECLAIMER */
+EpochReclaimer::EpochReclaimer() : epoch_(1), slots_(0)
+{
+	if (pthread_key_create(&key_, releaseSlot)) {
+		LOG_CRIT("Cannot create the epoch reclaimer thread key");
+		throw ConcurrentException("Cannot create thread key");
+	}
+}
+
+EpochReclaimer::~EpochReclaimer() throw ()
+{
+	Slot * slot;
+
+	pthread_key_delete(key_);
+
+	while (!retired_.empty()) {
+		retired_.front().destroy(retired_.front().object);
+		retired_.pop_front();
+	}
+
+	while (slots_) {
+		slot = slots_;
+		slots_ = slot->next;
+		delete slot;
+	}
+}
+
+void EpochReclaimer::releaseSlot(void * slot)
+{
+	__atomic_store_n(&static_cast<Slot *>(slot)->in_use, false,
+			 __ATOMIC_RELEASE);
+}
+
+EpochReclaimer::Slot * EpochReclaimer::getSlot()
+{
+	Slot * slot = static_cast<Slot *>(pthread_getspecific(key_));
+
+	if (slot)
+		return slot;
+
+	// Reuse the slot of a thread that exited, or add one
+	for (slot = __atomic_load_n(&slots_, __ATOMIC_ACQUIRE); slot;
+			slot = slot->next) {
+		if (!__atomic_load_n(&slot->in_use, __ATOMIC_RELAXED) &&
+				!__atomic_exchange_n(&slot->in_use, true,
+						     __ATOMIC_ACQUIRE))
+			break;
+	}
+	if (!slot) {
+		slot = new Slot();
+		slot->epoch = 0;
+		slot->in_use = true;
+		slot->next = __atomic_load_n(&slots_, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&slots_, &slot->next, slot,
+						    true, __ATOMIC_RELEASE,
+						    __ATOMIC_RELAXED));
+	}
+	slot->nesting = 0;
+	pthread_setspecific(key_, slot);
+
+	return slot;
+}
+
+void EpochReclaimer::readLock()
+{
+	Slot * slot = getSlot();
+
+	if (slot->nesting++)
+		return;
+
+	// Announce the epoch before reading any shared pointer; writers
+	// scan the slots after unlinking and advancing the epoch
+	__atomic_store_n(&slot->epoch,
+			 __atomic_load_n(&epoch_, __ATOMIC_SEQ_CST),
+			 __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void EpochReclaimer::readUnlock()
+{
+	Slot * slot = static_cast<Slot *>(pthread_getspecific(key_));
+
+	if (--slot->nesting)
+		return;
+
+	__atomic_store_n(&slot->epoch, 0, __ATOMIC_RELEASE);
+}
+
+void EpochReclaimer::retire(void (*destroy)(void *), void * object)
+{
+	Retired retired;
+
+	retired.destroy = destroy;
+	retired.object = object;
+
+	ScopedLock g(lock_);
+
+	// Readers announcing this epoch or an older one may still reach
+	// the object; those entering later cannot
+	retired.epoch = __atomic_fetch_add(&epoch_, 1, __ATOMIC_SEQ_CST);
+	retired_.push_back(retired);
+	reclaimLocked();
+}
+
+void EpochReclaimer::reclaim()
+{
+	ScopedLock g(lock_);
+
+	reclaimLocked();
+}
+
+void EpochReclaimer::reclaimLocked()
+{
+	unsigned long oldest = 0;
+	unsigned long epoch;
+
+	if (retired_.empty())
+		return;
+
+	for (Slot * slot = __atomic_load_n(&slots_, __ATOMIC_ACQUIRE); slot;
+			slot = slot->next) {
+		epoch = __atomic_load_n(&slot->epoch, __ATOMIC_SEQ_CST);
+		if (epoch && (!oldest || epoch < oldest))
+			oldest = epoch;
+	}
+
+	while (!retired_.empty() &&
+			(!oldest || retired_.front().epoch < oldest)) {
+		retired_.front().destroy(retired_.front().object);
+		retired_.pop_front();
+	}
+}
+
 // Class Sleep
 bool Sleep::sleep(int sec, int milisec) {
 	return usleep(sec * 1000000 + milisec * 1000);
@@ -20,6 +20,8 @@
 // MA  02110-1301  USA
 //
 
+#include <cerrno>
+#include <poll.h>
 #include <sstream>
 #include <unistd.h>
 #include <sys/eventfd.h>
@@ -466,7 +468,7 @@ void * doNetlinkMessageReaderWork(void * arg)
 {
   RINAManager * myRINAManager = (RINAManager *) arg;
   NetlinkManager * netlinkManager = myRINAManager->getNetlinkManager();
-  BlockingFIFOQueue<IPCEvent> * eventsQueue = myRINAManager->getEventQueue();
+  LockFreeMPSCQueue<IPCEvent> * eventsQueue = myRINAManager->getEventQueue();
   BaseNetlinkMessage * incomingMessage;
   IPCEvent * event;
 
@@ -555,14 +557,15 @@ RINAManager::RINAManager(unsigned int netlinkPort)
 void RINAManager::initialize()
 {
   //2 Initialize eventsQueue and the associated eventfd
-  eventQueue = new BlockingFIFOQueue<IPCEvent>();
+  eventQueue = new LockFreeMPSCQueue<IPCEvent>();
   LOG_DBG("Initialized event queue");
 
-  /* This must be opened in blocking mode, see eventQueuePopped. */
-  eventQueueReady = eventfd(0 , EFD_SEMAPHORE);
+  /* Non-blocking, see eventQueueDrained. */
+  eventQueueReady = eventfd(0 , EFD_NONBLOCK);
   if (eventQueueReady < 0) {
     throw Exception("Failed to create eventfd");
   }
+  eventQueueSignalled = 0;
 
   keep_on_reading = true;
 
@@ -588,6 +591,11 @@ RINAManager::~RINAManager()
   netlinkMessageReader->join(&status);
   delete netlinkManager;
   delete netlinkMessageReader;
+
+  IPCEvent * event;
+  while ((event = eventQueue->poll()) != 0) {
+    delete event;
+  }
   delete eventQueue;
 }
 
@@ -653,7 +661,7 @@ IPCEvent * RINAManager::osProcessFinalized(unsigned int nl_portid)
   return event;
 }
 
-BlockingFIFOQueue<IPCEvent>* RINAManager::getEventQueue()
+LockFreeMPSCQueue<IPCEvent>* RINAManager::getEventQueue()
 {
   return eventQueue;
 }
@@ -663,36 +671,83 @@ NetlinkManager* RINAManager::getNetlinkManager()
   return netlinkManager;
 }
 
+/* Only the producer that finds the queue not signalled writes to the
+ * eventfd, so a burst of events costs a single write() until the
+ * consumer drains the queue.
+ */
 void RINAManager::eventQueuePushed()
 {
   uint64_t x = 1;
   int n;
 
+  if (__atomic_exchange_n(&eventQueueSignalled, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+
   n = write(eventQueueReady, &x, sizeof(x));
   if (n != sizeof(x)) {
     throw Exception("Failed to write to to eventQueueReady eventfd");
   }
 }
 
-/* It may be that the netlink reader has put() an event in the queue,
- * but has not called yet eventQueuePushed() when this function is
- * called by the event consumer, who has already seen the new event.
- * In case this happens, it is not a problem, because the eventfd is
- * open in blocking mode: the read() blocks, and returns as soon as
- * the netlink reader has the chance to call eventQueuePushed().
+/* Called by the consumer when it has found the queue empty. The
+ * eventfd is reset before clearing the signalled flag; if a producer
+ * pushed an event in between without writing the eventfd, the flag is
+ * set again here so that the eventfd stays readable while the queue is
+ * not empty.
  */
-void RINAManager::eventQueuePopped()
+void RINAManager::eventQueueDrained()
 {
   uint64_t x;
   int n;
 
   n = read(eventQueueReady, &x, sizeof(x));
-  if (n != sizeof(x)) {
+  if (n != sizeof(x) && errno != EAGAIN) {
     throw Exception("Failed to read from eventQueueReady eventfd");
   }
 
-  if (x != 1) {
-    throw Exception("Unexpected value read from eventQueueReady eventfd");
+  __atomic_store_n(&eventQueueSignalled, 0, __ATOMIC_SEQ_CST);
+
+  if (!eventQueue->empty()) {
+    eventQueuePushed();
+  }
+}
+
+unsigned int RINAManager::takeEvents(std::vector<IPCEvent *>& events,
+                                     unsigned int max, int timeout_ms)
+{
+  struct pollfd pfd;
+  unsigned int result;
+  int ret;
+
+  for (;;) {
+    eventQueueConsumerLock.lock();
+    result = eventQueue->takeBatch(events, max);
+    if (eventQueue->empty()) {
+      try {
+        eventQueueDrained();
+      } catch (Exception &e) {
+        eventQueueConsumerLock.unlock();
+        throw e;
+      }
+    }
+    eventQueueConsumerLock.unlock();
+
+    if (result > 0 || timeout_ms == 0) {
+      return result;
+    }
+
+    pfd.fd = eventQueueReady;
+    pfd.events = POLLIN;
+    ret = poll(&pfd, 1, timeout_ms);
+    if (ret < 0 && errno != EINTR) {
+      throw Exception("Failed to poll eventQueueReady eventfd");
+    }
+
+    if (ret == 0) {
+      // Timeout, give the queue a last look
+      timeout_ms = 0;
+    }
   }
 }
 
@@ -120,12 +120,22 @@ class RINAManager {
 	NetlinkManager * netlinkManager;
 
 	/** The events queue */
-	BlockingFIFOQueue<IPCEvent> * eventQueue;
+	LockFreeMPSCQueue<IPCEvent> * eventQueue;
 
 	/** eventfd to notify applications about events arriving in
-	 *  eventQueue. */
+	 *  eventQueue. It is readable while the queue is not empty,
+	 *  a single write covers all the events pushed until the
+	 *  consumer drains the queue. */
 	int eventQueueReady;
 
+	/** 1 if eventQueueReady has been written and not drained yet */
+	int eventQueueSignalled;
+
+	/** Serializes the consumers of eventQueue */
+	Lockable eventQueueConsumerLock;
+
+	void eventQueueDrained();
+
 	/** The thread that is continuously reading incoming Netlink messages */
 	Thread * netlinkMessageReader;
 
@@ -162,11 +172,19 @@ public:
 	 */
 	IPCEvent * osProcessFinalized(unsigned int nl_portid);
 
-	BlockingFIFOQueue<IPCEvent>* getEventQueue();
+	LockFreeMPSCQueue<IPCEvent>* getEventQueue();
 	NetlinkManager* getNetlinkManager();
 	int getEventFd() const { return eventQueueReady; }
 	void eventQueuePushed();
-	void eventQueuePopped();
+
+	/**
+	 * Take up to max events from the event queue, waiting no more
+	 * than timeout_ms if it is empty (-1 waits forever, 0 does not
+	 * wait).
+	 * @return the number of events appended to events
+	 */
+	unsigned int takeEvents(std::vector<IPCEvent *>& events,
+				unsigned int max, int timeout_ms);
 	bool keep_on_reading;
 };
 
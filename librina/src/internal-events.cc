@@ -21,108 +21,183 @@
 
 #define RINA_PREFIX "internal-events"
 
+#include <algorithm>
+
 #include "librina/logs.h"
 #include "librina/internal-events.h"
 
 namespace rina {
 
-const std::string InternalEvent::APP_CONNECTIVITY_TO_NEIGHBOR_LOST = "CONNECTIVITY_TO_NEIGHBOR_LOST";
-const std::string InternalEvent::APP_N_MINUS_1_FLOW_ALLOCATED = "N_MINUS_1_FLOW_ALLOCATED";
-const std::string InternalEvent::APP_N_MINUS_1_FLOW_ALLOCATION_FAILED = "N_MINUS_1_FLOW_ALLOCATION_FAILED";
-const std::string InternalEvent::APP_N_MINUS_1_FLOW_DEALLOCATED = "N_MINUS_1_FLOW_DEALLOCATED";
-const std::string InternalEvent::APP_NEIGHBOR_DECLARED_DEAD = "NEIGHBOR_DECLARED_DEAD";
-const std::string InternalEvent::APP_NEIGHBOR_ADDED = "NEIGHBOR_ADDED";
-const std::string InternalEvent::ADDRESS_CHANGE = "ADDRESS_CHANGE";
-const std::string InternalEvent::NEIGHBOR_ADDRESS_CHANGE = "NEIGHBOR_ADDRESS_CHANGE";
-const std::string InternalEvent::IPCP_INTERNAL_FLOW_ALLOCATED = "IPCP_INTERNAL_FLOW_ALLOCATED";
-const std::string InternalEvent::IPCP_INTERNAL_FLOW_ALLOCATION_FAILED = "IPCP_INTERNAL_FLOW_ALLOCATION_FAILED";
-const std::string InternalEvent::IPCP_INTERNAL_FLOW_DEALLOCATED = "IPCP_INTERNAL_FLOW_DEALLOCATED";
+static const char * event_type_names[] = {
+	"CONNECTIVITY_TO_NEIGHBOR_LOST",
+	"N_MINUS_1_FLOW_ALLOCATED",
+	"N_MINUS_1_FLOW_ALLOCATION_FAILED",
+	"N_MINUS_1_FLOW_DEALLOCATED",
+	"NEIGHBOR_DECLARED_DEAD",
+	"NEIGHBOR_ADDED",
+	"ADDRESS_CHANGE",
+	"NEIGHBOR_ADDRESS_CHANGE",
+	"IPCP_INTERNAL_FLOW_ALLOCATED",
+	"IPCP_INTERNAL_FLOW_ALLOCATION_FAILED",
+	"IPCP_INTERNAL_FLOW_DEALLOCATED",
+};
+
+const char * InternalEvent::type_name(EventType type)
+{
+	if (type < 0 || type >= NUM_EVENT_TYPES)
+		return "UNKNOWN";
+
+	return event_type_names[type];
+}
 
 // Class SimpleInternalEventManager
+SimpleInternalEventManager::SimpleInternalEventManager(bool async)
+{
+	for (int i = 0; i < InternalEvent::NUM_EVENT_TYPES; i++) {
+		event_listeners_[i] = new ListenerList();
+	}
+
+	dispatcher_ = 0;
+	if (async) {
+		ThreadAttributes threadAttributes;
+		threadAttributes.setJoinable();
+		threadAttributes.setName("events");
+		dispatcher_ = new Dispatcher(&threadAttributes, this);
+		dispatcher_->start();
+	}
+}
+
+SimpleInternalEventManager::~SimpleInternalEventManager() throw()
+{
+	InternalEvent * event;
+
+	if (dispatcher_) {
+		events_.put(0);
+		dispatcher_->join(NULL);
+		delete dispatcher_;
+	}
+
+	while ((event = events_.poll()) != 0) {
+		delete event;
+	}
+
+	for (int i = 0; i < InternalEvent::NUM_EVENT_TYPES; i++) {
+		delete event_listeners_[i];
+	}
+}
+
 void SimpleInternalEventManager::set_application_process(ApplicationProcess * ap)
 {
 	app = ap;
 }
 
-void SimpleInternalEventManager::subscribeToEvent(const std::string& type,
-                                     	 	  InternalEventListener * eventListener)
+void SimpleInternalEventManager::subscribeToEvent(InternalEvent::EventType type,
+						  InternalEventListener * eventListener)
 {
-        if (!eventListener)
-                return;
+	ListenerList * listeners, * old;
+
+	if (!eventListener || type < 0 || type >= InternalEvent::NUM_EVENT_TYPES)
+		return;
 
-        events_lock_.lock();
+	ScopedLock g(events_lock_);
 
-        std::map<std::string, std::list<InternalEventListener*> >::iterator it =
-        		event_listeners_.find(type);
-        if (it == event_listeners_.end()) {
-                std::list<InternalEventListener *> listenersList;
-                listenersList.push_back(eventListener);
-                event_listeners_[type] = listenersList;
-        } else {
-                std::list<InternalEventListener *>::iterator listIterator;
-                for (listIterator=it->second.begin(); listIterator != it->second.end(); ++listIterator) {
-                        if (*listIterator == eventListener) {
-                                events_lock_.unlock();
-                                return;
-                        }
-                }
+	listeners = event_listeners_[type];
+	if (std::find(listeners->begin(), listeners->end(),
+		      eventListener) != listeners->end())
+		return;
 
-                it->second.push_back(eventListener);
-        }
+	listeners = new ListenerList(*listeners);
+	listeners->push_back(eventListener);
+	old = event_listeners_[type];
+	__atomic_store_n(&event_listeners_[type], listeners, __ATOMIC_RELEASE);
+	epochs_.retire(EpochReclaimer::destroy<ListenerList>, old);
 
-        LOG_INFO("EventListener subscribed to event %s", type.c_str());
-        events_lock_.unlock();
+	LOG_DBG("EventListener subscribed to event %s",
+		InternalEvent::type_name(type));
 }
 
-void SimpleInternalEventManager::unsubscribeFromEvent(const std::string& type,
-                                         	      InternalEventListener * eventListener)
+void SimpleInternalEventManager::unsubscribeFromEvent(InternalEvent::EventType type,
+						      InternalEventListener * eventListener)
 {
-        if (!eventListener)
-                return;
+	ListenerList * listeners, * old;
+	ListenerList::iterator it;
 
-        events_lock_.lock();
-        std::map<std::string, std::list<InternalEventListener*> >::iterator it =
-        		event_listeners_.find(type);
-        if (it == event_listeners_.end()) {
-                events_lock_.unlock();
-                return;
-        }
+	if (!eventListener || type < 0 || type >= InternalEvent::NUM_EVENT_TYPES)
+		return;
 
-        it->second.remove(eventListener);
-        if (it->second.size() == 0) {
-                event_listeners_.erase(it);
-        }
+	ScopedLock g(events_lock_);
 
-        LOG_INFO("EventListener unsubscribed from event %s", type.c_str());
-        events_lock_.unlock();
+	listeners = event_listeners_[type];
+	it = std::find(listeners->begin(), listeners->end(), eventListener);
+	if (it == listeners->end())
+		return;
+
+	listeners = new ListenerList(*listeners);
+	listeners->erase(listeners->begin() +
+			 (it - event_listeners_[type]->begin()));
+	old = event_listeners_[type];
+	__atomic_store_n(&event_listeners_[type], listeners, __ATOMIC_RELEASE);
+	epochs_.retire(EpochReclaimer::destroy<ListenerList>, old);
+
+	LOG_DBG("EventListener unsubscribed from event %s",
+		InternalEvent::type_name(type));
 }
 
 void SimpleInternalEventManager::deliverEvent(InternalEvent * event)
 {
-        if (!event)
-                return;
+	if (!event)
+		return;
+
+	if (event->type < 0 || event->type >= InternalEvent::NUM_EVENT_TYPES) {
+		LOG_ERR("Unknown event type %d", event->type);
+		delete event;
+		return;
+	}
+
+	if (dispatcher_) {
+		events_.put(event);
+		return;
+	}
+
+	dispatch(event);
+}
+
+void SimpleInternalEventManager::dispatch(InternalEvent * event)
+{
+	ListenerList * listeners;
 
-        LOG_INFO("Event %s has just happened. Notifying event listeners.",
-                       event->type.c_str());
+	LOG_DBG("Event %s has just happened. Notifying event listeners.",
+		InternalEvent::type_name(event->type));
 
-        events_lock_.lock();
-        std::map<std::string, std::list<InternalEventListener*> >::iterator it =
-        		event_listeners_.find(event->type);
-        if (it == event_listeners_.end()) {
-                events_lock_.unlock();
-                delete event;
-                return;
-        }
+	{
+		EpochScopedRead r(epochs_);
 
-        events_lock_.unlock();
-        std::list<InternalEventListener *>::iterator listIterator;
-        for (listIterator=it->second.begin(); listIterator != it->second.end(); ++listIterator) {
-                (*listIterator)->eventHappened(event);
-        }
+		listeners = __atomic_load_n(&event_listeners_[event->type],
+					    __ATOMIC_ACQUIRE);
+		for (unsigned int i = 0; i < listeners->size(); i++) {
+			(*listeners)[i]->eventHappened(event);
+		}
+	}
+
+	delete event;
+}
+
+SimpleInternalEventManager::Dispatcher::Dispatcher(ThreadAttributes * threadAttributes,
+						   SimpleInternalEventManager * manager)
+	: SimpleThread(threadAttributes)
+{
+	manager_ = manager;
+}
+
+int SimpleInternalEventManager::Dispatcher::run()
+{
+	InternalEvent * event;
+
+	while ((event = manager_->events_.take()) != 0) {
+		manager_->dispatch(event);
+	}
 
-        if (event) {
-                delete event;
-        }
+	return 0;
 }
 
 //CLASS NMinusOneFlowAllocationFailedEvent
@@ -139,7 +214,7 @@ NMinusOneFlowAllocationFailedEvent::NMinusOneFlowAllocationFailedEvent(unsigned
 const std::string NMinusOneFlowAllocationFailedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Handle: "<<handle_;
+	ss<<"Event id: "<<type_name(type)<<"; Handle: "<<handle_;
 	ss<<"; Result reason: "<<result_reason_<<std::endl;
 	ss<<"Flow description: "<<flow_information_.toString();
 	return ss.str();
@@ -157,7 +232,7 @@ NMinusOneFlowAllocatedEvent::NMinusOneFlowAllocatedEvent(unsigned int handle,
 const std::string NMinusOneFlowAllocatedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Handle: "<<handle_<<std::endl;
+	ss<<"Event id: "<<type_name(type)<<"; Handle: "<<handle_<<std::endl;
 	ss<<"Flow description: "<<flow_information_.toString();
 	return ss.str();
 }
@@ -173,7 +248,7 @@ NMinusOneFlowDeallocatedEvent::NMinusOneFlowDeallocatedEvent(int port_id):
 const std::string NMinusOneFlowDeallocatedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Port-id: "<<port_id_<<std::endl;
+	ss<<"Event id: "<<type_name(type)<<"; Port-id: "<<port_id_<<std::endl;
 	return ss.str();
 }
 
@@ -187,7 +262,7 @@ ConnectiviyToNeighborLostEvent::ConnectiviyToNeighborLostEvent(const Neighbor& n
 const std::string ConnectiviyToNeighborLostEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
+	ss<<"Event id: "<<type_name(type)<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
 	return ss.str();
 }
 
@@ -206,7 +281,7 @@ NeighborAddedEvent::NeighborAddedEvent(const Neighbor& neighbor, bool enrollee,
 const std::string NeighborAddedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
+	ss<<"Event id: "<<type_name(type)<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
 	ss<<"Enrollee: "<<enrollee_<<std::endl;
 	if (prepare_handover) {
 		ss<<"Prepare for handover: true; Disc neighbor name: "
@@ -225,7 +300,7 @@ NeighborDeclaredDeadEvent::NeighborDeclaredDeadEvent(const Neighbor& neighbor):
 const std::string NeighborDeclaredDeadEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
+	ss<<"Event id: "<<type_name(type)<<"; Neighbor: "<<neighbor_.toString()<<std::endl;
 	return ss.str();
 }
 
@@ -245,7 +320,7 @@ AddressChangeEvent::AddressChangeEvent(unsigned int new_addr,
 const std::string AddressChangeEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; New address: "<< new_address
+	ss<<"Event id: "<<type_name(type)<<"; New address: "<< new_address
 			<<"; Old address: " << old_address << std::endl;
 	ss<<"Use new address timeout: " << use_new_timeout << " ms; "
 	  <<"Deprecate old address timeout: " << deprecate_old_timeout << " ms" << std::endl;
@@ -266,7 +341,7 @@ NeighborAddressChangeEvent::NeighborAddressChangeEvent(const std::string& name,
 const std::string NeighborAddressChangeEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Name: "<<neigh_name<<"; New address: "<< new_address
+	ss<<"Event id: "<<type_name(type)<<"; Name: "<<neigh_name<<"; New address: "<< new_address
 			<<"; Old address: " << old_address << std::endl;
 	return ss.str();
 }
@@ -285,7 +360,7 @@ IPCPInternalFlowAllocatedEvent::IPCPInternalFlowAllocatedEvent(unsigned int port
 const std::string IPCPInternalFlowAllocatedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Port id: "<<port_id
+	ss<<"Event id: "<<type_name(type)<<"; Port id: "<<port_id
 	   <<"; File descriptor: " << fd << std::endl;
 	ss<<"Flow description: "<<flow_info.toString();
 	return ss.str();
@@ -305,7 +380,7 @@ IPCPInternalFlowAllocationFailedEvent::IPCPInternalFlowAllocationFailedEvent(uns
 const std::string IPCPInternalFlowAllocationFailedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Error code: "<<error_code;
+	ss<<"Event id: "<<type_name(type)<<"; Error code: "<<error_code;
 	ss<<"; Result reason: "<<reason<<std::endl;
 	ss<<"Flow description: "<<flow_info.toString();
 	return ss.str();
@@ -321,7 +396,7 @@ IPCPInternalFlowDeallocatedEvent::IPCPInternalFlowDeallocatedEvent(int port):
 const std::string IPCPInternalFlowDeallocatedEvent::toString()
 {
 	std::stringstream ss;
-	ss<<"Event id: "<<type<<"; Port-id: "<<port_id;
+	ss<<"Event id: "<<type_name(type)<<"; Port-id: "<<port_id;
 	return ss.str();
 }
 
@@ -25,8 +25,10 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <cerrno>
 #include <cstdio>
 #include <pthread.h>
+#include <sys/time.h>
 #include <time.h>
 #include <string>
 
@@ -51,6 +53,36 @@ const std::string LOG_LEVEL_EMERG = "EMERG";
 
 static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Asynchronous backend: every thread formats its log statements into its
+ * own buffer, which the writer thread drains to logStream every
+ * LOG_ASYNC_PERIOD_MS (or earlier, when a buffer is half full). Lock
+ * ordering is log_buffers_mutex -> log_buffer::lock -> log_mutex.
+ */
+#define LOG_ASYNC_BUFFER_SIZE (64 * 1024)
+#define LOG_ASYNC_PERIOD_MS   100
+
+struct log_buffer {
+	pthread_mutex_t    lock;
+	size_t             len;
+	bool               orphan;
+	struct log_buffer * next;
+	char               data[LOG_ASYNC_BUFFER_SIZE];
+};
+
+static int log_async = 0;
+static pthread_key_t log_buffer_key;
+static pthread_once_t log_buffer_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t log_buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct log_buffer * log_buffers = 0;
+
+static pthread_mutex_t log_writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t log_writer;
+static bool log_writer_running = false;
+static bool log_writer_stop = false;
+static bool log_atexit_registered = false;
+
 void setLogLevel(const char* level)
 {
 	std::string newLogLevel(level);
@@ -102,6 +134,204 @@ int setLogFile(const char* file)
 	return result;
 }
 
+static void log_buffer_release(void * arg)
+{
+	struct log_buffer * buffer = (struct log_buffer *) arg;
+
+	// The writer frees it once it has been drained
+	pthread_mutex_lock(&buffer->lock);
+	buffer->orphan = true;
+	pthread_mutex_unlock(&buffer->lock);
+}
+
+static void log_buffer_key_create(void)
+{
+	pthread_key_create(&log_buffer_key, log_buffer_release);
+}
+
+static struct log_buffer * log_buffer_get(void)
+{
+	struct log_buffer * buffer;
+
+	buffer = (struct log_buffer *) pthread_getspecific(log_buffer_key);
+	if (likely(buffer != 0))
+		return buffer;
+
+	buffer = (struct log_buffer *) malloc(sizeof(*buffer));
+	if (!buffer)
+		return 0;
+
+	pthread_mutex_init(&buffer->lock, 0);
+	buffer->len = 0;
+	buffer->orphan = false;
+
+	pthread_mutex_lock(&log_buffers_mutex);
+	buffer->next = log_buffers;
+	log_buffers = buffer;
+	pthread_mutex_unlock(&log_buffers_mutex);
+
+	pthread_setspecific(log_buffer_key, buffer);
+
+	return buffer;
+}
+
+/* Must be called with buffer->lock held */
+static void log_buffer_write(struct log_buffer * buffer)
+{
+	if (buffer->len == 0)
+		return;
+
+	pthread_mutex_lock(&log_mutex);
+	fwrite(buffer->data, 1, buffer->len, logStream);
+	pthread_mutex_unlock(&log_mutex);
+	buffer->len = 0;
+}
+
+/* Drains all the per-thread buffers, freeing those of exited threads */
+static void log_buffers_drain(void)
+{
+	struct log_buffer ** iter;
+	struct log_buffer * buffer;
+	bool orphan;
+
+	pthread_mutex_lock(&log_buffers_mutex);
+	iter = &log_buffers;
+	while (*iter) {
+		buffer = *iter;
+		pthread_mutex_lock(&buffer->lock);
+		log_buffer_write(buffer);
+		orphan = buffer->orphan;
+		pthread_mutex_unlock(&buffer->lock);
+
+		if (orphan) {
+			*iter = buffer->next;
+			pthread_mutex_destroy(&buffer->lock);
+			free(buffer);
+		} else {
+			iter = &buffer->next;
+		}
+	}
+	pthread_mutex_unlock(&log_buffers_mutex);
+
+	pthread_mutex_lock(&log_mutex);
+	fflush(logStream);
+	pthread_mutex_unlock(&log_mutex);
+}
+
+static void * log_writer_loop(void * arg)
+{
+	struct timespec deadline;
+	struct timeval now;
+
+	(void) arg;
+
+	pthread_mutex_lock(&log_writer_mutex);
+	while (!log_writer_stop) {
+		gettimeofday(&now, 0);
+		deadline.tv_sec = now.tv_sec;
+		deadline.tv_nsec = now.tv_usec * 1000 +
+				   LOG_ASYNC_PERIOD_MS * 1000000L;
+		while (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait(&log_writer_cond, &log_writer_mutex,
+				       &deadline);
+
+		pthread_mutex_unlock(&log_writer_mutex);
+		log_buffers_drain();
+		pthread_mutex_lock(&log_writer_mutex);
+	}
+	pthread_mutex_unlock(&log_writer_mutex);
+
+	return 0;
+}
+
+void flushLogs(void)
+{
+	log_buffers_drain();
+}
+
+int setLogAsync(int enable)
+{
+	int result = 0;
+
+	pthread_once(&log_buffer_key_once, log_buffer_key_create);
+
+	pthread_mutex_lock(&log_writer_mutex);
+	if (enable && !log_writer_running) {
+		log_writer_stop = false;
+		if (pthread_create(&log_writer, 0, log_writer_loop, 0)) {
+			result = -1;
+		} else {
+			log_writer_running = true;
+			if (!log_atexit_registered) {
+				atexit(flushLogs);
+				log_atexit_registered = true;
+			}
+			__atomic_store_n(&log_async, 1, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&log_writer_mutex);
+	} else if (!enable && log_writer_running) {
+		__atomic_store_n(&log_async, 0, __ATOMIC_RELEASE);
+		log_writer_stop = true;
+		log_writer_running = false;
+		pthread_cond_signal(&log_writer_cond);
+		pthread_mutex_unlock(&log_writer_mutex);
+		pthread_join(log_writer, 0);
+	} else {
+		pthread_mutex_unlock(&log_writer_mutex);
+	}
+
+	flushLogs();
+
+	return result;
+}
+
+static void logFuncAsync(const char * fmt, va_list args)
+{
+	struct log_buffer * buffer = log_buffer_get();
+	size_t space;
+	va_list copy;
+	int n;
+
+	if (unlikely(!buffer)) {
+		pthread_mutex_lock(&log_mutex);
+		vfprintf(logStream, fmt, args);
+		pthread_mutex_unlock(&log_mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&buffer->lock);
+
+	space = LOG_ASYNC_BUFFER_SIZE - buffer->len;
+	va_copy(copy, args);
+	n = vsnprintf(buffer->data + buffer->len, space, fmt, copy);
+	va_end(copy);
+
+	if (unlikely(n < 0)) {
+		n = 0;
+	} else if (unlikely((size_t) n >= space)) {
+		// Does not fit: write out what we have and retry
+		log_buffer_write(buffer);
+		n = vsnprintf(buffer->data, LOG_ASYNC_BUFFER_SIZE, fmt, args);
+		if (n < 0) {
+			n = 0;
+		} else if ((size_t) n >= LOG_ASYNC_BUFFER_SIZE) {
+			// Longer than the whole buffer, truncate it
+			n = LOG_ASYNC_BUFFER_SIZE - 1;
+			buffer->data[n - 1] = '\n';
+		}
+	}
+
+	buffer->len += n;
+	if (buffer->len >= LOG_ASYNC_BUFFER_SIZE / 2 &&
+			buffer->len - n < LOG_ASYNC_BUFFER_SIZE / 2)
+		pthread_cond_signal(&log_writer_cond);
+
+	pthread_mutex_unlock(&buffer->lock);
+}
+
 void logFunc(enum LOG_LEVEL level, const char * fmt, ...)
 {
 	//Avoid to use locking
@@ -113,6 +343,11 @@ void logFunc(enum LOG_LEVEL level, const char * fmt, ...)
 	va_list args;
 
 	va_start(args, fmt);
+	if (__atomic_load_n(&log_async, __ATOMIC_ACQUIRE)) {
+		logFuncAsync(fmt, args);
+		va_end(args);
+		return;
+	}
 	vfprintf(stream, fmt, args);
 	va_end(args);
 
@@ -20,13 +20,15 @@
 // MA  02110-1301  USA
 //
 
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
 #include <unistd.h>
 #include <netlink/genl/genl.h>
 #include <netlink/genl/ctrl.h>
 #include <netlink/socket.h>
 
-#include <sys/time.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 
 #define RINA_PREFIX "librina.nl-manager"
 
@@ -86,6 +88,11 @@ NetlinkManager::NetlinkManager(unsigned int localPort) {
 
 NetlinkManager::~NetlinkManager() {
 	LOG_DBG("Netlink Manager destructor called");
+	close(epollFd);
+	free(rxBuffers);
+	if (txMessage) {
+		nlmsg_free(txMessage);
+	}
 	nl_socket_free(socket);
 }
 
@@ -126,6 +133,44 @@ void NetlinkManager::initialize(bool ipcManager) {
 				NetlinkException::error_resolving_netlink_family);
 	}
 	LOG_DBG("Generic Netlink RINA family id: %d", family);
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd < 0) {
+		LOG_CRIT("Could not create epoll instance: %d", errno);
+		throw NetlinkException(
+				NetlinkException::error_connecting_netlink_socket);
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, nl_socket_get_fd(socket),
+		      &event) < 0) {
+		LOG_CRIT("Could not watch the Netlink socket: %d", errno);
+		close(epollFd);
+		throw NetlinkException(
+				NetlinkException::error_connecting_netlink_socket);
+	}
+
+	// Not touched until the kernel writes to them, so only the pages
+	// actually used by received datagrams are committed
+	rxBuffers = (unsigned char *) malloc(NETLINK_RX_BATCH *
+					     NETLINK_RX_BUFFER_SIZE);
+	if (!rxBuffers) {
+		close(epollFd);
+		throw NetlinkException(
+				NetlinkException::error_allocating_netlink_message);
+	}
+	for (unsigned int i = 0; i < NETLINK_RX_BATCH; i++) {
+		rxIovecs[i].iov_base = rxBuffers + i * NETLINK_RX_BUFFER_SIZE;
+		rxIovecs[i].iov_len = NETLINK_RX_BUFFER_SIZE;
+	}
+	rxCount = 0;
+	rxNext = 0;
+	rxHeader = NULL;
+	rxRemaining = 0;
+	clock_gettime(CLOCK_MONOTONIC, &statsStart);
+	txMessage = NULL;
 }
 
 void NetlinkManager::_sendMessage(BaseNetlinkMessage * message, struct nl_msg* netlinkMessage) {
@@ -152,7 +197,6 @@ void NetlinkManager::_sendMessage(BaseNetlinkMessage * message, struct nl_msg* n
                         flags, message->getOperationCode(),
                         RINA_GENERIC_NETLINK_FAMILY_VERSION);
         if (!myHeader){
-                nlmsg_free(netlinkMessage);
                 LOG_ERR("%s",
                                 NetlinkException::error_generating_netlink_message.c_str());
                 throw NetlinkException(
@@ -163,7 +207,6 @@ void NetlinkManager::_sendMessage(BaseNetlinkMessage * message, struct nl_msg* n
 
         int result = putBaseNetlinkMessage(netlinkMessage, message);
         if (result < 0) {
-                nlmsg_free(netlinkMessage);
                 LOG_ERR("%s %d",
                                 NetlinkException::error_generating_netlink_message.c_str(),
                                 result);
@@ -175,7 +218,6 @@ void NetlinkManager::_sendMessage(BaseNetlinkMessage * message, struct nl_msg* n
         nl_socket_set_peer_port(socket, message->getDestPortId());
         result = nl_send(socket, netlinkMessage);
         if (result < 0) {
-                nlmsg_free(netlinkMessage);
                 LOG_ERR("%s %d %d",
                                 NetlinkException::error_sending_netlink_message.c_str(),
                                 result, message->getDestPortId());
@@ -183,8 +225,6 @@ void NetlinkManager::_sendMessage(BaseNetlinkMessage * message, struct nl_msg* n
                                 NetlinkException::error_sending_netlink_message);
         }
         LOG_DBG("NL msg TX. %s", message->toString().c_str());
-        //Cleanup
-        nlmsg_free(netlinkMessage);
 }
 
 unsigned int NetlinkManager::getLocalPort(){
@@ -196,14 +236,17 @@ unsigned int NetlinkManager::getSequenceNumber(){
 }
 
 void NetlinkManager::sendMessage(BaseNetlinkMessage * message) {
-        struct nl_msg* netlinkMessage;
-
-        netlinkMessage = nlmsg_alloc();
-        if (!netlinkMessage) {
-                throw NetlinkException("Error allocating Netlink Message structure");
+        if (!txMessage) {
+                txMessage = nlmsg_alloc();
+                if (!txMessage) {
+                        throw NetlinkException("Error allocating Netlink Message structure");
+                }
+        } else {
+                /* Drop the previous message, keeping the buffer */
+                nlmsg_hdr(txMessage)->nlmsg_len = NLMSG_HDRLEN;
         }
 
-        _sendMessage(message, netlinkMessage);
+        _sendMessage(message, txMessage);
 }
 
 void NetlinkManager::sendMessageOfMaxSize(BaseNetlinkMessage * message, size_t maxSize) {
@@ -213,62 +256,84 @@ void NetlinkManager::sendMessageOfMaxSize(BaseNetlinkMessage * message, size_t m
                 throw NetlinkException("Error allocating Netlink Message structure");
         }
 
-        _sendMessage(message, netlinkMessage);
+        try {
+                _sendMessage(message, netlinkMessage);
+        } catch (NetlinkException &e) {
+                nlmsg_free(netlinkMessage);
+                throw e;
+        }
+        nlmsg_free(netlinkMessage);
 }
 
-BaseNetlinkMessage * NetlinkManager::getMessage() {
-	unsigned char *buf = NULL;
-	struct nlmsghdr *hdr;
-	struct genlmsghdr *nlhdr;
-	struct rinaHeader * myHeader;
-	struct sockaddr_nl nla;
-	struct nl_msg *msg = NULL;
-	struct ucred *creds = NULL;
-	int numBytes;
-
-	// Use Select to implement a read with timeout
-	struct timeval timeout = {2,0};
-	fd_set readset;
-	FD_ZERO(&readset);
-	int res, fd_socket = nl_socket_get_fd(socket);
-	FD_SET(fd_socket, &readset);
-
-	if ((res = select(fd_socket+1, &readset, NULL, NULL, &timeout))>0
-		&& FD_ISSET(fd_socket, &readset)){
-
-		memset(&nla, 0, sizeof(nla));
-		numBytes = nl_recv(socket, &nla, &buf, &creds);
-		if (numBytes <= 0) {
-			LOG_ERR("%s %d",
-				NetlinkException::error_receiving_netlink_message.c_str(),
-				numBytes);
-			throw NetlinkException(
-				NetlinkException::error_receiving_netlink_message);
+static unsigned long long elapsedNs(const struct timespec& from,
+				    const struct timespec& to)
+{
+	return (to.tv_sec - from.tv_sec) * 1000000000ULL
+		+ to.tv_nsec - from.tv_nsec;
+}
+
+bool NetlinkManager::receiveBatch() {
+	int fd = nl_socket_get_fd(socket);
+	int n;
+
+	memset(rxMessages, 0, sizeof(rxMessages));
+	for (unsigned int i = 0; i < NETLINK_RX_BATCH; i++) {
+		rxMessages[i].msg_hdr.msg_name = &rxAddresses[i];
+		rxMessages[i].msg_hdr.msg_namelen = sizeof(rxAddresses[i]);
+		rxMessages[i].msg_hdr.msg_iov = &rxIovecs[i];
+		rxMessages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// If the last batch was full there are probably more datagrams
+	// queued, so try to receive before waiting
+	if (rxCount < NETLINK_RX_BATCH) {
+		struct epoll_event event;
+
+		n = epoll_wait(epollFd, &event, 1, NETLINK_RX_TIMEOUT_MS);
+		if (n <= 0) {
+			return false;
 		}
 	}
-	else
-		return NULL;
 
-	hdr = (struct nlmsghdr *) buf;
-	nlhdr = (genlmsghdr *) nlmsg_data(hdr);
-	msg = nlmsg_convert(hdr);
-	if (!msg) {
-		LOG_ERR("%s", NetlinkException::error_parsing_netlink_message.c_str());
+	rxCount = 0;
+	rxNext = 0;
+	n = recvmmsg(fd, rxMessages, NETLINK_RX_BATCH, MSG_DONTWAIT, NULL);
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			return false;
+		}
+		__atomic_add_fetch(&stats.errors, 1, __ATOMIC_RELAXED);
+		LOG_ERR("%s %d",
+			NetlinkException::error_receiving_netlink_message.c_str(),
+			errno);
 		throw NetlinkException(
-				NetlinkException::error_parsing_netlink_message);
+			NetlinkException::error_receiving_netlink_message);
 	}
 
-	nlmsg_set_src(msg, &nla);
+	rxCount = n;
+	if (n == 0) {
+		return false;
+	}
 
-	if (creds) {
-		nlmsg_set_creds(msg, creds);
+	unsigned long long bytes = 0;
+	for (int i = 0; i < n; i++) {
+		bytes += rxMessages[i].msg_len;
 	}
+	__atomic_add_fetch(&stats.batches, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stats.datagrams, n, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stats.bytes, bytes, __ATOMIC_RELAXED);
 
+	return true;
+}
+
+BaseNetlinkMessage * NetlinkManager::parseMessage(struct nlmsghdr * hdr,
+		const struct sockaddr_nl& src) {
+	struct genlmsghdr *nlhdr;
+	struct rinaHeader * myHeader;
+
+	nlhdr = (genlmsghdr *) nlmsg_data(hdr);
 	myHeader = (rinaHeader*) genlmsg_data(nlhdr);
-	if(!myHeader){
-		nlmsg_free(msg);
-		free(buf);
-		free(creds);
+	if (hdr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN + sizeof(*myHeader))) {
 		LOG_ERR("%s", NetlinkException::error_parsing_netlink_message.c_str());
 		throw NetlinkException(
 				NetlinkException::error_parsing_netlink_message);
@@ -277,9 +342,6 @@ BaseNetlinkMessage * NetlinkManager::getMessage() {
 	BaseNetlinkMessage * result = parseBaseNetlinkMessage(hdr);
 
 	if (result == NULL) {
-		nlmsg_free(msg);
-		free(buf);
-		free(creds);
 		LOG_ERR("%s", NetlinkException::error_parsing_netlink_message.c_str());
 		throw NetlinkException(
 				NetlinkException::error_parsing_netlink_message);
@@ -298,20 +360,81 @@ BaseNetlinkMessage * NetlinkManager::getMessage() {
 
 	result->setFamily(family);
 	result->setDestPortId(localPort);
-	result->setSourcePortId(nla.nl_pid);
+	result->setSourcePortId(src.nl_pid);
 	result->setSequenceNumber(hdr->nlmsg_seq);
 	result->setSourceIpcProcessId(myHeader->sourceIPCProcessId);
 	result->setDestIpcProcessId(myHeader->destIPCProcessId);
 
-	nlmsg_free(msg);
-	free(buf);
-	free(creds);
+	return result;
+}
 
-    LOG_DBG("NL msg RX. %s ", result->toString().c_str());
+BaseNetlinkMessage * NetlinkManager::getMessage() {
+	struct nlmsghdr *hdr;
+	struct timespec start, end;
+	BaseNetlinkMessage * result;
+	unsigned int current;
+
+	// Find the next message of the batch, receiving a new batch when
+	// this one is exhausted
+	while (!rxHeader || !nlmsg_ok(rxHeader, rxRemaining)) {
+		if (rxNext == rxCount && !receiveBatch()) {
+			return NULL;
+		}
+
+		current = rxNext++;
+		if (rxMessages[current].msg_hdr.msg_flags & MSG_TRUNC) {
+			rxHeader = NULL;
+			__atomic_add_fetch(&stats.errors, 1, __ATOMIC_RELAXED);
+			LOG_ERR("%s: datagram larger than %d bytes",
+				NetlinkException::error_receiving_netlink_message.c_str(),
+				NETLINK_RX_BUFFER_SIZE);
+			throw NetlinkException(
+				NetlinkException::error_receiving_netlink_message);
+		}
+		rxHeader = (struct nlmsghdr *) rxIovecs[current].iov_base;
+		rxRemaining = rxMessages[current].msg_len;
+	}
+
+	// Advance before parsing, so that a parsing error does not
+	// leave the cursor on the offending message
+	hdr = rxHeader;
+	rxHeader = nlmsg_next(rxHeader, &rxRemaining);
+	current = rxNext - 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	try {
+		result = parseMessage(hdr, rxAddresses[current]);
+	} catch (NetlinkException &e) {
+		__atomic_add_fetch(&stats.errors, 1, __ATOMIC_RELAXED);
+		throw e;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	__atomic_add_fetch(&stats.messages, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stats.parse_time_ns, elapsedNs(start, end),
+			   __ATOMIC_RELAXED);
+
+	LOG_DBG("NL msg RX. %s ", result->toString().c_str());
 
 	return result;
 }
 
+NetlinkStatistics NetlinkManager::getStatistics() const {
+	NetlinkStatistics result;
+	struct timespec now;
+
+	result.messages = __atomic_load_n(&stats.messages, __ATOMIC_RELAXED);
+	result.bytes = __atomic_load_n(&stats.bytes, __ATOMIC_RELAXED);
+	result.datagrams = __atomic_load_n(&stats.datagrams, __ATOMIC_RELAXED);
+	result.batches = __atomic_load_n(&stats.batches, __ATOMIC_RELAXED);
+	result.errors = __atomic_load_n(&stats.errors, __ATOMIC_RELAXED);
+	result.parse_time_ns = __atomic_load_n(&stats.parse_time_ns,
+					       __ATOMIC_RELAXED);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	result.elapsed = elapsedNs(statsStart, now) / 1e9;
+
+	return result;
+}
 
 int NetlinkManager::getSocketFd() const {
         return nl_socket_get_fd(socket);
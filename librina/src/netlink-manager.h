@@ -25,6 +25,8 @@
 
 #ifdef __cplusplus
 
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include <netlink/netlink.h>
 
 #include "librina/exceptions.h"
@@ -35,6 +37,19 @@
 #define RINA_GENERIC_NETLINK_FAMILY_NAME "rina"
 #define RINA_GENERIC_NETLINK_FAMILY_VERSION 1
 
+/** Maximum number of datagrams received by a single recvmmsg() call */
+#define NETLINK_RX_BATCH 16
+
+/**
+ * Size of each receive buffer. The buffers are only committed to memory
+ * as the kernel writes to them, so this can be much larger than the usual
+ * message size.
+ */
+#define NETLINK_RX_BUFFER_SIZE (128 * 1024)
+
+/** How long getMessage() waits for a datagram before returning NULL */
+#define NETLINK_RX_TIMEOUT_MS 2000
+
 namespace rina{
 
 /**
@@ -73,10 +88,51 @@ class NetlinkManager{
 	/** The numeric value of the Generic RINA Netlink family */
 	int family;
 
+	/** epoll instance watching the netlink socket */
+	int epollFd;
+
+	/** Receive buffers, NETLINK_RX_BATCH of NETLINK_RX_BUFFER_SIZE bytes */
+	unsigned char * rxBuffers;
+	struct mmsghdr rxMessages[NETLINK_RX_BATCH];
+	struct iovec rxIovecs[NETLINK_RX_BATCH];
+	struct sockaddr_nl rxAddresses[NETLINK_RX_BATCH];
+
+	/** Datagrams received by the last batch */
+	unsigned int rxCount;
+
+	/** Next datagram of the batch to be parsed */
+	unsigned int rxNext;
+
+	/**
+	 * Next message of the datagram being parsed (rxNext - 1) and the
+	 * number of bytes left in it, NULL if the datagram is exhausted
+	 */
+	struct nlmsghdr * rxHeader;
+	int rxRemaining;
+
+	/** Counters, updated by the reader thread only */
+	NetlinkStatistics stats;
+
+	/** When the counters were reset, CLOCK_MONOTONIC */
+	struct timespec statsStart;
+
+	/**
+	 * Reused by sendMessage(), whose callers are serialized by the
+	 * RINAManager, NULL until the first message is sent
+	 */
+	struct nl_msg * txMessage;
+
+	/** Receives the next batch of datagrams, false on timeout */
+	bool receiveBatch();
+
+	/** Parses a message in place, in one of the receive buffers */
+	BaseNetlinkMessage * parseMessage(struct nlmsghdr * hdr,
+					  const struct sockaddr_nl& src);
+
 	/** Creates the Netlink socket and binds it to the netlinkPid */
 	void initialize(bool ipcManager);
 
-	/** Send a Netlink message */
+	/** Send a Netlink message, the caller keeps ownership of the nl_msg */
 	void _sendMessage(BaseNetlinkMessage * message, struct nl_msg* netlinkMessage);
 
 public:
@@ -112,8 +168,16 @@ public:
 
 	void sendMessageOfMaxSize(BaseNetlinkMessage * message, size_t maxSize);
 
+	/**
+	 * Returns the next incoming message, or NULL if none arrived within
+	 * NETLINK_RX_TIMEOUT_MS. Datagrams are received in batches and
+	 * parsed one message per call; only one thread may call this.
+	 */
 	BaseNetlinkMessage *  getMessage();
 
+	/** Returns a snapshot of the receive counters */
+	NetlinkStatistics getStatistics() const;
+
         int getSocketFd() const;
 };
 
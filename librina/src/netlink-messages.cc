@@ -1815,6 +1815,8 @@ IPCEvent* IPCPReadMgmtSDUNotificationMessage::toIPCEvent()
 							size,
 							port_id,
 							getSequenceNumber());
+        //The event owns the SDU now
+        sdu = 0;
         return event;
 }
 
@@ -31,6 +31,8 @@
 
 namespace rina {
 
+template <class T> struct NetlinkSchema;
+
 enum RINANetlinkOperationCode{
 	RINA_C_UNSPEC, /* 0 Unespecified operation */
 	RINA_C_IPCM_ASSIGN_TO_DIF_REQUEST, /* 1 IPC Manager -> IPC Process */
@@ -222,6 +224,8 @@ class AppAllocateFlowRequestMessage: public BaseNetlinkMessage {
 	/** The DIF name where the flow is to be allocated, optional*/
 	ApplicationProcessNamingInformation difName;
 
+	friend struct NetlinkSchema<AppAllocateFlowRequestMessage>;
+
 public:
 	AppAllocateFlowRequestMessage();
 	const ApplicationProcessNamingInformation& getDestAppName() const;
@@ -741,6 +745,8 @@ class IpcmAllocateFlowRequestMessage: public BaseNetlinkMessage {
 	/** The DIF where the Flow is being allocated */
 	ApplicationProcessNamingInformation difName;
 
+	friend struct NetlinkSchema<IpcmAllocateFlowRequestMessage>;
+
 public:
 	IpcmAllocateFlowRequestMessage();
 	const ApplicationProcessNamingInformation& getDestAppName() const;
@@ -1092,6 +1098,8 @@ class RmtModifyPDUFTEntriesRequestMessage: public BaseNetlinkMessage {
         /** 0 add, 1 remove, 2 flush and add */
         int mode;
 
+        friend struct NetlinkSchema<RmtModifyPDUFTEntriesRequestMessage>;
+
 public:
         RmtModifyPDUFTEntriesRequestMessage();
         const std::list<PDUForwardingTableEntry *>& getEntries() const;
@@ -1110,6 +1118,8 @@ class RmtDumpPDUFTEntriesResponseMessage: public BaseNetlinkMessage {
         /** The entries in the table */
         std::list<PDUForwardingTableEntry> entries;
 
+        friend struct NetlinkSchema<RmtDumpPDUFTEntriesResponseMessage>;
+
 public:
         RmtDumpPDUFTEntriesResponseMessage();
         const std::list<PDUForwardingTableEntry>& getEntries() const;
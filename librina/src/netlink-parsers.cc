@@ -25,6 +25,7 @@
 
 #include "librina/logs.h"
 #include "netlink-parsers.h"
+#include "netlink-schema.h"
 
 namespace rina {
 
@@ -726,216 +727,119 @@ BaseNetlinkMessage * parseBaseNetlinkMessage(nlmsghdr* netlinkMessageHeader) {
 	}
 }
 
-int putApplicationProcessNamingInformationObject(nl_msg* netlinkMessage,
-		const ApplicationProcessNamingInformation& object) {
-	NLA_PUT_STRING(netlinkMessage, APNI_ATTR_PROCESS_NAME,
-			object.processName.c_str());
-	NLA_PUT_STRING(netlinkMessage, APNI_ATTR_PROCESS_INSTANCE,
-			object.processInstance.c_str());
-	NLA_PUT_STRING(netlinkMessage, APNI_ATTR_ENTITY_NAME,
-			object.entityName.c_str());
-	NLA_PUT_STRING(netlinkMessage, APNI_ATTR_ENTITY_INSTANCE,
-			object.entityInstance.c_str());
+NETLINK_SCHEMA(ApplicationProcessNamingInformation) {
+	{ APNI_ATTR_PROCESS_NAME,
+	  &NetlinkString<Object, &Object::processName>::codec },
+	{ APNI_ATTR_PROCESS_INSTANCE,
+	  &NetlinkString<Object, &Object::processInstance>::codec },
+	{ APNI_ATTR_ENTITY_NAME,
+	  &NetlinkString<Object, &Object::entityName>::codec },
+	{ APNI_ATTR_ENTITY_INSTANCE,
+	  &NetlinkString<Object, &Object::entityInstance>::codec },
+	{ 0, 0 }
+};
 
-	return 0;
+/*
+ * Encodes an object with its schema, logging the failure like the
+ * hand-written parsers do
+ */
+template <class T>
+static int putSchemaObject(nl_msg* netlinkMessage, const T& object)
+{
+	if (putNetlinkObject(netlinkMessage, object) < 0) {
+		LOG_ERR("Error building %s Netlink object",
+			NetlinkSchema<T>::name);
+		return -1;
+	}
 
-	nla_put_failure: LOG_ERR(
-			"Error building ApplicationProcessNamingInformation Netlink object");
-	return -1;
+	return 0;
 }
 
-ApplicationProcessNamingInformation *
-parseApplicationProcessNamingInformationObject(nlattr *nested) {
-	struct nla_policy attr_policy[APNI_ATTR_MAX + 1];
-	attr_policy[APNI_ATTR_PROCESS_NAME].type = NLA_STRING;
-	attr_policy[APNI_ATTR_PROCESS_NAME].minlen = 0;
-	attr_policy[APNI_ATTR_PROCESS_NAME].maxlen = 65535;
-	attr_policy[APNI_ATTR_PROCESS_INSTANCE].type = NLA_STRING;
-	attr_policy[APNI_ATTR_PROCESS_INSTANCE].minlen = 0;
-	attr_policy[APNI_ATTR_PROCESS_INSTANCE].maxlen = 65535;
-	attr_policy[APNI_ATTR_ENTITY_NAME].type = NLA_STRING;
-	attr_policy[APNI_ATTR_ENTITY_NAME].minlen = 0;
-	attr_policy[APNI_ATTR_ENTITY_NAME].maxlen = 65535;
-	attr_policy[APNI_ATTR_ENTITY_INSTANCE].type = NLA_STRING;
-	attr_policy[APNI_ATTR_ENTITY_INSTANCE].minlen = 0;
-	attr_policy[APNI_ATTR_ENTITY_INSTANCE].maxlen = 65535;
-	struct nlattr *attrs[APNI_ATTR_MAX + 1];
-
-	int err = nla_parse_nested(attrs, APNI_ATTR_MAX, nested, attr_policy);
-	if (err < 0) {
-		LOG_ERR(
-				"Error parsing ApplicationProcessNaming information from Netlink message: %d",
-				err);
-		return NULL;
-	}
+/* Decodes a nested attribute into a new object with its schema */
+template <class T>
+static T * parseSchemaObject(nlattr *nested)
+{
+	T * result = new T();
 
-	ApplicationProcessNamingInformation * result =
-			new ApplicationProcessNamingInformation();
-	if (attrs[APNI_ATTR_PROCESS_NAME]) {
-		result->processName = nla_get_string(attrs[APNI_ATTR_PROCESS_NAME]);
+	if (parseNetlinkNested(nested, *result) < 0) {
+		LOG_ERR("Error parsing %s from Netlink message",
+			NetlinkSchema<T>::name);
+		delete result;
+		return 0;
 	}
 
-	if (attrs[APNI_ATTR_PROCESS_INSTANCE]) {
-		result->processInstance =
-				nla_get_string(attrs[APNI_ATTR_PROCESS_INSTANCE]);
-	}
+	return result;
+}
 
-	if (attrs[APNI_ATTR_ENTITY_NAME]) {
-		result->entityName = nla_get_string(attrs[APNI_ATTR_ENTITY_NAME]);
-	}
+/* Decodes a RINA Netlink message into a new object with its schema */
+template <class T>
+static T * parseSchemaMessage(nlmsghdr *hdr)
+{
+	T * result = new T();
+	int err = parseNetlinkObject(hdr, *result);
 
-	if (attrs[APNI_ATTR_ENTITY_INSTANCE]) {
-		result->entityInstance =
-				nla_get_string(attrs[APNI_ATTR_ENTITY_INSTANCE]);
+	if (err < 0) {
+		LOG_ERR("Error parsing %s information from Netlink message: %d",
+			NetlinkSchema<T>::name, err);
+		delete result;
+		return 0;
 	}
 
 	return result;
 }
 
-int putFlowSpecificationObject(nl_msg* netlinkMessage,
-		const FlowSpecification& object) {
-	if (object.averageBandwidth > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_AVG_BWITH,
-				object.averageBandwidth);
-	}
-	if (object.averageSDUBandwidth > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_AVG_SDU_BWITH,
-				object.averageSDUBandwidth);
-	}
-	if (object.delay > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_DELAY, object.delay);
-	}
-	if (object.jitter > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_JITTER, object.jitter);
-	}
-	if (object.maxAllowableGap >= 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_MAX_GAP,
-				object.maxAllowableGap);
-	}
-	if (object.maxSDUsize > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_MAX_SDU_SIZE,
-				object.maxSDUsize);
-	}
-	if (object.orderedDelivery) {
-		NLA_PUT_FLAG(netlinkMessage, FSPEC_ATTR_IN_ORD_DELIVERY);
-	}
-	if (object.partialDelivery) {
-		NLA_PUT_FLAG(netlinkMessage, FSPEC_ATTR_PART_DELIVERY);
-	}
-	if (object.peakBandwidthDuration > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_PEAK_BWITH_DURATION,
-				object.peakBandwidthDuration);
-	}
-	if (object.peakSDUBandwidthDuration > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_PEAK_SDU_BWITH_DURATION,
-				object.peakSDUBandwidthDuration);
-	}
-	if (object.undetectedBitErrorRate > 0) {
-		NLA_PUT_U32(netlinkMessage, FSPEC_ATTR_UNDETECTED_BER,
-				object.undetectedBitErrorRate);
-	}
+int putApplicationProcessNamingInformationObject(nl_msg* netlinkMessage,
+		const ApplicationProcessNamingInformation& object) {
+	return putSchemaObject(netlinkMessage, object);
+}
 
-	return 0;
+ApplicationProcessNamingInformation *
+parseApplicationProcessNamingInformationObject(nlattr *nested) {
+	return parseSchemaObject<ApplicationProcessNamingInformation>(nested);
+}
+
+NETLINK_SCHEMA(FlowSpecification) {
+	{ FSPEC_ATTR_AVG_BWITH,
+	  &NetlinkU32<Object, unsigned int, &Object::averageBandwidth,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_AVG_SDU_BWITH,
+	  &NetlinkU32<Object, unsigned int, &Object::averageSDUBandwidth,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_DELAY,
+	  &NetlinkU32<Object, unsigned int, &Object::delay,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_JITTER,
+	  &NetlinkU32<Object, unsigned int, &Object::jitter,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_MAX_GAP,
+	  &NetlinkU32<Object, int, &Object::maxAllowableGap,
+		      NL_PUT_IF_NOT_NEGATIVE>::codec },
+	{ FSPEC_ATTR_MAX_SDU_SIZE,
+	  &NetlinkU32<Object, unsigned int, &Object::maxSDUsize,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_IN_ORD_DELIVERY,
+	  &NetlinkFlag<Object, &Object::orderedDelivery>::codec },
+	{ FSPEC_ATTR_PART_DELIVERY,
+	  &NetlinkFlag<Object, &Object::partialDelivery>::codec },
+	{ FSPEC_ATTR_PEAK_BWITH_DURATION,
+	  &NetlinkU32<Object, unsigned int, &Object::peakBandwidthDuration,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_PEAK_SDU_BWITH_DURATION,
+	  &NetlinkU32<Object, unsigned int, &Object::peakSDUBandwidthDuration,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ FSPEC_ATTR_UNDETECTED_BER,
+	  &NetlinkU32<Object, double, &Object::undetectedBitErrorRate,
+		      NL_PUT_IF_POSITIVE>::codec },
+	{ 0, 0 }
+};
 
-	nla_put_failure: LOG_ERR(
-			"Error building ApplicationProcessNamingInformation Netlink object");
-	return -1;
+int putFlowSpecificationObject(nl_msg* netlinkMessage,
+		const FlowSpecification& object) {
+	return putSchemaObject(netlinkMessage, object);
 }
 
 FlowSpecification * parseFlowSpecificationObject(nlattr *nested) {
-	struct nla_policy attr_policy[FSPEC_ATTR_MAX + 1];
-	attr_policy[FSPEC_ATTR_AVG_BWITH].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_AVG_BWITH].minlen = 4;
-	attr_policy[FSPEC_ATTR_AVG_BWITH].maxlen = 4;
-	attr_policy[FSPEC_ATTR_AVG_SDU_BWITH].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_AVG_SDU_BWITH].minlen = 4;
-	attr_policy[FSPEC_ATTR_AVG_SDU_BWITH].maxlen = 4;
-	attr_policy[FSPEC_ATTR_DELAY].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_DELAY].minlen = 4;
-	attr_policy[FSPEC_ATTR_DELAY].maxlen = 4;
-	attr_policy[FSPEC_ATTR_JITTER].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_JITTER].minlen = 4;
-	attr_policy[FSPEC_ATTR_JITTER].maxlen = 4;
-	attr_policy[FSPEC_ATTR_MAX_GAP].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_MAX_GAP].minlen = 4;
-	attr_policy[FSPEC_ATTR_MAX_GAP].maxlen = 4;
-	attr_policy[FSPEC_ATTR_MAX_SDU_SIZE].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_MAX_SDU_SIZE].minlen = 4;
-	attr_policy[FSPEC_ATTR_MAX_SDU_SIZE].maxlen = 4;
-	attr_policy[FSPEC_ATTR_IN_ORD_DELIVERY].type = NLA_FLAG;
-	attr_policy[FSPEC_ATTR_IN_ORD_DELIVERY].minlen = 0;
-	attr_policy[FSPEC_ATTR_IN_ORD_DELIVERY].maxlen = 0;
-	attr_policy[FSPEC_ATTR_PART_DELIVERY].type = NLA_FLAG;
-	attr_policy[FSPEC_ATTR_PART_DELIVERY].minlen = 0;
-	attr_policy[FSPEC_ATTR_PART_DELIVERY].maxlen = 0;
-	attr_policy[FSPEC_ATTR_PEAK_BWITH_DURATION].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_PEAK_BWITH_DURATION].minlen = 4;
-	attr_policy[FSPEC_ATTR_PEAK_BWITH_DURATION].maxlen = 4;
-	attr_policy[FSPEC_ATTR_PEAK_SDU_BWITH_DURATION].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_PEAK_SDU_BWITH_DURATION].minlen = 4;
-	attr_policy[FSPEC_ATTR_PEAK_SDU_BWITH_DURATION].maxlen = 4;
-	attr_policy[FSPEC_ATTR_UNDETECTED_BER].type = NLA_U32;
-	attr_policy[FSPEC_ATTR_UNDETECTED_BER].minlen = 4;
-	attr_policy[FSPEC_ATTR_UNDETECTED_BER].maxlen = 4;
-	struct nlattr *attrs[FSPEC_ATTR_MAX + 1];
-
-	int err = nla_parse_nested(attrs, FSPEC_ATTR_MAX, nested, attr_policy);
-	if (err < 0) {
-		LOG_ERR(
-				"Error parsing FlowSpecification object from Netlink message: %d",
-				err);
-		return NULL;
-	}
-
-	FlowSpecification * result = new FlowSpecification();
-	if (attrs[FSPEC_ATTR_AVG_BWITH]) {
-		result->averageBandwidth = nla_get_u32(attrs[FSPEC_ATTR_AVG_BWITH]);
-	}
-
-	if (attrs[FSPEC_ATTR_AVG_SDU_BWITH]) {
-		result->averageSDUBandwidth =
-				nla_get_u32(attrs[FSPEC_ATTR_AVG_SDU_BWITH]);
-	}
-
-	if (attrs[FSPEC_ATTR_DELAY]) {
-		result->delay = nla_get_u32(attrs[FSPEC_ATTR_DELAY]);
-	}
-
-	if (attrs[FSPEC_ATTR_JITTER]) {
-		result->jitter = nla_get_u32(attrs[FSPEC_ATTR_JITTER]);
-	}
-
-	if (attrs[FSPEC_ATTR_MAX_GAP]) {
-		result->maxAllowableGap = nla_get_u32(attrs[FSPEC_ATTR_MAX_GAP]);
-	}
-
-	if (attrs[FSPEC_ATTR_MAX_SDU_SIZE]) {
-		result->maxSDUsize = nla_get_u32(attrs[FSPEC_ATTR_MAX_SDU_SIZE]);
-	}
-
-	if (attrs[FSPEC_ATTR_IN_ORD_DELIVERY]) {
-		result->orderedDelivery = true;
-	} else {
-		result->orderedDelivery = false;
-	}
-
-	if (attrs[FSPEC_ATTR_PART_DELIVERY]) {
-		result->partialDelivery = true;
-	} else {
-		result->partialDelivery = false;
-	}
-
-	if (attrs[FSPEC_ATTR_PEAK_BWITH_DURATION]) {
-		result->peakBandwidthDuration =
-				nla_get_u32(attrs[FSPEC_ATTR_PEAK_BWITH_DURATION]);
-	}
-
-	if (attrs[FSPEC_ATTR_PEAK_SDU_BWITH_DURATION]) {
-		result->peakSDUBandwidthDuration =
-				nla_get_u32(attrs[FSPEC_ATTR_PEAK_SDU_BWITH_DURATION]);
-	}
-
-	return result;
+	return parseSchemaObject<FlowSpecification>(nested);
 }
 
 QoSCube * parseQoSCubeObject(nlattr *nested) {
@@ -3256,57 +3160,25 @@ Connection * parseConnectionObject(nlattr *nested) {
 }
 
 
+NETLINK_SCHEMA(AppAllocateFlowRequestMessage) {
+	{ AAFR_ATTR_SOURCE_APP_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::sourceAppName>::codec },
+	{ AAFR_ATTR_DEST_APP_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::destAppName>::codec },
+	{ AAFR_ATTR_FLOW_SPEC,
+	  &NetlinkNested<Object, FlowSpecification,
+			 &Object::flowSpecification>::codec },
+	{ AAFR_ATTR_DIF_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::difName>::codec },
+	{ 0, 0 }
+};
+
 int putAppAllocateFlowRequestMessageObject(nl_msg* netlinkMessage,
 		const AppAllocateFlowRequestMessage& object) {
-	struct nlattr *sourceAppName, *destinationAppName, *flowSpec ,
-	              *difName;
-
-	if (!(sourceAppName = nla_nest_start(netlinkMessage,
-			AAFR_ATTR_SOURCE_APP_NAME))) {
-		goto nla_put_failure;
-	}
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-			object.getSourceAppName()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, sourceAppName);
-
-	if (!(destinationAppName = nla_nest_start(netlinkMessage,
-			AAFR_ATTR_DEST_APP_NAME))) {
-		goto nla_put_failure;
-	}
-
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-			object.getDestAppName()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, destinationAppName);
-
-	if (!(flowSpec = nla_nest_start(netlinkMessage, AAFR_ATTR_FLOW_SPEC))) {
-		goto nla_put_failure;
-	}
-
-	if (putFlowSpecificationObject(netlinkMessage,
-			object.getFlowSpecification()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, flowSpec);
-
-	if (!(difName = nla_nest_start(netlinkMessage,
-	                AAFR_ATTR_DIF_NAME))) {
-	        goto nla_put_failure;
-	}
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-	                object.getDifName()) < 0) {
-	        goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, difName);
-
-	return 0;
-
-	nla_put_failure: LOG_ERR(
-			"Error building AppAllocateFlowRequestMessage Netlink object");
-	return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
 int putAppAllocateFlowRequestResultMessageObject(nl_msg* netlinkMessage,
@@ -4589,50 +4461,24 @@ int putIpcmEnrollToDIFResponseMessageObject(nl_msg* netlinkMessage,
         return -1;
 }
 
+NETLINK_SCHEMA(IpcmAllocateFlowRequestMessage) {
+	{ IAFRM_ATTR_SOURCE_APP_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::sourceAppName>::codec },
+	{ IAFRM_ATTR_DEST_APP_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::destAppName>::codec },
+	{ IAFRM_ATTR_FLOW_SPEC,
+	  &NetlinkNested<Object, FlowSpecification, &Object::flowSpec>::codec },
+	{ IAFRM_ATTR_DIF_NAME,
+	  &NetlinkNested<Object, ApplicationProcessNamingInformation,
+			 &Object::difName>::codec },
+	{ 0, 0 }
+};
+
 int putIpcmAllocateFlowRequestMessageObject(nl_msg* netlinkMessage,
 		const IpcmAllocateFlowRequestMessage& object){
-	struct nlattr *sourceName, *destName, *flowSpec, *difName;
-
-	if (!(sourceName = nla_nest_start(netlinkMessage, IAFRM_ATTR_SOURCE_APP_NAME))){
-		goto nla_put_failure;
-	}
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-			object.getSourceAppName()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, sourceName);
-
-	if (!(destName = nla_nest_start(netlinkMessage, IAFRM_ATTR_DEST_APP_NAME))){
-		goto nla_put_failure;
-	}
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-			object.getDestAppName()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, destName);
-
-	if (!(flowSpec = nla_nest_start(netlinkMessage, IAFRM_ATTR_FLOW_SPEC))){
-		goto nla_put_failure;
-	}
-	if (putFlowSpecificationObject(netlinkMessage, object.getFlowSpec()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, flowSpec);
-
-	if (!(difName = nla_nest_start(netlinkMessage, IAFRM_ATTR_DIF_NAME))){
-		goto nla_put_failure;
-	}
-	if (putApplicationProcessNamingInformationObject(netlinkMessage,
-			object.getDifName()) < 0) {
-		goto nla_put_failure;
-	}
-	nla_nest_end(netlinkMessage, difName);
-
-	return 0;
-
-	nla_put_failure: LOG_ERR(
-			"Error building IpcmAllocateFlowRequestMessage Netlink object");
-	return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
 int putIpcmAllocateFlowRequestArrivedMessageObject(nl_msg* netlinkMessage,
@@ -4948,171 +4794,58 @@ int putIpcpConnectionCreateResultMessageObject(nl_msg* netlinkMessage,
         return -1;
 }
 
+NETLINK_SCHEMA(PortIdAltlist) {
+	{ PIA_ATTR_PORT_IDS, &NetlinkU32List<Object, &Object::alts>::codec },
+	{ 0, 0 }
+};
+
 int putPortIdAltlist(nl_msg* netlinkMessage, const PortIdAltlist& object)
 {
-	struct nlattr * portIds;
-	std::list<unsigned int>::const_iterator it;
-	int i = 0;
-
-	if (!(portIds = nla_nest_start(netlinkMessage, PIA_ATTR_PORT_IDS ))) {
-		goto nla_put_failure;
-	}
-
-	for (it = object.alts.begin(); it != object.alts.end(); it++, i++) {
-		NLA_PUT_U32(netlinkMessage, i, *it);
-	}
-
-        nla_nest_end(netlinkMessage, portIds);
-	return 0;
-
-        nla_put_failure:
-		LOG_ERR("Error building PDUForwardingTableEntry Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
+NETLINK_SCHEMA(PDUForwardingTableEntry) {
+	{ PFTE_ATTR_ADDRESS,
+	  &NetlinkU32<Object, unsigned int, &Object::address>::codec },
+	{ PFTE_ATTR_QOS_ID,
+	  &NetlinkU32<Object, unsigned int, &Object::qosId>::codec },
+	{ PFTE_ATTR_PORT_ID_ALTLISTS,
+	  &NetlinkObjectList<Object, PortIdAltlist,
+			     &Object::portIdAltlists>::codec },
+	{ 0, 0 }
+};
+
 int putPDUForwardingTableEntryObject(nl_msg* netlinkMessage,
               const PDUForwardingTableEntry& object) {
-        struct nlattr * portIdAltlists;
-        std::list<PortIdAltlist>::const_iterator iterator;
-        const std::list<PortIdAltlist> portIdsList = object.getPortIdAltlists();
-        int i = 0;
-
-        NLA_PUT_U32(netlinkMessage, PFTE_ATTR_ADDRESS, object.getAddress());
-        NLA_PUT_U32(netlinkMessage, PFTE_ATTR_QOS_ID, object.getQosId());
-
-        if (!(portIdAltlists = nla_nest_start(netlinkMessage,
-					  PFTE_ATTR_PORT_ID_ALTLISTS))) {
-                goto nla_put_failure;
-        }
-
-        for (iterator = portIdsList.begin();
-                        iterator != portIdsList.end();
-                        ++iterator, ++i) {
-		struct nlattr * portIdAlt;
-
-		if (!(portIdAlt = nla_nest_start(netlinkMessage, i))) {
-			goto nla_put_failure;
-		}
-
-		if (putPortIdAltlist(netlinkMessage, *iterator)) {
-			goto nla_put_failure;
-		}
-
-		nla_nest_end(netlinkMessage, portIdAlt);
-        }
-
-        nla_nest_end(netlinkMessage, portIdAltlists);
-        return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building PDUForwardingTableEntry Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
-int putListOfPFTEntries(nl_msg* netlinkMessage,
-                const std::list<PDUForwardingTableEntry *>& entries){
-        std::list<PDUForwardingTableEntry *>::const_iterator iterator;
-        struct nlattr *entry;
-        int i = 0;
-
-        for (iterator = entries.begin();
-                        iterator != entries.end();
-                        ++iterator) {
-                if (!(entry = nla_nest_start(netlinkMessage, i))){
-                        goto nla_put_failure;
-                }
-                if (putPDUForwardingTableEntryObject(netlinkMessage,
-                                *(*iterator)) < 0) {
-                        goto nla_put_failure;
-                }
-                nla_nest_end(netlinkMessage, entry);
-                i++;
-        }
-
-        return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building putPDUForwardingTableEntryObject Netlink object");
-        return -1;
-}
-
-int putListOfPFTEntries(nl_msg* netlinkMessage,
-                const std::list<PDUForwardingTableEntry>& entries){
-        std::list<PDUForwardingTableEntry>::const_iterator iterator;
-        struct nlattr *entry;
-        int i = 0;
-
-        for (iterator = entries.begin();
-                        iterator != entries.end();
-                        ++iterator) {
-                if (!(entry = nla_nest_start(netlinkMessage, i))){
-                        goto nla_put_failure;
-                }
-                if (putPDUForwardingTableEntryObject(netlinkMessage,
-                                *iterator) < 0) {
-                        goto nla_put_failure;
-                }
-                nla_nest_end(netlinkMessage, entry);
-                i++;
-        }
-
-        return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building putPDUForwardingTableEntryObject Netlink object");
-        return -1;
-}
+NETLINK_SCHEMA(RmtModifyPDUFTEntriesRequestMessage) {
+	{ RMPFTE_ATTR_ENTRIES,
+	  &NetlinkObjectList<Object, PDUForwardingTableEntry *,
+			     &Object::entries>::codec },
+	{ RMPFTE_ATTR_MODE, &NetlinkU32<Object, int, &Object::mode>::codec },
+	{ 0, 0 }
+};
 
 int putRmtModifyPDUFTEntriesRequestObject(nl_msg* netlinkMessage,
                 const RmtModifyPDUFTEntriesRequestMessage& object) {
-        struct nlattr *entries;
-
-        if (!(entries =
-                        nla_nest_start(netlinkMessage, RMPFTE_ATTR_ENTRIES))) {
-                goto nla_put_failure;
-        }
-
-        if (object.getEntries().size() > 0) {
-                if (putListOfPFTEntries(netlinkMessage,
-                                object.getEntries()) < 0) {
-                        goto nla_put_failure;
-                }
-        }
-
-        nla_nest_end(netlinkMessage, entries);
-
-        NLA_PUT_U32(netlinkMessage, RMPFTE_ATTR_MODE, object.getMode());
-
-        return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building RmtModifyPDUFTEntriesRequestMessage Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
+NETLINK_SCHEMA(RmtDumpPDUFTEntriesResponseMessage) {
+	{ RDPFTE_ATTR_RESULT,
+	  &NetlinkU32<BaseNetlinkMessage, int, &BaseNetlinkMessage::result,
+		      NL_PUT_ALWAYS, Object>::codec },
+	{ RDPFTE_ATTR_ENTRIES,
+	  &NetlinkObjectList<Object, PDUForwardingTableEntry,
+			     &Object::entries>::codec },
+	{ 0, 0 }
+};
+
 int putRmtDumpPDUFTEntriesResponseObject(nl_msg* netlinkMessage,
                 const RmtDumpPDUFTEntriesResponseMessage& object) {
-        struct nlattr *entries;
-
-        NLA_PUT_U32(netlinkMessage, RDPFTE_ATTR_RESULT, object.result);
-
-        if (!(entries =
-                        nla_nest_start(netlinkMessage, RDPFTE_ATTR_ENTRIES))) {
-                goto nla_put_failure;
-        }
-
-        if (putListOfPFTEntries(netlinkMessage,
-                        object.getEntries()) < 0) {
-                goto nla_put_failure;
-        }
-
-        nla_nest_end(netlinkMessage, entries);
-
-        return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building RmtDumpPDUFTEntriesResponseMessage Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
 int putIpcmSetPolicySetParamRequestMessageObject(nl_msg* netlinkMessage,
@@ -5276,43 +5009,34 @@ int putIPCPAllocatePortRequestMessage(nl_msg* netlinkMessage,
         return -1;
 }
 
+NETLINK_SCHEMA(IPCPWriteMgmtSDURequestMessage) {
+	{ IWMSRM_ATTR_SDU,
+	  &NetlinkBinary<Object, &Object::sdu, &Object::size>::codec },
+	{ IWMSRM_ATTR_PORT_ID,
+	  &NetlinkU32<Object, unsigned int, &Object::port_id>::codec },
+	{ IWMSRM_ATTR_ADDRESS,
+	  &NetlinkU32<Object, unsigned int, &Object::address>::codec },
+	{ 0, 0 }
+};
+
 int putIPCPWriteMgmtSDURequestMessage(nl_msg* netlinkMessage,
                 		      const IPCPWriteMgmtSDURequestMessage& object)
 {
-	if (object.sdu) {
-		NLA_PUT(netlinkMessage,
-			IWMSRM_ATTR_SDU,
-			object.size,
-			object.sdu);
-	}
-	NLA_PUT_U32(netlinkMessage, IWMSRM_ATTR_PORT_ID, object.port_id);
-	NLA_PUT_U32(netlinkMessage, IWMSRM_ATTR_ADDRESS, object.address);
-
-	return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building IPCPWriteMgmtSDURequestMessage"
-                        "Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
+NETLINK_SCHEMA(IPCPReadMgmtSDUNotificationMessage) {
+	{ IRMSREM_ATTR_SDU,
+	  &NetlinkBinary<Object, &Object::sdu, &Object::size>::codec },
+	{ IRMSREM_ATTR_PORT_ID,
+	  &NetlinkU32<Object, unsigned int, &Object::port_id>::codec },
+	{ 0, 0 }
+};
+
 int putIPCPReadMgmtSDUNotificationMessage(nl_msg* netlinkMessage,
                 		         const IPCPReadMgmtSDUNotificationMessage& object)
 {
-	if (object.sdu) {
-		NLA_PUT(netlinkMessage,
-			IRMSREM_ATTR_SDU,
-			object.size,
-			object.sdu);
-	}
-	NLA_PUT_U32(netlinkMessage, IRMSREM_ATTR_PORT_ID, object.port_id);
-
-	return 0;
-
-        nla_put_failure: LOG_ERR(
-                        "Error building IPCPReadMgmtSDUNotificationMessage"
-                        "Netlink object");
-        return -1;
+	return putSchemaObject(netlinkMessage, object);
 }
 
 int putIpcmCreateIPCPRequestMessage(nl_msg* netlinkMessage,
@@ -5565,91 +5289,7 @@ int putIpcmMediaReportMessageObject(nl_msg* netlinkMessage,
 
 AppAllocateFlowRequestMessage * parseAppAllocateFlowRequestMessage(
 		nlmsghdr *hdr) {
-	struct nla_policy attr_policy[AAFR_ATTR_MAX + 1];
-	attr_policy[AAFR_ATTR_SOURCE_APP_NAME].type = NLA_NESTED;
-	attr_policy[AAFR_ATTR_SOURCE_APP_NAME].minlen = 0;
-	attr_policy[AAFR_ATTR_SOURCE_APP_NAME].maxlen = 0;
-	attr_policy[AAFR_ATTR_DEST_APP_NAME].type = NLA_NESTED;
-	attr_policy[AAFR_ATTR_DEST_APP_NAME].minlen = 0;
-	attr_policy[AAFR_ATTR_DEST_APP_NAME].maxlen = 0;
-	attr_policy[AAFR_ATTR_FLOW_SPEC].type = NLA_NESTED;
-	attr_policy[AAFR_ATTR_FLOW_SPEC].minlen = 0;
-	attr_policy[AAFR_ATTR_FLOW_SPEC].maxlen = 0;
-	attr_policy[AAFR_ATTR_DIF_NAME].type = NLA_NESTED;
-	attr_policy[AAFR_ATTR_DIF_NAME].minlen = 0;
-	attr_policy[AAFR_ATTR_DIF_NAME].maxlen = 0;
-	struct nlattr *attrs[AAFR_ATTR_MAX + 1];
-
-	/*
-	 * The nlmsg_parse() function will make sure that the message contains
-	 * enough payload to hold the header (struct my_hdr), validates any
-	 * attributes attached to the messages and stores a pointer to each
-	 * attribute in the attrs[] array accessable by attribute type.
-	 */
-	int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-			AAFR_ATTR_MAX, attr_policy);
-	if (err < 0) {
-		LOG_ERR(
-				"Error parsing AppAllocateFlowRequestMessage information from Netlink message: %d",
-				err);
-		return 0;
-	}
-
-	AppAllocateFlowRequestMessage * result =
-			new AppAllocateFlowRequestMessage();
-	ApplicationProcessNamingInformation * sourceName;
-	ApplicationProcessNamingInformation * destName;
-	FlowSpecification * flowSpec;
-	ApplicationProcessNamingInformation * difName;
-
-	if (attrs[AAFR_ATTR_SOURCE_APP_NAME]) {
-		sourceName = parseApplicationProcessNamingInformationObject(
-				attrs[AAFR_ATTR_SOURCE_APP_NAME]);
-		if (sourceName == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setSourceAppName(*sourceName);
-			delete sourceName;
-		}
-	}
-
-	if (attrs[AAFR_ATTR_DEST_APP_NAME]) {
-		destName = parseApplicationProcessNamingInformationObject(
-				attrs[AAFR_ATTR_DEST_APP_NAME]);
-		if (destName == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setDestAppName(*destName);
-			delete destName;
-		}
-	}
-
-	if (attrs[AAFR_ATTR_FLOW_SPEC]) {
-		flowSpec = parseFlowSpecificationObject(attrs[AAFR_ATTR_FLOW_SPEC]);
-		if (flowSpec == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setFlowSpecification(*flowSpec);
-			delete flowSpec;
-		}
-	}
-
-	if (attrs[AAFR_ATTR_DIF_NAME]) {
-	        difName = parseApplicationProcessNamingInformationObject(
-	                        attrs[AAFR_ATTR_DIF_NAME]);
-	        if (difName == 0) {
-	                delete result;
-	                return 0;
-	        } else {
-	                result->setDifName(*difName);
-	                delete difName;
-	        }
-	}
-
-	return result;
+	return parseSchemaMessage<AppAllocateFlowRequestMessage>(hdr);
 }
 
 AppAllocateFlowRequestResultMessage * parseAppAllocateFlowRequestResultMessage(
@@ -7886,85 +7526,7 @@ parseIpcmDisconnectNeighborRequestMessage(nlmsghdr *hdr) {
 
 IpcmAllocateFlowRequestMessage *
 	parseIpcmAllocateFlowRequestMessage(nlmsghdr *hdr){
-	struct nla_policy attr_policy[IAFRM_ATTR_MAX + 1];
-	attr_policy[IAFRM_ATTR_SOURCE_APP_NAME].type = NLA_NESTED;
-	attr_policy[IAFRM_ATTR_SOURCE_APP_NAME].minlen = 0;
-	attr_policy[IAFRM_ATTR_SOURCE_APP_NAME].maxlen = 0;
-	attr_policy[IAFRM_ATTR_DEST_APP_NAME].type = NLA_NESTED;
-	attr_policy[IAFRM_ATTR_DEST_APP_NAME].minlen = 0;
-	attr_policy[IAFRM_ATTR_DEST_APP_NAME].maxlen = 0;
-	attr_policy[IAFRM_ATTR_FLOW_SPEC].type = NLA_NESTED;
-	attr_policy[IAFRM_ATTR_FLOW_SPEC].minlen = 0;
-	attr_policy[IAFRM_ATTR_FLOW_SPEC].maxlen = 0;
-	attr_policy[IAFRM_ATTR_DIF_NAME].type = NLA_NESTED;
-	attr_policy[IAFRM_ATTR_DIF_NAME].minlen = 0;
-	attr_policy[IAFRM_ATTR_DIF_NAME].maxlen = 0;
-	struct nlattr *attrs[IAFRM_ATTR_MAX + 1];
-
-	int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-			IAFRM_ATTR_MAX, attr_policy);
-	if (err < 0) {
-		LOG_ERR(
-				"Error parsing IpcmAssignToDIFRequestMessage information from Netlink message: %d",
-				err);
-		return 0;
-	}
-
-	IpcmAllocateFlowRequestMessage * result =
-			new IpcmAllocateFlowRequestMessage();
-	ApplicationProcessNamingInformation * sourceName;
-	ApplicationProcessNamingInformation * destName;
-	FlowSpecification * flowSpec;
-	ApplicationProcessNamingInformation * difName;
-
-	if (attrs[IAFRM_ATTR_SOURCE_APP_NAME]) {
-		sourceName = parseApplicationProcessNamingInformationObject(
-				attrs[IAFRM_ATTR_SOURCE_APP_NAME]);
-		if (sourceName == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setSourceAppName(*sourceName);
-			delete sourceName;
-		}
-	}
-
-	if (attrs[IAFRM_ATTR_DEST_APP_NAME]) {
-		destName = parseApplicationProcessNamingInformationObject(
-				attrs[IAFRM_ATTR_DEST_APP_NAME]);
-		if (destName == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setDestAppName(*destName);
-			delete destName;
-		}
-	}
-
-	if (attrs[IAFRM_ATTR_FLOW_SPEC]) {
-		flowSpec = parseFlowSpecificationObject(attrs[IAFRM_ATTR_FLOW_SPEC]);
-		if (flowSpec == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setFlowSpec(*flowSpec);
-			delete flowSpec;
-		}
-	}
-
-	if (attrs[IAFRM_ATTR_DIF_NAME]) {
-		difName = parseApplicationProcessNamingInformationObject(
-				attrs[IAFRM_ATTR_DIF_NAME]);
-		if (difName == 0) {
-			delete result;
-			return 0;
-		} else {
-			result->setDifName(*difName);
-			delete difName;
-		}
-	}
-
-	return result;
+	return parseSchemaMessage<IpcmAllocateFlowRequestMessage>(hdr);
 }
 
 IpcmAllocateFlowRequestArrivedMessage * parseIpcmAllocateFlowRequestArrivedMessage(
@@ -8642,224 +8204,28 @@ IpcpConnectionCreateResultMessage * parseIpcpConnectionCreateResultMessage(
 
 int parsePortIdAltlist(nlattr *nested, PortIdAltlist& portIdAlt)
 {
-        struct nla_policy attr_policy[PIA_ATTR_MAX + 1];
-        attr_policy[PIA_ATTR_PORT_IDS].type = NLA_NESTED;
-        attr_policy[PIA_ATTR_PORT_IDS].minlen = 0;
-        attr_policy[PIA_ATTR_PORT_IDS].maxlen = 0;
-        struct nlattr *attrs[PIA_ATTR_MAX + 1];
-	int err = nla_parse_nested(attrs, PIA_ATTR_MAX, nested, attr_policy);
-
-        if (err < 0) {
-                LOG_ERR("Error parsing PortIdAltlist from Netlink message: %d",
-                        err);
-                return err;
-        }
+	int err = parseNetlinkNested(nested, portIdAlt);
 
-	if (attrs[PIA_ATTR_PORT_IDS]) {
-		nlattr * nla;
-		int rem;
-
-		for (nla = (nlattr*) nla_data(nested), rem = nla_len(nested);
-				nla_ok(nla, rem);
-				nla = nla_next(nla, &(rem))){
-			portIdAlt.add_alt(nla_get_u32(nla));
-		}
-
-		if (rem > 0){
-			LOG_WARN("Missing bits to parse");
-		}
+	if (err < 0) {
+		LOG_ERR("Error parsing PortIdAltlist from Netlink message: %d",
+			err);
 	}
 
-        return 0;
-}
-
-int parseListOfPortIdAltlists(nlattr *nested, PDUForwardingTableEntry * entry) {
-        nlattr * nla;
-        int rem;
-
-        for (nla = (nlattr*) nla_data(nested), rem = nla_len(nested);
-                        nla_ok(nla, rem);
-                        nla = nla_next(nla, &(rem))){
-		int err;
-
-		entry->portIdAltlists.push_back(PortIdAltlist());
-		err = parsePortIdAltlist(nla, entry->portIdAltlists.back());
-		if (err) {
-			return err;
-		}
-        }
-
-        if (rem > 0){
-                LOG_WARN("Missing bits to parse");
-        }
-
-        return 0;
+	return err;
 }
 
 PDUForwardingTableEntry * parsePDUForwardingTableEntry(nlattr *nested) {
-        struct nla_policy attr_policy[PFTE_ATTR_MAX + 1];
-        attr_policy[PFTE_ATTR_ADDRESS].type = NLA_U32;
-        attr_policy[PFTE_ATTR_ADDRESS].minlen = 4;
-        attr_policy[PFTE_ATTR_ADDRESS].maxlen = 4;
-        attr_policy[PFTE_ATTR_QOS_ID].type = NLA_U32;
-        attr_policy[PFTE_ATTR_QOS_ID].minlen = 4;
-        attr_policy[PFTE_ATTR_QOS_ID].maxlen = 4;
-        attr_policy[PFTE_ATTR_PORT_ID_ALTLISTS].type = NLA_NESTED;
-        attr_policy[PFTE_ATTR_PORT_ID_ALTLISTS].minlen = 0;
-        attr_policy[PFTE_ATTR_PORT_ID_ALTLISTS].maxlen = 0;
-        struct nlattr *attrs[PFTE_ATTR_MAX + 1];
-
-        int err = nla_parse_nested(attrs, PFTE_ATTR_MAX, nested, attr_policy);
-        if (err < 0) {
-                LOG_ERR("Error parsing PDUForwardingTableEntry from Netlink message: %d",
-                        err);
-                return 0;
-        }
-
-        PDUForwardingTableEntry * result = new PDUForwardingTableEntry();
-
-        if (attrs[PFTE_ATTR_ADDRESS]){
-                result->setAddress(
-                                nla_get_u32(attrs[PFTE_ATTR_ADDRESS]));
-        }
-
-        if (attrs[PFTE_ATTR_QOS_ID]){
-                result->setQosId(
-                                nla_get_u32(attrs[PFTE_ATTR_QOS_ID]));
-        }
-
-        if (attrs[PFTE_ATTR_PORT_ID_ALTLISTS]){
-                parseListOfPortIdAltlists(attrs[PFTE_ATTR_PORT_ID_ALTLISTS], result);
-        }
-
-        return result;
-}
-
-int parseListOfPDUFTEntries(nlattr *nested,
-                RmtModifyPDUFTEntriesRequestMessage * message){
-        nlattr * nla;
-        int rem;
-        PDUForwardingTableEntry * pfte;
-
-        for (nla = (nlattr*) nla_data(nested), rem = nla_len(nested);
-                     nla_ok(nla, rem);
-                     nla = nla_next(nla, &(rem))){
-                /* validate & parse attribute */
-                pfte = parsePDUForwardingTableEntry(nla);
-                if (pfte == 0){
-                        return -1;
-                }
-                message->addEntry(pfte);
-        }
-
-        if (rem > 0){
-                LOG_WARN("Missing bits to parse");
-        }
-
-        return 0;
+	return parseSchemaObject<PDUForwardingTableEntry>(nested);
 }
 
 RmtModifyPDUFTEntriesRequestMessage * parseRmtModifyPDUFTEntriesRequestMessage(
                 nlmsghdr *hdr) {
-        struct nla_policy attr_policy[RMPFTE_ATTR_MAX + 1];
-        attr_policy[RMPFTE_ATTR_ENTRIES].type = NLA_NESTED;
-        attr_policy[RMPFTE_ATTR_ENTRIES].minlen = 0;
-        attr_policy[RMPFTE_ATTR_ENTRIES].maxlen = 0;
-        attr_policy[RMPFTE_ATTR_MODE].type = NLA_U32;
-        attr_policy[RMPFTE_ATTR_MODE].minlen = 4;
-        attr_policy[RMPFTE_ATTR_MODE].maxlen = 4;
-        struct nlattr *attrs[RMPFTE_ATTR_MAX + 1];
-
-        int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-                        RMPFTE_ATTR_MAX, attr_policy);
-        if (err < 0) {
-                LOG_ERR("Error parsing RmtModifyPDUFTEntriesRequestMessage information from Netlink message: %d",
-                         err);
-                return 0;
-        }
-
-        RmtModifyPDUFTEntriesRequestMessage * result =
-                        new RmtModifyPDUFTEntriesRequestMessage();
-
-        if (attrs[RMPFTE_ATTR_MODE]){
-                result->setMode(nla_get_u32(attrs[RMPFTE_ATTR_MODE]));
-        }
-
-        int status = 0;
-        if (attrs[RMPFTE_ATTR_ENTRIES]) {
-                status = parseListOfPDUFTEntries(
-                                attrs[RMPFTE_ATTR_ENTRIES], result);
-                if (status != 0){
-                        delete result;
-                        return 0;
-                }
-        }
-
-        return result;
-}
-
-int parseListOfPDUFTEntries2(nlattr *nested,
-                RmtDumpPDUFTEntriesResponseMessage * message){
-        nlattr * nla;
-        int rem;
-        PDUForwardingTableEntry * pfte;
-
-        for (nla = (nlattr*) nla_data(nested), rem = nla_len(nested);
-                     nla_ok(nla, rem);
-                     nla = nla_next(nla, &(rem))){
-                /* validate & parse attribute */
-                pfte = parsePDUForwardingTableEntry(nla);
-                if (pfte == 0){
-                        return -1;
-                }
-                message->addEntry(*pfte);
-                delete pfte;
-        }
-
-        if (rem > 0){
-                LOG_WARN("Missing bits to parse");
-        }
-
-        return 0;
+	return parseSchemaMessage<RmtModifyPDUFTEntriesRequestMessage>(hdr);
 }
 
 RmtDumpPDUFTEntriesResponseMessage * parseRmtDumpPDUFTEntriesResponseMessage(
                 nlmsghdr *hdr) {
-        struct nla_policy attr_policy[RDPFTE_ATTR_MAX + 1];
-        attr_policy[RDPFTE_ATTR_RESULT].type = NLA_U32;
-        attr_policy[RDPFTE_ATTR_RESULT].minlen = 4;
-        attr_policy[RDPFTE_ATTR_RESULT].maxlen = 4;
-        attr_policy[RDPFTE_ATTR_ENTRIES].type = NLA_NESTED;
-        attr_policy[RDPFTE_ATTR_ENTRIES].minlen = 0;
-        attr_policy[RDPFTE_ATTR_ENTRIES].maxlen = 0;
-        struct nlattr *attrs[RDPFTE_ATTR_MAX + 1];
-
-        int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-                        RDPFTE_ATTR_MAX, attr_policy);
-        if (err < 0) {
-                LOG_ERR("Error parsing RmtDumpPDUFTEntriesResponseMessage information from Netlink message: %d",
-                         err);
-                return 0;
-        }
-
-        RmtDumpPDUFTEntriesResponseMessage * result =
-                        new RmtDumpPDUFTEntriesResponseMessage();
-
-        if (attrs[RDPFTE_ATTR_RESULT]){
-                result->result = nla_get_u32(attrs[RDPFTE_ATTR_RESULT]);
-        }
-
-        int status = 0;
-        if (attrs[RDPFTE_ATTR_ENTRIES]) {
-                status = parseListOfPDUFTEntries2(
-                                attrs[RDPFTE_ATTR_ENTRIES], result);
-                if (status != 0){
-                        delete result;
-                        return 0;
-                }
-        }
-
-        return result;
+	return parseSchemaMessage<RmtDumpPDUFTEntriesResponseMessage>(hdr);
 }
 
 IpcmSetPolicySetParamRequestMessage *
@@ -9193,81 +8559,12 @@ IPCPAllocatePortRequestMessage * parseIPCPAllocatePortRequestMessage(nlmsghdr *h
 
 IPCPWriteMgmtSDURequestMessage * parseIPCPWriteMgmtSDURequestMessage(nlmsghdr *hdr)
 {
-	struct nla_policy attr_policy[IWMSRM_ATTR_MAX + 1];
-        attr_policy[IWMSRM_ATTR_SDU].type = NLA_UNSPEC;
-        attr_policy[IWMSRM_ATTR_SDU].minlen = 0;
-        attr_policy[IWMSRM_ATTR_SDU].maxlen = 65535;
-        attr_policy[IWMSRM_ATTR_PORT_ID].type = NLA_U32;
-        attr_policy[IWMSRM_ATTR_PORT_ID].minlen = 4;
-        attr_policy[IWMSRM_ATTR_PORT_ID].maxlen = 4;
-        attr_policy[IWMSRM_ATTR_ADDRESS].type = NLA_U32;
-        attr_policy[IWMSRM_ATTR_ADDRESS].minlen = 4;
-        attr_policy[IWMSRM_ATTR_ADDRESS].maxlen = 4;
-	struct nlattr *attrs[IWMSRM_ATTR_MAX + 1];
-
-	int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-			IWMSRM_ATTR_MAX, attr_policy);
-	if (err < 0) {
-		LOG_ERR("Error parsing IPCPWriteMgmtSDURequestMessage "
-                        "information from Netlink message: %d", err);
-		return 0;
-	}
-
-	IPCPWriteMgmtSDURequestMessage * result =
-			new IPCPWriteMgmtSDURequestMessage();
-
-	if (attrs[IWMSRM_ATTR_SDU]) {
-		result->size = nla_len(attrs[IWMSRM_ATTR_SDU]);
-		result->sdu = new unsigned char[result->size];
-		unsigned char * data = (unsigned char *) nla_data(attrs[IWMSRM_ATTR_SDU]);
-		memcpy(result->sdu, data, result->size);
-	}
-
-	if (attrs[IWMSRM_ATTR_PORT_ID]) {
-		result->port_id = nla_get_u32(attrs[IWMSRM_ATTR_PORT_ID]);
-	}
-
-	if (attrs[IWMSRM_ATTR_ADDRESS]) {
-		result->address = nla_get_u32(attrs[IWMSRM_ATTR_ADDRESS]);
-	}
-
-	return result;
+	return parseSchemaMessage<IPCPWriteMgmtSDURequestMessage>(hdr);
 }
 
 IPCPReadMgmtSDUNotificationMessage * parseIPCPReadMgmtSDUNotificationMessage(nlmsghdr *hdr)
 {
-	struct nla_policy attr_policy[IRMSREM_ATTR_MAX + 1];
-        attr_policy[IRMSREM_ATTR_SDU].type = NLA_UNSPEC;
-        attr_policy[IRMSREM_ATTR_SDU].minlen = 0;
-        attr_policy[IRMSREM_ATTR_SDU].maxlen = 65535;
-        attr_policy[IRMSREM_ATTR_PORT_ID].type = NLA_U32;
-        attr_policy[IRMSREM_ATTR_PORT_ID].minlen = 4;
-        attr_policy[IRMSREM_ATTR_PORT_ID].maxlen = 4;
-	struct nlattr *attrs[IRMSREM_ATTR_MAX + 1];
-
-	int err = genlmsg_parse(hdr, sizeof(struct rinaHeader), attrs,
-			IRMSREM_ATTR_MAX, attr_policy);
-	if (err < 0) {
-		LOG_ERR("Error parsing IPCPReadMgmtSDUNotificationMessage "
-                        "information from Netlink message: %d", err);
-		return 0;
-	}
-
-	IPCPReadMgmtSDUNotificationMessage * result =
-			new IPCPReadMgmtSDUNotificationMessage();
-
-	if (attrs[IRMSREM_ATTR_SDU]) {
-		result->size = nla_len(attrs[IRMSREM_ATTR_SDU]);
-		result->sdu = new unsigned char[result->size];
-		unsigned char * data = (unsigned char *) nla_data(attrs[IRMSREM_ATTR_SDU]);
-		memcpy(result->sdu, data, result->size);
-	}
-
-	if (attrs[IRMSREM_ATTR_PORT_ID]) {
-		result->port_id = nla_get_u32(attrs[IRMSREM_ATTR_PORT_ID]);
-	}
-
-	return result;
+	return parseSchemaMessage<IPCPReadMgmtSDUNotificationMessage>(hdr);
 }
 
 IpcmCreateIPCPRequestMessage * parseIpcmCreateIPCPRequestMessage(nlmsghdr *hdr)
@@ -0,0 +1,469 @@
+/*
+ * Table-driven Netlink attribute encoding and decoding
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#ifndef LIBRINA_NETLINK_SCHEMA_H
+#define LIBRINA_NETLINK_SCHEMA_H
+
+#ifdef __cplusplus
+
+#include <cstring>
+#include <list>
+#include <string>
+
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <netlink/genl/genl.h>
+
+#include "netlink-messages.h"
+
+/*
+ * The attributes of a type are described by a static table mapping each
+ * attribute id to a codec, a pair of functions generated at compile time
+ * from a pointer to the member it is stored in. The generic functions
+ * below walk the table to encode an object, and walk the attributes of a
+ * message once to decode it straight into the members of an existing
+ * object, without building the intermediate objects and attribute arrays
+ * that nla_parse() based parsers need.
+ *
+ * A schema is defined in a single translation unit with
+ *
+ *	NETLINK_SCHEMA(Foo) {
+ *		{ FOO_ATTR_ID, &NetlinkU32<Object, unsigned int,
+ *					   &Object::id>::codec },
+ *		{ FOO_ATTR_NAME, &NetlinkString<Object, &Object::name>::codec },
+ *		{ 0, 0 }
+ *	};
+ *
+ * with the entries ordered by attribute id. Members that are not public
+ * require Foo to declare NetlinkSchema<Foo> as a friend.
+ */
+
+namespace rina {
+
+/** Encodes and decodes one attribute of a T */
+template <class T>
+struct NetlinkCodec {
+	/** Appends the attribute to the message; < 0 on error */
+	int (*put)(nl_msg * msg, int type, const T& object);
+
+	/** Stores the attribute in the object; < 0 on error */
+	int (*get)(const nlattr * attr, T& object);
+
+	/** If not null, resets the member before decoding */
+	void (*reset)(T& object);
+};
+
+template <class T>
+struct NetlinkAttribute {
+	int type;
+	const NetlinkCodec<T> * codec;
+};
+
+/** Attribute table of a T, see NETLINK_SCHEMA */
+template <class T>
+struct NetlinkSchema {
+	typedef T Object;
+
+	static const char * const name;
+	static const NetlinkAttribute<T> attrs[];
+};
+
+#define NETLINK_SCHEMA(T)						\
+	template<> const char * const NetlinkSchema<T>::name = #T;	\
+	template<> const NetlinkAttribute<T> NetlinkSchema<T>::attrs[] =
+
+/** Declares a schema defined in another translation unit */
+#define NETLINK_SCHEMA_DECLARE(T)					\
+	template<> const char * const NetlinkSchema<T>::name;		\
+	template<> const NetlinkAttribute<T> NetlinkSchema<T>::attrs[]
+
+/** Appends all the attributes of object to msg; < 0 on error */
+template <class T>
+int putNetlinkObject(nl_msg * msg, const T& object)
+{
+	const NetlinkAttribute<T> * a;
+
+	for (a = NetlinkSchema<T>::attrs; a->codec; a++) {
+		if (a->codec->put(msg, a->type, object) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Decodes the len bytes of attributes starting at head into object.
+ * Attributes not in the schema are ignored; < 0 on error
+ */
+template <class T>
+int parseNetlinkAttrs(const nlattr * head, int len, T& object)
+{
+	const NetlinkAttribute<T> * attrs = NetlinkSchema<T>::attrs;
+	const NetlinkAttribute<T> * a;
+	const nlattr * nla;
+	int rem, type;
+
+	for (a = attrs; a->codec; a++) {
+		if (a->codec->reset) {
+			a->codec->reset(object);
+		}
+	}
+
+	for (nla = head, rem = len; nla_ok(nla, rem);
+			nla = nla_next(nla, &rem)) {
+		type = nla_type(nla);
+		for (a = attrs; a->codec && a->type < type; a++)
+			;
+		if (!a->codec || a->type != type) {
+			continue;
+		}
+		if (a->codec->get(nla, object) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/** Decodes the attributes nested in attr into object */
+template <class T>
+int parseNetlinkNested(const nlattr * attr, T& object)
+{
+	return parseNetlinkAttrs((const nlattr *) nla_data(attr),
+				 nla_len(attr), object);
+}
+
+/** Decodes a RINA generic Netlink message into object */
+template <class T>
+int parseNetlinkObject(nlmsghdr * hdr, T& object)
+{
+	genlmsghdr * ghdr = (genlmsghdr *) nlmsg_data(hdr);
+
+	if (!genlmsg_valid_hdr(hdr, sizeof(struct rinaHeader))) {
+		return -NLE_MSG_TOOSHORT;
+	}
+
+	return parseNetlinkAttrs(genlmsg_attrdata(ghdr,
+						  sizeof(struct rinaHeader)),
+				 genlmsg_attrlen(ghdr,
+						 sizeof(struct rinaHeader)),
+				 object);
+}
+
+/** When a numeric member is encoded */
+enum NetlinkPutCondition {
+	NL_PUT_ALWAYS,
+	NL_PUT_IF_POSITIVE,
+	NL_PUT_IF_NOT_NEGATIVE,
+};
+
+/**
+ * A numeric member encoded as a u32. C is the class declaring the
+ * member, which may be a base of T.
+ */
+template <class C, class M, M C::*member, int when = NL_PUT_ALWAYS,
+	  class T = C>
+struct NetlinkU32 {
+	static int put(nl_msg * msg, int type, const T& object) {
+		if ((when == NL_PUT_IF_POSITIVE && !(object.*member > 0)) ||
+		    (when == NL_PUT_IF_NOT_NEGATIVE && object.*member < 0)) {
+			return 0;
+		}
+		return nla_put_u32(msg, type, (uint32_t) (object.*member));
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		if (nla_len(attr) < (int) sizeof(uint32_t)) {
+			return -NLE_RANGE;
+		}
+		object.*member = (M) nla_get_u32((nlattr *) attr);
+		return 0;
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class C, class M, M C::*member, int when, class T>
+const NetlinkCodec<T> NetlinkU32<C, M, member, when, T>::codec =
+	{ put, get, 0 };
+
+/** A bool member encoded as a flag, false if the flag is missing */
+template <class T, bool T::*member>
+struct NetlinkFlag {
+	static int put(nl_msg * msg, int type, const T& object) {
+		return object.*member ? nla_put_flag(msg, type) : 0;
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		object.*member = true;
+		return 0;
+	}
+
+	static void reset(T& object) {
+		object.*member = false;
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, bool T::*member>
+const NetlinkCodec<T> NetlinkFlag<T, member>::codec = { put, get, reset };
+
+/** A std::string member, encoded NUL-terminated */
+template <class T, std::string T::*member>
+struct NetlinkString {
+	static int put(nl_msg * msg, int type, const T& object) {
+		const std::string& value = object.*member;
+
+		return nla_put(msg, type, value.size() + 1, value.c_str());
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		const char * data = (const char *) nla_data(attr);
+
+		(object.*member).assign(data, strnlen(data, nla_len(attr)));
+		return 0;
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, std::string T::*member>
+const NetlinkCodec<T> NetlinkString<T, member>::codec = { put, get, 0 };
+
+/**
+ * A buffer allocated with new[], referenced by a pointer member and
+ * with its length in another member. Not encoded if the pointer is null.
+ * When decoding, the object owns the buffer: the one of a previous
+ * decode is freed, unless the pointer was set to null after taking it.
+ */
+template <class T, void * T::*data, int T::*size>
+struct NetlinkBinary {
+	static int put(nl_msg * msg, int type, const T& object) {
+		if (!(object.*data)) {
+			return 0;
+		}
+		return nla_put(msg, type, object.*size, object.*data);
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		int len = nla_len(attr);
+		unsigned char * buffer;
+
+		reset(object);
+		buffer = new unsigned char[len];
+		memcpy(buffer, nla_data(attr), len);
+		object.*data = buffer;
+		object.*size = len;
+		return 0;
+	}
+
+	static void reset(T& object) {
+		delete[] (unsigned char *) (object.*data);
+		object.*data = 0;
+		object.*size = 0;
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, void * T::*data, int T::*size>
+const NetlinkCodec<T> NetlinkBinary<T, data, size>::codec =
+	{ put, get, reset };
+
+/** A member with its own schema, encoded as a nested attribute */
+template <class T, class M, M T::*member>
+struct NetlinkNested {
+	static int put(nl_msg * msg, int type, const T& object) {
+		nlattr * nested = nla_nest_start(msg, type);
+
+		if (!nested || putNetlinkObject(msg, object.*member) < 0) {
+			return -1;
+		}
+		nla_nest_end(msg, nested);
+		return 0;
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		return parseNetlinkNested(attr, object.*member);
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, class M, M T::*member>
+const NetlinkCodec<T> NetlinkNested<T, M, member>::codec = { put, get, 0 };
+
+/**
+ * A list of integers, encoded as a nested attribute with one u32 per
+ * element whose type is the element index
+ */
+template <class T, std::list<unsigned int> T::*member>
+struct NetlinkU32List {
+	static int put(nl_msg * msg, int type, const T& object) {
+		std::list<unsigned int>::const_iterator it;
+		nlattr * nested = nla_nest_start(msg, type);
+		int i = 0;
+
+		if (!nested) {
+			return -1;
+		}
+		for (it = (object.*member).begin();
+				it != (object.*member).end(); ++it, ++i) {
+			if (nla_put_u32(msg, i, *it) < 0) {
+				return -1;
+			}
+		}
+		nla_nest_end(msg, nested);
+		return 0;
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		const nlattr * nla;
+		int rem;
+
+		reset(object);
+		for (nla = (const nlattr *) nla_data(attr), rem = nla_len(attr);
+				nla_ok(nla, rem); nla = nla_next(nla, &rem)) {
+			if (nla_len(nla) < (int) sizeof(uint32_t)) {
+				return -NLE_RANGE;
+			}
+			(object.*member).push_back(nla_get_u32((nlattr *) nla));
+		}
+		return 0;
+	}
+
+	static void reset(T& object) {
+		(object.*member).clear();
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, std::list<unsigned int> T::*member>
+const NetlinkCodec<T> NetlinkU32List<T, member>::codec = { put, get, reset };
+
+/**
+ * A list of objects with their own schema, encoded as a nested attribute
+ * containing one nested attribute per element, whose type is the element
+ * index. The elements are stored by value (E) or by pointer (E *, the
+ * decoder allocates them with new, and deletes the ones of a previous
+ * decode into the same object).
+ */
+template <class E>
+struct NetlinkListElement {
+	static const E& ref(const E& element) { return element; }
+	static E& append(std::list<E>& list) {
+		list.push_back(E());
+		return list.back();
+	}
+	static void drop(std::list<E>& list) { list.pop_back(); }
+	static void clear(std::list<E>& list) { list.clear(); }
+};
+
+template <class E>
+struct NetlinkListElement<E *> {
+	static const E& ref(const E * element) { return *element; }
+	static E& append(std::list<E *>& list) {
+		list.push_back(new E());
+		return *list.back();
+	}
+	static void drop(std::list<E *>& list) {
+		delete list.back();
+		list.pop_back();
+	}
+	static void clear(std::list<E *>& list) {
+		typename std::list<E *>::iterator it;
+
+		for (it = list.begin(); it != list.end(); ++it) {
+			delete *it;
+		}
+		list.clear();
+	}
+};
+
+template <class T, class E, std::list<E> T::*member>
+struct NetlinkObjectList {
+	typedef NetlinkListElement<E> Element;
+
+	static int put(nl_msg * msg, int type, const T& object) {
+		typename std::list<E>::const_iterator it;
+		nlattr * nested = nla_nest_start(msg, type);
+		nlattr * element;
+		int i = 0;
+
+		if (!nested) {
+			return -1;
+		}
+		for (it = (object.*member).begin();
+				it != (object.*member).end(); ++it, ++i) {
+			if (!(element = nla_nest_start(msg, i)) ||
+			    putNetlinkObject(msg, Element::ref(*it)) < 0) {
+				return -1;
+			}
+			nla_nest_end(msg, element);
+		}
+		nla_nest_end(msg, nested);
+		return 0;
+	}
+
+	static int get(const nlattr * attr, T& object) {
+		const nlattr * nla;
+		int rem;
+
+		reset(object);
+		for (nla = (const nlattr *) nla_data(attr), rem = nla_len(attr);
+				nla_ok(nla, rem); nla = nla_next(nla, &rem)) {
+			if (parseNetlinkNested(nla,
+					Element::append(object.*member)) < 0) {
+				Element::drop(object.*member);
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	static void reset(T& object) {
+		Element::clear(object.*member);
+	}
+
+	static const NetlinkCodec<T> codec;
+};
+
+template <class T, class E, std::list<E> T::*member>
+const NetlinkCodec<T> NetlinkObjectList<T, E, member>::codec =
+	{ put, get, reset };
+
+NETLINK_SCHEMA_DECLARE(ApplicationProcessNamingInformation);
+NETLINK_SCHEMA_DECLARE(FlowSpecification);
+NETLINK_SCHEMA_DECLARE(PortIdAltlist);
+NETLINK_SCHEMA_DECLARE(PDUForwardingTableEntry);
+NETLINK_SCHEMA_DECLARE(AppAllocateFlowRequestMessage);
+NETLINK_SCHEMA_DECLARE(IpcmAllocateFlowRequestMessage);
+NETLINK_SCHEMA_DECLARE(RmtModifyPDUFTEntriesRequestMessage);
+NETLINK_SCHEMA_DECLARE(RmtDumpPDUFTEntriesResponseMessage);
+NETLINK_SCHEMA_DECLARE(IPCPWriteMgmtSDURequestMessage);
+NETLINK_SCHEMA_DECLARE(IPCPReadMgmtSDUNotificationMessage);
+
+}
+
+#endif
+
+#endif
@@ -27,8 +27,11 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <deque>
 #include <map>
+#include <vector>
 #define RINA_PREFIX "rib"
+
 #include <librina/logs.h>
 //FIXME iostream is only for debuging purposes
 //#include <iostream>
@@ -37,6 +40,8 @@
 #include "librina/cdap_v2.h"
 #include "librina/security-manager.h"
 
+#include "CDAP.pb.h"
+
 namespace rina {
 namespace rib {
 
@@ -262,6 +267,374 @@ create_cb_t RIBSchema::get_create_callback(const std::string& class_,
 	return NULL;
 }
 
+/// The object store of a RIB: a dense array of entries indexed by
+/// the slot of the instance id and an open addressing (linear probing)
+/// hash table over the fully qualified names, so that lookups by name
+/// and by id are O(1). The children of each object are kept inline in
+/// its entry.
+///
+/// The low 32 bits of an instance id are its slot and the others count
+/// the times the slot was reused, so the id of a removed object never
+/// names the next one in its slot.
+///
+/// Copies share the entries: each table has a generation, and entries
+/// of an older one are cloned before being modified and left in
+/// replaced instead of being deleted, so that a copy can be modified
+/// while the original is still being read.
+class RIBObjTable {
+
+public:
+	struct Entry {
+		RIBObj* obj;
+		int64_t id;
+		std::string fqn;
+		uint32_t hash;
+		int64_t parent;
+		//Position in the parent's children
+		size_t pos;
+		//Instance ids of the children in insertion order, -1 for
+		//removed ones not compacted yet
+		std::vector<int64_t> children;
+		size_t holes;
+		//Generation of the table that created it
+		unsigned long gen;
+	};
+
+	RIBObjTable();
+
+	/// A copy sharing the entries of other, of a newer generation
+	RIBObjTable(const RIBObjTable& other);
+
+	/// Does not delete the entries
+	~RIBObjTable() {};
+
+	/// Delete the entries of this table and its objects
+	void clear(void);
+
+	/// @ret The instance id of the object named fqn or -1
+	int64_t find(const std::string& fqn) const;
+
+	/// @ret The entry of an instance id or NULL
+	const Entry* get(int64_t id) const {
+		const Entry* e;
+
+		if (id < 0 || slot(id) >= entries.size())
+			return NULL;
+		e = entries[slot(id)];
+		return e && e->id == id ? e : NULL;
+	}
+
+	/// Get a free instance id, reusing the slot of the oldest freed
+	/// one first
+	int64_t new_id(void);
+
+	/// Add an object under a new_id() id; the parent must exist
+	void insert(int64_t id, int64_t parent, const std::string& fqn,
+		    RIBObj* obj);
+
+	/// Remove the object with instance id id; the object is not
+	/// deleted
+	void erase(int64_t id);
+
+	/// Slots are in [0, slots()); the entry in a slot or NULL
+	size_t slots(void) const {
+		return entries.size();
+	}
+	const Entry* at(size_t slot) const {
+		return entries[slot];
+	}
+
+	/// Number of objects that delegate
+	unsigned int delegating(void) const {
+		return num_of_deleg;
+	}
+
+	/// An object that delegates has been added (1) or removed (-1);
+	/// for consistency (delegation in delegation) the cache is dropped
+	void count_delegating(int n);
+
+	/// @ret The cached instance id of the delegating object serving
+	/// fqn in this generation, or -1
+	int64_t find_deleg(const std::string& fqn) const;
+
+	/// Cache the delegating object serving fqn in this generation
+	void cache_deleg(const std::string& fqn, int64_t id) const;
+
+	/// Entries of older generations no longer in this table
+	std::vector<Entry*> replaced;
+
+private:
+	struct Bucket {
+		uint32_t hash;
+		//-1 if empty
+		int32_t slot;
+	};
+
+	static uint32_t hash_fqn(const std::string& fqn);
+
+	static size_t slot(int64_t id) {
+		return id & 0xffffffff;
+	}
+
+	//Get an entry of this generation, cloning it if needed
+	Entry* writable(int64_t id);
+	void release(Entry* e);
+	void grow(void);
+	void compact_children(int64_t id);
+
+	//NULL for free slots
+	std::vector<Entry*> entries;
+	//The ids that reuse the free slots next
+	std::deque<int64_t> free_ids;
+	std::vector<Bucket> buckets;
+	size_t count;
+	unsigned long gen;
+
+	//Number of objects that delegate
+	unsigned int num_of_deleg;
+
+	//Delegation cache of this generation: fqn <-> inst id. Lock-free
+	//readers fill it too, so it is only touched under cache_rwlock
+	mutable std::map<std::string, int64_t> deleg_cache;
+	mutable ReadWriteLockable cache_rwlock;
+};
+
+RIBObjTable::RIBObjTable() : buckets(64), count(0), gen(0), num_of_deleg(0)
+{
+	for (size_t i = 0; i < buckets.size(); i++)
+		buckets[i].slot = -1;
+}
+
+RIBObjTable::RIBObjTable(const RIBObjTable& other) :
+		entries(other.entries), free_ids(other.free_ids),
+		buckets(other.buckets), count(other.count),
+		gen(other.gen + 1), num_of_deleg(other.num_of_deleg)
+{
+	//The delegation cache starts empty, readers fill it again
+}
+
+void RIBObjTable::clear()
+{
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (!entries[i])
+			continue;
+		delete entries[i]->obj;
+		delete entries[i];
+	}
+	entries.clear();
+}
+
+uint32_t RIBObjTable::hash_fqn(const std::string& fqn)
+{
+	//FNV-1a
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < fqn.size(); i++) {
+		h ^= (unsigned char) fqn[i];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+int64_t RIBObjTable::find(const std::string& fqn) const
+{
+	uint32_t h = hash_fqn(fqn);
+	size_t mask = buckets.size() - 1;
+
+	for (size_t i = h & mask; buckets[i].slot >= 0; i = (i + 1) & mask) {
+		if (buckets[i].hash == h && entries[buckets[i].slot]->fqn == fqn)
+			return entries[buckets[i].slot]->id;
+	}
+
+	return -1;
+}
+
+void RIBObjTable::count_delegating(int n)
+{
+	WriteScopedLock wlock(cache_rwlock);
+
+	num_of_deleg += n;
+	deleg_cache.clear();
+}
+
+int64_t RIBObjTable::find_deleg(const std::string& fqn) const
+{
+	std::map<std::string, int64_t>::const_iterator it;
+
+	ReadScopedLock rlock(cache_rwlock);
+
+	it = deleg_cache.find(fqn);
+	return it == deleg_cache.end() ? -1 : it->second;
+}
+
+void RIBObjTable::cache_deleg(const std::string& fqn, int64_t id) const
+{
+	WriteScopedLock wlock(cache_rwlock);
+
+	deleg_cache[fqn] = id;
+}
+
+int64_t RIBObjTable::new_id()
+{
+	int64_t id;
+
+	if (free_ids.empty())
+		return entries.size();
+
+	id = free_ids.front();
+	free_ids.pop_front();
+	return id;
+}
+
+RIBObjTable::Entry* RIBObjTable::writable(int64_t id)
+{
+	Entry* e = entries[slot(id)];
+
+	if (e->gen == gen)
+		return e;
+
+	replaced.push_back(e);
+	e = new Entry(*e);
+	e->gen = gen;
+	entries[slot(id)] = e;
+	return e;
+}
+
+void RIBObjTable::release(Entry* e)
+{
+	if (e->gen == gen)
+		delete e;
+	else
+		replaced.push_back(e);
+}
+
+void RIBObjTable::grow()
+{
+	std::vector<Bucket> old;
+	size_t mask;
+
+	old.swap(buckets);
+	buckets.resize(old.size() * 2);
+	mask = buckets.size() - 1;
+	for (size_t i = 0; i < buckets.size(); i++)
+		buckets[i].slot = -1;
+
+	for (size_t i = 0; i < old.size(); i++) {
+		size_t j;
+
+		if (old[i].slot < 0)
+			continue;
+		for (j = old[i].hash & mask; buckets[j].slot >= 0;
+				j = (j + 1) & mask);
+		buckets[j] = old[i];
+	}
+}
+
+void RIBObjTable::insert(int64_t id, int64_t parent, const std::string& fqn,
+			 RIBObj* obj)
+{
+	size_t mask, i;
+	Entry* e = new Entry();
+
+	e->obj = obj;
+	e->id = id;
+	e->fqn = fqn;
+	e->hash = hash_fqn(fqn);
+	e->parent = parent;
+	e->pos = 0;
+	e->holes = 0;
+	e->gen = gen;
+	if (parent >= 0) {
+		Entry* p = writable(parent);
+		e->pos = p->children.size();
+		p->children.push_back(id);
+	}
+	if (slot(id) == entries.size())
+		entries.push_back(e);
+	else
+		entries[slot(id)] = e;
+
+	//Keep the load factor under 1/2
+	if (2 * (count + 1) > buckets.size())
+		grow();
+	mask = buckets.size() - 1;
+	for (i = e->hash & mask; buckets[i].slot >= 0; i = (i + 1) & mask);
+	buckets[i].hash = e->hash;
+	buckets[i].slot = slot(id);
+	count++;
+}
+
+void RIBObjTable::compact_children(int64_t id)
+{
+	Entry* e = writable(id);
+	size_t n = 0;
+
+	for (size_t i = 0; i < e->children.size(); i++) {
+		if (e->children[i] < 0)
+			continue;
+		writable(e->children[i])->pos = n;
+		e->children[n++] = e->children[i];
+	}
+	e->children.resize(n);
+	e->holes = 0;
+}
+
+void RIBObjTable::erase(int64_t id)
+{
+	Entry* e = entries[slot(id)];
+	size_t mask = buckets.size() - 1;
+	size_t i, j;
+
+	//Find the bucket and close the gap (backward shift deletion)
+	for (i = e->hash & mask; buckets[i].slot != (int32_t) slot(id);
+			i = (i + 1) & mask);
+	for (j = (i + 1) & mask; buckets[j].slot >= 0; j = (j + 1) & mask) {
+		size_t home = buckets[j].hash & mask;
+
+		//Move it back unless its home is cyclically in (i, j]
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			buckets[i] = buckets[j];
+			i = j;
+		}
+	}
+	buckets[i].slot = -1;
+	count--;
+
+	//Leave a hole in the parent's children, compacting them when
+	//more than half are holes
+	if (e->parent >= 0) {
+		Entry* p = writable(e->parent);
+		p->children[e->pos] = -1;
+		if (2 * ++p->holes > p->children.size())
+			compact_children(e->parent);
+	}
+
+	entries[slot(id)] = NULL;
+	release(e);
+
+	//The next object in the slot gets the next id, wrapping around
+	//before the id turns negative
+	free_ids.push_back((((id >> 32) + 1) & 0x7fffffff) << 32 | slot(id));
+}
+
+/// What a write to a read-mostly RIB leaves behind
+struct RIBGarbage {
+	RIBObjTable* table;
+	std::vector<RIBObjTable::Entry*> entries;
+	std::list<RIBObj*> objects;
+
+	~RIBGarbage() {
+		std::list<RIBObj*>::iterator it;
+
+		delete table;
+		for (size_t i = 0; i < entries.size(); i++)
+			delete entries[i];
+		for (it = objects.begin(); it != objects.end(); ++it)
+			delete *it;
+	}
+};
+
 //fwd decl
 class RIBDaemon;
 
@@ -302,8 +675,8 @@ public:
 	// @ret The object instance id or -1 if it does not exist
 	//
 	int64_t get_obj_inst_id(const std::string& fqn) {
-		ReadScopedLock rlock(rwlock);
-		return __get_obj_inst_id(fqn);
+		ReadScope scope(*this);
+		return __get_obj_inst_id(*scope.table, fqn);
 	};
 
 	//
@@ -312,8 +685,8 @@ public:
 	// @ret The object fqn or "" if does not exist
 	//
 	std::string get_obj_fqn(const int64_t inst_id) {
-		ReadScopedLock rlock(rwlock);
-		return __get_obj_fqn(inst_id);
+		ReadScope scope(*this);
+		return __get_obj_fqn(*scope.table, inst_id);
 	};
 
 	//
@@ -372,6 +745,26 @@ public:
 
 	void set_security_manager(ISecurityManager * sec_man);
 
+	///
+	/// Set the maximum size of the batched replies to scoped reads,
+	/// 0 to disable batching
+	///
+	void set_read_batch_size(unsigned int max_size);
+
+	///
+	/// Read the RIB without locking from now on; see
+	/// RIBDaemonProxy::setReadMostly
+	///
+	void set_read_mostly(void);
+
+	///
+	/// Remove and add several objects, publishing all the changes at
+	/// once. Objects that cannot be removed or added are skipped; the
+	/// pointers of the objects added are set to NULL
+	///
+	void update_objs(const std::list<std::string>& to_remove,
+			 std::list<std::pair<std::string, RIBObj*> >& to_add);
+
 protected:
 	//
 	// Incoming requests to the local RIB
@@ -414,32 +807,53 @@ protected:
 			const int invoke_id);
 private:
 
-	// fqn <-> obj
-	std::map<std::string, RIBObj*> obj_name_map;
+	/// Pins the object table for reading. Read-mostly RIBs are read
+	/// without locking, in an epoch read section that also keeps the
+	/// objects removed meanwhile alive until the scope ends; the other
+	/// RIBs are read locked until unlock() or the end of the scope
+	class ReadScope {
+	public:
+		ReadScope(RIB& rib);
+		~ReadScope() throw();
 
-	// instance id <-> obj
-	std::map<int64_t, RIBObj*> obj_inst_map;
+		void unlock(void);
 
-	// instance id <-> fqn
-	std::map<int64_t, std::string> inst_name_map;
+		const RIBObjTable* table;
+		bool lockless;
 
-	// fqn <-> instance id
-	std::map<std::string, int64_t> name_inst_map;
+	private:
+		RIB& rib;
+		bool locked;
+	};
 
-	// Children map instance id <-> std<int64_t> children
-	std::map<int64_t, std::list<int64_t>*> obj_inst_child_map;
+	/// Releases at the end of the scope an object read locked by
+	/// get_objects_to_operate, if it was
+	class ObjReadUnlock {
+	public:
+		ObjReadUnlock(RIBObj* obj_, bool locked) :
+				obj(locked ? obj_ : NULL) {};
+		~ObjReadUnlock() throw() {
+			if (obj)
+				obj->rwlock.unlock();
+		};
+
+	private:
+		RIBObj* obj;
+	};
 
-	// delegation cache: fqn <-> inst id
-	std::map<std::string, int64_t> deleg_cache;
+	// Objects, indexed by instance id and by fqn. Writers replace the
+	// whole table in read-mostly RIBs
+	RIBObjTable* obj_table;
+
+	// Reclaims the tables, entries and objects a read-mostly RIB
+	// replaced or removed; NULL until the RIB is read-mostly
+	EpochReclaimer* epochs;
 
 	//Schema
 	RIBSchema *const schema;
 
-	//Next id pointer
-	int64_t next_inst_id;
-
-	//Number of objects that delegate
-	unsigned int num_of_deleg;
+	//Maximum size of a batched read reply (0 if disabled)
+	unsigned int read_batch_size;
 
         //CDAP Provider
         cdap::CDAPProviderInterface *cdap_provider;
@@ -447,17 +861,17 @@ private:
         //rwlock
         ReadWriteLockable rwlock;
 
-        //Cache rwlock
-        ReadWriteLockable cache_rwlock;
-
         //RIB handle (id)
         const rib_handle_t handle;
 
-	void get_objects_to_operate(const int64_t object_id,
+	//Objects are read locked unless lockless
+	void get_objects_to_operate(const RIBObjTable& table,
+				    const int64_t object_id,
 				    int scope,
 				    char* filter,
 				    std::list<std::pair<int, RIBObj*> >
-	                            &objects);
+	                            &objects,
+				    bool lockless = false);
 
 	//return 0 if operation is allowed, negative number otherwise
 	void check_operation_allowed(const cdap_rib::auth_policy_t & auth,
@@ -466,27 +880,41 @@ private:
 				     const std::string obj_name,
 				     cdap_rib::res_info_t& res);
 
-	//@internal only; must be called with the rwlock acquired
-	RIBObj* get_obj(int64_t inst_id);
+	//@internal only; table must be pinned (ReadScope or rwlock)
+	RIBObj* get_obj(const RIBObjTable& table, int64_t inst_id);
 
-	//@internal: must be called with the rwlock acquired
 	void __remove_obj(int64_t inst_id);
 
-	//@internal: must be called with the rwlock acquired
-	int64_t __get_obj_inst_id(const std::string& fqn);
+	//@internal: table must be pinned (ReadScope or rwlock)
+	int64_t __get_obj_inst_id(const RIBObjTable& table,
+				  const std::string& fqn);
 
-	//@internal: must be called with the rwlock acquired
-	std::string __get_obj_fqn(const int64_t inst_id);
+	//@internal: table must be pinned (ReadScope or rwlock)
+	std::string __get_obj_fqn(const RIBObjTable& table,
+				  const int64_t inst_id);
 
 	//@internal: validate an object name
 	void __validate_fqn(const std::string& fqn);
 
-	//@internal must be called with the rwlock acquired
-	std::string __get_obj_class(const int64_t instance_id);
+	//@internal: table must be pinned (ReadScope or rwlock)
+	std::string __get_obj_class(const RIBObjTable& table,
+				    const int64_t instance_id);
+
+	//@internal: the table to modify, with the rwlock write locked;
+	//a copy of the current one in read-mostly RIBs
+	RIBObjTable* begin_write(void);
 
-	//@internal Get a new (unused) instance id (strictly > 0);
-	//must be called with the wlock acquired
-	int64_t get_new_inst_id(void);
+	//@internal: publish the table modified and delete the objects
+	//removed, once no reader can reach them
+	void end_write(RIBObjTable* table, const std::list<RIBObj*>& removed);
+
+	//@internal: drop a table from begin_write() left unmodified
+	void abort_write(RIBObjTable* table);
+
+	//@internal: add and remove objects in a table from begin_write()
+	int64_t __add_obj(RIBObjTable& table, const std::string& fqn,
+			  RIBObj* obj);
+	RIBObj* __remove_obj(RIBObjTable& table, int64_t inst_id);
 
 	int compareString(std::string a, std::string b);
 
@@ -501,9 +929,10 @@ RIB::RIB(const rib_handle_t& handle_,
 	 RIBSchema *const schema_,
 	 cdap::CDAPProviderInterface *cdap_provider_,
 	 ISecurityManager * sec_man) :
+						obj_table(new RIBObjTable()),
+						epochs(NULL),
 						schema(schema_),
-						next_inst_id(1),
-						num_of_deleg(0),
+						read_batch_size(0),
 						cdap_provider(cdap_provider_),
 						handle(handle_){
 
@@ -516,53 +945,94 @@ RIB::RIB(const rib_handle_t& handle_,
 	root_fqn << schema->get_root_name() << schema->get_separator();
 
 	// Fill in the stuf
-	obj_name_map[root_fqn.str()] = root;
-	obj_inst_map[RIB_ROOT_INST_ID] = root;
-	inst_name_map[RIB_ROOT_INST_ID] = root_fqn.str();
-	name_inst_map[root_fqn.str()] = RIB_ROOT_INST_ID;
-	std::list<int64_t>* child_list = new std::list<int64_t>();
-	obj_inst_child_map[RIB_ROOT_INST_ID] = child_list;
+	obj_table->insert(obj_table->new_id(), -1, root_fqn.str(), root);
 	security_m = sec_man;
 }
 
 RIB::~RIB() {
-	std::list<int64_t> *child_list;
-	int64_t inst_id;
-	RIBObj* obj;
-	std::map<int64_t, RIBObj*>::iterator it;
-
 	//Mutual exclusion
 	WriteScopedLock wlock(rwlock);
 
 	//Remove objects
-	for(it = obj_inst_map.begin(); it != obj_inst_map.end(); it++){
-		inst_id = it->first;
-		obj = it->second;
-
-		//If there, remove from the cache
-		if(obj->delegates){
-			//Remove cached delegated objs
-			deleg_cache.clear();
-			num_of_deleg--;
-		}
-		try{
-			child_list = obj_inst_child_map[inst_id];
-		}catch(...){
-			LOG_ERR("Unable to recover the children list/parent"
-				"children list for object '" PRId64 "';"
-				"corrupted internal state!",inst_id);
-			continue;
-		}
-		if (child_list != NULL){
-			delete child_list;
-		}
-		delete obj;
-	}
+	obj_table->clear();
+	delete obj_table;
 
+	//And whatever read-mostly RIBs replaced or removed
+	delete epochs;
 
 	//TODO: remove schema if allocated by us?
 }
 
+RIB::ReadScope::ReadScope(RIB& rib_) : rib(rib_), locked(false)
+{
+	EpochReclaimer* epochs = __atomic_load_n(&rib.epochs,
+						 __ATOMIC_ACQUIRE);
+
+	lockless = epochs != NULL;
+	if (lockless) {
+		epochs->readLock();
+		table = __atomic_load_n(&rib.obj_table, __ATOMIC_ACQUIRE);
+	} else {
+		//Once read locked, the RIB cannot become read-mostly
+		rib.rwlock.readlock();
+		locked = true;
+		table = rib.obj_table;
+	}
+}
+
+RIB::ReadScope::~ReadScope() throw()
+{
+	if (lockless)
+		rib.epochs->readUnlock();
+	else
+		unlock();
+}
+
+void RIB::ReadScope::unlock()
+{
+	if (!locked)
+		return;
+
+	rib.rwlock.unlock();
+	locked = false;
+	table = NULL;
+}
+
+RIBObjTable* RIB::begin_write()
+{
+	if (!epochs)
+		return obj_table;
+
+	return new RIBObjTable(*obj_table);
+}
+
+void RIB::end_write(RIBObjTable* table, const std::list<RIBObj*>& removed)
+{
+	RIBObjTable* old = obj_table;
+	std::list<RIBObj*>::const_iterator it;
+
+	if (!epochs) {
+		for (it = removed.begin(); it != removed.end(); ++it)
+			delete *it;
+		return;
+	}
+
+	//Readers that got the old table may still use anything in it
+	__atomic_store_n(&obj_table, table, __ATOMIC_RELEASE);
+
+	RIBGarbage* garbage = new RIBGarbage();
+	garbage->table = old;
+	garbage->entries.swap(table->replaced);
+	garbage->objects = removed;
+	epochs->retire(EpochReclaimer::destroy<RIBGarbage>, garbage);
+}
+
+void RIB::abort_write(RIBObjTable* table)
+{
+	if (table != obj_table)
+		delete table;
+}
+
 void RIB::check_operation_allowed(const cdap_rib::auth_policy_t & auth,
 			          const cdap_rib::con_handle_t & con,
 				  const cdap::cdap_m_t::Opcode opcode,
@@ -630,7 +1100,7 @@ void RIB::create_request(const cdap_rib::con_handle_t &con,
 
 		int64_t id = get_obj_inst_id(obj.name_);
 		if(id)
-			rib_obj = get_obj(id);
+			rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -736,7 +1206,7 @@ void RIB::delete_request(const cdap_rib::con_handle_t &con,
 		ReadScopedLock rlock(rwlock);
 
 		id = get_obj_inst_id(obj.name_);
-		rib_obj = get_obj(id);
+		rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -795,6 +1265,173 @@ int RIB::compareString(std::string a, std::string b)
         return 0;
 }
 
+/// The objects read by a scoped M_READ, packed into replies of up to
+/// max_size bytes. Each reply carries the F_RD_BATCH flag, has
+/// ReadBatch::class_name as its class and a messages::objDataList_t as its
+/// value. An object that does not fit in a reply by itself gets a reply of
+/// its own without the flag, as without batching.
+class ReadBatch {
+
+public:
+	ReadBatch(cdap::CDAPProviderInterface *cdap_provider,
+		  const cdap_rib::con_handle_t &con,
+		  const cdap_rib::obj_info_t &obj,
+		  unsigned int max_size,
+		  int invoke_id);
+
+	/// Add an object, sending the pending ones first if it does not fit.
+	/// If it is the last one, everything is sent.
+	void add(const std::string &class_,
+		 const std::string &fqn,
+		 const cdap_rib::obj_info_t &obj_reply,
+		 const cdap_rib::res_info_t &res,
+		 bool last);
+
+	/// Send the pending objects (if any, or if this is the last reply)
+	void flush(bool last);
+
+	static const std::string class_name;
+
+private:
+	void send(const cdap_rib::obj_info_t &obj_reply,
+		  const cdap_rib::res_info_t &res,
+		  bool last,
+		  bool batched);
+
+	cdap::CDAPProviderInterface *cdap_provider;
+	const cdap_rib::con_handle_t &con;
+	const cdap_rib::obj_info_t &obj;
+	const int invoke_id;
+	messages::objDataList_t objects;
+	// Room left for objects in the current reply
+	int room;
+	int max_room;
+};
+
+const std::string ReadBatch::class_name = "ObjectBatch";
+
+// Bytes of a reply taken by everything but the objects and the names
+static const int READ_BATCH_OVERHEAD = 64;
+
+// ByteSize() is deprecated since protobuf 3.1 added ByteSizeLong()
+static inline int message_size(const google::protobuf::MessageLite &message)
+{
+#if GOOGLE_PROTOBUF_VERSION >= 3001000
+	return message.ByteSizeLong();
+#else
+	return message.ByteSize();
+#endif
+}
+
+ReadBatch::ReadBatch(cdap::CDAPProviderInterface *cdap_provider_,
+		     const cdap_rib::con_handle_t &con_,
+		     const cdap_rib::obj_info_t &obj_,
+		     unsigned int max_size,
+		     int invoke_id_) : cdap_provider(cdap_provider_),
+				       con(con_),
+				       obj(obj_),
+				       invoke_id(invoke_id_)
+{
+	max_room = max_size - READ_BATCH_OVERHEAD - obj.name_.size() -
+		class_name.size();
+	room = max_room;
+}
+
+void ReadBatch::add(const std::string &class_,
+		    const std::string &fqn,
+		    const cdap_rib::obj_info_t &obj_reply,
+		    const cdap_rib::res_info_t &res,
+		    bool last)
+{
+	messages::objData_t *data = objects.add_objdata();
+	int size;
+
+	data->set_objclass(class_);
+	data->set_objname(fqn);
+	data->set_objinst(obj_reply.inst_);
+	if (obj_reply.value_.size_ > 0)
+		data->set_objvalue(obj_reply.value_.message_,
+				   obj_reply.value_.size_);
+	if (res.code_ != cdap_rib::CDAP_SUCCESS) {
+		data->set_result(res.code_);
+		data->set_resultreason(res.reason_);
+	}
+
+	// Tag, length and the object itself
+	size = message_size(*data);
+	size += 1 + google::protobuf::io::CodedOutputStream::VarintSize32(size);
+	if (size > max_room) {
+		// Too big for any batch: send the others, then this one alone
+		cdap_rib::obj_info_t obj_single;
+
+		objects.mutable_objdata()->RemoveLast();
+		flush(false);
+		obj_single.class_ = class_;
+		obj_single.name_ = fqn;
+		obj_single.inst_ = obj_reply.inst_;
+		SerObjLoan value(obj_single.value_, obj_reply.value_);
+		send(obj_single, res, last, false);
+		return;
+	}
+	if (size > room && objects.objdata_size() > 1) {
+		// Send the others, then start a new reply with this one
+		data = objects.mutable_objdata()->ReleaseLast();
+		flush(false);
+		objects.mutable_objdata()->AddAllocated(data);
+	}
+	room -= size;
+	if (last)
+		flush(true);
+}
+
+void ReadBatch::flush(bool last)
+{
+	cdap_rib::obj_info_t obj_reply;
+	cdap_rib::res_info_t res;
+
+	if (objects.objdata_size() == 0 && !last)
+		return;
+
+	obj_reply.name_ = obj.name_;
+	obj_reply.class_ = class_name;
+	obj_reply.value_.size_ = message_size(objects);
+	obj_reply.value_.message_ = new unsigned char[obj_reply.value_.size_];
+	objects.SerializeWithCachedSizesToArray(obj_reply.value_.message_);
+	objects.Clear();
+	room = max_room;
+
+	res.code_ = cdap_rib::CDAP_SUCCESS;
+	send(obj_reply, res, last, true);
+}
+
+void ReadBatch::send(const cdap_rib::obj_info_t &obj_reply,
+		     const cdap_rib::res_info_t &res,
+		     bool last,
+		     bool batched)
+{
+	cdap_rib::flags_t flags;
+	int value;
+
+	value = last ? cdap_rib::flags_t::NONE_FLAGS :
+		       cdap_rib::flags_t::F_RD_INCOMPLETE;
+	if (batched)
+		value |= cdap_rib::flags_t::F_RD_BATCH;
+	flags.flags_ = static_cast<cdap_rib::flags_t::Flags>(value);
+	try {
+		LOG_DBG("Sending batched read result for object %s with "
+			"flags %d", obj_reply.name_.c_str(), flags.flags_);
+		cdap_provider->send_read_result(con,
+						obj_reply,
+						flags,
+						res,
+						invoke_id);
+	} catch (Exception &e) {
+		LOG_ERR("Unable to send response for invoke id %d, problem was: %s",
+			invoke_id,
+			e.what());
+	}
+}
+
 void RIB::read_request(const cdap_rib::con_handle_t &con,
 		       const cdap_rib::obj_info_t &obj,
 		       const cdap_rib::filt_info_t &filt,
@@ -815,6 +1452,12 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 	cdap_rib::res_info_t res;
 	std::list<std::pair <int, RIBObj*> > objects;
         RIBObj* rib_obj = NULL;
+	unsigned int batch_size = 0;
+
+	// Delegated objects answer one object per reply
+	cdap_rib::flags_t deleg_flags = flags;
+	deleg_flags.flags_ = static_cast<cdap_rib::flags_t::Flags>(
+			flags.flags_ & ~cdap_rib::flags_t::F_RD_BATCH);
 
 	check_operation_allowed(auth,
 			        con,
@@ -837,20 +1480,27 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 		return;
 	}
 
+	//Mutual exclusion (none in read-mostly RIBs, whose objects stay
+	//pinned until we return)
+	ReadScope rscope(*this);
 	/* RAII scope for RIB scoped lock (read) */
 	{
-		//Mutual exclusion
-		ReadScopedLock rlock(rwlock);
-		int64_t id = get_obj_inst_id(obj.name_);
-		// Check if we have to delegate the call
-		rib_obj = get_obj(id);
+		int64_t id = __get_obj_inst_id(*rscope.table, obj.name_);
 
 		//Get all objects affected by the operation
-		get_objects_to_operate(id,
+		get_objects_to_operate(*rscope.table,
+				       id,
 				       filt.scope_,
 				       filt.filter_,
-				       objects);
-	} //RAII
+				       objects,
+				       rscope.lockless);
+
+		if ((flags.flags_ & cdap_rib::flags_t::F_RD_BATCH) &&
+				invoke_id != 0)
+			batch_size = __atomic_load_n(&read_batch_size,
+						     __ATOMIC_RELAXED);
+	}
+	rscope.unlock();
 
 	if(objects.size() == 0){
 		if (invoke_id != 0) {
@@ -874,12 +1524,13 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 	std::list<std::pair<int, RIBObj*> >::iterator it;
 	std::list<DelegationObj*> delegated_objs;
 	unsigned int count = 0;
+	ReadBatch batch(cdap_provider, con, obj, batch_size, invoke_id);
 	for (it = objects.begin(); it != objects.end(); ++it) {
 		rib_obj = it->second;
 		count++;
 		LOG_DBG("Processing read over object %s", rib_obj->fqn.c_str());
 		//Mutual exclusion
-		ReadScopedLock rlock(rib_obj->rwlock, false);
+		ObjReadUnlock runlock(rib_obj, !rscope.lockless);
 
 		rib_obj->read(con,
 			      obj.name_,
@@ -925,12 +1576,14 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 				DelegationObj *del_obj = (DelegationObj*)rib_obj;
                                 if (count == objects.size())
                                         del_obj->last = true;
+				if (batch_size)
+					batch.flush(false);
 				del_obj->forward_object(con,
 							rina::cdap::cdap_m_t::M_READ,
 							delegated_name,
 							rib_obj->class_name,
 							obj.value_,
-							flags,
+							deleg_flags,
 							deleg_filt,
 							invoke_id);
 
@@ -951,6 +1604,16 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 				flags_r.flags_ =
 				                cdap_rib::flags_t::F_RD_INCOMPLETE;
 
+			if (batch_size) {
+				batch.add(rib_obj->class_name, rib_obj->fqn,
+					  obj_reply, res, count == objects.size());
+
+				delete[] obj_reply.value_.message_;
+				obj_reply.value_.message_ = NULL;
+				obj_reply.value_.size_ = 0;
+				continue;
+			}
+
 			obj_reply.class_ = rib_obj->class_name;
 			obj_reply.name_ = rib_obj->fqn;
 			try {
@@ -973,6 +1636,12 @@ void RIB::read_request(const cdap_rib::con_handle_t &con,
 				delegated_objs.push_back((DelegationObj*) rib_obj);
 		}
 	}
+
+	// If the last object answers by itself (its read is pending or it is
+	// delegated), the objects batched before it still have to be sent,
+	// as incomplete replies
+	if (batch_size)
+		batch.flush(false);
 }
 
 void RIB::cancel_read_request(const cdap_rib::con_handle_t &con,
@@ -1012,7 +1681,7 @@ void RIB::cancel_read_request(const cdap_rib::con_handle_t &con,
 		ReadScopedLock rlock(rwlock);
 
 		int64_t id = get_obj_inst_id(obj.name_);
-		rib_obj = get_obj(id);
+		rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -1091,7 +1760,7 @@ void RIB::write_request(const cdap_rib::con_handle_t &con,
 		ReadScopedLock rlock(rwlock);
 
 		int64_t id = get_obj_inst_id(obj.name_);
-		rib_obj = get_obj(id);
+		rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -1175,7 +1844,7 @@ void RIB::start_request(const cdap_rib::con_handle_t &con,
 		ReadScopedLock rlock(rwlock);
 
 		int64_t id = get_obj_inst_id(obj.name_);
-		rib_obj = get_obj(id);
+		rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -1258,7 +1927,7 @@ void RIB::stop_request(const cdap_rib::con_handle_t &con,
 		ReadScopedLock rlock(rwlock);
 
 		int64_t id = get_obj_inst_id(obj.name_);
-		rib_obj = get_obj(id);
+		rib_obj = get_obj(*obj_table, id);
 
 		//Acquire the read lock over the object (make sure it is not
 		//deleted while we process the operation)
@@ -1295,67 +1964,61 @@ void RIB::stop_request(const cdap_rib::con_handle_t &con,
 	}
 }
 
-void RIB::get_objects_to_operate(const int64_t object_id,
+void RIB::get_objects_to_operate(const RIBObjTable& table,
+				 const int64_t object_id,
 			         int scope,
 			         char * filter,
 			         std::list<std::pair<int, RIBObj*> >
-			         &objects)
+			         &objects,
+				 bool lockless)
 {
-	std::list<int64_t> *child_list = NULL;
+	const RIBObjTable::Entry *entry;
 	RIBObj *rib_obj = NULL;
 
-	rib_obj = get_obj(object_id);
-	if (!rib_obj)
+	entry = table.get(object_id);
+	if (!entry)
 		return;
+	rib_obj = entry->obj;
 	//TODO apply filter
 
 	//Acquire the read lock over the object (make sure it is not
-	//deleted while we process the operation)
-	rib_obj->rwlock.readlock();
+	//deleted while we process the operation); read-mostly RIBs do
+	//not delete objects while they are being read
+	if (!lockless)
+		rib_obj->rwlock.readlock();
 	std::pair<int, RIBObj*> pair (scope, rib_obj);
 	objects.push_back(pair);
 
 	if (scope == 0)
 		return;
 
-	child_list = obj_inst_child_map[object_id];
-	if (!child_list || child_list->size() == 0)
-		return;
-
-	std::list<int64_t>::const_iterator it;
-	for(it = child_list->begin(); it != child_list->end(); ++it)
-		get_objects_to_operate(*it,
-				       scope - 1,
-				       filter,
-				       objects);
+	//The table does not change while it is pinned
+	const std::vector<int64_t>& children = entry->children;
+	for(size_t i = 0; i < children.size(); ++i)
+		if (children[i] >= 0)
+			get_objects_to_operate(table,
+					       children[i],
+					       scope - 1,
+					       filter,
+					       objects,
+					       lockless);
 }
 
-RIBObj* RIB::get_obj(int64_t inst_id){
-	if(obj_inst_map.find(inst_id) != obj_inst_map.end())
-		return obj_inst_map[inst_id];
-	else
-		return NULL;
-}
+RIBObj* RIB::get_obj(const RIBObjTable& table, int64_t inst_id){
+	const RIBObjTable::Entry* entry = table.get(inst_id);
 
-int64_t RIB::__get_obj_inst_id(const std::string& fqn){
-	int64_t id = -1;
+	return entry ? entry->obj : NULL;
+}
 
-	if(name_inst_map.find(fqn) != name_inst_map.end())
-		id = name_inst_map[fqn];
+int64_t RIB::__get_obj_inst_id(const RIBObjTable& table,
+			       const std::string& fqn){
+	int64_t id = table.find(fqn);
 
 	//If there are delegated objects
-	//Note: this block of code is specially polluted by RAII
-	//I hate exceptions
-	if(id == -1 && num_of_deleg > 0){
-
-		/* rwlock RAII scope */ {
+	if(id == -1 && table.delegating() > 0){
 
-			ReadScopedLock rlock(cache_rwlock);
-
-			//Check cache
-			if(deleg_cache.find(fqn) != deleg_cache.end())
-				id = deleg_cache[fqn];
-		} //RAI
+		//Check the cache of this generation of the table
+		id = table.find_deleg(fqn);
 
 		//If found in cache return
 		if(id != -1)
@@ -1363,11 +2026,10 @@ int64_t RIB::__get_obj_inst_id(const std::string& fqn){
 
 		//If it is still not found, look recursively
 		std::string tmp = fqn;
-		std::string root_name = __get_obj_fqn(0);
+		std::string root_name = __get_obj_fqn(table, 0);
 		do{
 			tmp = get_parent_fqn(tmp);
-			if(name_inst_map.find(tmp) != name_inst_map.end())
-				id = name_inst_map[tmp];
+			id = table.find(tmp);
 			if(id >= 0 || tmp == root_name)
 				break;
 		}while(1);
@@ -1377,7 +2039,7 @@ int64_t RIB::__get_obj_inst_id(const std::string& fqn){
 			return id;
 
 		//Check if it is a delegated obj
-		RIBObj *obj = get_obj(id);
+		RIBObj *obj = get_obj(table, id);
 		if(!obj){
 			assert(0); // neither this one
 			return -1;
@@ -1386,41 +2048,17 @@ int64_t RIB::__get_obj_inst_id(const std::string& fqn){
 			return -1;
 
 		//Since it is, add to cache
-		/* rwlock RAII scope */ {
-			WriteScopedLock rlock(cache_rwlock);
-			deleg_cache[fqn] = id;
-		} //RAI
+		table.cache_deleg(fqn, id);
 	}
 
 	return id;
 }
 
-std::string RIB::__get_obj_fqn(const int64_t inst_id) {
-	std::string fqn("");
-
-	if(inst_name_map.find(inst_id) != inst_name_map.end())
-		fqn = inst_name_map[inst_id];
+std::string RIB::__get_obj_fqn(const RIBObjTable& table,
+			       const int64_t inst_id) {
+	const RIBObjTable::Entry* entry = table.get(inst_id);
 
-	return fqn;
-}
-
-int64_t RIB::get_new_inst_id(){
-
-	int64_t curr = -1;
-
-	for(;; ++next_inst_id){
-		//Reuse ids; restart at 1
-		if(next_inst_id < 1)
-			next_inst_id = 1;
-
-		//Set stop flag
-		if(curr < 0)
-			curr = next_inst_id;
-
-		if(obj_inst_map.find(next_inst_id) == obj_inst_map.end())
-			break;
-	}
-	return next_inst_id;
+	return entry ? entry->fqn : std::string("");
 }
 
 //Checks for fqn sanity.
@@ -1452,7 +2090,7 @@ void RIB::__validate_fqn(const std::string& fqn){
 }
 
 int64_t RIB::add_obj(const std::string& fqn, RIBObj** obj_) {
-	int64_t id, parent_id;
+	int64_t id;
 	std::string parent_fqn = get_parent_fqn(fqn);
 
 	//Note that obj_ cannot be NULL (checked by RIBDaemon)
@@ -1478,8 +2116,28 @@ int64_t RIB::add_obj(const std::string& fqn, RIBObj** obj_) {
 	//Mutual exclusion
 	WriteScopedLock wlock(rwlock);
 
+	RIBObjTable* table = begin_write();
+	try {
+		id = __add_obj(*table, fqn, obj);
+	} catch (...) {
+		abort_write(table);
+		throw;
+	}
+	end_write(table, std::list<RIBObj*>());
+
+	//Mark pointer as acquired and return
+	*obj_ = NULL;
+
+	return id;
+}
+
+int64_t RIB::__add_obj(RIBObjTable& table, const std::string& fqn,
+		       RIBObj* obj) {
+	int64_t id, parent_id;
+	std::string parent_fqn = get_parent_fqn(fqn);
+
 	//Check whether the father exists
-	parent_id = __get_obj_inst_id(parent_fqn);
+	parent_id = __get_obj_inst_id(table, parent_fqn);
 	if(parent_id == -1){
 		LOG_ERR("Unable to add object(%p) at '%s'; parent does not exist!",
 								obj,
@@ -1488,49 +2146,24 @@ int64_t RIB::add_obj(const std::string& fqn, RIBObj** obj_) {
 	}
 
 	//Check if the object already exists
-	id = __get_obj_inst_id(obj->fqn);
+	id = __get_obj_inst_id(table, fqn);
 	if(id != -1){
 		LOG_ERR("Unable to add object(%p) at '%s'; an object of class '%s' already exists!",
 							obj,
 							fqn.c_str(),
-							__get_obj_class(id).c_str());
+							__get_obj_class(table, id).c_str());
 		throw eObjExists();
 	}
 
-	//Allocate space
-	std::list<int64_t>* child_list = new std::list<int64_t>();
-
 	//get a (free) instance id
-	id = get_new_inst_id();
+	id = table.new_id();
 	obj->parent_inst_id = parent_id;
 
-	//Add it and return
-	obj_name_map[fqn] = obj;
-	obj_inst_map[id] = obj;
-	inst_name_map[id] = fqn;
-	name_inst_map[fqn] = id;
-	obj_inst_child_map[id] = child_list;
-
-	if(obj->delegates){
-		//Increase counter number of num_of_deleg
-		num_of_deleg++;
-		//For consistency (delegation in delegation); clear cache
-		deleg_cache.clear();
-	}
-
-	//Recover parent's children list  and add ourselves
-	std::list<int64_t>* parent_child_list;
-	try{
-		parent_child_list = obj_inst_child_map[parent_id];
-		if(parent_child_list == NULL)
-			throw Exception();
-	}catch(...){
-		LOG_ERR("Unable to recover the children list for object '" PRId64  "'; corrupted internal state!",
-						parent_id);
-		assert(0);
-		throw Exception("Corrupted internal state");
-	}
-	parent_child_list->push_back(id);
+	//Add it (to its parent's children too) and return
+	table.insert(id, parent_id, fqn, obj);
+
+	if(obj->delegates)
+		table.count_delegating(1);
 
 	LOG_DBG("Add object operation over RIB(%p), of object(%p) with fqn: '%s', succeeded. Instance id: '%" PRId64 "'",
 								this,
@@ -1538,24 +2171,35 @@ int64_t RIB::add_obj(const std::string& fqn, RIBObj** obj_) {
 								fqn.c_str(),
 								id);
 
-	//Mark pointer as acquired and return
-	*obj_ = NULL;
-
 	return id;
 }
 
 void RIB::__remove_obj(int64_t inst_id) {
 
 	RIBObj* obj;
-	std::list<int64_t> *child_list = NULL, *parent_child_list = NULL;
-	std::list<int64_t>::iterator it;
-	int64_t parent_inst_id;
 
 	//Mutual exclusion
 	WriteScopedLock wlock(rwlock);
 
-	obj = get_obj(inst_id);
-	if(!obj){
+	RIBObjTable* table = begin_write();
+	try {
+		obj = __remove_obj(*table, inst_id);
+	} catch (...) {
+		abort_write(table);
+		throw;
+	}
+
+	//Delete object (once no reader can reach it)
+	end_write(table, std::list<RIBObj*>(1, obj));
+}
+
+RIBObj* RIB::__remove_obj(RIBObjTable& table, int64_t inst_id) {
+
+	const RIBObjTable::Entry* entry;
+	RIBObj* obj;
+
+	entry = table.get(inst_id);
+	if(!entry){
 		LOG_ERR("Unable to remove with instance id '%" PRId64  "'. Object does not exist!",
 								inst_id);
 		throw eObjDoesNotExist();
@@ -1567,72 +2211,90 @@ void RIB::__remove_obj(int64_t inst_id) {
 		throw eObjInvalid();
 	}
 
-
-
-	parent_inst_id = obj->parent_inst_id;
-
 	//Check first if it has children
-	try{
-		child_list = obj_inst_child_map[inst_id];
-		if(child_list == NULL)
-			throw Exception();
-		parent_child_list = obj_inst_child_map[parent_inst_id];
-		if(parent_child_list == NULL)
-			throw Exception();
-	}catch(...){
-		LOG_ERR("Unable to recover the children list/parent children list for object '" PRId64  "'; corrupted internal state!",
-							inst_id);
-		assert(0);
-		throw Exception("Corrupted internal state");
-	}
-
-	if(child_list->size() > 0){
-		LOG_ERR("Unable to remove object '" PRId64  "'; the object has children",
+	if(entry->children.size() > entry->holes){
+		LOG_ERR("Unable to remove object '%" PRId64  "'; the object has children",
 							inst_id);
 		throw eObjHasChildren();
 	}
 
-	//Check if we are in the parent's child list
-	it = std::find(parent_child_list->begin(), parent_child_list->end(),
-								inst_id);
-	if(it == parent_child_list->end()){
-		LOG_ERR("Parent's children list does not contain object '" PRId64  "'; corrupted internal state!",
-							inst_id);
-		throw Exception("Corrupted internal state");
-	}
-
-	//Remove from the maps
-	std::string fqn = __get_obj_fqn(inst_id);
+	obj = entry->obj;
+	std::string fqn = entry->fqn;
 
 	LOG_DBG("Removing object over RIB(%p) instance id: '%" PRId64 "' fqn: '%s'",
 								this,
 								inst_id,
 								fqn.c_str());
-	obj_inst_map.erase(inst_id);
-	inst_name_map.erase(inst_id);
-	name_inst_map.erase(fqn);
-	obj_name_map.erase(fqn);
-	obj_inst_child_map.erase(inst_id);
 
-	//Remove ourselves from the parent's children list
-	parent_child_list->erase(it);
+	//Remove from the table and from the parent's children
+	table.erase(inst_id);
 
-	//If there Remove from the cache
-	if(obj->delegates){
-		//Remove cached delegated objs
-		deleg_cache.clear();
-		num_of_deleg--;
-	}
+	//Remove cached delegated objs
+	if(obj->delegates)
+		table.count_delegating(-1);
 
 	LOG_DBG("Object '%s' of class '%s' succesfully removed (id:'%" PRId64 "')",
 							fqn.c_str(),
 							obj->get_class().c_str(),
 							inst_id);
 
+	return obj;
+}
+
+void RIB::set_read_mostly() {
+
+	//Mutual exclusion
+	WriteScopedLock wlock(rwlock);
+
+	if (!epochs)
+		__atomic_store_n(&epochs, new EpochReclaimer(),
+				 __ATOMIC_RELEASE);
+}
+
+void RIB::update_objs(const std::list<std::string>& to_remove,
+		      std::list<std::pair<std::string, RIBObj*> >& to_add) {
+
+	std::list<std::string>::const_iterator it;
+	std::list<std::pair<std::string, RIBObj*> >::iterator jt;
+	std::list<RIBObj*> removed;
+	int64_t id;
+
+	//Mutual exclusion
+	WriteScopedLock wlock(rwlock);
+
+	RIBObjTable* table = begin_write();
+
+	for (it = to_remove.begin(); it != to_remove.end(); ++it) {
+		id = table->find(*it);
+		if (id == -1) {
+			LOG_WARN("Not removing object '%s'; it does not exist",
+				 it->c_str());
+			continue;
+		}
+		try {
+			removed.push_back(__remove_obj(*table, id));
+		} catch (Exception &e) {
+			LOG_WARN("Not removing object '%s'", it->c_str());
+		}
+	}
 
-	//Delete object
-	delete obj;
-	delete child_list;
+	for (jt = to_add.begin(); jt != to_add.end(); ++jt) {
+		RIBObj* obj = jt->second;
+
+		if (!obj)
+			continue;
+		try {
+			__validate_fqn(jt->first);
+			obj->rib = this;
+			obj->fqn = jt->first;
+			__add_obj(*table, jt->first, obj);
+			jt->second = NULL;
+		} catch (Exception &e) {
+			LOG_WARN("Not adding object '%s'", jt->first.c_str());
+		}
+	}
+
+	end_write(table, removed);
 }
 
 char RIB::get_separator() const {
@@ -1655,15 +2317,16 @@ std::string RIB::get_obj_class(const int64_t inst_id){
 
 
 	//Mutual exclusion
-	ReadScopedLock rlock(rwlock);
+	ReadScope scope(*this);
 
-	return __get_obj_class(inst_id);
+	return __get_obj_class(*scope.table, inst_id);
 }
 
-std::string RIB::__get_obj_class(const int64_t inst_id){
+std::string RIB::__get_obj_class(const RIBObjTable& table,
+				 const int64_t inst_id){
 	RIBObj* obj;
 
-	obj = get_obj(inst_id);
+	obj = get_obj(table, inst_id);
 
 	if(obj == NULL)
 		throw eObjDoesNotExist();
@@ -1675,27 +2338,42 @@ const cdap_rib::vers_info_t& RIB::get_version() const {
 	return schema->get_version();
 }
 
+static bool compare_object_data_names(const RIBObjectData& a,
+				      const RIBObjectData& b)
+{
+	return a.name_ < b.name_;
+}
+
 std::list<RIBObjectData> RIB::get_all_rib_objects_data(
 		const std::string& class_,
 		const std::string& name)
 {
 	std::list<RIBObjectData> result;
 	RIBObjectData data;
+	const RIBObjTable::Entry* entry;
 	unsigned n = name.size();
 
-	for (std::map<std::string, RIBObj*>::iterator it = obj_name_map.begin();
-			it != obj_name_map.end(); ++it) {
-		data = it->second->get_object_data();
+	//Mutual exclusion
+	ReadScope scope(*this);
+
+	for (size_t i = 0; i < scope.table->slots(); i++) {
+		entry = scope.table->at(i);
+		if (!entry)
+			continue;
+		data = entry->obj->get_object_data();
 		if (class_.size() && class_ != data.class_)
 			continue;
 		if (n && (name[n-1] == '/' ? data.name_.compare(0, n, name)
 					   : data.name_ != name))
 			continue;
-		if (it->first != "/")
-			data.instance_ = __get_obj_inst_id(data.name_);
+		if (entry->id != RIB_ROOT_INST_ID)
+			data.instance_ = entry->id;
 		result.push_back(data);
 	}
 
+	//Sorted by name, as they have always been listed
+	result.sort(compare_object_data_names);
+
 	return result;
 }
 
@@ -1704,6 +2382,12 @@ void RIB::set_security_manager(ISecurityManager * sec_man)
 	security_m = sec_man;
 }
 
+void RIB::set_read_batch_size(unsigned int max_size)
+{
+	WriteScopedLock wlock(rwlock);
+	__atomic_store_n(&read_batch_size, max_size, __ATOMIC_RELAXED);
+}
+
 ///
 /// RIBDaemon main class
 ///
@@ -1915,6 +2599,15 @@ public:
 
 	int set_security_manager(ApplicationEntity * sec_man);
 
+	void setReadBatchSize(const rib_handle_t& handle,
+			      unsigned int max_size);
+
+	void setReadMostly(const rib_handle_t& handle);
+
+	void updateObjsRIB(const rib_handle_t& handle,
+			   const std::list<std::string>& to_remove,
+			   std::list<std::pair<std::string, RIBObj*> >& to_add);
+
 	///
 	/// Perform an operation on a remote object. If resp_handler
 	/// is not null, the response will be handled by him.
@@ -2048,6 +2741,13 @@ private:
 							       const int invoke_id,
 						  	       bool remove);
 
+	///
+	/// @internal pass the objects of a batched read result to handler
+	///
+	void read_batch_results(const cdap_rib::con_handle_t &con,
+				const cdap_rib::obj_info_t &obj,
+				RIBOpsRespHandler * handler);
+
 	cacep::AppConHandlerInterface *app_con_callback_;
 	cdap::CDAPProviderInterface *cdap_provider;
 
@@ -2722,6 +3422,57 @@ std::list<RIBObjectData> RIBDaemon::get_rib_objects_data(
 	return rib->get_all_rib_objects_data(class_, name);
 }
 
+void RIBDaemon::setReadBatchSize(const rib_handle_t& handle,
+				 unsigned int max_size)
+{
+	//Mutual exclusion
+	ReadScopedLock rlock(rwlock);
+
+	//Retreive the RIB
+	RIB* rib = getRIB(handle);
+
+	if(rib == NULL){
+		LOG_ERR("RIB ('%" PRId64 "') does not exist", handle);
+		throw eRIBNotFound();
+	}
+
+	rib->set_read_batch_size(max_size);
+}
+
+void RIBDaemon::setReadMostly(const rib_handle_t& handle)
+{
+	//Mutual exclusion
+	ReadScopedLock rlock(rwlock);
+
+	//Retreive the RIB
+	RIB* rib = getRIB(handle);
+
+	if(rib == NULL){
+		LOG_ERR("RIB ('%" PRId64 "') does not exist", handle);
+		throw eRIBNotFound();
+	}
+
+	rib->set_read_mostly();
+}
+
+void RIBDaemon::updateObjsRIB(const rib_handle_t& handle,
+			      const std::list<std::string>& to_remove,
+			      std::list<std::pair<std::string, RIBObj*> >& to_add)
+{
+	//Mutual exclusion
+	ReadScopedLock rlock(rwlock);
+
+	//Retreive the RIB
+	RIB* rib = getRIB(handle);
+
+	if(rib == NULL){
+		LOG_ERR("RIB ('%" PRId64 "') does not exist", handle);
+		throw eRIBNotFound();
+	}
+
+	rib->update_objs(to_remove, to_add);
+}
+
 int RIBDaemon::set_security_manager(ApplicationEntity * sec_man)
 {
 	if (security_m) {
@@ -2907,7 +3658,8 @@ void RIBDaemon::remote_read_result(const cdap_rib::con_handle_t &con,
 	RIBOpsRespHandler * handler;
 	bool remove = true;
 
-	if (flags.flags_ == cdap_rib::flags_t::F_RD_INCOMPLETE)
+	if ((flags.flags_ & ~cdap_rib::flags_t::F_RD_BATCH) ==
+			cdap_rib::flags_t::F_RD_INCOMPLETE)
 		remove = false;
 
 	handler = check_rib_and_get_response_handler(con,
@@ -2915,15 +3667,49 @@ void RIBDaemon::remote_read_result(const cdap_rib::con_handle_t &con,
 						     remove);
 	if (handler) {
 		try {
-			handler->remoteReadResult(con,
-						  obj,
-						  res);
+			if (flags.flags_ & cdap_rib::flags_t::F_RD_BATCH)
+				read_batch_results(con, obj, handler);
+			else
+				handler->remoteReadResult(con,
+							  obj,
+							  res);
 		} catch (Exception &e) {
 			LOG_ERR("Unable to process the response");
 		}
 	}
 }
 
+void RIBDaemon::read_batch_results(const cdap_rib::con_handle_t &con,
+				   const cdap_rib::obj_info_t &obj,
+				   RIBOpsRespHandler * handler)
+{
+	messages::objDataList_t objects;
+
+	if (!objects.ParseFromArray(obj.value_.message_, obj.value_.size_)) {
+		LOG_ERR("Malformed batched read result for object %s",
+			obj.name_.c_str());
+		return;
+	}
+
+	for (int i = 0; i < objects.objdata_size(); i++) {
+		const messages::objData_t &data = objects.objdata(i);
+		cdap_rib::obj_info_t obj_data;
+		cdap_rib::res_info_t res;
+
+		obj_data.class_ = data.objclass();
+		obj_data.name_ = data.objname();
+		obj_data.inst_ = data.objinst();
+		res.code_ = static_cast<cdap_rib::res_code_t>(data.result());
+		res.reason_ = data.resultreason();
+
+		// The handler only sees the value during the call
+		SerObjLoan value(obj_data.value_,
+				 (const unsigned char *) data.objvalue().data(),
+				 data.objvalue().size());
+		handler->remoteReadResult(con, obj_data, res);
+	}
+}
+
 void RIBDaemon::remote_cancel_read_result(const cdap_rib::con_handle_t &con,
 					  const cdap_rib::res_info_t &res,
 					  const int invoke_id)
@@ -3321,10 +4107,14 @@ void DelegationObj::forwarded_object_response(int port, int invoke_id,
         con.port_id = port;
         msg->invoke_id_ = invoke_id;
         msg->obj_name_ = fqn  + msg->obj_name_;
-        if (msg->flags_ != rina::cdap_rib::flags_t::F_RD_INCOMPLETE)
+        if ((msg->flags_ & ~rina::cdap_rib::flags_t::F_RD_BATCH) !=
+                        rina::cdap_rib::flags_t::F_RD_INCOMPLETE)
         {
                 if (!last)
-                        msg->flags_=rina::cdap_rib::flags_t::F_RD_INCOMPLETE;
+                        msg->flags_ = static_cast<rina::cdap_rib::flags_t::Flags>(
+                                (msg->flags_ &
+                                 rina::cdap_rib::flags_t::F_RD_BATCH) |
+                                rina::cdap_rib::flags_t::F_RD_INCOMPLETE);
                 signal = true;
         }
         rina::cdap::getProvider()->send_cdap_result(con,  msg);
@@ -3486,6 +4276,24 @@ int RIBDaemonProxy::set_security_manager(ApplicationEntity * sec_man)
 	return ribd->set_security_manager(sec_man);
 }
 
+void RIBDaemonProxy::setReadBatchSize(const rib_handle_t& handle,
+				      unsigned int max_size)
+{
+	ribd->setReadBatchSize(handle, max_size);
+}
+
+void RIBDaemonProxy::setReadMostly(const rib_handle_t& handle)
+{
+	ribd->setReadMostly(handle);
+}
+
+void RIBDaemonProxy::updateObjsRIB(const rib_handle_t& handle,
+				   const std::list<std::string>& to_remove,
+				   std::list<std::pair<std::string, RIBObj*> >& to_add)
+{
+	ribd->updateObjsRIB(handle, to_remove, to_add);
+}
+
 //
 // Client
 //
@@ -20,6 +20,7 @@
 //
 
 #include <cerrno>
+#include <ctime>
 
 #define RINA_PREFIX "librina.timer"
 
@@ -63,172 +64,686 @@ int Time::get_time_in_ms()
 	return (int) time_seconds * 1000 + (int) (time_.tv_usec / 1000);
 }
 
-// CLASS LockableMap
-void* doWorkTask(void *arg) {
-	TimerTask *timer_task = (TimerTask*) arg;
-	timer_task->run();
-	delete timer_task;
-	timer_task = 0;
+// Wheel entry, linked in a slot of the wheel or in the free list
+struct TimerEntry {
+	TimerEntry * prev;
+	TimerEntry * next;
+	TimerTask * task;
+	unsigned long expires;
+	unsigned int generation;
+	bool root;
+};
+
+static inline void entry_list_init(TimerEntry * head)
+{
+	head->prev = head;
+	head->next = head;
+}
+
+static inline bool entry_list_empty(const TimerEntry * head)
+{
+	return head->next == head;
+}
+
+static inline void entry_list_add_tail(TimerEntry * head, TimerEntry * entry)
+{
+	entry->prev = head->prev;
+	entry->next = head;
+	head->prev->next = entry;
+	head->prev = entry;
+}
+
+static inline void entry_list_del(TimerEntry * entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+	entry->prev = entry;
+	entry->next = entry;
+}
+
+// CLASS TimerTaskIndex
+TimerTaskIndex::TimerTaskIndex() : buckets(64), count(0)
+{
+	for (size_t i = 0; i < buckets.size(); i++)
+		buckets[i].task = 0;
+}
+
+size_t TimerTaskIndex::hash(const TimerTask * task)
+{
+	//Fibonacci hashing of the pointer, without its alignment bits
+	return (size_t) ((((unsigned long) task) >> 4) * 2654435761UL);
+}
+
+TimerEntry * TimerTaskIndex::find(TimerTask * task) const
+{
+	size_t mask = buckets.size() - 1;
+
+	for (size_t i = hash(task) & mask; buckets[i].task; i = (i + 1) & mask) {
+		if (buckets[i].task == task)
+			return buckets[i].entry;
+	}
+
+	return 0;
+}
+
+void TimerTaskIndex::insert(TimerTask * task, TimerEntry * entry)
+{
+	size_t mask, i;
+
+	//Keep the load factor under 1/2
+	if (2 * (count + 1) > buckets.size()) {
+		std::vector<Bucket> old;
+
+		old.swap(buckets);
+		buckets.resize(old.size() * 2);
+		mask = buckets.size() - 1;
+		for (i = 0; i < buckets.size(); i++)
+			buckets[i].task = 0;
+
+		for (size_t j = 0; j < old.size(); j++) {
+			if (!old[j].task)
+				continue;
+			for (i = hash(old[j].task) & mask; buckets[i].task;
+					i = (i + 1) & mask);
+			buckets[i] = old[j];
+		}
+	}
+
+	mask = buckets.size() - 1;
+	for (i = hash(task) & mask; buckets[i].task; i = (i + 1) & mask);
+	buckets[i].task = task;
+	buckets[i].entry = entry;
+	count++;
+}
+
+void TimerTaskIndex::erase(TimerTask * task)
+{
+	size_t mask = buckets.size() - 1;
+	size_t i, j;
+
+	for (i = hash(task) & mask; buckets[i].task != task; i = (i + 1) & mask) {
+		if (!buckets[i].task)
+			return;
+	}
+
+	//Close the gap (backward shift deletion)
+	for (j = (i + 1) & mask; buckets[j].task; j = (j + 1) & mask) {
+		size_t home = hash(buckets[j].task) & mask;
+
+		//Move it back unless its home is cyclically in (i, j]
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			buckets[i] = buckets[j];
+			i = j;
+		}
+	}
+	buckets[i].task = 0;
+	count--;
+}
+
+void* doWorkDispatcher(void *arg) {
+	TaskScheduler *scheduler = (TaskScheduler*) arg;
+	scheduler->dispatcher_loop();
+	return (void *) 0;
+}
+
+void* doWorkWorker(void *arg) {
+	TaskScheduler *scheduler = (TaskScheduler*) arg;
+	scheduler->worker_loop();
 	return (void *) 0;
 }
 
-TaskScheduler::TaskScheduler() :
-		Lockable() {
+// CLASS TaskScheduler
+TaskScheduler::TaskScheduler(unsigned int core_workers) :
+		ConditionVariable()
+{
+	root_ = new TimerEntry[ROOT_SIZE];
+	for (unsigned int i = 0; i < ROOT_SIZE; i++)
+		entry_list_init(&root_[i]);
+	for (unsigned int l = 0; l < LEVELS; l++) {
+		levels_[l] = new TimerEntry[LEVEL_SIZE];
+		for (unsigned int i = 0; i < LEVEL_SIZE; i++)
+			entry_list_init(&levels_[l][i]);
+	}
+	free_entries_ = 0;
+	base_ = now_ms();
+	next_wake_ = 0;
+	pending_ = 0;
+	root_pending_ = 0;
+	stopping_ = false;
+	core_workers_ = core_workers > 0 ? core_workers : 1;
+	idle_workers_ = 0;
+	has_orphan_ = false;
+
+	ThreadAttributes threadAttributes;
+	threadAttributes.setJoinable();
+	threadAttributes.setName("timer");
+	dispatcher_ = new Thread(&doWorkDispatcher, (void *) this,
+				 &threadAttributes);
+	dispatcher_->start();
+}
+
+TaskScheduler::~TaskScheduler() throw ()
+{
+	TimerEntry * entry;
+
+	for (size_t i = 0; i < index_.buckets.size(); i++) {
+		if (!index_.buckets[i].task)
+			continue;
+		delete index_.buckets[i].task;
+		delete index_.buckets[i].entry;
+	}
+
+	for (std::deque<TimerTask*>::iterator it = ready_.begin();
+			it != ready_.end(); ++it)
+		delete *it;
+	ready_.clear();
+
+	while (free_entries_) {
+		entry = free_entries_;
+		free_entries_ = entry->next;
+		delete entry;
+	}
+
+	for (unsigned int l = 0; l < LEVELS; l++)
+		delete[] levels_[l];
+	delete[] root_;
+}
+
+unsigned long TaskScheduler::now_ms()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+TimerEntry * TaskScheduler::alloc_entry()
+{
+	TimerEntry * entry;
+
+	if (free_entries_) {
+		entry = free_entries_;
+		free_entries_ = entry->next;
+	} else {
+		entry = new TimerEntry();
+		entry->generation = 0;
+	}
+	entry_list_init(entry);
+
+	return entry;
+}
+
+void TaskScheduler::free_entry(TimerEntry * entry)
+{
+	// Invalidate outstanding handles to this entry
+	entry->generation++;
+	entry->task = 0;
+	entry->next = free_entries_;
+	free_entries_ = entry;
+}
+
+void TaskScheduler::add_entry(TimerEntry * entry)
+{
+	unsigned long idx = entry->expires - base_;
+	unsigned int shift;
+	TimerEntry * head = 0;
+
+	entry->root = false;
+	if ((long) idx < 0) {
+		// Already expired, run on the next tick
+		head = &root_[base_ & (ROOT_SIZE - 1)];
+		entry->root = true;
+	} else if (idx < ROOT_SIZE) {
+		head = &root_[entry->expires & (ROOT_SIZE - 1)];
+		entry->root = true;
+	} else {
+		for (unsigned int l = 0; l < LEVELS; l++) {
+			shift = ROOT_BITS + l * LEVEL_BITS;
+			if (idx < (1UL << (shift + LEVEL_BITS)) || l == LEVELS - 1) {
+				head = &levels_[l][(entry->expires >> shift) &
+						   (LEVEL_SIZE - 1)];
+				break;
+			}
+		}
+	}
+
+	if (entry->root)
+		root_pending_++;
+	entry_list_add_tail(head, entry);
+}
+
+void TaskScheduler::remove_entry(TimerEntry * entry)
+{
+	if (entry->root)
+		root_pending_--;
+	entry_list_del(entry);
+}
+
+unsigned int TaskScheduler::cascade(unsigned int level, unsigned int index)
+{
+	TimerEntry head;
+	TimerEntry * entry;
+	TimerEntry * slot = &levels_[level][index];
+
+	if (entry_list_empty(slot))
+		return index;
+
+	// Detach the slot and redistribute its entries in lower levels
+	head.next = slot->next;
+	head.prev = slot->prev;
+	head.next->prev = &head;
+	head.prev->next = &head;
+	entry_list_init(slot);
+
+	while (!entry_list_empty(&head)) {
+		entry = head.next;
+		entry_list_del(entry);
+		add_entry(entry);
+	}
+
+	return index;
+}
+
+void TaskScheduler::expire(unsigned long now)
+{
+	unsigned int index;
+	unsigned int shift;
+	unsigned long next;
+	TimerEntry * slot;
+	TimerEntry * entry;
+
+	if (pending_ == 0) {
+		base_ = now + 1;
+		return;
+	}
+
+	while ((long) (now - base_) >= 0) {
+		index = base_ & (ROOT_SIZE - 1);
+		if (!index) {
+			for (unsigned int l = 0; l < LEVELS; l++) {
+				shift = ROOT_BITS + l * LEVEL_BITS;
+				if (cascade(l, (base_ >> shift) & (LEVEL_SIZE - 1)))
+					break;
+			}
+		}
+		base_++;
+
+		slot = &root_[index];
+		while (!entry_list_empty(slot)) {
+			entry = slot->next;
+			remove_entry(entry);
+			index_.erase(entry->task);
+			expired_.push_back(entry->task);
+			free_entry(entry);
+			pending_--;
+		}
+
+		if (pending_ == 0) {
+			base_ = now + 1;
+			break;
+		}
+
+		// Nothing in the root wheel, skip to the next cascade
+		if (root_pending_ == 0 && (base_ & (ROOT_SIZE - 1))) {
+			next = (base_ | (ROOT_SIZE - 1)) + 1;
+			base_ = (long) (next - (now + 1)) < 0 ? next : now + 1;
+		}
+	}
 }
-TaskScheduler::~TaskScheduler() throw () {
-  for (std::map<Time, std::list<TimerTask*>* >::iterator iter_map = tasks_.begin();
-      iter_map != tasks_.end(); ++iter_map) {
-    for (std::list<TimerTask*>::iterator iter_list = iter_map->second->begin();
-        iter_list != iter_map->second->end(); ++iter_list){
-      delete *iter_list;
-    }
-    iter_map->second->empty();
-    delete iter_map->second;
-  }
-  tasks_.empty();
+
+unsigned long TaskScheduler::next_expiry()
+{
+	unsigned long result = base_ + (1UL << (ROOT_BITS + LEVELS * LEVEL_BITS));
+	unsigned long candidate;
+	unsigned long current;
+	unsigned int shift;
+	unsigned int j;
+
+	if (root_pending_) {
+		for (j = 0; j < ROOT_SIZE; j++) {
+			if (!entry_list_empty(&root_[(base_ + j) & (ROOT_SIZE - 1)])) {
+				result = base_ + j;
+				break;
+			}
+		}
+	}
+
+	// For the upper levels, wake up when the first non-empty slot
+	// is due to be cascaded
+	for (unsigned int l = 0; l < LEVELS; l++) {
+		shift = ROOT_BITS + l * LEVEL_BITS;
+		current = base_ >> shift;
+		j = (base_ & ((1UL << shift) - 1)) ? 1 : 0;
+		for (; j <= LEVEL_SIZE; j++) {
+			if (!entry_list_empty(&levels_[l][(current + j) &
+							  (LEVEL_SIZE - 1)])) {
+				candidate = (current + j) << shift;
+				if ((long) (candidate - result) < 0)
+					result = candidate;
+				break;
+			}
+		}
+	}
+
+	return result;
 }
-void TaskScheduler::insert(Time time, TimerTask* timer_task) {
+
+TimerHandle TaskScheduler::insert(TimerTask* timer_task, long delay_ms)
+{
+	TimerHandle handle;
+	TimerEntry * entry;
+	unsigned long now;
+
+	if (delay_ms < 0)
+		delay_ms = 0;
+
 	lock();
 
-	std::map<Time, std::list<TimerTask*>* >::iterator iter = tasks_.find(time);
-	if (iter != tasks_.end()) {
-		iter->second->push_back(timer_task);
+	now = now_ms();
+	if (pending_ == 0)
+		base_ = now;
+
+	entry = index_.find(timer_task);
+	if (entry) {
+		LOG_WARN("Task %p is already scheduled, rescheduling it",
+			 timer_task);
+		remove_entry(entry);
+		pending_--;
 	} else {
-		std::list<TimerTask*> *list = new std::list<TimerTask*>;
-		list->push_back(timer_task);
-		std::pair<Time, std::list<TimerTask*>* > pair(time, list);
-		tasks_.insert(pair);
+		entry = alloc_entry();
+		entry->task = timer_task;
+		index_.insert(timer_task, entry);
 	}
 
+	entry->expires = now + delay_ms;
+	add_entry(entry);
+	pending_++;
+
+	handle.entry = entry;
+	handle.generation = entry->generation;
+
+	// Wake up the dispatcher if the new deadline is earlier
+	if (pending_ == 1 || (long) (entry->expires - next_wake_) < 0)
+		signal();
+
 	unlock();
+
+	return handle;
 }
 
-void TaskScheduler::runTasks() {
+void TaskScheduler::cancelTask(TimerTask *task)
+{
+	TimerEntry * entry;
+
 	lock();
-	Time now;
-	std::map<Time, std::list<TimerTask*>* >::iterator first = tasks_.begin();
-	std::map<Time, std::list<TimerTask*>* >::iterator last = tasks_.upper_bound(
-			now);
-	for (std::map<Time, std::list<TimerTask*>* >::iterator iter_map = first;
-			iter_map != last; ++iter_map) {
-		for (std::list<TimerTask*>::iterator iter_list = iter_map->second->begin();
-				iter_list != iter_map->second->end(); ++iter_list){
-			try {
-				ThreadAttributes threadAttributes;
-				threadAttributes.setDettached();
-				threadAttributes.setName("timer_task");
-				Thread *t = new Thread(&doWorkTask,
-						       (void *) (*iter_list),
-						       &threadAttributes);
-				t->start();
-				delete t;
-				t = 0;
-			} catch (Exception &e) {
-				LOG_ERR("Problems creating thread: %s", e.what());
-			}
-		}
-		delete iter_map->second;
+	entry = index_.find(task);
+	if (entry) {
+		index_.erase(task);
+		remove_entry(entry);
+		free_entry(entry);
+		pending_--;
+		delete task;
+	}
+	unlock();
+}
+
+void TaskScheduler::cancelTask(const TimerHandle& handle)
+{
+	TimerEntry * entry = handle.entry;
+	TimerTask * task = 0;
+
+	if (!entry)
+		return;
+
+	lock();
+	if (entry->generation == handle.generation && entry->task) {
+		task = entry->task;
+		index_.erase(task);
+		remove_entry(entry);
+		free_entry(entry);
+		pending_--;
 	}
-	tasks_.erase(first, last);
 	unlock();
+
+	if (task)
+		delete task;
+}
+
+unsigned int TaskScheduler::pending()
+{
+	unsigned int result;
+
+	lock();
+	result = pending_;
+	unlock();
+
+	return result;
 }
 
-void TaskScheduler::cancelTask(TimerTask *task) {
+void TaskScheduler::dispatcher_loop()
+{
+	unsigned long now;
+	unsigned long delay;
+
 	lock();
-	std::map<Time, std::list<TimerTask*>* >::iterator iter_map =
-	            tasks_.begin();
-	while(iter_map != tasks_.end()) {
-	    std::list<TimerTask*>::iterator iter_list = iter_map->second->begin();
-		while(iter_list != iter_map->second->end()){
-			if (*iter_list == task){
-				delete *iter_list;
-				iter_map->second->erase(iter_list++);
+	while (!stopping_) {
+		now = now_ms();
+		expire(now);
+		if (!expired_.empty()) {
+			dispatch();
+			continue;
+		}
+
+		if (pending_ == 0) {
+			// Any insertion will wake us up
+			next_wake_ = now;
+			doWait();
+			continue;
+		}
+
+		next_wake_ = next_expiry();
+		if ((long) (next_wake_ - now) <= 0)
+			continue;
+
+		delay = next_wake_ - now;
+		try {
+			timedwait(delay / 1000, (delay % 1000) * 1000000);
+		} catch (ConcurrentException &e) {
+		}
+	}
+	unlock();
+}
+
+void TaskScheduler::dispatch()
+{
+	ThreadAttributes threadAttributes;
+	Thread * worker;
+
+	ready_cond_.lock();
+	ready_.insert(ready_.end(), expired_.begin(), expired_.end());
+	expired_.clear();
+
+	// Every ready task gets a worker, unless MAX_WORKERS are busy
+	while (idle_workers_ < ready_.size() && workers_.size() < MAX_WORKERS) {
+		try {
+			threadAttributes.setJoinable();
+			threadAttributes.setName("timer_worker");
+			worker = new Thread(&doWorkWorker, (void *) this,
+					    &threadAttributes);
+			worker->start();
+			workers_.push_back(worker);
+			idle_workers_++;
+		} catch (Exception &e) {
+			LOG_ERR("Problems creating thread: %s", e.what());
+			break;
+		}
+	}
+
+	if (idle_workers_ > 1 && ready_.size() > 1)
+		ready_cond_.broadcast();
+	else
+		ready_cond_.signal();
+	ready_cond_.unlock();
+
+	join_exited();
+}
+
+// Called by an extra worker on its way out, with ready_cond_ locked
+void TaskScheduler::retire_worker()
+{
+	for (std::vector<Thread*>::iterator it = workers_.begin();
+			it != workers_.end(); ++it) {
+		if (pthread_equal((*it)->getThreadType(), pthread_self())) {
+			exited_.push_back(*it);
+			workers_.erase(it);
+			return;
+		}
+	}
+}
+
+void TaskScheduler::join_exited()
+{
+	std::vector<Thread*> exited;
+	void * status;
+
+	ready_cond_.lock();
+	exited.swap(exited_);
+	ready_cond_.unlock();
+
+	for (std::vector<Thread*>::iterator it = exited.begin();
+			it != exited.end(); ++it) {
+		(*it)->join(&status);
+		delete *it;
+	}
+}
+
+void TaskScheduler::worker_loop()
+{
+	TimerTask * task;
+	bool reaper;
+
+	ready_cond_.lock();
+	// Workers are counted as idle when they are spawned
+	idle_workers_--;
+	while (true) {
+		while (ready_.empty() && !stopping_) {
+			idle_workers_++;
+			if (workers_.size() <= core_workers_) {
+				ready_cond_.doWait();
+				idle_workers_--;
+				continue;
+			}
+
+			try {
+				ready_cond_.timedwait(WORKER_IDLE_MS / 1000,
+						      (WORKER_IDLE_MS % 1000) * 1000000);
+			} catch (ConcurrentException &e) {
 			}
-			else
-			{
-			    ++iter_list;
+			idle_workers_--;
+			if (ready_.empty() && !stopping_ &&
+					workers_.size() > core_workers_) {
+				// An extra worker with nothing to do
+				retire_worker();
+				ready_cond_.unlock();
+				return;
 			}
 		}
-		if (iter_map->second->size() == 0){
-			delete iter_map->second;
-			tasks_.erase(iter_map++);
+
+		if (stopping_)
+			break;
+
+		task = ready_.front();
+		ready_.pop_front();
+		ready_cond_.unlock();
+
+		try {
+			task->run();
+		} catch (std::exception &e) {
+			LOG_ERR("Timer task raised an exception: %s", e.what());
+		}
+		delete task;
+
+		ready_cond_.lock();
+		reaper = has_orphan_ && pthread_equal(orphan_, pthread_self());
+		if (reaper) {
+			// The timer was destroyed by the task that just ran
+			ready_cond_.unlock();
+			delete this;
+			return;
 		}
-		else
-		    ++iter_map;
 	}
-unlock();
+	ready_cond_.unlock();
 }
 
-// CLASS Timer
-void* doWorkTimer(void *arg) {
-	Timer *timer = (Timer*) arg;
-	Sleep sleep;
-	while (timer->execute_tasks()) {
-                sleep.sleepForMili(100);
+bool TaskScheduler::stop()
+{
+	void * status;
+	bool result = true;
+
+	// stopping_ is read by the dispatcher and by the workers
+	lock();
+	ready_cond_.lock();
+	stopping_ = true;
+	ready_cond_.broadcast();
+	ready_cond_.unlock();
+	signal();
+	unlock();
+
+	dispatcher_->join(&status);
+	delete dispatcher_;
+	dispatcher_ = 0;
+
+	join_exited();
+	for (std::vector<Thread*>::iterator it = workers_.begin();
+			it != workers_.end(); ++it) {
+		if (pthread_equal((*it)->getThreadType(), pthread_self())) {
+			ready_cond_.lock();
+			orphan_ = pthread_self();
+			has_orphan_ = true;
+			ready_cond_.unlock();
+			(*it)->detach();
+			result = false;
+		} else {
+			(*it)->join(&status);
+		}
+		delete *it;
 	}
-	return (void *) 0;
+	workers_.clear();
+
+	return result;
 }
 
+// CLASS Timer
 Timer::Timer() {
-	ThreadAttributes threadAttributes;
-	threadAttributes.setJoinable();
-	continue_lock_.lock();
-	continue_ = true;
-	continue_lock_.unlock();
-	task_scheduler = new TaskScheduler();
-	thread_ = new Thread(&doWorkTimer, (void *) this, &threadAttributes);
-	thread_->start();
-	LOG_DBG("Timer with ID %d started", thread_);
+	task_scheduler = new TaskScheduler(DEFAULT_WORKERS);
+}
+
+Timer::Timer(unsigned int core_workers) {
+	task_scheduler = new TaskScheduler(core_workers);
 }
-Timer::~Timer() {
-	cancel();
 
+Timer::~Timer() {
 	if (task_scheduler) {
-		delete task_scheduler;
+		if (task_scheduler->stop())
+			delete task_scheduler;
 		task_scheduler = 0;
 	}
-
-	if (thread_) {
-		delete thread_;
-		thread_ = 0;
-	}
 }
 
-void Timer::scheduleTask(TimerTask* task, long delay_ms) {
-	Time executeTime;
-	timeval t;
-	int milisecondsNotNorm = executeTime.get_only_milliseconds() + (delay_ms % 1000);
-	int miliseconds = milisecondsNotNorm % 1000;
-	int seconds = executeTime.get_time_seconds() + (delay_ms / 1000) + (milisecondsNotNorm / 1000);
-	t.tv_sec = seconds;
-	t.tv_usec = miliseconds * 1000;
-	executeTime.set_timeval(t);
-	task_scheduler->insert(executeTime, task);
+TimerHandle Timer::scheduleTask(TimerTask* task, long delay_ms) {
+	return task_scheduler->insert(task, delay_ms);
 }
+
 void Timer::cancelTask(TimerTask* task) {
 	task_scheduler->cancelTask(task);
 }
-void Timer::cancel() {
-	continue_lock_.lock();
-	continue_ = false;
-	continue_lock_.unlock();
-	void *r;
-	LOG_DBG("Waiting for the timer %d to join", thread_);
-	thread_->join(&r);
-	LOG_DBG("Timer with ID %d ended", thread_);
+
+void Timer::cancelTask(const TimerHandle& handle) {
+	task_scheduler->cancelTask(handle);
 }
+
 TaskScheduler* Timer::get_task_scheduler() const {
 	return task_scheduler;
 }
-bool Timer::execute_tasks() {
-	continue_lock_.lock();
-        bool result = continue_;
-	if (result)
-	{
-	        get_task_scheduler()->runTasks();
-	}
-	continue_lock_.unlock();
-	return result;
-}
-}
 
+}
@@ -0,0 +1,193 @@
+//
+// CDAP encoding benchmark
+//
+// Measures how many M_READ, M_WRITE and M_CREATE messages per second
+// the GPB concrete syntax encodes and decodes, with empty, 1 KB and
+// 64 KB object values: encoding into a newly allocated and into a
+// caller supplied buffer, and decoding into a new and into a reused
+// message, and into a new one that borrows the value from the encoding.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#define RINA_PREFIX "bench-cdap"
+
+#include "librina/cdap_v2.h"
+#include "librina/logs.h"
+
+using namespace rina;
+using namespace rina::cdap;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const std::string& name, const char * op, int n,
+		   double elapsed)
+{
+	printf("%-22s %-8s %8d msgs %10.1f ns/msg %12.0f msgs/s\n",
+	       name.c_str(), op, n, elapsed * 1e9 / n, n / elapsed);
+}
+
+// A request as the RIB daemon sends it
+static void fill(cdap_m_t& message, cdap_m_t::Opcode op_code, int size)
+{
+	message.op_code_ = op_code;
+	message.invoke_id_ = 1234;
+	message.flags_ = cdap_rib::flags_t::NONE_FLAGS;
+	message.obj_class_ = "NeighborSet";
+	message.obj_name_ = "/ra/nsm/neighbors";
+	message.obj_inst_ = 0;
+	message.scope_ = 0;
+	message.version_ = 1;
+	if (size > 0) {
+		message.obj_value_.message_ = new unsigned char[size];
+		message.obj_value_.size_ = size;
+		memset(message.obj_value_.message_, 0x5a, size);
+	}
+}
+
+static bool same(const cdap_m_t& a, const cdap_m_t& b)
+{
+	return a.op_code_ == b.op_code_ && a.invoke_id_ == b.invoke_id_ &&
+		a.obj_class_ == b.obj_class_ && a.obj_name_ == b.obj_name_ &&
+		a.obj_value_.size_ == b.obj_value_.size_ &&
+		(a.obj_value_.size_ == 0 ||
+		 !memcmp(a.obj_value_.message_, b.obj_value_.message_,
+			 a.obj_value_.size_));
+}
+
+static int bench(CDAPMessageEncoder& encoder, const char * op_name,
+		 cdap_m_t::Opcode op_code, int size, int n)
+{
+	std::string name = std::string(op_name) + " (" +
+		(size >= 1024 ? std::string(size == 1024 ? "1 KB" : "64 KB") :
+		 std::string("0 B")) + ")";
+	cdap_m_t message, reused;
+	ser_obj_t encoded;
+	unsigned char * buffer;
+	int buffer_size;
+	double start;
+
+	fill(message, op_code, size);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		ser_obj_t result;
+		encoder.encode(message, result);
+	}
+	report(name, "encode", n, now_s() - start);
+
+	buffer_size = encoder.encode(message, 0, 0);
+	buffer = new unsigned char[buffer_size];
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		if (encoder.encode(message, buffer, buffer_size) !=
+				buffer_size) {
+			printf("%s: error encoding into a buffer\n",
+			       name.c_str());
+			delete[] buffer;
+			return -1;
+		}
+	}
+	report(name, "encode/b", n, now_s() - start);
+
+	encoder.encode(message, encoded);
+	if (encoded.size_ != buffer_size) {
+		printf("%s: encodings of %d and %d bytes\n", name.c_str(),
+		       encoded.size_, buffer_size);
+		delete[] buffer;
+		return -1;
+	}
+	delete[] buffer;
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		cdap_m_t result;
+		encoder.decode(encoded, result);
+	}
+	report(name, "decode", n, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		delete[] reused.obj_value_.message_;
+		reused.obj_value_.message_ = 0;
+		reused.obj_value_.size_ = 0;
+		encoder.decode(encoded, reused);
+	}
+	report(name, "decode/r", n, now_s() - start);
+
+	if (!same(message, reused)) {
+		printf("%s: decoded message differs\n", name.c_str());
+		return -1;
+	}
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		cdap_m_t result;
+		SerObjLoan value(result.obj_value_);
+		encoder.decode(encoded, result, value);
+	}
+	report(name, "decode/v", n, now_s() - start);
+
+	{
+		cdap_m_t result;
+		SerObjLoan value(result.obj_value_);
+
+		encoder.decode(encoded, result, value);
+		if (!same(message, result)) {
+			printf("%s: message decoded as a view differs\n",
+			       name.c_str());
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 200000;
+	cdap_rib::concrete_syntax_t syntax;
+	CDAPMessageEncoder encoder(syntax);
+	const int sizes[] = { 0, 1024, 64 * 1024 };
+	int result = 0;
+
+	setLogLevel("ERR");
+
+	for (int i = 0; i < 3; i++) {
+		int m = sizes[i] > 1024 ? n / 20 : n;
+
+		result |= bench(encoder, "M_READ", cdap_m_t::M_READ,
+				sizes[i], m);
+		result |= bench(encoder, "M_WRITE", cdap_m_t::M_WRITE,
+				sizes[i], m);
+		result |= bench(encoder, "M_CREATE", cdap_m_t::M_CREATE,
+				sizes[i], m);
+	}
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,143 @@
+//
+// Internal event manager microbenchmark
+//
+// Measures the cost of delivering an event with 1 to 64 listeners
+// subscribed to its type and as many subscribed to each of the other
+// types, both with synchronous dispatch (the cost is paid by the thread
+// that delivers the event) and with asynchronous dispatch (the deliverer
+// only queues the event). For a burst of events it reports the cost per
+// event for the deliverer and until the last listener has seen them all;
+// for events delivered one at a time, the latency until the last listener
+// sees each one.
+//
+// Usage: bench-internal-events [events]
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#define RINA_PREFIX "bench-internal-events"
+
+#include "librina/internal-events.h"
+#include "librina/logs.h"
+
+using namespace rina;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+class BenchEvent: public InternalEvent {
+public:
+	BenchEvent() : InternalEvent(InternalEvent::ADDRESS_CHANGE),
+		sent(now_s()) {};
+
+	double sent;
+};
+
+class NopListener: public InternalEventListener {
+public:
+	void eventHappened(InternalEvent * event) { (void) event; };
+};
+
+// Subscribed last, so it sees every event after all the other listeners
+class LatencyListener: public InternalEventListener {
+public:
+	LatencyListener() : received(0) {};
+	void eventHappened(InternalEvent * event) {
+		latency.push_back(now_s() - static_cast<BenchEvent *>(event)->sent);
+		cond.lock();
+		received++;
+		cond.signal();
+		cond.unlock();
+	};
+
+	ConditionVariable cond;
+	int received;
+	std::vector<double> latency;
+};
+
+static void bench(bool async, int listeners, int n)
+{
+	SimpleInternalEventManager manager(async);
+	std::vector<NopListener> nops(listeners * InternalEvent::NUM_EVENT_TYPES);
+	LatencyListener last;
+	double start, delivered, drained;
+	int k = 0;
+
+	for (int type = 0; type < InternalEvent::NUM_EVENT_TYPES; type++) {
+		for (int i = 0; i < listeners; i++) {
+			manager.subscribeToEvent((InternalEvent::EventType) type,
+						 &nops[k++]);
+		}
+	}
+	manager.subscribeToEvent(InternalEvent::ADDRESS_CHANGE, &last);
+	last.latency.reserve(n);
+
+	// Burst: what the deliverer pays, and how long until all are seen
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		manager.deliverEvent(new BenchEvent());
+	}
+	delivered = now_s() - start;
+
+	last.cond.lock();
+	while (last.received < n)
+		last.cond.doWait();
+	last.cond.unlock();
+	drained = now_s() - start;
+
+	// One event at a time, to measure the latency without queueing
+	last.latency.clear();
+	for (int i = 0; i < n; i++) {
+		manager.deliverEvent(new BenchEvent());
+		last.cond.lock();
+		while (last.received < n + i + 1)
+			last.cond.doWait();
+		last.cond.unlock();
+	}
+
+	std::sort(last.latency.begin(), last.latency.end());
+	printf("%-6s %3d listeners %8.1f ns/deliver %8.1f ns/event "
+	       "latency p50 %8.1f ns p99 %8.1f ns\n",
+	       async ? "async" : "sync", listeners + 1, delivered * 1e9 / n,
+	       drained * 1e9 / n, last.latency[n / 2] * 1e9,
+	       last.latency[n * 99 / 100] * 1e9);
+}
+
+int main(int argc, char * argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 100000;
+
+	setLogLevel("ERR");
+
+	for (int async = 0; async <= 1; async++) {
+		for (int listeners = 0; listeners <= 63; listeners = listeners * 2 + 1) {
+			bench(async, listeners, n);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+//
+// Logging benchmark
+//
+// Measures the cost of disabled DBG statements in a simulated event
+// loop, compared with evaluating their arguments eagerly as the log
+// macros used to do, and the cost of enabled statements with the
+// synchronous and the asynchronous backends.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+
+#define RINA_PREFIX "bench-logs"
+
+#include "librina/logs.h"
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Stands for IPCEvent::eventTypeToString() and the like
+static std::string event_type_to_string(unsigned int type)
+{
+	std::stringstream ss;
+
+	ss << "EVENT_TYPE_" << type;
+	return ss.str();
+}
+
+static volatile unsigned int sink;
+
+// One iteration of a simulated event loop: some work plus a DBG trace
+static void event_loop(unsigned int n, bool eager)
+{
+	for (unsigned int i = 0; i < n; i++) {
+		sink += i * 7;
+		if (eager)
+			logFunc(DBG, "%d(%ld)#" RINA_PREFIX " (DBG): Got event "
+				"of type %s and sequence number %u\n", getpid(),
+				time(0), event_type_to_string(i % 32).c_str(), i);
+		else
+			LOG_DBG("Got event of type %s and sequence number %u",
+				event_type_to_string(i % 32).c_str(), i);
+	}
+}
+
+static void report(const char * name, unsigned int n, double elapsed)
+{
+	printf("%-36s %9u events %9.1f ns/event %12.0f events/s\n", name, n,
+	       elapsed * 1e9 / n, n / elapsed);
+}
+
+int main(int argc, char * argv[])
+{
+	unsigned int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	const char * file = argc > 2 ? argv[2] : "/dev/null";
+	double start;
+
+	setLogLevel("INFO");
+
+	start = now_s();
+	event_loop(n, true);
+	report("DBG disabled, eager arguments", n, now_s() - start);
+
+	start = now_s();
+	event_loop(n, false);
+	report("DBG disabled, level checked first", n, now_s() - start);
+
+	if (setLogFile(file)) {
+		printf("Cannot open %s\n", file);
+		return -1;
+	}
+	setLogLevel("DBG");
+	n /= 4;
+
+	start = now_s();
+	event_loop(n, false);
+	report("DBG enabled, synchronous", n, now_s() - start);
+
+	setLogAsync(1);
+	start = now_s();
+	event_loop(n, false);
+	flushLogs();
+	report("DBG enabled, asynchronous", n, now_s() - start);
+	setLogAsync(0);
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+//
+// Netlink parsers benchmark
+//
+// Measures the encoding and decoding cost of the hot netlink messages,
+// built from the same fixtures as the netlink parsers tests: encoding
+// into a new and into a reused nl_msg, and decoding into a new and into
+// a preallocated message object.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#define RINA_PREFIX "bench-netlink-parsers"
+
+#include "librina/logs.h"
+#include "netlink-parsers.h"
+#include "netlink-schema.h"
+#include "netlink-parsers-fixtures.h"
+
+using namespace rina;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char * name, const char * op, int n,
+		   double elapsed)
+{
+	printf("%-36s %-8s %8d ops %10.1f ns/op\n", name, op, n,
+	       elapsed * 1e9 / n);
+}
+
+static int put(nl_msg * netlinkMessage, BaseNetlinkMessage& message)
+{
+	genlmsg_put(netlinkMessage, NL_AUTO_PORT, message.getSequenceNumber(),
+		    21, sizeof(struct rinaHeader), 0,
+		    message.getOperationCode(), 0);
+	return putBaseNetlinkMessage(netlinkMessage, &message);
+}
+
+static nl_msg * encode(BaseNetlinkMessage& message, size_t size)
+{
+	nl_msg * netlinkMessage = nlmsg_alloc_size(size);
+
+	if (!netlinkMessage) {
+		return 0;
+	}
+	if (put(netlinkMessage, message) < 0) {
+		nlmsg_free(netlinkMessage);
+		return 0;
+	}
+
+	return netlinkMessage;
+}
+
+/* Releases what the parsers allocate besides the message itself */
+static void clear(BaseNetlinkMessage * message)
+{
+	if (IPCPWriteMgmtSDURequestMessage * m =
+			dynamic_cast<IPCPWriteMgmtSDURequestMessage *>(message)) {
+		delete[] (unsigned char *) m->sdu;
+	} else if (IPCPReadMgmtSDUNotificationMessage * m =
+		   dynamic_cast<IPCPReadMgmtSDUNotificationMessage *>(message)) {
+		delete[] (unsigned char *) m->sdu;
+	} else if (RmtModifyPDUFTEntriesRequestMessage * m =
+		   dynamic_cast<RmtModifyPDUFTEntriesRequestMessage *>(message)) {
+		std::list<PDUForwardingTableEntry *>::const_iterator it;
+
+		for (it = m->getEntries().begin();
+				it != m->getEntries().end(); ++it) {
+			delete *it;
+		}
+		m->setEntries(std::list<PDUForwardingTableEntry *>());
+	}
+}
+
+static void release(BaseNetlinkMessage * message)
+{
+	clear(message);
+	delete message;
+}
+
+template <class T>
+static int bench(const char * name, T& message, size_t size, int n)
+{
+	nl_msg * netlinkMessage;
+	double start;
+	T preallocated;
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		netlinkMessage = encode(message, size);
+		if (!netlinkMessage) {
+			printf("%s: error encoding\n", name);
+			return -1;
+		}
+		nlmsg_free(netlinkMessage);
+	}
+	report(name, "encode", n, now_s() - start);
+
+	netlinkMessage = nlmsg_alloc_size(size);
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		nlmsg_hdr(netlinkMessage)->nlmsg_len = NLMSG_HDRLEN;
+		if (put(netlinkMessage, message) < 0) {
+			printf("%s: error encoding\n", name);
+			nlmsg_free(netlinkMessage);
+			return -1;
+		}
+	}
+	report(name, "encode/r", n, now_s() - start);
+	nlmsg_free(netlinkMessage);
+
+	netlinkMessage = encode(message, size);
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		BaseNetlinkMessage * result =
+			parseBaseNetlinkMessage(nlmsg_hdr(netlinkMessage));
+		if (!result) {
+			printf("%s: error decoding\n", name);
+			nlmsg_free(netlinkMessage);
+			return -1;
+		}
+		release(result);
+	}
+	report(name, "decode", n, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		if (parseNetlinkObject(nlmsg_hdr(netlinkMessage),
+				       preallocated) < 0) {
+			printf("%s: error decoding\n", name);
+			nlmsg_free(netlinkMessage);
+			return -1;
+		}
+	}
+	report(name, "decode/p", n, now_s() - start);
+	clear(&preallocated);
+	nlmsg_free(netlinkMessage);
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 200000;
+	int result = 0;
+
+	setLogLevel("ERR");
+
+	IpcmAllocateFlowRequestMessage allocateFlow;
+	fillIpcmAllocateFlowRequestMessage(allocateFlow);
+	result |= bench("IpcmAllocateFlowRequestMessage", allocateFlow,
+			4096, n);
+
+	IPCPWriteMgmtSDURequestMessage writeSmall, writeLarge;
+	fillIPCPWriteMgmtSDURequestMessage(writeSmall);
+	fillIPCPWriteMgmtSDURequestMessage(writeLarge, 1400);
+	result |= bench("IPCPWriteMgmtSDURequest (20 B)", writeSmall, 4096, n);
+	result |= bench("IPCPWriteMgmtSDURequest (1400 B)", writeLarge,
+			4096, n);
+
+	IPCPReadMgmtSDUNotificationMessage readSmall;
+	fillIPCPReadMgmtSDUNotificationMessage(readSmall);
+	result |= bench("IPCPReadMgmtSDUNotification (20 B)", readSmall,
+			4096, n);
+
+	RmtModifyPDUFTEntriesRequestMessage pduftSmall, pduftLarge;
+	fillRmtModifyPDUFTEntriesRequestMessage(pduftSmall);
+	fillRmtModifyPDUFTEntriesRequestMessage(pduftLarge, 500);
+	result |= bench("RmtModifyPDUFTEntries (2 entries)", pduftSmall,
+			4096, n);
+	result |= bench("RmtModifyPDUFTEntries (500 entries)", pduftLarge,
+			64 * 1024, n / 100);
+
+	delete[] (unsigned char *) writeSmall.sdu;
+	delete[] (unsigned char *) writeLarge.sdu;
+	delete[] (unsigned char *) readSmall.sdu;
+	release(new RmtModifyPDUFTEntriesRequestMessage(pduftSmall));
+	release(new RmtModifyPDUFTEntriesRequestMessage(pduftLarge));
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,248 @@
+//
+// RIB read contention benchmark
+//
+// Measures the object lookups per second and their latency of 1, 2, 4
+// and 8 reader threads while a writer replaces 1000 objects per second
+// in batches of 10, on a locked and on a read-mostly RIB of 10k objects.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define RINA_PREFIX "bench-rib-contention"
+
+#include "librina/concurrency.h"
+#include "librina/logs.h"
+#include "librina/rib_v2.h"
+#include "rib-loopback-provider.h"
+
+#define SUBTREE_SIZE  1000
+#define MAX_READERS   8
+#define WRITE_BATCH   10
+#define WRITE_PERIOD  10	// ms, for 1000 objects per second
+#define SAMPLE_PERIOD 64	// Time one lookup out of SAMPLE_PERIOD
+
+using namespace rina;
+using namespace rina::rib;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static RIBDaemonProxy * ribd;
+static rib_handle_t handle;
+static std::vector<std::string> names;
+static int stop;
+static int errors;
+
+struct Reader {
+	unsigned int seed;
+	long lookups;
+	std::vector<double> latencies;
+};
+
+static void * read_objects(void * arg)
+{
+	Reader * reader = (Reader *) arg;
+	double start = 0;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		const std::string& name = names[rand_r(&reader->seed) %
+						names.size()];
+		bool timed = reader->lookups % SAMPLE_PERIOD == 0;
+
+		if (timed)
+			start = now_s();
+		try {
+			int64_t id = ribd->getObjInstId(handle, name);
+			try {
+				if (ribd->getObjFqn(handle, id) != name)
+					__atomic_add_fetch(&errors, 1,
+							   __ATOMIC_RELAXED);
+			} catch (eObjDoesNotExist &e) {
+				// Replaced between the two lookups; the
+				// new object has another id
+			}
+		} catch (Exception &e) {
+			__atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+		}
+		if (timed)
+			reader->latencies.push_back(now_s() - start);
+		reader->lookups++;
+	}
+
+	return 0;
+}
+
+// Replaces WRITE_BATCH objects every WRITE_PERIOD ms until stopped
+static void * write_objects(void * arg)
+{
+	long * replaced = (long *) arg;
+	unsigned int seed = 1;
+	double next = now_s();
+	Sleep sleep;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		std::list<std::string> to_remove;
+		std::list<std::pair<std::string, RIBObj *> > to_add;
+		std::list<std::pair<std::string, RIBObj *> >::iterator it;
+		double wait;
+
+		for (int i = 0; i < WRITE_BATCH; i++) {
+			const std::string& name = names[rand_r(&seed) %
+							names.size()];
+
+			if (std::find(to_remove.begin(), to_remove.end(),
+				      name) != to_remove.end())
+				continue;
+			to_remove.push_back(name);
+			to_add.push_back(std::make_pair(name,
+							new RIBObj("Bench")));
+		}
+		ribd->updateObjsRIB(handle, to_remove, to_add);
+		for (it = to_add.begin(); it != to_add.end(); ++it) {
+			if (it->second) {
+				__atomic_add_fetch(&errors, 1,
+						   __ATOMIC_RELAXED);
+				delete it->second;
+			}
+		}
+		*replaced += to_remove.size();
+
+		next += WRITE_PERIOD / 1e3;
+		wait = next - now_s();
+		if (wait > 0)
+			sleep.sleepForMili(wait * 1e3);
+	}
+
+	return 0;
+}
+
+static int bench(const char * mode, int readers, double seconds)
+{
+	Thread * threads[MAX_READERS + 1];
+	Reader reader[MAX_READERS];
+	std::vector<double> latencies;
+	long lookups = 0, replaced = 0;
+	void * status;
+	double start, elapsed;
+
+	stop = 0;
+	errors = 0;
+
+	ThreadAttributes * threadAttributes = new ThreadAttributes();
+	threadAttributes->setJoinable();
+	start = now_s();
+	for (int i = 0; i < readers; i++) {
+		reader[i].seed = i + 1;
+		reader[i].lookups = 0;
+		threads[i] = new Thread(read_objects, &reader[i],
+					threadAttributes);
+		threads[i]->start();
+	}
+	threads[readers] = new Thread(write_objects, &replaced,
+				      threadAttributes);
+	threads[readers]->start();
+	delete threadAttributes;
+
+	Sleep().sleepForMili(seconds * 1e3);
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for (int i = 0; i <= readers; i++) {
+		threads[i]->join(&status);
+		delete threads[i];
+	}
+	elapsed = now_s() - start;
+
+	for (int i = 0; i < readers; i++) {
+		lookups += reader[i].lookups;
+		latencies.insert(latencies.end(),
+				 reader[i].latencies.begin(),
+				 reader[i].latencies.end());
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("%-12s %d readers %10.0f lookups/s %7.0f ns p50 %8.0f ns p99 "
+	       "%6.0f objects/s written\n", mode, readers, lookups / elapsed,
+	       latencies[latencies.size() / 2] * 1e9,
+	       latencies[latencies.size() * 99 / 100] * 1e9,
+	       replaced / elapsed);
+
+	if (errors) {
+		printf("%d lookups or writes failed\n", errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int objects = argc > 1 ? atoi(argv[1]) : 10000;
+	double seconds = argc > 2 ? atof(argv[2]) : 2;
+	cdap_rib::cdap_params params;
+	cdap_rib::vers_info_t version;
+	AppHandlers app_handlers;
+	RIBObj * obj;
+	int result = 0;
+
+	setLogLevel("ERR");
+
+	params.ipcp = false;
+	init(&app_handlers, params);
+	ribd = RIBDaemonProxyFactory();
+
+	version.version_ = 0x1;
+	ribd->createSchema(version);
+	handle = ribd->createRIB(version);
+
+	obj = new RIBObj("Bench");
+	ribd->addObjRIB(handle, "/bench", &obj);
+	for (int i = 0; i < objects; i++) {
+		std::stringstream ss;
+
+		ss << "/bench/" << i / SUBTREE_SIZE;
+		if (i % SUBTREE_SIZE == 0) {
+			obj = new RIBObj("Bench");
+			ribd->addObjRIB(handle, ss.str(), &obj);
+		}
+		ss << "/" << i;
+		names.push_back(ss.str());
+		obj = new RIBObj("Bench");
+		ribd->addObjRIB(handle, names.back(), &obj);
+	}
+
+	for (int readers = 1; readers <= MAX_READERS; readers *= 2)
+		result |= bench("locked", readers, seconds);
+
+	ribd->setReadMostly(handle);
+	for (int readers = 1; readers <= MAX_READERS; readers *= 2)
+		result |= bench("read-mostly", readers, seconds);
+
+	delete ribd;
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,249 @@
+//
+// RIB scoped read benchmark
+//
+// Measures the end-to-end time of reading 10k flow objects with a single
+// scoped M_READ, with one reply per object and with batched replies. The
+// replies are encoded and decoded as CDAP messages and handed back to the
+// RIB daemon of the requester, which passes them to its response handler.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+
+#define RINA_PREFIX "bench-rib-read"
+
+#include "librina/logs.h"
+#include "librina/rib_v2.h"
+#include "rib-loopback-provider.h"
+
+#define MAX_SDU_SIZE 10000
+
+using namespace rina;
+using namespace rina::rib;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A flow, as the IPCP RIB shows them under /dif/management/flows
+class FlowObj : public RIBObj {
+
+public:
+	FlowObj(int port_id, int padding = 0) : RIBObj("Flow")
+	{
+		std::stringstream ss;
+
+		ss << "Local address: 16; Remote address: 23; Port-id: "
+		   << port_id << "; QoS cube: 1; State: Allocated; "
+		   << "Source: rina.apps.echotime.client-1--; "
+		   << "Destination: rina.apps.echotime.server-1--";
+		value = ss.str() + std::string(padding, ' ');
+	}
+
+	void read(const cdap_rib::con_handle_t &con,
+		  const std::string& fqn,
+		  const std::string& class_,
+		  const cdap_rib::filt_info_t &filt,
+		  const int invoke_id,
+		  cdap_rib::obj_info_t &obj_reply,
+		  cdap_rib::res_info_t& res)
+	{
+		cdap::StringEncoder encoder;
+
+		(void) con; (void) fqn; (void) class_; (void) filt;
+		(void) invoke_id;
+		encoder.encode(value, obj_reply.value_);
+		res.code_ = cdap_rib::CDAP_SUCCESS;
+	}
+
+private:
+	std::string value;
+};
+
+// Counts the objects read, whatever their result
+class ReadHandler : public RIBOpsRespHandler {
+
+public:
+	ReadHandler() : objects(0), bytes(0) {};
+
+	void remoteReadResult(const cdap_rib::con_handle_t &con,
+			      const cdap_rib::obj_info_t &obj,
+			      const cdap_rib::res_info_t &res)
+	{
+		(void) con; (void) res;
+		objects++;
+		bytes += obj.value_.size_;
+	}
+
+	int objects;
+	long bytes;
+};
+
+static int bench(RIBDaemonProxy * ribd, LoopbackProvider& provider,
+		 const cdap_rib::con_handle_t& con, bool batch, int objects,
+		 int n, long * bytes = 0)
+{
+	cdap_rib::obj_info_t obj;
+	cdap_rib::flags_t flags;
+	cdap_rib::filt_info_t filt;
+	double start, elapsed = 0;
+
+	obj.name_ = "/dif/management/flows";
+	obj.class_ = "Flows";
+	flags.flags_ = batch ? cdap_rib::flags_t::F_RD_BATCH :
+			       cdap_rib::flags_t::NONE_FLAGS;
+	filt.scope_ = 1;
+
+	for (int i = 0; i < n; i++) {
+		ReadHandler handler;
+
+		provider.pdus = 0;
+		provider.bytes = 0;
+		provider.max_pdu = 0;
+		start = now_s();
+		ribd->remote_read(con, obj, flags, filt, &handler);
+		if (provider.read_flags.flags_ != flags.flags_) {
+			printf("Read request flags %d decoded as %d\n",
+			       flags.flags_, provider.read_flags.flags_);
+			return -1;
+		}
+		provider.rib_provider->read_request(con, provider.read_obj,
+					   provider.read_filt,
+					   provider.read_flags,
+					   provider.read_auth,
+					   provider.read_invoke_id);
+		elapsed += now_s() - start;
+
+		// The flows object itself and all the flows
+		if (handler.objects != objects + 1) {
+			printf("Read %d objects instead of %d\n",
+			       handler.objects, objects + 1);
+			return -1;
+		}
+		if (batch && provider.max_pdu > MAX_SDU_SIZE && !bytes) {
+			printf("Batched reply of %d bytes\n", provider.max_pdu);
+			return -1;
+		}
+		if (bytes)
+			*bytes = handler.bytes;
+	}
+
+	printf("%-10s %6d objects %6d PDUs %9ld bytes %9.2f ms/read\n",
+	       batch ? "batched" : "unbatched", objects + 1, provider.pdus,
+	       provider.bytes, elapsed * 1000 / n);
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int objects = argc > 1 ? atoi(argv[1]) : 10000;
+	int n = argc > 2 ? atoi(argv[2]) : 10;
+	cdap_rib::cdap_params params;
+	cdap_rib::vers_info_t version;
+	cdap_rib::con_handle_t con;
+	cdap::CDAPMessage message;
+	AppHandlers app_handlers;
+	RIBDaemonProxy * ribd;
+	rib_handle_t rib;
+	RIBObj * obj;
+	int result;
+
+	setLogLevel("ERR");
+
+	params.ipcp = false;
+	init(&app_handlers, params);
+	LoopbackProvider provider(params.syntax);
+	__set_cdap_provider(&provider);
+	provider.rib_provider = __get_rib_provider();
+	ribd = RIBDaemonProxyFactory();
+
+	version.version_ = 0x1;
+	ribd->createSchema(version);
+	rib = ribd->createRIB(version);
+	ribd->associateRIBtoAE(rib, "bench");
+	ribd->setReadBatchSize(rib, MAX_SDU_SIZE);
+
+	obj = new RIBObj("DIF");
+	ribd->addObjRIB(rib, "/dif", &obj);
+	obj = new RIBObj("Management");
+	ribd->addObjRIB(rib, "/dif/management", &obj);
+	obj = new RIBObj("Flows");
+	ribd->addObjRIB(rib, "/dif/management/flows", &obj);
+	for (int i = 1; i <= objects; i++) {
+		std::stringstream ss;
+
+		ss << "/dif/management/flows/" << i;
+		obj = new FlowObj(i);
+		ribd->addObjRIB(rib, ss.str(), &obj);
+	}
+
+	con.port_id = 1;
+	con.src_.ae_name_ = "bench";
+	con.version_ = version;
+	provider.rib_provider->open_connection(con, message);
+
+	// F_RD_BATCH combines with the other flags on the wire
+	{
+		cdap::cdap_m_t m_sent, m_rcv;
+		ser_obj_t sdu;
+
+		m_sent.op_code_ = cdap::cdap_m_t::M_READ;
+		m_sent.flags_ = static_cast<cdap_rib::flags_t::Flags>(
+				cdap_rib::flags_t::F_SYNC |
+				cdap_rib::flags_t::F_RD_BATCH);
+		provider.encoder.encode(m_sent, sdu);
+		provider.encoder.decode(sdu, m_rcv);
+		if (m_rcv.flags_ != m_sent.flags_) {
+			printf("Flags %d decoded as %d\n", m_sent.flags_,
+			       m_rcv.flags_);
+			return -1;
+		}
+	}
+
+	result = bench(ribd, provider, con, false, objects, n);
+	result |= bench(ribd, provider, con, true, objects, n);
+
+	// A flow bigger than a batch is read as well, in a reply of its own
+	{
+		long bytes, batched_bytes;
+
+		obj = new FlowObj(objects + 1, 3 * MAX_SDU_SIZE);
+		ribd->addObjRIB(rib, "/dif/management/flows/big", &obj);
+		result |= bench(ribd, provider, con, false, objects + 1, 1,
+				&bytes);
+		result |= bench(ribd, provider, con, true, objects + 1, 1,
+				&batched_bytes);
+		if (bytes != batched_bytes) {
+			printf("Read %ld bytes batched instead of %ld\n",
+			       batched_bytes, bytes);
+			result = -1;
+		}
+	}
+
+	delete ribd;
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,231 @@
+//
+// RIB object store benchmark
+//
+// Measures the cost of adding, looking up (by name and by instance id),
+// iterating with scoped reads and removing 100k objects, laid out as
+// /bench/<subtree>/<object> with 1000 objects per subtree.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <inttypes.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define RINA_PREFIX "bench-rib"
+
+#include "librina/logs.h"
+#include "librina/rib_v2.h"
+#include "rib-loopback-provider.h"
+
+#define SUBTREE_SIZE 1000
+
+using namespace rina;
+using namespace rina::rib;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char * op, int n, double elapsed)
+{
+	printf("%-24s %8d ops %10.1f ns/op\n", op, n, elapsed * 1e9 / n);
+}
+
+// Serves a scoped read of name; returns the objects read
+static int scoped_read(LoopbackProvider& provider,
+		       const cdap_rib::con_handle_t& con,
+		       const std::string& name, int scope)
+{
+	cdap_rib::obj_info_t obj;
+	cdap_rib::flags_t flags;
+	cdap_rib::filt_info_t filt;
+	cdap_rib::auth_policy_t auth;
+
+	obj.name_ = name;
+	obj.class_ = "Bench";
+	filt.scope_ = scope;
+
+	provider.pdus = 0;
+	provider.rib_provider->read_request(con, obj, filt, flags, auth, 1);
+
+	return provider.pdus;
+}
+
+static int bench(RIBDaemonProxy * ribd, LoopbackProvider& provider,
+		 const rib_handle_t& rib, const cdap_rib::con_handle_t& con,
+		 int objects)
+{
+	std::vector<std::string> names;
+	std::vector<int64_t> ids;
+	int subtrees = (objects + SUBTREE_SIZE - 1) / SUBTREE_SIZE;
+	int64_t sum = 0;
+	double start;
+	RIBObj * obj;
+
+	for (int i = 0; i < objects; i++) {
+		std::stringstream ss;
+
+		ss << "/bench/" << i / SUBTREE_SIZE << "/" << i;
+		names.push_back(ss.str());
+	}
+	ids.resize(objects);
+
+	obj = new RIBObj("Bench");
+	ribd->addObjRIB(rib, "/bench", &obj);
+	for (int i = 0; i < subtrees; i++) {
+		std::stringstream ss;
+
+		ss << "/bench/" << i;
+		obj = new RIBObj("Bench");
+		ribd->addObjRIB(rib, ss.str(), &obj);
+	}
+
+	start = now_s();
+	for (int i = 0; i < objects; i++) {
+		obj = new RIBObj("Bench");
+		ids[i] = ribd->addObjRIB(rib, names[i], &obj);
+	}
+	report("add", objects, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < objects; i++) {
+		int j = (i * 7919) % objects;
+
+		if (ribd->getObjInstId(rib, names[j]) != ids[j]) {
+			printf("Wrong instance id for %s\n", names[j].c_str());
+			return -1;
+		}
+	}
+	report("lookup by name", objects, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < objects; i++) {
+		int j = (i * 7919) % objects;
+
+		sum += ribd->getObjFqn(rib, ids[j]).size();
+	}
+	report("lookup by id", objects, now_s() - start);
+	if (sum <= 0)
+		return -1;
+
+	start = now_s();
+	for (int i = 0; i < subtrees; i++) {
+		std::stringstream ss;
+		int expected = i < subtrees - 1 ? SUBTREE_SIZE :
+			       objects - i * SUBTREE_SIZE;
+
+		ss << "/bench/" << i;
+		if (scoped_read(provider, con, ss.str(), 1) !=
+				expected + 1) {
+			printf("Wrong number of objects read from %s\n",
+			       ss.str().c_str());
+			return -1;
+		}
+	}
+	report("scoped read (1 subtree)", subtrees, now_s() - start);
+
+	start = now_s();
+	if (scoped_read(provider, con, "/bench", 2) !=
+			objects + subtrees + 1) {
+		printf("Wrong number of objects read from /bench\n");
+		return -1;
+	}
+	report("scoped read (all)", 1, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < objects; i++) {
+		int j = (i * 7919) % objects;
+
+		ribd->removeObjRIB(rib, ids[j]);
+	}
+	report("remove", objects, now_s() - start);
+
+	// The first object removed gives its slot to the next one added,
+	// under a new id
+	obj = new RIBObj("Bench");
+	ids[1] = ribd->addObjRIB(rib, names[1], &obj);
+	if (ids[1] == ids[0] || (ids[1] & 0xffffffff) != (ids[0] & 0xffffffff)) {
+		printf("Instance id %" PRId64 " reused for %s\n", ids[1],
+		       names[1].c_str());
+		return -1;
+	}
+	try {
+		ribd->getObjFqn(rib, ids[0]);
+		printf("The id of a removed object names %s\n",
+		       names[1].c_str());
+		return -1;
+	} catch (Exception &e) {
+	}
+	ribd->removeObjRIB(rib, ids[1]);
+
+	for (int i = 0; i < subtrees; i++) {
+		std::stringstream ss;
+
+		ss << "/bench/" << i;
+		ribd->removeObjRIB(rib, ss.str());
+	}
+	ribd->removeObjRIB(rib, "/bench");
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int objects = argc > 1 ? atoi(argv[1]) : 100000;
+	cdap_rib::cdap_params params;
+	cdap_rib::vers_info_t version;
+	cdap_rib::con_handle_t con;
+	cdap::CDAPMessage message;
+	AppHandlers app_handlers;
+	RIBDaemonProxy * ribd;
+	rib_handle_t rib;
+	int result;
+
+	setLogLevel("ERR");
+
+	params.ipcp = false;
+	init(&app_handlers, params);
+	LoopbackProvider provider(params.syntax);
+	provider.loopback = false;
+	__set_cdap_provider(&provider);
+	provider.rib_provider = __get_rib_provider();
+	ribd = RIBDaemonProxyFactory();
+
+	version.version_ = 0x1;
+	ribd->createSchema(version);
+	rib = ribd->createRIB(version);
+	ribd->associateRIBtoAE(rib, "bench");
+
+	con.port_id = 1;
+	con.src_.ae_name_ = "bench";
+	con.version_ = version;
+	provider.rib_provider->open_connection(con, message);
+
+	result = bench(ribd, provider, rib, con, objects);
+
+	delete ribd;
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,156 @@
+//
+// Timer microbenchmark
+//
+// Measures schedule, cancel and fire throughput of rina::Timer, as
+// well as the firing jitter (actual minus requested delay).
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "librina/timer.h"
+
+using namespace rina;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+class NopTimerTask: public TimerTask {
+public:
+	void run() {};
+};
+
+static ConditionVariable fired_cond;
+static int fired = 0;
+
+class CountTimerTask: public TimerTask {
+public:
+	void run() {
+		fired_cond.lock();
+		fired++;
+		fired_cond.signal();
+		fired_cond.unlock();
+	};
+};
+
+static Lockable jitter_lock;
+static std::vector<double> jitter;
+
+class JitterTimerTask: public TimerTask {
+public:
+	JitterTimerTask(long delay_ms) {
+		expected_ = now_s() + delay_ms / 1000.0;
+	};
+	void run() {
+		ScopedLock g(jitter_lock);
+		jitter.push_back((now_s() - expected_) * 1000.0);
+	};
+private:
+	double expected_;
+};
+
+static void report(const char * name, int n, double elapsed)
+{
+	printf("%-28s %8d ops %10.1f ns/op %12.0f ops/s\n", name, n,
+	       elapsed * 1e9 / n, n / elapsed);
+}
+
+int main(int argc, char * argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 100000;
+	int jitter_tasks = argc > 2 ? atoi(argv[2]) : 2000;
+	std::vector<TimerHandle> handles(n);
+	std::vector<TimerTask *> tasks(n);
+	double start;
+	Timer * timer;
+
+	srand(1);
+
+	// Schedule + cancel by handle
+	timer = new Timer();
+	start = now_s();
+	for (int i = 0; i < n; i++)
+		handles[i] = timer->scheduleTask(new NopTimerTask(),
+						 10000 + rand() % 3600000);
+	report("schedule", n, now_s() - start);
+
+	start = now_s();
+	for (int i = 0; i < n; i++)
+		timer->cancelTask(handles[i]);
+	report("cancel (handle)", n, now_s() - start);
+	delete timer;
+
+	// Cancel by task pointer
+	timer = new Timer();
+	for (int i = 0; i < n; i++) {
+		tasks[i] = new NopTimerTask();
+		timer->scheduleTask(tasks[i], 10000 + rand() % 3600000);
+	}
+	start = now_s();
+	for (int i = 0; i < n; i++)
+		timer->cancelTask(tasks[i]);
+	report("cancel (task pointer)", n, now_s() - start);
+	delete timer;
+
+	// Fire throughput: all tasks spread over the next 100 ms
+	timer = new Timer();
+	fired = 0;
+	start = now_s();
+	for (int i = 0; i < n; i++)
+		timer->scheduleTask(new CountTimerTask(), rand() % 100);
+	fired_cond.lock();
+	while (fired < n)
+		fired_cond.doWait();
+	fired_cond.unlock();
+	report("schedule + fire", n, now_s() - start);
+	delete timer;
+
+	// Jitter, with delays up to 2 s
+	timer = new Timer();
+	for (int i = 0; i < jitter_tasks; i++) {
+		long delay = rand() % 2000;
+		timer->scheduleTask(new JitterTimerTask(delay), delay);
+	}
+	Sleep sleep;
+	sleep.sleepForMili(2500);
+	delete timer;
+
+	std::sort(jitter.begin(), jitter.end());
+	if (jitter.empty()) {
+		printf("jitter: no task fired\n");
+		return -1;
+	}
+
+	double sum = 0;
+	for (size_t i = 0; i < jitter.size(); i++)
+		sum += jitter[i];
+	printf("jitter (%d tasks, ms): mean %.3f p50 %.3f p99 %.3f max %.3f\n",
+	       (int) jitter.size(), sum / jitter.size(),
+	       jitter[jitter.size() / 2], jitter[jitter.size() * 99 / 100],
+	       jitter.back());
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Netlink parsers test fixtures
+//
+// Messages used both by the netlink parsers tests and benchmark.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#ifndef LIBRINA_TEST_NETLINK_PARSERS_FIXTURES_H
+#define LIBRINA_TEST_NETLINK_PARSERS_FIXTURES_H
+
+#include "netlink-parsers.h"
+
+namespace rina {
+
+static inline void
+fillIpcmAllocateFlowRequestMessage(IpcmAllocateFlowRequestMessage& message)
+{
+	ApplicationProcessNamingInformation sourceName;
+	sourceName.processName = "/apps/source";
+	sourceName.processInstance = "1";
+	sourceName.entityName = "database";
+	sourceName.entityInstance = "1234";
+	message.setSourceAppName(sourceName);
+	ApplicationProcessNamingInformation destName;
+	destName.processName = "/apps/dest";
+	destName.processInstance = "4";
+	destName.entityName = "server";
+	destName.entityInstance = "342";
+	message.setDestAppName(destName);
+	FlowSpecification flowSpec;
+	message.setFlowSpec(flowSpec);
+	ApplicationProcessNamingInformation difName;
+	difName.processName = "/difs/Test.DIF";
+	message.setDifName(difName);
+}
+
+/**
+ * The two entries of the original test, repeated until there are
+ * numEntries of them with distinct addresses
+ */
+static inline void
+fillRmtModifyPDUFTEntriesRequestMessage(
+		RmtModifyPDUFTEntriesRequestMessage& message,
+		unsigned int numEntries = 2)
+{
+	for (unsigned int i = 0; i < numEntries; i += 2) {
+		PDUForwardingTableEntry * entry1 = new PDUForwardingTableEntry();
+		entry1->setAddress(23 + i);
+		entry1->portIdAltlists.push_back(34);
+		entry1->portIdAltlists.push_back(29);
+		entry1->portIdAltlists.push_back(36);
+		entry1->setQosId(1);
+		message.addEntry(entry1);
+		if (i + 1 == numEntries) {
+			break;
+		}
+		PDUForwardingTableEntry * entry2 = new PDUForwardingTableEntry();
+		entry2->setAddress(20 + i);
+		entry2->portIdAltlists.push_back(28);
+		entry2->portIdAltlists.push_back(35);
+		entry2->portIdAltlists.push_back(43);
+		entry2->setQosId(2);
+		message.addEntry(entry2);
+	}
+	message.setMode(1);
+}
+
+static inline void
+fillIPCPWriteMgmtSDURequestMessage(IPCPWriteMgmtSDURequestMessage& message,
+				   int size = 20)
+{
+	message.sdu = new unsigned char[size];
+	memset(message.sdu, 0x5a, size);
+	message.size = size;
+	message.port_id = 30;
+	message.address = 54;
+}
+
+static inline void
+fillIPCPReadMgmtSDUNotificationMessage(
+		IPCPReadMgmtSDUNotificationMessage& message, int size = 20)
+{
+	message.sdu = new unsigned char[size];
+	memset(message.sdu, 0xa5, size);
+	message.size = size;
+	message.port_id = 30;
+}
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+//
+// CDAP provider looping RIB read replies back to the RIB daemon
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#ifndef LIBRINA_TEST_RIB_LOOPBACK_PROVIDER_H
+#define LIBRINA_TEST_RIB_LOOPBACK_PROVIDER_H
+
+#include "librina/cdap_v2.h"
+#include "librina/rib_v2.h"
+
+namespace rina { namespace rib {
+void __set_cdap_provider(cdap::CDAPProviderInterface* p);
+cdap::CDAPCallbackInterface* __get_rib_provider(void);
+}}
+
+namespace rina {
+
+class AppHandlers : public cacep::AppConHandlerInterface {
+
+public:
+	void connect(const cdap::CDAPMessage& message,
+		     cdap_rib::con_handle_t &con) { (void) message; (void) con; }
+	void connectResult(const cdap::CDAPMessage& message,
+			   cdap_rib::con_handle_t &con)
+	{ (void) message; (void) con; }
+	void release(int invoke_id, const cdap_rib::con_handle_t &con)
+	{ (void) invoke_id; (void) con; }
+	void releaseResult(const cdap_rib::res_info_t &res,
+			   const cdap_rib::con_handle_t &con)
+	{ (void) res; (void) con; }
+	void process_authentication_message(const cdap::CDAPMessage& message,
+					    const cdap_rib::con_handle_t &con)
+	{ (void) message; (void) con; }
+};
+
+// Sends the replies back to the RIB daemon through the CDAP encoder, as
+// if the requester were at the other end of a management flow, and
+// keeps the last read request so that it can be served locally
+class LoopbackProvider : public cdap::CDAPProviderInterface {
+
+public:
+	LoopbackProvider(cdap_rib::concrete_syntax_t& syntax) :
+		encoder(syntax), rib_provider(0), loopback(true), pdus(0),
+		bytes(0), max_pdu(0), read_invoke_id(0) {};
+
+	cdap_rib::con_handle_t remote_open_connection(
+			const cdap_rib::vers_info_t &ver,
+			const cdap_rib::ep_info_t &src,
+			const cdap_rib::ep_info_t &dest,
+			const cdap_rib::auth_policy &auth, int port)
+	{
+		(void) ver; (void) src; (void) dest; (void) auth; (void) port;
+		return cdap_rib::con_handle_t();
+	}
+	int remote_close_connection(unsigned int port, bool need_reply)
+	{ (void) port; (void) need_reply; return 0; }
+	int remote_create(const cdap_rib::con_handle_t &con,
+			  const cdap_rib::obj_info_t &obj,
+			  const cdap_rib::flags_t &flags,
+			  const cdap_rib::filt_info_t &filt,
+			  const cdap_rib::auth_policy &auth,
+			  const int invoke_id) { return 0; }
+	int remote_delete(const cdap_rib::con_handle_t &con,
+			  const cdap_rib::obj_info_t &obj,
+			  const cdap_rib::flags_t &flags,
+			  const cdap_rib::filt_info_t &filt,
+			  const cdap_rib::auth_policy &auth,
+			  const int invoke_id) { return 0; }
+	int remote_read(const cdap_rib::con_handle_t &con,
+			const cdap_rib::obj_info_t &obj,
+			const cdap_rib::flags_t &flags,
+			const cdap_rib::filt_info_t &filt,
+			const cdap_rib::auth_policy &auth,
+			const int invoke_id)
+	{
+		cdap::cdap_m_t m_sent, m_rcv;
+		ser_obj_t sdu;
+
+		// The flags go through the encoder, as they would on a flow
+		cdap::CDAPMessageFactory::getReadObjectRequestMessage(m_sent,
+				filt, flags, obj);
+		encoder.encode(m_sent, sdu);
+		encoder.decode(sdu, m_rcv);
+
+		read_obj = obj;
+		read_flags.flags_ = m_rcv.flags_;
+		read_filt = filt;
+		read_auth = auth;
+		read_invoke_id = invoke_id;
+		return 0;
+	}
+	int remote_cancel_read(const cdap_rib::con_handle_t &con,
+			       const cdap_rib::flags_t &flags,
+			       const cdap_rib::auth_policy &auth,
+			       const int invoke_id) { return 0; }
+	int remote_write(const cdap_rib::con_handle_t &con,
+			 const cdap_rib::obj_info_t &obj,
+			 const cdap_rib::flags_t &flags,
+			 const cdap_rib::filt_info_t &filt,
+			 const cdap_rib::auth_policy &auth,
+			 const int invoke_id) { return 0; }
+	int remote_start(const cdap_rib::con_handle_t &con,
+			 const cdap_rib::obj_info_t &obj,
+			 const cdap_rib::flags_t &flags,
+			 const cdap_rib::filt_info_t &filt,
+			 const cdap_rib::auth_policy &auth,
+			 const int invoke_id) { return 0; }
+	int remote_stop(const cdap_rib::con_handle_t &con,
+			const cdap_rib::obj_info_t &obj,
+			const cdap_rib::flags_t &flags,
+			const cdap_rib::filt_info_t &filt,
+			const cdap_rib::auth_policy &auth,
+			const int invoke_id) { return 0; }
+
+	void send_open_connection_result(const cdap_rib::con_handle_t &con,
+					 const cdap_rib::res_info_t &res,
+					 const cdap_rib::auth_policy_t &auth,
+					 int invoke_id) {}
+	void send_open_connection_result(const cdap_rib::con_handle_t &con,
+					 const cdap_rib::res_info_t &res,
+					 int invoke_id) {}
+	void send_close_connection_result(unsigned int port,
+					  const cdap_rib::flags_t &flags,
+					  const cdap_rib::res_info_t &res,
+					  int invoke_id) {}
+	void send_create_result(const cdap_rib::con_handle_t &con,
+				const cdap_rib::obj_info_t &obj,
+				const cdap_rib::flags_t &flags,
+				const cdap_rib::res_info_t &res,
+				int invoke_id) {}
+	void send_delete_result(const cdap_rib::con_handle_t &con,
+				const cdap_rib::obj_info_t &obj,
+				const cdap_rib::flags_t &flags,
+				const cdap_rib::res_info_t &res,
+				int invoke_id) {}
+	void send_read_result(const cdap_rib::con_handle_t &con,
+			      const cdap_rib::obj_info_t &obj,
+			      const cdap_rib::flags_t &flags,
+			      const cdap_rib::res_info_t &res,
+			      int invoke_id)
+	{
+		cdap::cdap_m_t m_sent, m_rcv;
+		ser_obj_t sdu;
+
+		if (!loopback) {
+			pdus++;
+			return;
+		}
+
+		cdap::CDAPMessageFactory::getReadObjectResponseMessage(m_sent,
+				flags, obj, res, invoke_id);
+		encoder.encode(m_sent, sdu);
+		pdus++;
+		bytes += sdu.size_;
+		if (sdu.size_ > max_pdu)
+			max_pdu = sdu.size_;
+
+		encoder.decode(sdu, m_rcv);
+		cdap_rib::obj_info_t obj_rcv;
+		obj_rcv.class_ = m_rcv.obj_class_;
+		obj_rcv.name_ = m_rcv.obj_name_;
+		obj_rcv.inst_ = m_rcv.obj_inst_;
+		SerObjLoan value(obj_rcv.value_, m_rcv.obj_value_);
+		cdap_rib::res_info_t res_rcv;
+		res_rcv.code_ =
+			static_cast<cdap_rib::res_code_t>(m_rcv.result_);
+		res_rcv.reason_ = m_rcv.result_reason_;
+		cdap_rib::flags_t flags_rcv;
+		flags_rcv.flags_ = m_rcv.flags_;
+
+		rib_provider->remote_read_result(con, obj_rcv, res_rcv,
+						 flags_rcv, m_rcv.invoke_id_);
+	}
+	void send_cancel_read_result(const cdap_rib::con_handle_t &con,
+				     const cdap_rib::flags_t &flags,
+				     const cdap_rib::res_info_t &res,
+				     int invoke_id) {}
+	void send_write_result(const cdap_rib::con_handle_t &con,
+			       const cdap_rib::flags_t &flags,
+			       const cdap_rib::res_info_t &res,
+			       int invoke_id) {}
+	void send_start_result(const cdap_rib::con_handle_t &con,
+			       const cdap_rib::obj_info_t &obj,
+			       const cdap_rib::flags_t &flags,
+			       const cdap_rib::res_info_t &res,
+			       int invoke_id) {}
+	void send_stop_result(const cdap_rib::con_handle_t &con,
+			      const cdap_rib::flags_t &flags,
+			      const cdap_rib::res_info_t &res,
+			      int invoke_id) {}
+	void send_cdap_result(const cdap_rib::con_handle_t &con,
+			      cdap::cdap_m_t *cdap_m) {}
+	void process_message(ser_obj_t &message, unsigned int port,
+			     cdap_rib::cdap_dest_t cdap_dest) {}
+	void set_cdap_io_handler(cdap::CDAPIOHandler * handler) {}
+	cdap::CDAPIOHandler * get_cdap_io_handler() { return 0; }
+	cdap::CDAPSessionManagerInterface * get_session_manager()
+	{
+		return cdap::getProvider()->get_session_manager();
+	}
+
+	cdap::CDAPMessageEncoder encoder;
+
+	// The RIB daemon the replies are handed to
+	cdap::CDAPCallbackInterface * rib_provider;
+
+	// If false, replies are only counted
+	bool loopback;
+
+	int pdus;
+	long bytes;
+	int max_pdu;
+
+	// The last read request
+	cdap_rib::obj_info_t read_obj;
+	cdap_rib::flags_t read_flags;
+	cdap_rib::filt_info_t read_filt;
+	cdap_rib::auth_policy_t read_auth;
+	int read_invoke_id;
+};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+//
+// CDAP invoke id manager test
+//
+// Checks that the invoke id manager hands out the lowest free ids and
+// never the same id twice, with 64k outstanding ids and with several
+// threads allocating and freeing concurrently.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#include "librina/cdap_v2.h"
+#include "librina/concurrency.h"
+
+#define OUTSTANDING_IDS (64 * 1024)
+#define NUM_THREADS     8
+#define CHURN_ROUNDS    200
+#define CHURN_IDS       64
+
+using namespace rina;
+using namespace rina::cdap;
+
+static double nowInSeconds()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static CDAPInvokeIdManager * ids;
+
+// One flag per id, set while a thread owns it
+static std::vector<int> owners;
+static int errors = 0;
+
+static bool own(int id)
+{
+	if (id <= 0 || id >= (int) owners.size()) {
+		printf("Invoke id %d out of range\n", id);
+		return false;
+	}
+	return __atomic_exchange_n(&owners[id], 1, __ATOMIC_SEQ_CST) == 0;
+}
+
+static void disown(int id)
+{
+	__atomic_store_n(&owners[id], 0, __ATOMIC_SEQ_CST);
+}
+
+static void * allocateMany(void * arg)
+{
+	std::vector<int> * mine = (std::vector<int> *) arg;
+
+	for (size_t i = 0; i < mine->capacity(); i++) {
+		int id = ids->newInvokeId(true);
+		if (!own(id))
+			__atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+		mine->push_back(id);
+	}
+
+	return 0;
+}
+
+static void * churn(void * arg)
+{
+	(void) arg;
+	int held[CHURN_IDS];
+
+	for (int r = 0; r < CHURN_ROUNDS; r++) {
+		for (int i = 0; i < CHURN_IDS; i++) {
+			held[i] = ids->newInvokeId(true);
+			if (!own(held[i]))
+				__atomic_add_fetch(&errors, 1,
+						   __ATOMIC_RELAXED);
+		}
+		for (int i = 0; i < CHURN_IDS; i++) {
+			disown(held[i]);
+			// A response received frees an id we sent
+			ids->freeInvokeId(held[i], false);
+		}
+	}
+
+	return 0;
+}
+
+static int runThreads(void * (* work)(void *), std::vector<int> * args)
+{
+	Thread * threads[NUM_THREADS];
+	void * status;
+
+	ThreadAttributes * threadAttributes = new ThreadAttributes();
+	threadAttributes->setJoinable();
+	for (int i = 0; i < NUM_THREADS; i++) {
+		threads[i] = new Thread(work, args ? (void *) &args[i] : 0,
+					threadAttributes);
+		threads[i]->start();
+	}
+	delete threadAttributes;
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		threads[i]->join(&status);
+		delete threads[i];
+	}
+
+	return errors;
+}
+
+static int testSequential()
+{
+	double start;
+	int id;
+
+	start = nowInSeconds();
+	for (int i = 1; i <= OUTSTANDING_IDS; i++) {
+		id = ids->newInvokeId(true);
+		if (id != i) {
+			printf("Expected invoke id %d, got %d\n", i, id);
+			return -1;
+		}
+	}
+	printf("Allocated %d invoke ids in %.3f ms\n", OUTSTANDING_IDS,
+	       (nowInSeconds() - start) * 1000);
+
+	// Freed ids are reused lowest first
+	for (int i = 2; i <= OUTSTANDING_IDS; i += 2)
+		ids->freeInvokeId(i, false);
+	for (int i = 2; i <= OUTSTANDING_IDS; i += 2) {
+		id = ids->newInvokeId(true);
+		if (id != i) {
+			printf("Expected reused invoke id %d, got %d\n", i, id);
+			return -1;
+		}
+	}
+
+	// Reserved ids are skipped, including ids out of the bitmap
+	ids->freeInvokeId(10, false);
+	ids->freeInvokeId(11, false);
+	ids->reserveInvokeId(10, true);
+	ids->reserveInvokeId(10, true);
+	id = ids->newInvokeId(true);
+	if (id != 11) {
+		printf("Expected invoke id 11 after reserving 10, got %d\n", id);
+		return -1;
+	}
+	ids->reserveInvokeId(1 << 30, true);
+	ids->freeInvokeId(1 << 30, false);
+
+	// Sent and received ids are independent
+	id = ids->newInvokeId(false);
+	if (id != 1) {
+		printf("Expected received invoke id 1, got %d\n", id);
+		return -1;
+	}
+	ids->freeInvokeId(id, true);
+
+	start = nowInSeconds();
+	for (int i = 1; i <= OUTSTANDING_IDS; i++)
+		ids->freeInvokeId(i, false);
+	printf("Freed %d invoke ids in %.3f ms\n", OUTSTANDING_IDS,
+	       (nowInSeconds() - start) * 1000);
+
+	id = ids->newInvokeId(true);
+	ids->freeInvokeId(id, false);
+	if (id != 1) {
+		printf("Expected invoke id 1 once all are free, got %d\n", id);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int testConcurrent()
+{
+	std::vector<int> mine[NUM_THREADS];
+	double start;
+
+	owners.assign(OUTSTANDING_IDS + 1, 0);
+	for (int i = 0; i < NUM_THREADS; i++)
+		mine[i].reserve(OUTSTANDING_IDS / NUM_THREADS);
+
+	// Without frees, the ids handed out must be exactly 1..64k
+	start = nowInSeconds();
+	if (runThreads(allocateMany, mine)) {
+		printf("Invoke ids allocated twice or out of range\n");
+		return -1;
+	}
+	printf("%d threads allocated %d invoke ids in %.3f ms\n",
+	       NUM_THREADS, OUTSTANDING_IDS, (nowInSeconds() - start) * 1000);
+
+	// Free half of them, then churn over the holes
+	for (int i = 0; i < NUM_THREADS; i++) {
+		for (size_t j = 0; j < mine[i].size(); j += 2) {
+			disown(mine[i][j]);
+			ids->freeInvokeId(mine[i][j], false);
+		}
+	}
+	start = nowInSeconds();
+	if (runThreads(churn, 0)) {
+		printf("Invoke ids allocated twice or out of range\n");
+		return -1;
+	}
+	printf("%d threads churned %d invoke ids in %.3f ms\n", NUM_THREADS,
+	       NUM_THREADS * CHURN_ROUNDS * CHURN_IDS,
+	       (nowInSeconds() - start) * 1000);
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		for (size_t j = 1; j < mine[i].size(); j += 2)
+			ids->freeInvokeId(mine[i][j], false);
+	}
+
+	int id = ids->newInvokeId(true);
+	ids->freeInvokeId(id, false);
+	if (id != 1) {
+		printf("Expected invoke id 1 once all are free, got %d\n", id);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main()
+{
+	cdap_rib::concrete_syntax_t syntax;
+
+	init(0, syntax, true);
+	ids = getProvider()->get_session_manager()->get_invoke_id_manager();
+
+	if (testSequential() || testConcurrent()) {
+		fini();
+		return -1;
+	}
+	fini();
+
+	printf("Invoke id manager tests passed\n");
+	return 0;
+}
@@ -22,12 +22,15 @@
 
 #include <iostream>
 #include <math.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "librina/concurrency.h"
 
 #define NUM_THREADS 5
 #define TRIGGER     10
+#define MPSC_ITEMS  200000
+#define MPSC_BATCH  64
 
 using namespace rina;
 
@@ -233,6 +236,106 @@ void * doWorkConsume(void * arg)
 	return (void *) 0;
 }
 
+struct SeqItem {
+	intptr_t producer;
+	int seq;
+};
+
+struct MPSCArgs {
+	LockFreeMPSCQueue<SeqItem> * lfqueue;
+	BlockingFIFOQueue<SeqItem> * bqueue;
+	SeqItem * items;
+	intptr_t producer;
+};
+
+void * doWorkProduceMPSC(void * arg)
+{
+	MPSCArgs * args = (MPSCArgs *) arg;
+
+	for (int i = 0; i < MPSC_ITEMS; i++) {
+		args->items[i].producer = args->producer;
+		args->items[i].seq = i;
+		if (args->lfqueue)
+			args->lfqueue->put(&args->items[i]);
+		else
+			args->bqueue->put(&args->items[i]);
+	}
+
+	return (void *) 0;
+}
+
+static double nowInSeconds()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Runs nproducers against one consumer, checks per-producer FIFO order
+ * and returns the throughput in items per second (-1 on error) */
+static double runMPSCContention(int nproducers, bool lockfree)
+{
+	LockFreeMPSCQueue<SeqItem> lfqueue(1024);
+	BlockingFIFOQueue<SeqItem> bqueue;
+	MPSCArgs args[NUM_THREADS];
+	Thread * threads[NUM_THREADS];
+	std::vector<SeqItem *> batch;
+	int next[NUM_THREADS];
+	int total = nproducers * MPSC_ITEMS;
+	int received = 0;
+	double start;
+	void * status;
+	bool ordered = true;
+
+	ThreadAttributes * threadAttributes = new ThreadAttributes();
+	threadAttributes->setJoinable();
+	start = nowInSeconds();
+	for (int i = 0; i < nproducers; i++) {
+		args[i].lfqueue = lockfree ? &lfqueue : 0;
+		args[i].bqueue = lockfree ? 0 : &bqueue;
+		args[i].items = new SeqItem[MPSC_ITEMS];
+		args[i].producer = i;
+		next[i] = 0;
+		threads[i] = new Thread(&doWorkProduceMPSC, (void *) &args[i],
+					threadAttributes);
+		threads[i]->start();
+	}
+	delete threadAttributes;
+
+	while (received < total) {
+		batch.clear();
+		if (lockfree) {
+			if (lfqueue.takeBatch(batch, MPSC_BATCH) == 0) {
+				sched_yield();
+				continue;
+			}
+		} else {
+			batch.push_back(bqueue.take());
+		}
+
+		for (size_t j = 0; j < batch.size(); j++) {
+			if (batch[j]->seq != next[batch[j]->producer]++)
+				ordered = false;
+		}
+		received += batch.size();
+	}
+	double elapsed = nowInSeconds() - start;
+
+	for (int i = 0; i < nproducers; i++) {
+		threads[i]->join(&status);
+		delete threads[i];
+		delete[] args[i].items;
+	}
+
+	if (!ordered || !lfqueue.empty() || bqueue.poll() != 0) {
+		std::cout << "MPSC queue lost or reordered elements\n";
+		return -1;
+	}
+
+	return total / elapsed;
+}
+
 int main()
 {
 	std::cout << "TESTING CONCURRENCY WRAPPER CLASSES\n";
@@ -395,6 +498,29 @@ int main()
 	delete counter2;
 	delete queueWithCounter;
 
+	/* Test lock-free MPSC queue, and compare it under contention */
+	LockFreeMPSCQueue<Person> smallQueue(2);
+	Person p1, p2, p3;
+	if (!smallQueue.try_put(&p1) || !smallQueue.try_put(&p2) ||
+			smallQueue.try_put(&p3) || smallQueue.poll() != &p1 ||
+			!smallQueue.try_put(&p3) || smallQueue.poll() != &p2 ||
+			smallQueue.poll() != &p3 || smallQueue.poll() != 0) {
+		std::cout << "Error, lock-free MPSC queue is not FIFO\n";
+		return -1;
+	}
+
+	for (int producers = 1; producers < NUM_THREADS; producers++) {
+		double locked = runMPSCContention(producers, false);
+		double lockfree = runMPSCContention(producers, true);
+
+		if (locked < 0 || lockfree < 0)
+			return -1;
+
+		std::cout << producers << " producer(s): BlockingFIFOQueue "
+			  << (long) locked << " items/s, LockFreeMPSCQueue "
+			  << (long) lockfree << " items/s\n";
+	}
+
 	/* Test exit */
 	Thread::exit(NULL);
 	/*
@@ -23,6 +23,7 @@
 #include <iostream>
 
 #include "netlink-parsers.h"
+#include "netlink-parsers-fixtures.h"
 
 using namespace rina;
 
@@ -1694,23 +1695,7 @@ int testIpcmAllocateFlowRequestMessage() {
 	int returnValue = 0;
 
 	IpcmAllocateFlowRequestMessage message;
-	ApplicationProcessNamingInformation sourceName;
-	sourceName.processName = "/apps/source";
-	sourceName.processInstance = "1";
-	sourceName.entityName = "database";
-	sourceName.entityInstance = "1234";
-	message.setSourceAppName(sourceName);
-	ApplicationProcessNamingInformation destName;
-	destName.processName = "/apps/dest";
-	destName.processInstance = "4";
-	destName.entityName = "server";
-	destName.entityInstance = "342";
-	message.setDestAppName(destName);
-	FlowSpecification flowSpec;
-	message.setFlowSpec(flowSpec);
-	ApplicationProcessNamingInformation difName;
-	difName.processName = "/difs/Test.DIF";
-	message.setDifName(difName);
+	fillIpcmAllocateFlowRequestMessage(message);
 
 	struct nl_msg* netlinkMessage;
 	netlinkMessage = nlmsg_alloc();
@@ -2616,21 +2601,7 @@ int testRmtModifyPDUFTEntriesRequestMessage() {
         std::list<PortIdAltlist> portIdsList;
 
         RmtModifyPDUFTEntriesRequestMessage message;
-        PDUForwardingTableEntry * entry1 = new PDUForwardingTableEntry();
-        entry1->setAddress(23);
-        entry1->portIdAltlists.push_back(34);
-        entry1->portIdAltlists.push_back(29);
-        entry1->portIdAltlists.push_back(36);
-        entry1->setQosId(1);
-        message.addEntry(entry1);
-        PDUForwardingTableEntry * entry2 = new PDUForwardingTableEntry();
-        entry2->setAddress(20);
-        entry2->portIdAltlists.push_back(28);
-        entry2->portIdAltlists.push_back(35);
-        entry2->portIdAltlists.push_back(43);
-        entry2->setQosId(2);
-        message.addEntry(entry2);
-        message.setMode(1);
+        fillRmtModifyPDUFTEntriesRequestMessage(message);
 
         struct nl_msg* netlinkMessage;
         netlinkMessage = nlmsg_alloc();
@@ -2669,9 +2640,12 @@ int testRmtModifyPDUFTEntriesRequestMessage() {
 
 
         entriesList = recoveredMessage->getEntries();
+        std::list<PDUForwardingTableEntry *>::const_iterator original =
+                        message.getEntries().begin();
         for (iterator = entriesList.begin();
-                        iterator != entriesList.end();
-                        ++iterator) {
+                        iterator != entriesList.end() &&
+                        original != message.getEntries().end();
+                        ++iterator, ++original) {
                 portIdsList = (*iterator)->portIdAltlists;
                 if (portIdsList.size() != 3) {
                         std::cout << "Size of portids in original and recovered messages"
@@ -2687,6 +2661,27 @@ int testRmtModifyPDUFTEntriesRequestMessage() {
 				std::cout << *it3 <<std::endl;
 			}
                 }
+
+                if (**iterator != **original) {
+                        std::cout << "Entry on original and recovered messages"
+                                        << " are different\n";
+                        returnValue = -1;
+                }
+
+                if (portIdsList.size() != (*original)->portIdAltlists.size())
+                        continue;
+
+                std::list<PortIdAltlist>::const_iterator originalAlts =
+                                (*original)->portIdAltlists.begin();
+                for (iterator2 = portIdsList.begin();
+                                iterator2 != portIdsList.end();
+                                ++iterator2, ++originalAlts) {
+                        if (iterator2->alts != originalAlts->alts) {
+                                std::cout << "Port-ids on original and recovered "
+                                                << "messages are different\n";
+                                returnValue = -1;
+                        }
+                }
         }
 
         if (returnValue == 0) {
@@ -3074,10 +3069,7 @@ int testIPCPWriteManagementSDURequestMessage()
         int returnValue = 0;
 
         IPCPWriteMgmtSDURequestMessage message;
-        message.sdu = new unsigned char[20];
-        message.size = 20;
-        message.port_id = 30;
-        message.address = 54;
+        fillIPCPWriteMgmtSDURequestMessage(message);
         struct nl_msg* netlinkMessage = nlmsg_alloc();
         if (!netlinkMessage) {
                 std::cout << "Error allocating Netlink message\n";
@@ -3111,6 +3103,9 @@ int testIPCPWriteManagementSDURequestMessage()
         } else if (message.size != recoveredMessage->size) {
         	std::cout << "Error with size"<< std::endl;
         	returnValue = -1;
+        } else if (memcmp(message.sdu, recoveredMessage->sdu, message.size)) {
+        	std::cout << "Error with SDU contents"<< std::endl;
+        	returnValue = -1;
         }
 
         if (returnValue == 0) {
@@ -3130,9 +3125,7 @@ int testIPCPReadManagementSDUNotificationMessage()
         int returnValue = 0;
 
         IPCPReadMgmtSDUNotificationMessage message;
-        message.sdu = new unsigned char[20];
-        message.size = 20;
-        message.port_id = 30;
+        fillIPCPReadMgmtSDUNotificationMessage(message);
         struct nl_msg* netlinkMessage = nlmsg_alloc();
         if (!netlinkMessage) {
                 std::cout << "Error allocating Netlink message\n";
@@ -3163,6 +3156,9 @@ int testIPCPReadManagementSDUNotificationMessage()
         } else if (message.size != recoveredMessage->size) {
         	std::cout << "Error with size"<< std::endl;
         	returnValue = -1;
+        } else if (memcmp(message.sdu, recoveredMessage->sdu, message.size)) {
+        	std::cout << "Error with SDU contents"<< std::endl;
+        	returnValue = -1;
         }
 
         if (returnValue == 0) {
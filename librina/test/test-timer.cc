@@ -49,6 +49,48 @@ public:
 	bool check_;
 };
 
+static Lockable counter_lock;
+static int counter = 0;
+
+class CounterTimerTask: public TimerTask {
+public:
+	void run() {
+		ScopedLock g(counter_lock);
+		counter++;
+	};
+};
+
+static int get_counter()
+{
+	ScopedLock g(counter_lock);
+	return counter;
+}
+
+class DestroyTimerTask: public TimerTask {
+public:
+	DestroyTimerTask(Timer * timer) : timer_(timer) {};
+	void run() {
+		delete timer_;
+		ScopedLock g(counter_lock);
+		counter++;
+	};
+private:
+	Timer * timer_;
+};
+
+static ConditionVariable blocked_cond;
+static bool release_blocked = false;
+
+class BlockingTimerTask: public TimerTask {
+public:
+	void run() {
+		blocked_cond.lock();
+		while (!release_blocked)
+			blocked_cond.doWait();
+		blocked_cond.unlock();
+	};
+};
+
 int main()
 {
 	bool result = true;
@@ -129,6 +171,82 @@ int main()
 
 	delete timer;
 
+	std::cout<<std::endl <<	"//////////////////////////////////////////////" << std::endl <<
+							"/ test-timer TEST 5 : Cancel tasks by handle  /" << std::endl <<
+							"//////////////////////////////////////////////" << std::endl;
+	timer = new Timer();
+	counter = 0;
+
+	TimerHandle handle = timer->scheduleTask(new CounterTimerTask(), 100);
+	timer->scheduleTask(new CounterTimerTask(), 100);
+	timer->cancelTask(handle);
+	// Cancelling a stale handle is a no-op
+	timer->cancelTask(handle);
+	sleep.sleepForMili(500);
+
+	if (get_counter() != 1){
+		result = false;
+		std::cout<< "TEST 5 FAILED"<<std::endl;
+	}
+
+	delete timer;
+
+	std::cout<<std::endl <<	"//////////////////////////////////////////////" << std::endl <<
+							"/ test-timer TEST 6 : Many tasks, many delays /" << std::endl <<
+							"//////////////////////////////////////////////" << std::endl;
+	timer = new Timer();
+	counter = 0;
+
+	for (int i = 0; i < 1000; i++)
+		timer->scheduleTask(new CounterTimerTask(), i % 700);
+	timer->scheduleTask(new CounterTimerTask(), 100000);
+	sleep.sleepForMili(1000);
+
+	if (get_counter() != 1000 ||
+			timer->get_task_scheduler()->pending() != 1){
+		result = false;
+		std::cout<< "TEST 6 FAILED"<<std::endl;
+	}
+
+	delete timer;
+
+	std::cout<<std::endl <<	"//////////////////////////////////////////////" << std::endl <<
+							"/ test-timer TEST 7 : Timer deleted by a task /" << std::endl <<
+							"//////////////////////////////////////////////" << std::endl;
+	timer = new Timer();
+	counter = 0;
+
+	timer->scheduleTask(new DestroyTimerTask(timer), 50);
+	sleep.sleepForMili(500);
+
+	if (get_counter() != 1){
+		result = false;
+		std::cout<< "TEST 7 FAILED"<<std::endl;
+	}
+
+	std::cout<<std::endl <<	"//////////////////////////////////////////////" << std::endl <<
+							"/ test-timer TEST 8 : Blocked workers        /" << std::endl <<
+							"//////////////////////////////////////////////" << std::endl;
+	timer = new Timer();
+	counter = 0;
+
+	// More blocking tasks than core workers must not stall the others
+	for (unsigned int i = 0; i < 2 * Timer::DEFAULT_WORKERS; i++)
+		timer->scheduleTask(new BlockingTimerTask(), 10);
+	timer->scheduleTask(new CounterTimerTask(), 50);
+	sleep.sleepForMili(500);
+
+	if (get_counter() != 1){
+		result = false;
+		std::cout<< "TEST 8 FAILED"<<std::endl;
+	}
+
+	blocked_cond.lock();
+	release_blocked = true;
+	blocked_cond.broadcast();
+	blocked_cond.unlock();
+	delete timer;
+
 	if (result) {
 		std::cout<<std::endl <<	"//////////////////////////////////////" << std::endl <<
 								"//////////////////////////////////////" << std::endl <<
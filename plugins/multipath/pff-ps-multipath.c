@@ -39,6 +39,8 @@
 /* FIXME: This representation is crappy and MUST be changed */
 struct pft_port_entry {
         port_id_t        port_id;
+        /* Times the port-id was added, its share of the flows */
+        unsigned int     weight;
         struct list_head next;
 };
 
@@ -54,6 +56,7 @@ static struct pft_port_entry * pft_pe_create_gfp(gfp_t     flags,
                 return NULL;
 
         tmp->port_id = port_id;
+        tmp->weight  = 1;
         INIT_LIST_HEAD(&tmp->next);
 
         return tmp;
@@ -156,8 +159,10 @@ static int pfte_port_add(struct pft_entry * entry,
         ASSERT(pfte_is_ok(entry));
 
         pe = pfte_port_find(entry, id);
-        if (pe)
+        if (pe) {
+                pe->weight++;
                 return 0;
+        }
 
         pe = pft_pe_create_ni(id);
         if (!pe)
@@ -178,7 +183,8 @@ static void pfte_port_remove(struct pft_entry * entry,
 
         list_for_each_entry_safe(pos, next, &entry->ports, next) {
                 if (pft_pe_port(pos) == id) {
-                        pft_pe_destroy(pos);
+                        if (--pos->weight == 0)
+                                pft_pe_destroy(pos);
                         return;
                 }
         }
@@ -410,7 +416,8 @@ static int mp_flush(struct pff_ps * ps)
 
 /**
  * @brief Selects the next hop pft_entry from a list based
- * on hash-threshold algorithm
+ * on hash-threshold algorithm, weighted: every port gets a
+ * region of the hash space as big as its weight
  * @param entry_list: list of possible next hop pft_entries
  * @param pci: PCI to extract the source & dest address and QoS
  * of the PDU
@@ -419,14 +426,11 @@ static int mp_flush(struct pff_ps * ps)
 struct pft_port_entry * select_entry(struct pft_entry * entry,
                                 struct pci * pci)
 {
-        int num_entries;
+        unsigned int total_weight;
         struct pft_port_entry * pos;
-        int i;
 
         unsigned short hash_key;
-        const int KEYSPACE = 0xFFFF;
-        int region_size;
-        unsigned short region;
+        unsigned int region;
         
 	typedef struct {
 		address_t pci_source;
@@ -443,24 +447,24 @@ struct pft_port_entry * select_entry(struct pft_entry * entry,
 	c_id.pci_cep_source = pci_cep_source(pci);
 	c_id.pci_cep_destination = pci_cep_destination(pci);
 
-        num_entries = 0;
+        total_weight = 0;
         list_for_each_entry(pos, &entry->ports, next) {
-                num_entries++;
+                total_weight += pos->weight;
         }
         
         hash_key = crc16(0, (const u8 *)&c_id, sizeof(c_id));
         
-        region_size = KEYSPACE / num_entries;
-        region = hash_key / region_size;
+        /* Scale the 16-bit hash to [0, total_weight) */
+        region = ((u32) hash_key * total_weight) >> 16;
         
-        i = 0;
         list_for_each_entry(pos, &entry->ports, next) {
-                if (region == i++) {
+                if (region < pos->weight) {
                         return pos;
                 }
+                region -= pos->weight;
         }
         
-        return pos;
+        return NULL;
 }
 
 static int mp_next_hop(struct pff_ps * ps,
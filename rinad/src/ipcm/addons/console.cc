@@ -826,6 +826,43 @@ public:
 	}
 };
 
+class ShowNetlinkStatsConsoleCmd: public rina::ConsoleCmdInfo {
+public:
+	ShowNetlinkStatsConsoleCmd(IPCMConsole * console) :
+		rina::ConsoleCmdInfo("USAGE: show-netlink-stats", console) {};
+
+	int execute(vector<string>& args) {
+		rina::NetlinkStatistics stats = rina::getNetlinkStatistics();
+		double interval = stats.elapsed - last.elapsed;
+
+		if (args.size() != 1) {
+			console->outstream << console->commands_map[args[0]]->usage << endl;
+			return rina::UNIXConsole::CMDRETCONT;
+		}
+
+		console->outstream << stats.toString();
+		if (interval > 0) {
+			unsigned long long messages = stats.messages - last.messages;
+
+			console->outstream << "Since last query (" << interval
+				<< " s): " << messages / interval << " messages/s, "
+				<< (stats.bytes - last.bytes) / interval << " bytes/s";
+			if (messages) {
+				console->outstream << ", "
+					<< (stats.parse_time_ns - last.parse_time_ns) / messages
+					<< " ns/message";
+			}
+			console->outstream << endl;
+		}
+		last = stats;
+
+		return rina::UNIXConsole::CMDRETCONT;
+	}
+
+private:
+	rina::NetlinkStatistics last;
+};
+
 IPCMConsole::IPCMConsole(const string& socket_path_) :
 		rina::UNIXConsole(socket_path_),
 		Addon(IPCMConsole::NAME)
@@ -855,6 +892,7 @@ IPCMConsole::IPCMConsole(const string& socket_path_) :
 	commands_map["unregister-ip-prefix"] = new UnegisterIPPrefixConsoleCmd(this);
 	commands_map["allocate-iporina-flow"] = new AllocateIPoRINAFlowConsoleCmd(this);
 	commands_map["deallocate-iporina-flow"] = new DeallocateIPoRINAFlowConsoleCmd(this);
+	commands_map["show-netlink-stats"] = new ShowNetlinkStatsConsoleCmd(this);
 }
 
 int IPCMConsole::plugin_load_unload(vector<string>& args, bool load)
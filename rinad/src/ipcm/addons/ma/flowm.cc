@@ -344,6 +344,17 @@ void* ActiveWorker::run(void* param)
 			rina::cdap_rib::vers_info_t vers;
 			vers.version_ = 0x1; //TODO: do not hardcode this
 
+			//Batch the replies to scoped reads up to the max SDU
+			//size of the flow, or of our own reads if it has none
+			unsigned int batch_size =
+				flow_.flowSpecification.maxSDUsize;
+			if (batch_size == 0)
+				batch_size = max_sdu_size_in_bytes;
+			rib_factory_->getProxy()->setReadBatchSize(
+					RIBFactory::getRIBHandle(vers.version_,
+								 src.ae_name_),
+					batch_size);
+
 			//TODO: remove this. The API should NOT require a RIB
 			//instance for calling the remote API
 			rib_factory_->getProxy()->remote_open_connection(vers,
@@ -412,7 +423,8 @@ void FlowManager::process_fwd_cdap_msg_response(rina::FwdCDAPMsgResponseEvent*
 	rina::cdap::getProvider()->get_session_manager()->decodeCDAPMessage
 	                (fwdevent->sermsg, *rmsg);
 
-	if(rmsg->flags_ == rina::cdap_rib::flags::F_RD_INCOMPLETE)
+	if((rmsg->flags_ & ~rina::cdap_rib::flags::F_RD_BATCH) ==
+			rina::cdap_rib::flags::F_RD_INCOMPLETE)
 	        remove = false;
 	else
 	        remove = true;
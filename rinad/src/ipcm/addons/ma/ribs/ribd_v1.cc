@@ -35,6 +35,7 @@ namespace mad {
 namespace rib_v1 {
 
 const char IPCP_NAME[] = "/computingSystemID=1/processingSystemID=1/kernelApplicationProcess/osApplicationProcess/ipcProcesses";
+
 // Create the schema
 void createSchema(void){
 	rina::cdap_rib::vers_info_t vers;
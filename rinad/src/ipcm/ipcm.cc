@@ -67,6 +67,7 @@
 //Timeouts for timed wait
 #define IPCM_EVENT_TIMEOUT_S 0
 #define IPCM_EVENT_TIMEOUT_NS 100000000 //0.1 sec
+#define IPCM_EVENT_BATCH 32
 #define IPCM_TRANS_TIMEOUT_S 7
 
 //Downcast MACRO
@@ -2048,14 +2049,24 @@ void* IPCManager_::io_loop_trampoline(void* param)
 void IPCManager_::io_loop()
 {
     rina::IPCEvent *event;
+    std::vector<rina::IPCEvent *> events;
+    unsigned int next = 0;
 
     LOG_DBG("Starting main I/O loop...");
 
     while (!req_to_stop)
     {
-        event = rina::ipcEventProducer->eventTimedWait(
-        IPCM_EVENT_TIMEOUT_S,
-                                                       IPCM_EVENT_TIMEOUT_NS);
+        //Drain as many events as possible per wakeup
+        if (next == events.size())
+        {
+            events.clear();
+            next = 0;
+            rina::ipcEventProducer->eventTimedWaitBatch(events,
+                                                        IPCM_EVENT_BATCH,
+                                                        IPCM_EVENT_TIMEOUT_S,
+                                                        IPCM_EVENT_TIMEOUT_NS);
+        }
+
         if (req_to_stop)
         {
             //Signal the main thread to start
@@ -2064,9 +2075,11 @@ void IPCManager_::io_loop()
             break;
         }
 
-        if (!event)
+        if (next == events.size())
             continue;
 
+        event = events[next++];
+
         LOG_DBG("Got event of type %s and sequence number %u",
                 rina::IPCEvent::eventTypeToString(event->eventType).c_str(),
                 event->sequenceNumber);
@@ -2245,6 +2258,9 @@ void IPCManager_::io_loop()
         delete event;
     }
 
+    for (; next < events.size(); next++)
+        delete events[next];
+
     //TODO: probably move this to a private method if it starts to grow
     LOG_DBG("Stopping I/O loop...");
 }
@@ -49,6 +49,8 @@ enum IPCProcessOperationalState {
 };
 
 class IPCProcess;
+class KernelStats;
+class KernelStatsCache;
 
 /// IPC process component
 class IPCProcessComponent {
@@ -59,7 +61,7 @@ public:
 
         // Periodically read the kernel information exported via sysfs relevant
         // to this IPCP component, by default do nothing
-        virtual void sync_with_kernel() { };
+        virtual void sync_with_kernel(const KernelStats& stats) { };
 
         IPCProcess * ipcp;
 };
@@ -307,6 +309,13 @@ public:
 			 	    bool remove_from_rib,
 			 	    std::list<int>& neighs_to_exclude) = 0;
 
+	/// Remove a set of entries from the directory forwarding table
+	/// @param keys
+	virtual void removeDFTEntries(const std::list<std::string>& keys,
+				      bool notify_neighs,
+				      bool remove_from_rib,
+				      std::list<int>& neighs_to_exclude) = 0;
+
 	/// Process an application registration request
 	/// @param event
 	virtual void processApplicationRegistrationRequestEvent(
@@ -400,8 +409,11 @@ public:
 	virtual void addQoSCube(const rina::QoSCube& cube) = 0;
 
 	virtual std::list<rina::PDUForwardingTableEntry> get_pduft_entries() = 0;
-	/// This operation takes ownership of the entries
-	virtual void set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft) = 0;
+	/// This operation takes ownership of the entries. replaced tells if
+	/// the kernel table was replaced by pduft, dropping the temporary
+	/// entries.
+	virtual void set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft,
+				       bool replaced) = 0;
 
 	virtual std::list<rina::RoutingTableEntry> get_rt_entries() = 0;
 	/// This operation takes ownership of the entries
@@ -475,6 +487,10 @@ public:
         virtual int64_t addObjRIB(const std::string& fqn,
         			  rina::rib::RIBObj** obj) = 0;
         virtual void removeObjRIB(const std::string& fqn) = 0;
+        /// Remove and add several objects, all visible at once to readers;
+        /// see rina::rib::RIBDaemonProxy::updateObjsRIB
+        virtual void updateObjsRIB(const std::list<std::string>& to_remove,
+        			   std::list<std::pair<std::string, rina::rib::RIBObj*> >& to_add) = 0;
         virtual void processReadManagementSDUEvent(const rina::ReadMgmtSDUResponseEvent& event) = 0;
 };
 
@@ -494,6 +510,8 @@ public:
 	IPCPSecurityManager * security_manager_;
 	IRoutingComponent * routing_component_;
 	IPCPRIBDaemon * rib_daemon_;
+	/// Kernel counters for the RIB objects, NULL if not exported
+	KernelStatsCache * kernel_stats_;
 
 	IPCProcess(const std::string& name, const std::string& instance);
 	virtual ~IPCProcess(){};
@@ -771,7 +771,8 @@ void EnrollmentTask::internal_flow_allocated(rina::IPCPInternalFlowAllocatedEven
 		    	        == event->flow_info.remoteAppName.processName) {
 			ribd->start_internal_flow_sdu_reader(event->port_id,
 							     event->fd,
-							     it->second->remote_peer_.underlying_port_id_);
+							     it->second->remote_peer_.underlying_port_id_,
+							     event->flow_info.flowSpecification.maxSDUsize);
 
 			it->second->internal_flow_allocate_result(event->port_id,
 								  event->fd,
@@ -124,6 +124,18 @@ ConnectionsRIBObj::ConnectionsRIBObj(IPCProcess * ipc_process,
 	flow_allocator_ = flow_allocator;
 }
 
+// Copies the DTP counters exported by the kernel into the connection
+static void set_connection_stats(rina::Connection * con,
+				 const KernelStats::Record& record)
+{
+	con->stats.tx_bytes = record.values[0];
+	con->stats.rx_bytes = record.values[1];
+	con->stats.tx_pdus = record.values[2];
+	con->stats.rx_pdus = record.values[3];
+	con->stats.drop_pdus = record.values[4];
+	con->stats.err_pdus = record.values[5];
+}
+
 //Class Connection RIB Object
 const std::string ConnectionRIBObject::class_name = "Connection";
 const std::string ConnectionRIBObject::object_name_prefix = "/dt/connections/srcCepId=";
@@ -144,16 +156,29 @@ void ConnectionRIBObject::read(const rina::cdap_rib::con_handle_t &con,
 			       rina::cdap_rib::res_info_t& res)
 {
 	encoders::DTPInformationEncoder encoder;
+	refresh_stats();
 	rina::DTPInformation dtp_info(fai->get_flow()->getActiveConnection());
 	encoder.encode(dtp_info, obj_reply.value_);
 
 	res.code_ = rina::cdap_rib::CDAP_SUCCESS;
 }
 
+void ConnectionRIBObject::refresh_stats() const
+{
+	rina::Connection * con = fai->get_flow()->getActiveConnection();
+	KernelStats::Record record;
+
+	if (ipc_process_->kernel_stats_ &&
+	    ipc_process_->kernel_stats_->get_connection(con->sourceCepId, record))
+		set_connection_stats(con, record);
+}
+
 const std::string ConnectionRIBObject::get_displayable_value() const
 {
 	rina::Connection * con = fai->get_flow()->getActiveConnection();
 	std::stringstream ss;
+
+	refresh_stats();
 	ss << "CEP-ids: src = " << con->sourceCepId << ", dest = " << con->destCepId
 	   << "; Addresses: src = " << con->sourceAddress << ", dest = " << con->destAddress
 	   << "; Qos-id: " << con->qosId << "; Port-id: " << con->portId << std::endl;
@@ -618,7 +643,7 @@ void FlowAllocator::removeFlowAllocatorInstance(int portId)
 	}
 }
 
-void FlowAllocator::sync_with_kernel()
+void FlowAllocator::sync_with_kernel(const KernelStats& stats)
 {
 	IFlowAllocatorInstance * fai = NULL;
 	std::list<rina::ApplicationEntityInstance*>::iterator it;
@@ -631,7 +656,7 @@ void FlowAllocator::sync_with_kernel()
 			continue;
 		}
 
-		fai->sync_with_kernel();
+		fai->sync_with_kernel(stats);
 	}
 }
 
@@ -1507,9 +1532,17 @@ void FlowAllocatorInstance::remoteCreateResult(const rina::cdap_rib::con_handle_
 	}
 }
 
-void FlowAllocatorInstance::sync_with_kernel()
+void FlowAllocatorInstance::sync_with_kernel(const KernelStats& stats)
 {
 	rina::Connection * con = flow_->getActiveConnection();
+	const KernelStats::Record * record;
+
+	if (stats.available) {
+		record = stats.get_connection(con->sourceCepId);
+		if (record)
+			set_connection_stats(con, *record);
+		return;
+	}
 
 	SysfsHelper::get_dtp_tx_bytes(ipc_process_->get_id(),
 				      con->sourceCepId,
@@ -120,7 +120,7 @@ public:
 	virtual unsigned int get_allocate_response_message_handle() const = 0;
 	virtual void set_allocate_response_message_handle(
 			unsigned int allocate_response_message_handle) = 0;
-	virtual void sync_with_kernel() = 0;
+	virtual void sync_with_kernel(const KernelStats& stats) = 0;
 };
 
 /// Representation of a flow object in the RIB
@@ -221,6 +221,9 @@ public:
 	const static std::string object_name_prefix;
 
 private:
+	/// Fetch the counters of the connection from the kernel
+	void refresh_stats() const;
+
 	IFlowAllocatorInstance * fai;
 };
 
@@ -281,7 +284,7 @@ public:
 			const rina::UpdateConnectionResponseEvent& event);
 	void submitDeallocate(const rina::FlowDeallocateRequestEvent& event);
 	void removeFlowAllocatorInstance(int portId);
-	void sync_with_kernel();
+	void sync_with_kernel(const KernelStats& stats);
 	void processAllocatePortResponse(const rina::AllocatePortResponseEvent& event);
 	void processDeallocatePortResponse(const rina::DeallocatePortResponseEvent& event);
 
@@ -372,7 +375,7 @@ public:
 				const rina::cdap_rib::obj_info_t &obj,
 				const rina::cdap_rib::res_info_t &res);
 
-	void sync_with_kernel();
+	void sync_with_kernel(const KernelStats& stats);
 
 private:
 
@@ -48,6 +48,7 @@ namespace rinad {
 //Timeouts for timed wait
 #define IPCP_EVENT_TIMEOUT_S 0
 #define IPCP_EVENT_TIMEOUT_NS 1000000000 //1 sec
+#define IPCP_EVENT_BATCH 32
 
 //Class IPCProcessImpl
 AbstractIPCProcessImpl::AbstractIPCProcessImpl(const rina::ApplicationProcessNamingInformation& nm,
@@ -91,17 +92,27 @@ const std::string AbstractIPCProcessImpl::get_type() const
 void AbstractIPCProcessImpl::event_loop(void)
 {
 	rina::IPCEvent *e;
+	std::vector<rina::IPCEvent *> events;
+	unsigned int next = 0;
 
 	keep_running = true;
 
 	LOG_DBG("Starting main I/O loop...");
 
 	while(keep_running) {
-		e = rina::ipcEventProducer->eventTimedWait(
-				IPCP_EVENT_TIMEOUT_S,
-				IPCP_EVENT_TIMEOUT_NS);
-		if(!e)
-			continue;
+		// Drain as many events as possible per wakeup
+		if (next == events.size()) {
+			events.clear();
+			next = 0;
+			rina::ipcEventProducer->eventTimedWaitBatch(events,
+					IPCP_EVENT_BATCH,
+					IPCP_EVENT_TIMEOUT_S,
+					IPCP_EVENT_TIMEOUT_NS);
+			if (events.empty())
+				continue;
+		}
+
+		e = events[next++];
 
 		if(!keep_running){
 			delete e;
@@ -360,6 +371,9 @@ void AbstractIPCProcessImpl::event_loop(void)
 		}
 		delete e;
 	}
+
+	for (; next < events.size(); next++)
+		delete events[next];
 }
 
 //Class LazyIPCPProcessImpl
@@ -622,6 +636,8 @@ IPCProcessImpl* IPCPFactory::getIPCP()
 }
 
 //Class KernelSyncTrigger
+const unsigned int KernelSyncTrigger::DEFAULT_PERIOD_IN_MS = 4000;
+
 KernelSyncTrigger::KernelSyncTrigger(rina::ThreadAttributes * threadAttributes,
 		  	  	     AbstractIPCProcessImpl * ipc_process,
 		  	  	     unsigned int sync_period)
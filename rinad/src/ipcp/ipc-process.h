@@ -173,6 +173,8 @@ public:
 	int run();
 	void finish();
 
+	static const unsigned int DEFAULT_PERIOD_IN_MS;
+
 private:
 	bool end;
 	AbstractIPCProcessImpl * ipcp;
@@ -183,6 +185,12 @@ private:
 /// Implementation of the normal IPC Process Daemon
 class IPCProcessImpl: public IPCProcess, public LazyIPCProcessImpl, public rina::InternalEventListener  {
 public:
+        /// DIF configuration parameters, in ms: period of the sync with
+        /// the kernel (0 to disable it) and time the RIB objects keep
+        /// the kernel counters they read
+        static const std::string KERNEL_SYNC_PERIOD_IN_MS;
+        static const std::string KERNEL_STATS_TTL_IN_MS;
+
         IPCProcessImpl(const rina::ApplicationProcessNamingInformation& name,
                        unsigned short id,
 		       unsigned int ipc_manager_port,
@@ -209,14 +209,10 @@ void DFTRIBObj::checkDFTEntriesToRemove(unsigned int address,
 		return;
 
 	std::list<int> exc_neighs;
-	std::list<std::string>::const_iterator it;
-	for (it = entriesToDelete.begin(); it != entriesToDelete.end(); ++it) {
-		namespace_manager_->removeDFTEntry(*it,
-				true,
-				true,
-				exc_neighs);
-	}
-
+	namespace_manager_->removeDFTEntries(entriesToDelete,
+					     true,
+					     true,
+					     exc_neighs);
 }
 
 void DFTRIBObj::create(const rina::cdap_rib::con_handle_t &con_handle,
@@ -286,11 +282,298 @@ void AddressChangeTimerTask::run()
 						  old_address);
 }
 
+// Class DirectoryForwardingTable
+DirectoryForwardingTable::Index::Index() : buckets(64), count(0)
+{
+	for (size_t i = 0; i < buckets.size(); i++)
+		buckets[i].id = -1;
+}
+
+void DirectoryForwardingTable::Index::insert(uint32_t hash, int32_t id)
+{
+	size_t mask, i;
+
+	//Keep the load factor under 1/2
+	if (2 * (count + 1) > buckets.size()) {
+		std::vector<Bucket> old;
+
+		old.swap(buckets);
+		buckets.resize(old.size() * 2);
+		mask = buckets.size() - 1;
+		for (i = 0; i < buckets.size(); i++)
+			buckets[i].id = -1;
+
+		for (size_t j = 0; j < old.size(); j++) {
+			if (old[j].id < 0)
+				continue;
+			for (i = old[j].hash & mask; buckets[i].id >= 0;
+					i = (i + 1) & mask);
+			buckets[i] = old[j];
+		}
+	}
+
+	mask = buckets.size() - 1;
+	for (i = hash & mask; buckets[i].id >= 0; i = (i + 1) & mask);
+	buckets[i].hash = hash;
+	buckets[i].id = id;
+	count++;
+}
+
+void DirectoryForwardingTable::Index::erase(uint32_t hash, int32_t id)
+{
+	size_t mask = buckets.size() - 1;
+	size_t i, j;
+
+	//Find the bucket and close the gap (backward shift deletion)
+	for (i = hash & mask; buckets[i].id != id; i = (i + 1) & mask);
+	for (j = (i + 1) & mask; buckets[j].id >= 0; j = (j + 1) & mask) {
+		size_t home = buckets[j].hash & mask;
+
+		//Move it back unless its home is cyclically in (i, j]
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			buckets[i] = buckets[j];
+			i = j;
+		}
+	}
+	buckets[i].id = -1;
+	count--;
+}
+
+DirectoryForwardingTable::DirectoryForwardingTable() : count_(0)
+{
+}
+
+DirectoryForwardingTable::~DirectoryForwardingTable()
+{
+	for (size_t i = 0; i < slots_.size(); i++) {
+		delete slots_[i].entry;
+	}
+}
+
+uint32_t DirectoryForwardingTable::hash_string(const std::string& str)
+{
+	//FNV-1a
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < str.size(); i++) {
+		h ^= (unsigned char) str[i];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+int32_t DirectoryForwardingTable::find_slot(const std::string& key,
+					    uint32_t hash) const
+{
+	const std::vector<Index::Bucket>& buckets = keys_.buckets;
+	size_t mask = buckets.size() - 1;
+
+	for (size_t i = hash & mask; buckets[i].id >= 0; i = (i + 1) & mask) {
+		if (buckets[i].hash == hash && slots_[buckets[i].id].key == key)
+			return buckets[i].id;
+	}
+
+	return -1;
+}
+
+int32_t DirectoryForwardingTable::find_name(const std::string& name,
+					    uint32_t hash) const
+{
+	const std::vector<Index::Bucket>& buckets = names_index_.buckets;
+	size_t mask = buckets.size() - 1;
+
+	for (size_t i = hash & mask; buckets[i].id >= 0; i = (i + 1) & mask) {
+		if (buckets[i].hash == hash && names_[buckets[i].id].name == name)
+			return buckets[i].id;
+	}
+
+	return -1;
+}
+
+int32_t DirectoryForwardingTable::intern(const std::string& name)
+{
+	uint32_t hash = hash_string(name);
+	int32_t id = find_name(name, hash);
+
+	if (id >= 0)
+		return id;
+
+	if (free_names_.empty()) {
+		id = names_.size();
+		names_.push_back(Name());
+	} else {
+		id = free_names_.back();
+		free_names_.pop_back();
+	}
+	names_[id].name = name;
+	names_[id].hash = hash;
+	names_index_.insert(hash, id);
+
+	return id;
+}
+
+rina::DirectoryForwardingTableEntry * DirectoryForwardingTable::find(const std::string& key) const
+{
+	int32_t id = find_slot(key, hash_string(key));
+
+	return id < 0 ? 0 : slots_[id].entry;
+}
+
+rina::DirectoryForwardingTableEntry *
+DirectoryForwardingTable::find_process(const std::string& process_name,
+				       unsigned int excluded_address) const
+{
+	int32_t id = find_name(process_name, hash_string(process_name));
+	rina::DirectoryForwardingTableEntry * entry;
+
+	if (id < 0)
+		return 0;
+
+	for (size_t i = 0; i < names_[id].slots.size(); i++) {
+		entry = slots_[names_[id].slots[i]].entry;
+		if (entry->address_ != excluded_address)
+			return entry;
+	}
+
+	return 0;
+}
+
+bool DirectoryForwardingTable::put(rina::DirectoryForwardingTableEntry * entry)
+{
+	std::string key = entry->getKey();
+	uint32_t hash = hash_string(key);
+	int32_t id;
+
+	if (find_slot(key, hash) >= 0)
+		return false;
+
+	if (free_slots_.empty()) {
+		id = slots_.size();
+		slots_.push_back(Slot());
+	} else {
+		id = free_slots_.back();
+		free_slots_.pop_back();
+	}
+
+	Slot& slot = slots_[id];
+	slot.entry = entry;
+	slot.key = key;
+	slot.hash = hash;
+	slot.name = intern(entry->ap_naming_info_.processName);
+	slot.pos = names_[slot.name].slots.size();
+	names_[slot.name].slots.push_back(id);
+	keys_.insert(hash, id);
+	count_++;
+
+	return true;
+}
+
+rina::DirectoryForwardingTableEntry * DirectoryForwardingTable::erase(const std::string& key)
+{
+	uint32_t hash = hash_string(key);
+	int32_t id = find_slot(key, hash);
+	rina::DirectoryForwardingTableEntry * entry;
+
+	if (id < 0)
+		return 0;
+
+	Slot& slot = slots_[id];
+	Name& name = names_[slot.name];
+
+	//Swap the last slot of the name into the position of this one
+	name.slots[slot.pos] = name.slots.back();
+	slots_[name.slots[slot.pos]].pos = slot.pos;
+	name.slots.pop_back();
+	if (name.slots.empty()) {
+		names_index_.erase(name.hash, slot.name);
+		name.name.clear();
+		free_names_.push_back(slot.name);
+	}
+
+	keys_.erase(hash, id);
+	entry = slot.entry;
+	slot.entry = 0;
+	slot.key.clear();
+	free_slots_.push_back(id);
+	count_--;
+
+	return entry;
+}
+
+std::list<rina::DirectoryForwardingTableEntry *> DirectoryForwardingTable::getEntries() const
+{
+	std::list<rina::DirectoryForwardingTableEntry *> result;
+
+	for (size_t i = 0; i < slots_.size(); i++) {
+		if (slots_[i].entry)
+			result.push_back(slots_[i].entry);
+	}
+
+	return result;
+}
+
+std::list<rina::DirectoryForwardingTableEntry> DirectoryForwardingTable::getCopyofentries() const
+{
+	std::list<rina::DirectoryForwardingTableEntry> result;
+
+	for (size_t i = 0; i < slots_.size(); i++) {
+		if (slots_[i].entry)
+			result.push_back(*slots_[i].entry);
+	}
+
+	return result;
+}
+
+// Class DFTUpdateQueue
+void DFTUpdateQueue::add(const std::list<rina::DirectoryForwardingTableEntry>& created,
+			 const std::list<std::string>& deleted,
+			 const std::list<int>& neighs_to_exclude)
+{
+	std::set<int> excluded(neighs_to_exclude.begin(), neighs_to_exclude.end());
+	Batch& batch = batches_[excluded];
+
+	std::list<rina::DirectoryForwardingTableEntry>::const_iterator ct;
+	for (ct = created.begin(); ct != created.end(); ++ct) {
+		std::string key = ct->getKey();
+
+		erase(key);
+		batch.created[key] = *ct;
+	}
+
+	std::list<std::string>::const_iterator dt;
+	for (dt = deleted.begin(); dt != deleted.end(); ++dt) {
+		erase(*dt);
+		batch.deleted.insert(*dt);
+	}
+}
+
+void DFTUpdateQueue::take(std::map<std::set<int>, Batch>& batches)
+{
+	batches.clear();
+	batches.swap(batches_);
+}
+
+void DFTUpdateQueue::erase(const std::string& key)
+{
+	std::map<std::set<int>, Batch>::iterator it;
+
+	for (it = batches_.begin(); it != batches_.end(); ++it) {
+		it->second.created.erase(key);
+		it->second.deleted.erase(key);
+	}
+}
+
 //Class Namespace Manager
+const std::string NamespaceManager::DFT_UPDATE_BATCHING_IN_MS = "dftUpdateBatchingInMs";
+const unsigned int NamespaceManager::DEFAULT_DFT_UPDATE_BATCHING_IN_MS = 100;
+
 NamespaceManager::NamespaceManager() : INamespaceManager()
 {
 	rib_daemon_ = 0;
 	event_manager_ = 0;
+	dft_flush_scheduled_ = false;
+	dft_batching_ms_ = DEFAULT_DFT_UPDATE_BATCHING_IN_MS;
 }
 
 NamespaceManager::~NamespaceManager()
@@ -327,6 +610,14 @@ void NamespaceManager::set_dif_configuration(const rina::DIFConfiguration& dif_c
 	INamespaceManagerPs *nsmps = dynamic_cast<INamespaceManagerPs *> (ps);
 	assert(nsmps);
 	nsmps->set_dif_configuration(dif_configuration);
+
+	try {
+		dft_batching_ms_ = dif_configuration.nsm_configuration_.policy_set_.
+				get_param_value_as_uint(DFT_UPDATE_BATCHING_IN_MS);
+	} catch (rina::Exception &e) {
+		LOG_IPCP_INFO("Could not parse %s, using default value: %u",
+			      DFT_UPDATE_BATCHING_IN_MS.c_str(), dft_batching_ms_);
+	}
 }
 
 void NamespaceManager::populateRIB()
@@ -376,54 +667,32 @@ void NamespaceManager::addressChangeUpdateDFT(unsigned int new_address,
 			    	    	      unsigned int old_address)
 {
 	std::list<rina::DirectoryForwardingTableEntry> mod_entries;
-	rina::DirectoryForwardingTableEntry * entry;
-	std::vector<int> session_ids;
+	std::list<rina::DirectoryForwardingTableEntry *> entries;
+	std::list<rina::DirectoryForwardingTableEntry *>::iterator it;
+	std::list<int> exc_neighs;
 
-	rina::ScopedLock g(lock);
+	{
+		rina::ScopedLock g(lock);
 
-	std::list<std::string> keys = dft_.getKeys();
-	for(std::list<std::string>::iterator it = keys.begin();
-			it != keys.end(); ++it) {
-		entry = dft_.find(*it);
-		if (entry->address_ == old_address) {
-			entry->address_ = new_address;
-			entry->seqnum_ = entry->seqnum_ + 1;
-			mod_entries.push_back(*entry);
+		entries = dft_.getEntries();
+		for (it = entries.begin(); it != entries.end(); ++it) {
+			if ((*it)->address_ == old_address) {
+				(*it)->address_ = new_address;
+				(*it)->seqnum_ = (*it)->seqnum_ + 1;
+				mod_entries.push_back(**it);
+			}
 		}
 	}
 
 	if (mod_entries.size() == 0)
 		return;
 
-	rina::cdap::getProvider()->get_session_manager()->getAllCDAPSessionIds(session_ids);
-	encoders::DFTEListEncoder encoder;
-	rina::cdap_rib::obj_info_t obj;
-	obj.class_ = DFTRIBObj::class_name;
-	obj.name_ = DFTRIBObj::object_name;
-	encoder.encode(mod_entries, obj.value_);
-	rina::cdap_rib::flags_t flags;
-	rina::cdap_rib::filt_info_t filt;
-	rina::cdap_rib::con_handle_t con;
-	for (int i = 0; i < session_ids.size(); i++) {
-		try {
-			con.port_id = session_ids[i];
-			ipcp->rib_daemon_->getProxy()->remote_create(con,
-								     obj,
-								     flags,
-								     filt,
-								     NULL);
-		} catch (rina::Exception &e) {
-			LOG_WARN("Problems sending create CDAP message: %s",
-					e.what());
-		}
-	}
+	queue_dft_updates(mod_entries, std::list<std::string>(), exc_neighs);
 }
 
 unsigned int NamespaceManager::getDFTNextHop(rina::ApplicationProcessNamingInformation& apNamingInfo)
 {
 	rina::DirectoryForwardingTableEntry * nextHop = 0;
-	std::list<rina::DirectoryForwardingTableEntry *> entries;
-	std::list<rina::DirectoryForwardingTableEntry *>::iterator it;
 	unsigned int my_address = 0;
 
 	rina::ScopedLock g(lock);
@@ -439,13 +708,10 @@ unsigned int NamespaceManager::getDFTNextHop(rina::ApplicationProcessNamingInfor
 			apNamingInfo.entityInstance == "") {
 		//Searching for a DAF name
 		my_address = ipcp->get_active_address();
-		entries = dft_.getEntries();
-		for (it = entries.begin(); it != entries.end(); ++it) {
-			if ((*it)->ap_naming_info_.processName == apNamingInfo.processName &&
-					(*it)->address_ != my_address) {
-				apNamingInfo.processInstance = (*it)->ap_naming_info_.processInstance;
-				return (*it)->address_;
-			}
+		nextHop = dft_.find_process(apNamingInfo.processName, my_address);
+		if (nextHop) {
+			apNamingInfo.processInstance = nextHop->ap_naming_info_.processInstance;
+			return nextHop->address_;
 		}
 
 		return 0;
@@ -458,59 +724,146 @@ void NamespaceManager::addDFTEntries(const std::list<rina::DirectoryForwardingTa
 			    	     bool notify_neighs,
 			    	     std::list<int>& neighs_to_exclude)
 {
-	rina::ScopedLock g(lock);
+	std::list<rina::DirectoryForwardingTableEntry> added;
 	rina::DirectoryForwardingTableEntry * entry;
 
-	std::list<rina::DirectoryForwardingTableEntry>::const_iterator it;
-	for (it = entries.begin(); it != entries.end(); ++it) {
-		if (dft_.find(it->getKey()) != 0)
-			continue;
+	{
+		rina::ScopedLock g(lock);
 
-		entry = new rina::DirectoryForwardingTableEntry();
-		entry->address_ = it->address_;
-		entry->ap_naming_info_ = it->ap_naming_info_;
-		entry->seqnum_ = it->seqnum_;
+		std::list<rina::DirectoryForwardingTableEntry>::const_iterator it;
+		for (it = entries.begin(); it != entries.end(); ++it) {
+			if (dft_.find(it->getKey()) != 0)
+				continue;
 
-		try {
-			std::stringstream ss;
-			ss << DFTEntryRIBObj::object_name_prefix
-			   << entry->getKey();
+			entry = new rina::DirectoryForwardingTableEntry();
+			entry->address_ = it->address_;
+			entry->ap_naming_info_ = it->ap_naming_info_;
+			entry->seqnum_ = it->seqnum_;
 
-			rina::rib::RIBObj * nrobj = new DFTEntryRIBObj(ipcp, entry);
-			rib_daemon_->addObjRIB(ss.str(), &nrobj);
-		} catch (rina::Exception &e) {
-			LOG_IPCP_ERR("Problems creating RIB object: %s",
-					e.what());
-		}
+			try {
+				std::stringstream ss;
+				ss << DFTEntryRIBObj::object_name_prefix
+				   << entry->getKey();
+
+				rina::rib::RIBObj * nrobj = new DFTEntryRIBObj(ipcp, entry);
+				rib_daemon_->addObjRIB(ss.str(), &nrobj);
+			} catch (rina::Exception &e) {
+				LOG_IPCP_ERR("Problems creating RIB object: %s",
+						e.what());
+			}
 
-		dft_.put(entry->getKey(), entry);
-		LOG_IPCP_DBG("Added entry to DFT: %s",
-			     entry->toString().c_str());
+			dft_.put(entry);
+			added.push_back(*entry);
+			LOG_IPCP_DBG("Added entry to DFT: %s",
+				     entry->toString().c_str());
+		}
 	}
 
-	notify_neighbors_add(entries, neighs_to_exclude);
+	if (notify_neighs && added.size() > 0)
+		queue_dft_updates(added, std::list<std::string>(),
+				  neighs_to_exclude);
 }
 
 void NamespaceManager::notify_neighbors_add(const std::list<rina::DirectoryForwardingTableEntry>& entries,
 		          	  	    std::list<int>& neighs_to_exclude)
 {
+	queue_dft_updates(entries, std::list<std::string>(), neighs_to_exclude);
+}
+
+void NamespaceManager::queue_dft_updates(const std::list<rina::DirectoryForwardingTableEntry>& created,
+					 const std::list<std::string>& deleted,
+					 const std::list<int>& neighs_to_exclude)
+{
+	bool schedule = false;
+
+	{
+		rina::ScopedLock g(dft_updates_lock_);
+
+		dft_updates_.add(created, deleted, neighs_to_exclude);
+
+		if (dft_batching_ms_ > 0 && !dft_flush_scheduled_) {
+			dft_flush_scheduled_ = true;
+			schedule = true;
+		}
+	}
+
+	if (dft_batching_ms_ == 0) {
+		flush_dft_updates();
+	} else if (schedule) {
+		timer.scheduleTask(new DFTUpdateFlushTimerTask(this),
+				   dft_batching_ms_);
+	}
+}
+
+void NamespaceManager::flush_dft_updates()
+{
+	std::map<std::set<int>, DFTUpdateQueue::Batch> updates;
+	std::map<std::set<int>, DFTUpdateQueue::Batch>::iterator it;
 	std::vector<int> session_ids;
+
+	{
+		rina::ScopedLock g(dft_updates_lock_);
+
+		dft_updates_.take(updates);
+		dft_flush_scheduled_ = false;
+	}
+
+	if (updates.empty())
+		return;
+
 	rina::cdap::getProvider()->get_session_manager()->getAllCDAPSessionIds(session_ids);
-	encoders::DFTEListEncoder encoder;
-	rina::cdap_rib::obj_info_t obj;
-	obj.class_ = DFTRIBObj::class_name;
-	obj.name_ = DFTRIBObj::object_name;
-	encoder.encode(entries, obj.value_);
+	for (it = updates.begin(); it != updates.end(); ++it) {
+		send_dft_updates(session_ids, it->first, it->second);
+	}
+}
+
+void NamespaceManager::send_dft_updates(const std::vector<int>& session_ids,
+					const std::set<int>& excluded,
+					const DFTUpdateQueue::Batch& batch)
+{
+	std::list<rina::DirectoryForwardingTableEntry> entries;
+	std::map<std::string, rina::DirectoryForwardingTableEntry>::const_iterator ct;
+	std::set<std::string>::const_iterator dt;
+	rina::cdap_rib::obj_info_t obj, del_obj;
 	rina::cdap_rib::flags_t flags;
 	rina::cdap_rib::filt_info_t filt;
 	rina::cdap_rib::con_handle_t con;
-	for (int i = 0; i < session_ids.size(); i++) {
-		if (contains_entry(session_ids[i],
-				neighs_to_exclude))
+	encoders::DFTEListEncoder encoder;
+
+	//All the new and updated entries go in a single message, encoded once
+	for (ct = batch.created.begin(); ct != batch.created.end(); ++ct) {
+		entries.push_back(ct->second);
+	}
+	if (entries.size() > 0) {
+		obj.class_ = DFTRIBObj::class_name;
+		obj.name_ = DFTRIBObj::object_name;
+		encoder.encode(entries, obj.value_);
+	}
+	del_obj.class_ = DFTEntryRIBObj::class_name;
+
+	for (unsigned int i = 0; i < session_ids.size(); i++) {
+		if (excluded.count(session_ids[i]))
+			continue;
+
+		con.port_id = session_ids[i];
+		for (dt = batch.deleted.begin(); dt != batch.deleted.end(); ++dt) {
+			try {
+				del_obj.name_ = DFTEntryRIBObj::object_name_prefix + *dt;
+				ipcp->rib_daemon_->getProxy()->remote_delete(con,
+									     del_obj,
+									     flags,
+									     filt,
+									     NULL);
+			} catch (rina::Exception &e) {
+				LOG_WARN("Problems sending delete CDAP message: %s",
+						e.what());
+			}
+		}
+
+		if (entries.size() == 0)
 			continue;
 
 		try {
-			con.port_id = session_ids[i];
 			ipcp->rib_daemon_->getProxy()->remote_create(con,
 								     obj,
 								     flags,
@@ -525,11 +878,15 @@ void NamespaceManager::notify_neighbors_add(const std::list<rina::DirectoryForwa
 
 rina::DirectoryForwardingTableEntry * NamespaceManager::getDFTEntry(const std::string& key)
 {
+	rina::ScopedLock g(lock);
+
 	return dft_.find(key);
 }
 
 std::list<rina::DirectoryForwardingTableEntry> NamespaceManager::getDFTEntries()
 {
+	rina::ScopedLock g(lock);
+
 	return dft_.getCopyofentries();
 }
 
@@ -538,60 +895,52 @@ void NamespaceManager::removeDFTEntry(const std::string& key,
 			 	      bool remove_from_rib,
 			 	      std::list<int>& neighs_to_exclude)
 {
-	rina::ScopedLock g(lock);
-	std::string obj_name;
+	std::list<std::string> keys;
 
-	rina::DirectoryForwardingTableEntry * entry = dft_.erase(key);
-	if (!entry) {
-		LOG_IPCP_WARN("Could not find DFT for key: %s",
-			      key.c_str());
-		return;
-	}
+	keys.push_back(key);
+	removeDFTEntries(keys, notify_neighs, remove_from_rib, neighs_to_exclude);
+}
 
-	std::stringstream ss;
-	ss << DFTEntryRIBObj::object_name_prefix
-	   << key;
-	obj_name = ss.str();
+void NamespaceManager::removeDFTEntries(const std::list<std::string>& keys,
+					bool notify_neighs,
+					bool remove_from_rib,
+					std::list<int>& neighs_to_exclude)
+{
+	std::list<std::string> removed;
+	std::list<std::string>::const_iterator it;
+	rina::DirectoryForwardingTableEntry * entry;
 
-	if (remove_from_rib) {
-		try {
-			rib_daemon_->removeObjRIB(obj_name);
-		} catch (rina::Exception &e){
-			LOG_IPCP_ERR("Error removing object from RIB %s",
-					e.what());
-		}
-	}
+	{
+		rina::ScopedLock g(lock);
 
-	LOG_IPCP_DBG("Removed entry from DFT: %s",
-		     entry->toString().c_str());
+		for (it = keys.begin(); it != keys.end(); ++it) {
+			entry = dft_.erase(*it);
+			if (!entry) {
+				LOG_IPCP_WARN("Could not find DFT for key: %s",
+					      it->c_str());
+				continue;
+			}
 
-	std::vector<int> session_ids;
-	rina::cdap::getProvider()->get_session_manager()->getAllCDAPSessionIds(session_ids);
-	rina::cdap_rib::obj_info_t obj;
-	obj.class_ = DFTEntryRIBObj::class_name;
-	obj.name_ = obj_name;
-	rina::cdap_rib::flags_t flags;
-	rina::cdap_rib::filt_info_t filt;
-	rina::cdap_rib::con_handle_t con;
-	for (int i = 0; i < session_ids.size(); i++) {
-		if (contains_entry(session_ids[i],
-				   neighs_to_exclude))
-			continue;
+			if (remove_from_rib) {
+				try {
+					rib_daemon_->removeObjRIB(DFTEntryRIBObj::object_name_prefix
+								  + *it);
+				} catch (rina::Exception &e){
+					LOG_IPCP_ERR("Error removing object from RIB %s",
+							e.what());
+				}
+			}
 
-		try {
-			con.port_id = session_ids[i];
-			ipcp->rib_daemon_->getProxy()->remote_delete(con,
-								     obj,
-								     flags,
-								     filt,
-								     NULL);
-		} catch (rina::Exception &e) {
-			LOG_WARN("Problems sending delete CDAP message: %s",
-					e.what());
+			LOG_IPCP_DBG("Removed entry from DFT: %s",
+				     entry->toString().c_str());
+			removed.push_back(*it);
+			delete entry;
 		}
 	}
 
-	delete entry;
+	if (notify_neighs && removed.size() > 0)
+		queue_dft_updates(std::list<rina::DirectoryForwardingTableEntry>(),
+				  removed, neighs_to_exclude);
 }
 
 unsigned short NamespaceManager::getRegIPCProcessId(rina::ApplicationProcessNamingInformation& apNamingInfo)
@@ -787,6 +1136,7 @@ void NamespaceManager::processApplicationUnregistrationRequestEvent(
 {
 	rina::ApplicationRegistrationInformation * unregisteredApp = 0;
 	rina::ApplicationProcessNamingInformation dafToUnregister;
+	std::list<std::string> keys;
 	std::list<int> exc_neighs;
 	int result = 0;
 
@@ -808,20 +1158,14 @@ void NamespaceManager::processApplicationUnregistrationRequestEvent(
 		return;
 	}
 
-	removeDFTEntry(unregisteredApp->appName.getEncodedString(),
-		       true,
-		       true,
-		       exc_neighs);
-
+	keys.push_back(unregisteredApp->appName.getEncodedString());
 	if (unregisteredApp->dafName.processName != "") {
 		//Remove DFT entry corresponding to DAF name
 		dafToUnregister.processName = unregisteredApp->dafName.processName;
 		dafToUnregister.processInstance = unregisteredApp->appName.processName;
-		removeDFTEntry(dafToUnregister.getEncodedString(),
-			       true,
-			       true,
-			       exc_neighs);
+		keys.push_back(dafToUnregister.getEncodedString());
 	}
+	removeDFTEntries(keys, true, true, exc_neighs);
 
 	delete unregisteredApp;
 }
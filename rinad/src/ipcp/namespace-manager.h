@@ -23,6 +23,11 @@
 #ifndef IPCP_NAMESPACE_MANAGER_HH
 #define IPCP_NAMESPACE_MANAGER_HH
 
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <vector>
+
 #include <librina/ipc-process.h>
 #include <librina/internal-events.h>
 
@@ -162,6 +167,116 @@ public:
 	unsigned int old_address;
 };
 
+/// The directory forwarding table. Entries are kept in a dense array and
+/// found by key through an open addressing hash table. Their process names
+/// are interned: each distinct one is stored once, together with the
+/// entries that have it, so that resolving a DAF name does not walk the
+/// whole table. It is not thread safe.
+class DirectoryForwardingTable {
+public:
+	DirectoryForwardingTable();
+	/// Deletes the entries
+	~DirectoryForwardingTable();
+
+	/// @ret The entry with that key or NULL
+	rina::DirectoryForwardingTableEntry * find(const std::string& key) const;
+
+	/// @ret An entry of an application process called process_name that is
+	/// not at excluded_address, or NULL
+	rina::DirectoryForwardingTableEntry * find_process(const std::string& process_name,
+							   unsigned int excluded_address) const;
+
+	/// Takes ownership of the entry
+	/// @ret false if there is already an entry with the same key
+	bool put(rina::DirectoryForwardingTableEntry * entry);
+
+	/// @ret The entry with that key, that the caller has to delete, or NULL
+	rina::DirectoryForwardingTableEntry * erase(const std::string& key);
+
+	std::list<rina::DirectoryForwardingTableEntry *> getEntries() const;
+	std::list<rina::DirectoryForwardingTableEntry> getCopyofentries() const;
+	size_t size() const {
+		return count_;
+	};
+
+private:
+	struct Slot {
+		//NULL if free
+		rina::DirectoryForwardingTableEntry * entry;
+		std::string key;
+		uint32_t hash;
+		//Interned process name, and position in its slots
+		int32_t name;
+		size_t pos;
+	};
+
+	struct Name {
+		std::string name;
+		uint32_t hash;
+		//The slots of the entries with this process name
+		std::vector<int32_t> slots;
+	};
+
+	/// Open addressing (linear probing) hash table of ids
+	class Index {
+	public:
+		struct Bucket {
+			uint32_t hash;
+			//-1 if empty
+			int32_t id;
+		};
+
+		Index();
+		void insert(uint32_t hash, int32_t id);
+		void erase(uint32_t hash, int32_t id);
+
+		std::vector<Bucket> buckets;
+		size_t count;
+	};
+
+	static uint32_t hash_string(const std::string& str);
+	int32_t find_slot(const std::string& key, uint32_t hash) const;
+	int32_t find_name(const std::string& name, uint32_t hash) const;
+	int32_t intern(const std::string& name);
+
+	std::vector<Slot> slots_;
+	std::vector<int32_t> free_slots_;
+	Index keys_;
+	std::vector<Name> names_;
+	std::vector<int32_t> free_names_;
+	Index names_index_;
+	size_t count_;
+};
+
+/// DFT updates not sent yet to the neighbors, in batches keyed by the
+/// neighbors (port-ids) they exclude. A key is in created or in deleted
+/// of one batch only, so whatever the order the batches are sent in, the
+/// last update wins. It is not thread safe.
+class DFTUpdateQueue {
+public:
+	struct Batch {
+		std::map<std::string, rina::DirectoryForwardingTableEntry> created;
+		std::set<std::string> deleted;
+	};
+
+	void add(const std::list<rina::DirectoryForwardingTableEntry>& created,
+		 const std::list<std::string>& deleted,
+		 const std::list<int>& neighs_to_exclude);
+
+	/// Moves the pending batches to batches
+	void take(std::map<std::set<int>, Batch>& batches);
+
+	bool empty() const {
+		return batches_.empty();
+	};
+
+private:
+	std::map<std::set<int>, Batch> batches_;
+
+	/// Drops the pending update of key, if any
+	void erase(const std::string& key);
+};
+
 class NamespaceManager: public INamespaceManager, public rina::InternalEventListener {
 public:
 	NamespaceManager();
@@ -179,6 +294,10 @@ public:
 			    bool notify_neighs,
 			    bool remove_from_rib,
 			    std::list<int>& neighs_to_exclude);
+	void removeDFTEntries(const std::list<std::string>& keys,
+			      bool notify_neighs,
+			      bool remove_from_rib,
+			      std::list<int>& neighs_to_exclude);
 	unsigned short getRegIPCProcessId(rina::ApplicationProcessNamingInformation& apNamingInfo);
 	void processApplicationRegistrationRequestEvent(
 				const rina::ApplicationRegistrationRequestEvent& event);
@@ -196,11 +315,19 @@ public:
 	void notify_neighbors_add(const std::list<rina::DirectoryForwardingTableEntry>& entries,
 			          std::list<int>& neighs_to_exclude);
 
+	/// Send the DFT updates batched so far to the neighbors
+	void flush_dft_updates();
+
+	/// Time during which DFT updates are batched before being sent to the
+	/// neighbors, 0 to send each one right away
+	static const std::string DFT_UPDATE_BATCHING_IN_MS;
+	static const unsigned int DEFAULT_DFT_UPDATE_BATCHING_IN_MS;
+
 private:
 	rina::Lockable lock;
 
 	/// The directory forwarding table
-	rina::ThreadSafeMapOfPointers<std::string, rina::DirectoryForwardingTableEntry> dft_;
+	DirectoryForwardingTable dft_;
 
 	/// Applications registered in this IPC Process
 	rina::ThreadSafeMapOfPointers<std::string, rina::ApplicationRegistrationInformation> registrations_;
@@ -208,6 +335,12 @@ private:
 	/// Whatevercast names
 	rina::ThreadSafeMapOfPointers<std::string, rina::WhatevercastName> what_names;
 
+	/// Pending DFT updates
+	DFTUpdateQueue dft_updates_;
+	rina::Lockable dft_updates_lock_;
+	bool dft_flush_scheduled_;
+	unsigned int dft_batching_ms_;
+
 	IPCPRIBDaemon * rib_daemon_;
 	rina::InternalEventManager * event_manager_;
 	rina::Timer timer;
@@ -219,10 +352,28 @@ private:
 			int result);
 	int replyToIPCManagerUnregister(const rina::ApplicationUnregistrationRequestEvent& event,
 			int result);
+	void queue_dft_updates(const std::list<rina::DirectoryForwardingTableEntry>& created,
+			       const std::list<std::string>& deleted,
+			       const std::list<int>& neighs_to_exclude);
+	void send_dft_updates(const std::vector<int>& session_ids,
+			      const std::set<int>& excluded,
+			      const DFTUpdateQueue::Batch& batch);
 
 	bool contains_entry(int candidate, const std::list<int>& elements);
 };
 
+class DFTUpdateFlushTimerTask: public rina::TimerTask {
+public:
+	DFTUpdateFlushTimerTask(NamespaceManager * nsm) : namespace_manager(nsm) {};
+	~DFTUpdateFlushTimerTask() throw() {};
+	void run() {
+		namespace_manager->flush_dft_updates();
+	};
+
+private:
+	NamespaceManager * namespace_manager;
+};
+
 class CheckDFTEntriesToRemoveTimerTask : public rina::TimerTask {
 public:
 	CheckDFTEntriesToRemoveTimerTask(DFTRIBObj * dft_,
@@ -93,6 +93,9 @@ void UseNewIPCPAddressTimerTask::run()
 }
 
 //Class IPCProcessImpl
+const std::string IPCProcessImpl::KERNEL_SYNC_PERIOD_IN_MS = "kernelSyncPeriodInMs";
+const std::string IPCProcessImpl::KERNEL_STATS_TTL_IN_MS = "kernelStatsTtlInMs";
+
 IPCProcessImpl::IPCProcessImpl(const rina::ApplicationProcessNamingInformation& nm,
 			       unsigned short id,
 			       unsigned int ipc_manager_port,
@@ -115,6 +118,7 @@ IPCProcessImpl::IPCProcessImpl(const rina::ApplicationProcessNamingInformation&
         security_manager_ = new IPCPSecurityManager();
         routing_component_ = new RoutingComponent();
         rib_daemon_ = new IPCPRIBDaemonImpl(enrollment_task_);
+        kernel_stats_ = new KernelStatsCache(id);
 
         add_entity(internal_event_manager_);
         add_entity(rib_daemon_);
@@ -158,6 +162,7 @@ IPCProcessImpl::~IPCProcessImpl()
 	delete namespace_manager_;
 	delete routing_component_;
 	delete resource_allocator_;
+	delete kernel_stats_;
 	delete rib_daemon_;
 	delete enrollment_task_;
 }
@@ -306,8 +311,12 @@ void IPCProcessImpl::requestPDUFTEDump()
 
 void IPCProcessImpl::sync_with_kernel()
 {
-	flow_allocator_->sync_with_kernel();
-	resource_allocator_->sync_with_kernel();
+	KernelStats stats;
+
+	stats.read(get_id());
+	kernel_stats_->update(stats);
+	flow_allocator_->sync_with_kernel(stats);
+	resource_allocator_->sync_with_kernel(stats);
 }
 
 int IPCProcessImpl::dispatchSelectPolicySet(const std::string& path,
@@ -446,10 +455,33 @@ void IPCProcessImpl::assign_to_dif_response_handler(const rina::AssignToDIFRespo
 	}
 
 	state = ASSIGNED_TO_DIF;
+
+	// RIB objects read the kernel counters on demand, so large IPCPs can
+	// turn off the periodic sync with a period of 0
+	rina::PolicyConfig params;
+	unsigned int sync_period = KernelSyncTrigger::DEFAULT_PERIOD_IN_MS;
+	params.parameters_ = dif_information_.dif_configuration_.parameters_;
+	try {
+		sync_period = params.get_param_value_as_uint(KERNEL_SYNC_PERIOD_IN_MS);
+	} catch (rina::Exception &e) {
+		LOG_IPCP_DBG("Using default kernel sync period: %u ms", sync_period);
+	}
+	try {
+		kernel_stats_->set_ttl(params.get_param_value_as_uint(KERNEL_STATS_TTL_IN_MS));
+	} catch (rina::Exception &e) {
+		LOG_IPCP_DBG("Using default kernel stats TTL: %u ms",
+			     KernelStatsCache::DEFAULT_TTL_IN_MS);
+	}
+
+	if (sync_period == 0) {
+		LOG_IPCP_INFO("Periodic sync with the kernel disabled");
+		return;
+	}
+
 	rina::ThreadAttributes threadAttributes;
 	threadAttributes.setJoinable();
 	threadAttributes.setName("sysfs-sync");
-	kernel_sync = new KernelSyncTrigger(&threadAttributes, this, 4000);
+	kernel_sync = new KernelSyncTrigger(&threadAttributes, this, sync_period);
 	kernel_sync->start();
 }
 
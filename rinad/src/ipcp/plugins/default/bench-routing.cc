@@ -0,0 +1,780 @@
+//
+// Link-state routing benchmark
+//
+// Measures how long it takes to build the graph of 50k flow state objects,
+// from scratch and in place. Then measures how long the Dijkstra routing
+// algorithm takes to compute the routing table and the shortest distances
+// of one IPCP, on synthetic topologies of 1k and 10k IPCPs: a ring where
+// every IPCP also has a chord to a random IPCP, with link costs between 1
+// and 4. These are also the topologies of the graph benchmark. Then changes
+// one link of the 1k IPCP topology at a time, and measures the time the
+// full and the incremental algorithm take to update the routing table.
+// Last, measures how long the loop free alternate algorithm takes to add
+// the alternate next hops to the routing table, with and without worker
+// threads, on the ring topologies and on grids like the one of the tests.
+// And how long the routing tables of four QoS cubes with different link
+// cost metrics take on the 10k IPCP topology, with and without workers.
+// Finally, measures the bytes and the CPU time of the propagation rounds
+// of a database of 5k flow state objects with 4 neighbors: rounds with
+// 50 updates, each received from one neighbor, and the synchronization
+// of a new neighbor that lacks 1% of the objects and has older versions of
+// another 1%, with both ends sending all their objects or the neighbor
+// sending summaries. The encoding of every object for each port, as the
+// propagation used to do, is measured too. And measures the CPU time per
+// age timer pulse of 50k objects, 1% of them refreshed every pulse, until
+// a partition stops refreshing half of them and they expire, walking all
+// the objects every pulse as the aging used to do and with expiry buckets.
+// Last, changes one link at a time of the 10k IPCP topology and measures
+// the netlink bytes and entries sent to the kernel to update the PDU
+// forwarding table of one IPCP, replacing the whole table as it used to
+// be done and sending only the changes, and the time to compute them.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <vector>
+
+#define IPCP_MODULE "lsr-bench"
+#include "../../ipcp-logging.h"
+
+#include "ipcp/resource-allocator.h"
+#include "routing-ps.h"
+#include "routing-topologies.h"
+
+int ipcp_id = 1;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench(int ipcps, int n)
+{
+	std::vector<Link> links;
+	std::list<rinad::FlowStateObject> fsos;
+	std::map<std::string, int> distances;
+	rinad::DijkstraAlgorithm dijkstra;
+	double start;
+
+	ring_with_chords(ipcps, links);
+	flow_state_objects(links, fsos);
+
+	start = now_s();
+	rinad::Graph graph(fsos);
+	printf("%6d IPCPs %6zu edges: graph built in %.1f ms\n", ipcps,
+	       graph.edges_.size(), (now_s() - start) * 1e3);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		std::list<rina::RoutingTableEntry *> rt;
+
+		dijkstra.computeRoutingTable(graph, fsos, ipcp_name(i % ipcps),
+					     rt);
+		if ((int) rt.size() != ipcps - 1) {
+			printf("Routing table of %zu entries instead of %d\n",
+			       rt.size(), ipcps - 1);
+			return -1;
+		}
+		free_routing_table(rt);
+	}
+	printf("%-24s %6d IPCPs %12.0f ns/op\n", "routing table", ipcps,
+	       (now_s() - start) * 1e9 / n);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		dijkstra.computeShortestDistances(graph, ipcp_name(i % ipcps),
+						  distances);
+	}
+	printf("%-24s %6d IPCPs %12.0f ns/op\n", "shortest distances", ipcps,
+	       (now_s() - start) * 1e9 / n);
+
+	return 0;
+}
+
+// Changes the cost or the state of one random link at a time, and times
+// the full and the incremental computation of the new routing table
+static int bench_changes(int ipcps, int n)
+{
+	std::vector<Link> links;
+	rinad::DijkstraAlgorithm full;
+	rinad::IncrementalDijkstraAlgorithm incremental;
+	std::list<rina::RoutingTableEntry *> rt1, rt2;
+	std::string source = ipcp_name(0);
+	double start, full_time = 0, incremental_time = 0;
+	unsigned int seed = 1;
+	int incremental_runs = 0;
+
+	ring_with_chords(ipcps, links);
+
+	for (int i = 0; i <= n; i++) {
+		std::list<rinad::FlowStateObject> fsos;
+
+		if (i > 0) {
+			Link& link = links[rand_r(&seed) % links.size()];
+
+			if (rand_r(&seed) % 2) {
+				link.up = !link.up;
+			} else {
+				link.cost = 1 + rand_r(&seed) % 4;
+			}
+		}
+		flow_state_objects(links, fsos);
+		rinad::Graph graph(fsos);
+
+		start = now_s();
+		full.computeRoutingTable(graph, fsos, source, rt1);
+		if (i > 0)
+			full_time += now_s() - start;
+
+		start = now_s();
+		incremental.computeRoutingTable(graph, fsos, source, rt2);
+		if (i > 0) {
+			incremental_time += now_s() - start;
+			if (incremental.incremental())
+				incremental_runs++;
+		}
+
+		if (rt1.size() != rt2.size()) {
+			printf("Routing tables of %zu and %zu entries\n",
+			       rt1.size(), rt2.size());
+			return -1;
+		}
+		free_routing_table(rt1);
+		free_routing_table(rt2);
+	}
+
+	printf("%-24s %6d IPCPs %12.0f ns/change\n", "full SPF", ipcps,
+	       full_time * 1e9 / n);
+	printf("%-24s %6d IPCPs %12.0f ns/change (%d of %d incremental)\n",
+	       "incremental SPF", ipcps, incremental_time * 1e9 / n,
+	       incremental_runs, n);
+
+	return 0;
+}
+
+// Times building the graph of the flow state objects of a ring with chords
+static int bench_graph(int objects, int n)
+{
+	std::vector<Link> links;
+	std::list<rinad::FlowStateObject> fsos;
+	rinad::Graph reused;
+	double start;
+
+	ring_with_chords(objects / 4, links);
+	flow_state_objects(links, fsos);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		rinad::Graph graph(fsos);
+
+		if (graph.edges_.size() != links.size()) {
+			printf("Graph of %zu edges instead of %zu\n",
+			       graph.edges_.size(), links.size());
+			return -1;
+		}
+	}
+	printf("%-24s %6zu FSOs %13.0f ns/op\n", "graph", fsos.size(),
+	       (now_s() - start) * 1e9 / n);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		reused.set_flow_state_objects(fsos);
+	}
+	printf("%-24s %6zu FSOs %13.0f ns/op\n", "graph rebuilt in place",
+	       fsos.size(), (now_s() - start) * 1e9 / n);
+
+	return 0;
+}
+
+// Times the routing table computation followed by the loop free
+// alternates, of one IPCP at a time
+static int bench_lfa(const char * topology, const std::vector<Link>& links,
+		     int workers, int n)
+{
+	std::list<rinad::FlowStateObject> fsos;
+	rinad::DijkstraAlgorithm dijkstra;
+	rinad::LoopFreeAlternateAlgorithm lfa(dijkstra, workers);
+	double start, elapsed = 0;
+	unsigned int alternates = 0;
+
+	flow_state_objects(links, fsos);
+	rinad::Graph graph(fsos);
+
+	for (int i = 0; i < n; i++) {
+		std::list<rina::RoutingTableEntry *> rt;
+		std::list<rina::RoutingTableEntry *>::iterator it;
+		std::string source = ipcp_name(links[i * 7919 % links.size()].a);
+
+		dijkstra.computeRoutingTable(graph, fsos, source, rt);
+		start = now_s();
+		lfa.fortifyRoutingTable(graph, source, rt);
+		elapsed += now_s() - start;
+
+		for (it = rt.begin(); it != rt.end(); ++it) {
+			alternates += (*it)->nextHopNames.front().alts.size() - 1;
+		}
+		free_routing_table(rt);
+	}
+
+	printf("%-10s %6zu IPCPs %d workers %12.0f ns/op (%.1f alternates per table)\n",
+	       topology, graph.vertices_.size(), workers, elapsed * 1e9 / n,
+	       (double) alternates / n);
+
+	return 0;
+}
+
+// Four QoS cubes with different metrics
+static int bench_qos_cubes(int ipcps, int workers, int n)
+{
+	const int metrics[4][2] = {{1, 0}, {0, 1}, {2, 1}, {1, 3}};
+	std::vector<Link> links;
+	std::list<rinad::FlowStateObject> fsos;
+	rinad::QoSCubeRoutingAlgorithm algorithm(
+			rinad::LinkStateRoutingPolicy::DIJKSTRA_ALG, false, workers);
+	double start, elapsed = 0;
+	unsigned long entries = 0;
+
+	for (int i = 0; i < 4; i++) {
+		algorithm.addQoSCube(i + 1, metrics[i][0], metrics[i][1]);
+	}
+	ring_with_chords(ipcps, links);
+	flow_state_objects(links, fsos);
+	rinad::Graph graph(fsos);
+
+	for (int i = 0; i < n; i++) {
+		std::list<rina::RoutingTableEntry *> rt;
+		std::string source = ipcp_name(links[i * 7919 % links.size()].a);
+
+		start = now_s();
+		algorithm.computeRoutingTable(graph, fsos, source, rt);
+		elapsed += now_s() - start;
+		entries += rt.size();
+		free_routing_table(rt);
+	}
+
+	printf("QoS cubes  %6d IPCPs %d workers %12.0f ns/op (%.0f entries per table)\n",
+	       ipcps, workers, elapsed * 1e9 / n, (double) entries / n);
+
+	return 0;
+}
+
+typedef std::map<std::string, rinad::FlowStateObject *> FlowStateObjectMap;
+
+static unsigned long message_bytes(const rinad::FlowStateMessages& messages)
+{
+	std::map<int, std::list<unsigned int> >::const_iterator it;
+	std::list<unsigned int>::const_iterator jt;
+	unsigned long bytes = 0;
+
+	for (it = messages.ports.begin(); it != messages.ports.end(); ++it) {
+		for (jt = it->second.begin(); jt != it->second.end(); ++jt) {
+			bytes += messages.messages[*jt].size();
+		}
+	}
+
+	return bytes;
+}
+
+// Copies the objects to send on every port and encodes them per port, in
+// groups of max_objects
+static unsigned long encode_per_port(const std::map<int, std::list<rinad::FlowStateObject *> >& to_send,
+				     unsigned int max_objects)
+{
+	std::map<int, std::list<rinad::FlowStateObject *> >::const_iterator it;
+	std::list<rinad::FlowStateObject *>::const_iterator jt;
+	rinad::FlowStateObjectListEncoder encoder;
+	unsigned long bytes = 0;
+
+	for (it = to_send.begin(); it != to_send.end(); ++it) {
+		std::list<rinad::FlowStateObject> group;
+
+		for (jt = it->second.begin(); jt != it->second.end(); ++jt) {
+			group.push_back(**jt);
+			if (group.size() == max_objects) {
+				rina::ser_obj_t encoded;
+				encoder.encode(group, encoded);
+				bytes += encoded.size_;
+				group.clear();
+			}
+		}
+		if (!group.empty()) {
+			rina::ser_obj_t encoded;
+			encoder.encode(group, encoded);
+			bytes += encoded.size_;
+		}
+	}
+
+	return bytes;
+}
+
+static void report_propagation(const char * name, unsigned long objects,
+			       double bytes, double cpu)
+{
+	printf("%-24s %6lu FSOs %10.0f bytes/round %12.0f ns CPU/round\n",
+	       name, objects, bytes, cpu * 1e9);
+}
+
+static void add_objects(FlowStateObjectMap& db, rinad::FlowStateDeltas& deltas)
+{
+	for (FlowStateObjectMap::iterator it = db.begin(); it != db.end(); ++it) {
+		deltas.objectAdded(it->second);
+	}
+}
+
+static void free_objects(FlowStateObjectMap& db)
+{
+	for (FlowStateObjectMap::iterator it = db.begin(); it != db.end(); ++it) {
+		delete it->second;
+	}
+	db.clear();
+}
+
+// Propagation rounds of a database of objects flow state objects with
+// neighbors neighbors
+static int bench_propagation(int objects, int neighbors, int n)
+{
+	const unsigned int max_objects =
+		rinad::LinkStateRoutingPolicy::MAX_OBJECTS_PER_ROUTING_UPDATE_DEFAULT;
+	const int updates = 50;
+	std::vector<Link> links;
+	std::list<rinad::FlowStateObject> fsos;
+	std::list<rinad::FlowStateObject>::iterator ft;
+	FlowStateObjectMap db, neighbor_db;
+	std::vector<rinad::FlowStateObject *> index;
+	std::list<int> ports;
+	rinad::FlowStateDeltas deltas, neighbor_deltas;
+	rinad::FlowStateObjectSummaryEncoder encoder;
+	unsigned int seed = 1, stale = 0;
+	unsigned long bytes = 0, old_bytes = 0;
+	double start, cpu = 0, old_cpu = 0;
+	int port = neighbors + 1;
+
+	ring_with_chords(objects / 4, links);
+	flow_state_objects(links, fsos);
+	for (ft = fsos.begin(); ft != fsos.end(); ++ft) {
+		rinad::FlowStateObject * fso = new rinad::FlowStateObject(*ft);
+
+		db[fso->object_name] = fso;
+		index.push_back(fso);
+	}
+	add_objects(db, deltas);
+	for (int i = 1; i <= neighbors; i++) {
+		ports.push_back(i);
+	}
+	deltas.setPorts(ports);
+
+	// Rounds of updates, each one received from a neighbor
+	for (int i = 0; i < n; i++) {
+		std::map<int, std::list<rinad::FlowStateObject *> > to_send;
+		std::vector<std::pair<rinad::FlowStateObject *, int> > updated;
+		rinad::FlowStateMessages messages;
+
+		for (int j = 0; j < updates; j++) {
+			rinad::FlowStateObject * fso =
+				index[rand_r(&seed) % index.size()];
+
+			fso->seq_num++;
+			updated.push_back(std::make_pair(fso,
+							 1 + rand_r(&seed) % neighbors));
+		}
+
+		start = cpu_s();
+		for (int j = 0; j < updates; j++) {
+			deltas.objectModified(updated[j].first,
+					      updated[j].second);
+		}
+		deltas.getMessages(-1, max_objects, messages);
+		cpu += cpu_s() - start;
+		bytes += message_bytes(messages);
+
+		start = cpu_s();
+		for (int j = 0; j < updates; j++) {
+			for (int k = 1; k <= neighbors; k++) {
+				if (k != updated[j].second)
+					to_send[k].push_back(updated[j].first);
+			}
+		}
+		old_bytes += encode_per_port(to_send, max_objects);
+		old_cpu += cpu_s() - start;
+	}
+	report_propagation("updates", db.size(), (double) bytes / n, cpu / n);
+	report_propagation("updates per port", db.size(),
+			   (double) old_bytes / n, old_cpu / n);
+
+	// A new neighbor lacks 1% of the objects, and has older versions of
+	// another 1%
+	for (unsigned int i = 0; i < index.size(); i++) {
+		rinad::FlowStateObject * fso;
+
+		if (i % 100 == 0) {
+			stale++;
+			continue;
+		}
+		fso = new rinad::FlowStateObject(*index[i]);
+		if (i % 100 == 50) {
+			fso->seq_num--;
+			stale++;
+		}
+		neighbor_db[fso->object_name] = fso;
+	}
+	add_objects(neighbor_db, neighbor_deltas);
+
+	// Both ends send all their objects
+	bytes = 0;
+	cpu = 0;
+	for (int i = 0; i < n; i++) {
+		rinad::FlowStateMessages messages, neighbor_messages;
+
+		start = cpu_s();
+		deltas.addPort(port);
+		deltas.setAllPending(port);
+		deltas.getMessages(port, max_objects, messages);
+		neighbor_deltas.addPort(1);
+		neighbor_deltas.setAllPending(1);
+		neighbor_deltas.getMessages(1, max_objects, neighbor_messages);
+		cpu += cpu_s() - start;
+		bytes += message_bytes(messages) +
+			 message_bytes(neighbor_messages);
+	}
+	report_propagation("new neighbor", db.size(), (double) bytes / n,
+			   cpu / n);
+
+	// The new neighbor sends its summaries, gets the objects it lacks and
+	// is asked for the ones it has newer versions of
+	bytes = 0;
+	cpu = 0;
+	for (int i = 0; i < n; i++) {
+		std::list<rinad::FlowStateObjectSummary> summaries;
+		std::list<rinad::FlowStateObjectSummary>::iterator it;
+		rinad::FlowStateMessages messages, neighbor_messages;
+
+		start = cpu_s();
+		neighbor_deltas.getSummaries(rinad::LinkStateRoutingPolicy::MAX_OBJECTS_PER_SUMMARY,
+					     summaries);
+		for (it = summaries.begin(); it != summaries.end(); ++it) {
+			rinad::FlowStateObjectSummary decoded, request, reply;
+			rina::ser_obj_t encoded;
+
+			encoder.encode(*it, encoded);
+			bytes += encoded.size_;
+			encoder.decode(encoded, decoded);
+			deltas.processSummary(decoded, port, request);
+			if (request.objects.empty())
+				continue;
+
+			rina::ser_obj_t encoded_request;
+			encoder.encode(request, encoded_request);
+			bytes += encoded_request.size_;
+			decoded.objects.clear();
+			encoder.decode(encoded_request, decoded);
+			neighbor_deltas.processSummary(decoded, 1, reply);
+		}
+		deltas.getMessages(port, max_objects, messages);
+		neighbor_deltas.getMessages(1, max_objects, neighbor_messages);
+		cpu += cpu_s() - start;
+		bytes += message_bytes(messages) +
+			 message_bytes(neighbor_messages);
+
+		if (messages.objects != stale || neighbor_messages.objects) {
+			printf("Sent %u and %u objects instead of %u and 0\n",
+			       messages.objects, neighbor_messages.objects,
+			       stale);
+			return -1;
+		}
+	}
+	report_propagation("new neighbor summaries", db.size(),
+			   (double) bytes / n, cpu / n);
+
+	bytes = 0;
+	cpu = 0;
+	for (int i = 0; i < n; i++) {
+		std::map<int, std::list<rinad::FlowStateObject *> > to_send;
+		FlowStateObjectMap::iterator it;
+
+		start = cpu_s();
+		to_send[port].assign(index.begin(), index.end());
+		for (it = neighbor_db.begin(); it != neighbor_db.end(); ++it) {
+			to_send[1].push_back(it->second);
+		}
+		bytes += encode_per_port(to_send, max_objects);
+		cpu += cpu_s() - start;
+	}
+	report_propagation("new neighbor per port", db.size(),
+			   (double) bytes / n, cpu / n);
+
+	free_objects(db);
+	free_objects(neighbor_db);
+
+	return 0;
+}
+
+// The age timer pulses of objects flow state objects of maximum age
+// max_age, refreshing 1% of them every pulse. After pulses pulses half of
+// them stop being refreshed until they expire.
+static int bench_aging(int objects, unsigned int max_age, int pulses)
+{
+	std::vector<rinad::FlowStateObject *> db;
+	rinad::FlowStateAges ages;
+	unsigned int seed = 1;
+	double start, sweep = 0, buckets = 0;
+	unsigned long swept = 0, expired = 0, sweep_tasks = 0, bucket_tasks = 0;
+	int pulse;
+
+	for (int i = 0; i < objects; i++) {
+		db.push_back(new rinad::FlowStateObject(ipcp_name(i),
+							ipcp_name(i + 1), 1,
+							true, 1, 0));
+		db.back()->age = rand_r(&seed) % max_age;
+		db.back()->being_erased = false;
+	}
+
+	// Walking all the objects every pulse
+	for (pulse = 0; expired < (unsigned long) objects / 2; pulse++) {
+		int refreshed = pulse < pulses ? objects : objects / 2;
+
+		for (int i = 0; i < objects / 100; i++) {
+			db[rand_r(&seed) % refreshed]->age = 0;
+		}
+
+		start = cpu_s();
+		for (int i = 0; i < objects; i++) {
+			rinad::FlowStateObject * fso = db[i];
+
+			if (fso->age < UINT_MAX)
+				fso->age++;
+			if (fso->age >= max_age && !fso->being_erased) {
+				fso->being_erased = true;
+				expired++;
+				sweep_tasks++;
+			}
+		}
+		sweep += cpu_s() - start;
+		swept++;
+	}
+
+	// With expiry buckets
+	ages.set_maximum_age(max_age);
+	seed = 1;
+	for (int i = 0; i < objects; i++) {
+		ages.setAge(db[i], rand_r(&seed) % max_age);
+		db[i]->being_erased = false;
+	}
+	expired = 0;
+	for (pulse = 0; expired < (unsigned long) objects / 2; pulse++) {
+		int refreshed = pulse < pulses ? objects : objects / 2;
+		std::list<rinad::FlowStateObject *> to_erase;
+		std::list<rinad::FlowStateObject *>::iterator it;
+		bool erased = false;
+
+		for (int i = 0; i < objects / 100; i++) {
+			ages.setAge(db[rand_r(&seed) % refreshed], 0);
+		}
+
+		start = cpu_s();
+		ages.increment(to_erase);
+		for (it = to_erase.begin(); it != to_erase.end(); ++it) {
+			if ((*it)->being_erased)
+				continue;
+			(*it)->being_erased = true;
+			expired++;
+			erased = true;
+		}
+		if (erased)
+			bucket_tasks++;
+		buckets += cpu_s() - start;
+	}
+
+	printf("aging sweep   %6d FSOs %5lu pulses %10.0f ns CPU/pulse "
+	       "%6lu removal tasks\n", objects, swept, sweep * 1e9 / swept,
+	       sweep_tasks);
+	printf("aging buckets %6d FSOs %5d pulses %10.0f ns CPU/pulse "
+	       "%6lu removal tasks\n", objects, pulse, buckets * 1e9 / pulse,
+	       bucket_tasks);
+
+	for (unsigned int i = 0; i < db.size(); i++) {
+		delete db[i];
+	}
+
+	return 0;
+}
+
+// The PDU forwarding table of a routing table, with the index of every
+// IPCP as its address and the index of every next hop as the port-id
+static void pduft_of(const std::list<rina::RoutingTableEntry *>& rt,
+		     std::list<rina::PDUForwardingTableEntry *>& pduft)
+{
+	std::list<rina::RoutingTableEntry *>::const_iterator it;
+	std::list<rina::NHopAltList>::const_iterator jt;
+
+	for (it = rt.begin(); it != rt.end(); ++it) {
+		rina::PDUForwardingTableEntry * entry =
+			new rina::PDUForwardingTableEntry();
+
+		entry->address = atoi((*it)->destination.name.c_str() + 5);
+		entry->qosId = 1;
+		for (jt = (*it)->nextHopNames.begin();
+				jt != (*it)->nextHopNames.end(); ++jt) {
+			entry->portIdAltlists.push_back(rina::PortIdAltlist(
+				atoi(jt->alts.front().name.c_str() + 5)));
+		}
+		pduft.push_back(entry);
+	}
+}
+
+static void free_pduft(std::list<rina::PDUForwardingTableEntry *>& pduft)
+{
+	std::list<rina::PDUForwardingTableEntry *>::iterator it;
+
+	for (it = pduft.begin(); it != pduft.end(); ++it) {
+		delete *it;
+	}
+	pduft.clear();
+}
+
+// The bytes of the netlink message that sends entries to the kernel, as
+// the schema of RmtModifyPDUFTEntriesRequestMessage lays them out: the
+// netlink, generic netlink and RINA headers, the mode, and the nested
+// entries with their address, qos-id and port-id alternative lists
+static unsigned long netlink_bytes(const std::list<rina::PDUForwardingTableEntry *>& entries)
+{
+	std::list<rina::PDUForwardingTableEntry *>::const_iterator it;
+	std::list<rina::PortIdAltlist>::const_iterator jt;
+	unsigned long bytes = 16 + 4 + 4 + 8 + 4;
+
+	for (it = entries.begin(); it != entries.end(); ++it) {
+		bytes += 4 + 8 + 8 + 4;
+		for (jt = (*it)->portIdAltlists.begin();
+				jt != (*it)->portIdAltlists.end(); ++jt) {
+			bytes += 4 + 4 + 8 * jt->alts.size();
+		}
+	}
+
+	return bytes;
+}
+
+// Changes the cost or the state of one random link at a time, and sends
+// the new PDU forwarding table of the first IPCP to the kernel
+static int bench_pduft(int ipcps, int n)
+{
+	std::vector<Link> links;
+	rinad::DijkstraAlgorithm dijkstra;
+	rinad::PDUFTDeltas deltas;
+	std::string source = ipcp_name(0);
+	unsigned long replace_bytes = 0, replace_entries = 0;
+	unsigned long delta_bytes = 0, delta_entries = 0;
+	double start, delta_time = 0;
+	unsigned int seed = 1;
+
+	ring_with_chords(ipcps, links);
+
+	for (int i = 0; i <= n; i++) {
+		std::list<rinad::FlowStateObject> fsos;
+		std::list<rina::RoutingTableEntry *> rt;
+		std::list<rina::PDUForwardingTableEntry *> pduft, to_add,
+			to_remove;
+
+		if (i > 0) {
+			Link& link = links[rand_r(&seed) % links.size()];
+
+			if (rand_r(&seed) % 2) {
+				link.up = !link.up;
+			} else {
+				link.cost = 1 + rand_r(&seed) % 4;
+			}
+		}
+		flow_state_objects(links, fsos);
+		rinad::Graph graph(fsos);
+		dijkstra.computeRoutingTable(graph, fsos, source, rt);
+		pduft_of(rt, pduft);
+
+		start = cpu_s();
+		deltas.update(pduft, to_add, to_remove);
+		if (i > 0) {
+			delta_time += cpu_s() - start;
+			replace_bytes += netlink_bytes(pduft);
+			replace_entries += pduft.size();
+			delta_bytes += (to_add.empty() ? 0 : netlink_bytes(to_add)) +
+				(to_remove.empty() ? 0 : netlink_bytes(to_remove));
+			delta_entries += to_add.size() + to_remove.size();
+		}
+
+		free_routing_table(rt);
+		free_pduft(pduft);
+		free_pduft(to_add);
+		free_pduft(to_remove);
+	}
+
+	printf("%-24s %6d IPCPs %10.0f bytes/change %8.0f entries/change\n",
+	       "PDUFT replaced", ipcps, (double) replace_bytes / n,
+	       (double) replace_entries / n);
+	printf("%-24s %6d IPCPs %10.0f bytes/change %8.1f entries/change "
+	       "%8.0f ns CPU/change\n", "PDUFT changes", ipcps,
+	       (double) delta_bytes / n, (double) delta_entries / n,
+	       delta_time * 1e9 / n);
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 20;
+	int result;
+
+	setLogLevel("ERR");
+
+	result = bench_graph(50000, n);
+	result |= bench(1000, n);
+	result |= bench(10000, n > 10 ? n / 10 : 1);
+	result |= bench_changes(1000, n * 5);
+
+	for (int ipcps = 1000; ipcps <= 10000; ipcps *= 10) {
+		std::vector<Link> ring, square;
+		int m = ipcps > 1000 ? (n > 10 ? n / 10 : 1) : n;
+
+		ring_with_chords(ipcps, ring);
+		grid(ipcps, square);
+		for (int workers = 0; workers <= 3; workers += 3) {
+			result |= bench_lfa("LFA ring", ring, workers, m);
+			result |= bench_lfa("LFA grid", square, workers, m);
+		}
+	}
+
+	for (int workers = 0; workers <= 3; workers += 3) {
+		result |= bench_qos_cubes(10000, workers, n > 10 ? n / 10 : 1);
+	}
+
+	result |= bench_propagation(5000, 4, n);
+	result |= bench_aging(50000, 1000, 1000);
+	result |= bench_pduft(10000, n);
+
+	return result ? -1 : 0;
+}
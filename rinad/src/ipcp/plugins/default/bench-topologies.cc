@@ -0,0 +1,349 @@
+//
+// Link-state routing benchmark on synthetic topologies
+//
+// Generates the flow state objects of grid, fat tree, random geometric
+// and scale free topologies of 1k, 10k and 50k IPCPs, and measures the
+// time per operation of every step of a routing table update on its own:
+// building the graph, computing the routing table with Dijkstra, with
+// ECMP Dijkstra and with its weighted version, adding the loop free
+// alternates, and turning the routing table into the PDU forwarding table
+// with the default generator policy, which here records the entries
+// instead of sending them to the kernel.
+// The routing tables handed to the generator alternate between the ones
+// before and after a link of the source goes down. Every topology runs in
+// a child process, which reports its peak RSS after each step.
+//
+// Usage: bench-topologies [max IPCPs] [repetitions]
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define IPCP_MODULE "lsr-bench"
+#include "../../ipcp-logging.h"
+
+#include "resource-allocator-ps.h"
+#include "routing-ps.h"
+#include "routing-topologies.h"
+
+int ipcp_id = 1;
+
+static double now_s()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long peak_rss_kb()
+{
+	rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static void report(const char * topology, int ipcps, const char * step,
+		   double elapsed, int n)
+{
+	printf("%-16s %6d IPCPs %-16s %14.0f ns/op %8ld KB peak RSS\n",
+	       topology, ipcps, step, elapsed * 1e9 / n, peak_rss_kb());
+}
+
+// IPCP i has address i + 1, and the N-1 flow to it port-id i + 1
+static unsigned int ipcp_number(const std::string& name)
+{
+	return atoi(name.c_str() + 5) + 1;
+}
+
+class BenchNMinusOneFlowManager : public rinad::INMinusOneFlowManager {
+public:
+	void set_ipc_process(rinad::IPCProcess * ipc_process) { (void) ipc_process; }
+	void set_dif_configuration(const rina::DIFConfiguration& dif_configuration)
+	{ (void) dif_configuration; }
+	void processRegistrationNotification(const rina::IPCProcessDIFRegistrationEvent& event)
+	{ (void) event; }
+	std::list<int> getNMinusOneFlowsToNeighbour(unsigned int address)
+	{ (void) address; return std::list<int>(); }
+	int getManagementFlowToNeighbour(const std::string& name)
+	{ return ipcp_number(name); }
+	unsigned int numberOfFlowsToNeighbour(const std::string& apn,
+					      const std::string& api)
+	{ (void) apn; (void) api; return 1; }
+};
+
+// Keeps the last tables, as the resource allocator does
+class BenchResourceAllocator : public rinad::IResourceAllocator {
+public:
+	~BenchResourceAllocator()
+	{
+		free_routing_table(rt_);
+		free_pduft();
+	}
+	void set_application_process(rina::ApplicationProcess * ap) { (void) ap; }
+	void set_dif_configuration(const rina::DIFConfiguration& dif_configuration)
+	{ (void) dif_configuration; }
+	rinad::INMinusOneFlowManager * get_n_minus_one_flow_manager() const
+	{ return (rinad::INMinusOneFlowManager *) &n1fm_; }
+	std::list<rina::QoSCube*> getQoSCubes()
+	{ return std::list<rina::QoSCube*>(); }
+	void addQoSCube(const rina::QoSCube& cube) { (void) cube; }
+	std::list<rina::PDUForwardingTableEntry> get_pduft_entries()
+	{ return std::list<rina::PDUForwardingTableEntry>(); }
+	void set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft,
+			       bool replaced)
+	{
+		(void) replaced;
+		free_pduft();
+		pduft_ = pduft;
+	}
+	std::list<rina::RoutingTableEntry> get_rt_entries()
+	{ return std::list<rina::RoutingTableEntry>(); }
+	void set_rt_entries(const std::list<rina::RoutingTableEntry*>& rt)
+	{
+		free_routing_table(rt_);
+		rt_ = rt;
+	}
+	void get_next_hop_address(unsigned int dest_address,
+				  std::list<unsigned int>& addresses)
+	{ (void) dest_address; (void) addresses; }
+	unsigned int get_n1_port_to_address(unsigned int dest_address)
+	{ (void) dest_address; return 0; }
+	void add_temp_pduft_entry(unsigned int dest_address, int port_id)
+	{ (void) dest_address; (void) port_id; }
+	void remove_temp_pduft_entry(unsigned int dest_address)
+	{ (void) dest_address; }
+
+private:
+	BenchNMinusOneFlowManager n1fm_;
+	std::list<rina::RoutingTableEntry *> rt_;
+	std::list<rina::PDUForwardingTableEntry *> pduft_;
+
+	void free_pduft()
+	{
+		std::list<rina::PDUForwardingTableEntry *>::iterator it;
+
+		for (it = pduft_.begin(); it != pduft_.end(); ++it) {
+			delete *it;
+		}
+		pduft_.clear();
+	}
+};
+
+// Counts the entries instead of sending them to the kernel
+class BenchPDUFTGeneratorPs : public rinad::DefaultPDUFTGeneratorPs {
+public:
+	BenchPDUFTGeneratorPs(rinad::IResourceAllocator * ra)
+		: rinad::DefaultPDUFTGeneratorPs(ra), entries(0) {};
+
+	unsigned long entries;
+
+protected:
+	void modifyPDUForwardingTableEntries(const std::list<rina::PDUForwardingTableEntry *>& pduft,
+					     int mode)
+	{
+		(void) mode;
+		entries += pduft.size();
+	}
+};
+
+// Copies the routing table, with the addresses of the IPCPs
+static void routing_table_copy(const std::list<rina::RoutingTableEntry *>& rt,
+			       std::list<rina::RoutingTableEntry *>& copy)
+{
+	std::list<rina::RoutingTableEntry *>::const_iterator it;
+	std::list<rina::NHopAltList>::iterator jt;
+	std::list<rina::IPCPNameAddresses>::iterator kt;
+	rina::RoutingTableEntry * entry;
+
+	for (it = rt.begin(); it != rt.end(); ++it) {
+		entry = new rina::RoutingTableEntry(**it);
+		entry->destination.addresses.assign(1,
+				ipcp_number(entry->destination.name));
+		for (jt = entry->nextHopNames.begin();
+				jt != entry->nextHopNames.end(); ++jt) {
+			for (kt = jt->alts.begin(); kt != jt->alts.end(); ++kt) {
+				kt->addresses.assign(1, ipcp_number(kt->name));
+			}
+		}
+		copy.push_back(entry);
+	}
+}
+
+static void bench_topology(const char * topology, int ipcps,
+			   const std::vector<Link>& links, int n)
+{
+	std::list<rinad::FlowStateObject> fsos, flapped_fsos;
+	std::list<rina::RoutingTableEntry *> rt, flapped_rt;
+	std::string source = ipcp_name(links.front().a);
+	rinad::DijkstraAlgorithm dijkstra;
+	rinad::Graph graph;
+	double start, elapsed;
+
+	start = now_s();
+	flow_state_objects(links, fsos);
+	report(topology, ipcps, "FSOs", now_s() - start, 1);
+
+	start = now_s();
+	for (int i = 0; i < n; i++) {
+		graph.set_flow_state_objects(fsos);
+	}
+	report(topology, ipcps, "graph", now_s() - start, n);
+
+	elapsed = 0;
+	for (int i = 0; i < n; i++) {
+		start = now_s();
+		dijkstra.computeRoutingTable(graph, fsos, source, rt);
+		elapsed += now_s() - start;
+		free_routing_table(rt);
+	}
+	report(topology, ipcps, "Dijkstra", elapsed, n);
+
+	for (int weighted = 0; weighted <= 1; weighted++) {
+		rinad::ECMPDijkstraAlgorithm ecmp(weighted);
+
+		elapsed = 0;
+		for (int i = 0; i < n; i++) {
+			start = now_s();
+			ecmp.computeRoutingTable(graph, fsos, source, rt);
+			elapsed += now_s() - start;
+			free_routing_table(rt);
+		}
+		report(topology, ipcps, weighted ? "UCMP Dijkstra" : "ECMP Dijkstra",
+		       elapsed, n);
+	}
+
+	for (int workers = 0; workers <= 3; workers += 3) {
+		rinad::LoopFreeAlternateAlgorithm lfa(dijkstra, workers);
+
+		elapsed = 0;
+		for (int i = 0; i < n; i++) {
+			dijkstra.computeRoutingTable(graph, fsos, source, rt);
+			start = now_s();
+			lfa.fortifyRoutingTable(graph, source, rt);
+			elapsed += now_s() - start;
+			free_routing_table(rt);
+		}
+		report(topology, ipcps, workers ? "LFA (3 workers)" : "LFA",
+		       elapsed, n);
+	}
+
+	// The first link of the source goes down
+	dijkstra.computeRoutingTable(graph, fsos, source, rt);
+	flapped_fsos = fsos;
+	for (int i = 0; i < 2; i++) {
+		flapped_fsos.front().state_up = false;
+		flapped_fsos.push_back(flapped_fsos.front());
+		flapped_fsos.pop_front();
+	}
+	graph.set_flow_state_objects(flapped_fsos);
+	dijkstra.computeRoutingTable(graph, flapped_fsos, source, flapped_rt);
+
+	{
+		BenchResourceAllocator ra;
+		BenchPDUFTGeneratorPs pduft_gen(&ra);
+
+		elapsed = 0;
+		for (int i = 0; i < n; i++) {
+			std::list<rina::RoutingTableEntry *> copy;
+
+			routing_table_copy(i % 2 ? flapped_rt : rt, copy);
+			start = now_s();
+			pduft_gen.routingTableUpdated(copy);
+			elapsed += now_s() - start;
+		}
+		report(topology, ipcps, "PDUFT generator", elapsed, n);
+	}
+
+	free_routing_table(rt);
+	free_routing_table(flapped_rt);
+}
+
+// Runs the benchmark of the topology in a child process, so that its peak
+// RSS is its own
+static int run(const char * topology, int ipcps, int n)
+{
+	std::vector<Link> links;
+	int status;
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+
+	if (pid == 0) {
+		std::string name = topology;
+		int vertices = 0;
+
+		if (name == "grid") {
+			grid(ipcps, links);
+		} else if (name == "fat tree") {
+			fat_tree(ipcps, links);
+		} else if (name == "random geometric") {
+			random_geometric(ipcps, 8, links);
+		} else {
+			scale_free(ipcps, 2, links);
+		}
+		for (unsigned int i = 0; i < links.size(); i++) {
+			vertices = std::max(vertices,
+					    std::max(links[i].a, links[i].b) + 1);
+		}
+		bench_topology(topology, vertices, links, n);
+		fflush(stdout);
+		_exit(0);
+	}
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+			WEXITSTATUS(status) != 0) {
+		printf("%s of %d IPCPs failed\n", topology, ipcps);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	const char * topologies[] = {"grid", "fat tree", "random geometric",
+				     "scale free"};
+	int max_ipcps = argc > 1 ? atoi(argv[1]) : 50000;
+	int n = argc > 2 ? atoi(argv[2]) : 10;
+	int result = 0;
+
+	setLogLevel("ERR");
+	// Keep the results of a child that runs out of memory
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	for (int ipcps = 1000; ipcps <= max_ipcps; ipcps *= ipcps < 10000 ? 10 : 5) {
+		for (int i = 0; i < 4; i++) {
+			result |= run(topologies[i], ipcps,
+				      ipcps > 1000 ? (n > 10 ? n / 10 : 1) : n);
+		}
+	}
+
+	return result ? -1 : 0;
+}
@@ -22,32 +22,28 @@
 #define IPCP_MODULE "resource-allocator-ps-default"
 #include "../../ipcp-logging.h"
 
+#include <sstream>
 #include <string>
 
 #include "ipcp/components.h"
+#include "ipcp/resource-allocator.h"
+#include "resource-allocator-ps.h"
 
 namespace rinad {
 
-class DefaultPDUFTGeneratorPs: public IPDUFTGeneratorPs {
-public:
-	DefaultPDUFTGeneratorPs(IResourceAllocator * ra);
-	void routingTableUpdated(const std::list<rina::RoutingTableEntry*>& routing_table);
-	int set_policy_set_param(const std::string& name, const std::string& value);
-	virtual ~DefaultPDUFTGeneratorPs() {}
-
-private:
-        // Data model of the resource allocator component.
-        IResourceAllocator * res_alloc;
-};
+const std::string DefaultPDUFTGeneratorPs::REPLACE_PERIOD = "replacePeriod";
 
 DefaultPDUFTGeneratorPs::DefaultPDUFTGeneratorPs(IResourceAllocator * ra) : res_alloc(ra)
-{ }
+{
+	deltas.set_replace_period(DEFAULT_REPLACE_PERIOD);
+}
 
 void DefaultPDUFTGeneratorPs::routingTableUpdated(const std::list<rina::RoutingTableEntry*>& rt)
 {
 	LOG_IPCP_DBG("Got %d entries in the routing table", rt.size());
 	//Compute PDU Forwarding Table
 	std::list<rina::PDUForwardingTableEntry *> pduft;
+	std::list<rina::PDUForwardingTableEntry *> to_add, to_remove;
 	std::list<rina::PDUForwardingTableEntry *>::iterator pfit;
 	std::list<rina::PDUForwardingTableEntry *>::iterator pfjt;
 	std::list<rina::RoutingTableEntry *>::const_iterator it;
@@ -57,6 +53,7 @@ void DefaultPDUFTGeneratorPs::routingTableUpdated(const std::list<rina::RoutingT
 	rina::PDUForwardingTableEntry * entry;
 	rina::PDUForwardingTableEntry * candidate;
 	bool increment = true;
+	bool replaced = false;
 	INMinusOneFlowManager * n1fm;
 	int port_id = 0;
 
@@ -99,24 +96,69 @@ void DefaultPDUFTGeneratorPs::routingTableUpdated(const std::list<rina::RoutingT
 		}
 	}
 
+	//Only send the changes, adding the new port-ids before removing the
+	//old ones so that no destination is left without any. The kernel
+	//does not acknowledge them, so the whole table is replaced now and
+	//then to undo the ones it failed to apply.
 	try {
-		rina::kernelIPCProcess->modifyPDUForwardingTableEntries(pduft, 2);
+		if (deltas.update(pduft, to_add, to_remove)) {
+			modifyPDUForwardingTableEntries(pduft, 2);
+			replaced = true;
+		} else {
+			LOG_IPCP_DBG("Adding %d and removing %d PDU Forwarding Table entries",
+				     to_add.size(), to_remove.size());
+			if (!to_add.empty())
+				modifyPDUForwardingTableEntries(to_add, 0);
+			if (!to_remove.empty())
+				modifyPDUForwardingTableEntries(to_remove, 1);
+		}
 	} catch (rina::Exception & e) {
 		LOG_IPCP_ERR("Error setting PDU Forwarding Table in the kernel: %s",
 				e.what());
+		deltas.reset();
+	}
+
+	for (pfit = to_add.begin(); pfit != to_add.end(); ++pfit) {
+		delete *pfit;
+	}
+	for (pfit = to_remove.begin(); pfit != to_remove.end(); ++pfit) {
+		delete *pfit;
 	}
 
 	//Update resource allocator
 	res_alloc->set_rt_entries(rt);
-	res_alloc->set_pduft_entries(pduft);
+	res_alloc->set_pduft_entries(pduft, replaced);
+}
+
+void DefaultPDUFTGeneratorPs::modifyPDUForwardingTableEntries(
+		const std::list<rina::PDUForwardingTableEntry *>& entries,
+		int mode)
+{
+	rina::kernelIPCProcess->modifyPDUForwardingTableEntries(entries, mode);
 }
 
 int DefaultPDUFTGeneratorPs::set_policy_set_param(const std::string& name,
                                             	  const std::string& value)
 {
-        LOG_IPCP_DBG("No policy-set-specific parameters to set (%s, %s)",
-                        name.c_str(), value.c_str());
-        return -1;
+	std::stringstream ss(value);
+	unsigned int period;
+
+	if (name != REPLACE_PERIOD) {
+		LOG_IPCP_DBG("Unknown policy-set-specific parameter (%s, %s)",
+			     name.c_str(), value.c_str());
+		return -1;
+	}
+
+	if (!(ss >> period)) {
+		LOG_IPCP_ERR("Bad value for %s: %s", name.c_str(), value.c_str());
+		return -1;
+	}
+
+	deltas.set_replace_period(period);
+	LOG_IPCP_DBG("Replacing the kernel PDU Forwarding Table every %u updates",
+		     period);
+
+	return 0;
 }
 
 extern "C" rina::IPolicySet *
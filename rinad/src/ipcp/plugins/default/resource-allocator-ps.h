@@ -0,0 +1,60 @@
+//
+// Default policy set for Resource Allocator
+//
+//    Eduard Grasa <eduard.grasa@i2cat.net>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#ifndef IPCP_RESOURCE_ALLOCATOR_PS_DEFAULT_HH
+#define IPCP_RESOURCE_ALLOCATOR_PS_DEFAULT_HH
+
+#include <string>
+
+#include "ipcp/components.h"
+#include "ipcp/resource-allocator.h"
+
+namespace rinad {
+
+class DefaultPDUFTGeneratorPs: public IPDUFTGeneratorPs {
+public:
+	DefaultPDUFTGeneratorPs(IResourceAllocator * ra);
+	void routingTableUpdated(const std::list<rina::RoutingTableEntry*>& routing_table);
+	int set_policy_set_param(const std::string& name, const std::string& value);
+	virtual ~DefaultPDUFTGeneratorPs() {}
+
+	/// Number of routing table updates between two replacements of the
+	/// whole kernel table, 0 for none
+	static const std::string REPLACE_PERIOD;
+	static const unsigned int DEFAULT_REPLACE_PERIOD = 64;
+
+protected:
+	/// Sends the entries to the kernel, with the mode of the request
+	/// (0 add, 1 remove, 2 replace the table)
+	virtual void modifyPDUForwardingTableEntries(const std::list<rina::PDUForwardingTableEntry *>& entries,
+						     int mode);
+
+private:
+        // Data model of the resource allocator component.
+        IResourceAllocator * res_alloc;
+
+	// The changes since the table last sent to the kernel
+	PDUFTDeltas deltas;
+};
+
+}
+
+#endif
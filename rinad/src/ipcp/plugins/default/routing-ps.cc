@@ -22,11 +22,15 @@
 // MA  02110-1301  USA
 //
 
+#include <algorithm>
 #include <assert.h>
 #include <climits>
+#include <functional>
+#include <queue>
 #include <set>
 #include <sstream>
 #include <string>
+#include <unistd.h>
 
 #define IPCP_MODULE "routing-ps-link-state"
 #include "../../ipcp-logging.h"
@@ -109,7 +113,7 @@ bool Edge::isVertexIn(const std::string& name) const
 	return false;
 }
 
-std::string Edge::getOtherEndpoint(const std::string& name)
+std::string Edge::getOtherEndpoint(const std::string& name) const
 {
 	if (name == name1_) {
 		return name2_;
@@ -122,7 +126,7 @@ std::string Edge::getOtherEndpoint(const std::string& name)
 	return 0;
 }
 
-std::list<std::string> Edge::getEndpoints()
+std::list<std::string> Edge::getEndpoints() const
 {
 	std::list<std::string> result;
 	result.push_back(name1_);
@@ -170,166 +174,307 @@ Graph::Graph()
 {
 }
 
-void Graph::set_flow_state_objects(const std::list<FlowStateObject>& flow_state_objects)
+static uint32_t hashVertexName(const std::string& name)
+{
+	//FNV-1a
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < name.size(); i++) {
+		h ^= (unsigned char) name[i];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static uint32_t hashLink(uint64_t key)
 {
-	flow_state_objects_ = flow_state_objects;
-	init_vertices();
-	init_edges();
+	return (key * 0x9E3779B97F4A7C15ULL) >> 32;
 }
 
-Graph::~Graph()
+// A power of two at least twice the number of entries, so that linear
+// probing sequences stay short without ever having to grow
+static unsigned int hashTableSize(unsigned int entries)
 {
-	std::list<CheckedVertex *>::iterator it;
-	for (it = checked_vertices_.begin(); it != checked_vertices_.end(); ++it) {
-		delete (*it);
-	}
+	unsigned int size = 16;
 
-	std::list<Edge *>::iterator edgeIt;
-	for (edgeIt = edges_.begin(); edgeIt != edges_.end(); ++edgeIt) {
-		delete (*edgeIt);
+	while (size < 2 * entries) {
+		size <<= 1;
 	}
+
+	return size;
 }
 
-void Graph::init_vertices()
+void Graph::set_flow_state_objects(const std::list<FlowStateObject>& flow_state_objects)
 {
 	std::list<FlowStateObject>::const_iterator it;
-	for (it = flow_state_objects_.begin(); it != flow_state_objects_.end();
-			++it) {
-		if (!contains_vertex(it->name)) {
-			vertices_.push_back(it->name);
+	std::vector<unsigned int> ends;
+	unsigned int count = 0, k = 0;
+	LinkBucket * link;
+
+	edges_.clear();
+	vertices_.clear();
+	edge_ends_.clear();
+
+	for (it = flow_state_objects.begin(); it != flow_state_objects.end(); ++it) {
+		count++;
+	}
+	vertex_buckets_.assign(hashTableSize(2 * count), VertexBucket());
+	link_buckets_.assign(hashTableSize(count), LinkBucket());
+
+	// The vertices of all the flow state objects, up or not
+	ends.reserve(2 * count);
+	for (it = flow_state_objects.begin(); it != flow_state_objects.end(); ++it) {
+		ends.push_back(add_vertex(it->name));
+		ends.push_back(add_vertex(it->neighbor_name));
+	}
+
+	// An edge needs the flow state objects of both directions up. After
+	// that a pair of vertices needs two more for every parallel edge.
+	for (it = flow_state_objects.begin(); it != flow_state_objects.end();
+			++it, k += 2) {
+		if (!it->state_up) {
+			continue;
 		}
 
-		if (!contains_vertex(it->neighbor_name)) {
-			vertices_.push_back(it->neighbor_name);
+		LOG_IPCP_DBG("Processing flow state object: %s",
+				it->object_name.c_str());
+
+		link = add_link(ends[k], ends[k + 1]);
+		if (link->half) {
+			edges_.push_back(Edge(it->name, it->neighbor_name,
+					      it->cost));
+			edge_ends_.push_back(ends[k]);
+			edge_ends_.push_back(ends[k + 1]);
+			link->half = false;
+			link->edge = true;
+		} else {
+			link->half = true;
 		}
 	}
 }
 
-bool Graph::contains_vertex(const std::string& name) const
+unsigned int Graph::add_vertex(const std::string& name)
 {
-	std::list<std::string>::const_iterator it;
-	for (it = vertices_.begin(); it != vertices_.end(); ++it) {
-		if ((*it) == name) {
-			return true;
+	uint32_t h = hashVertexName(name);
+	unsigned int mask = vertex_buckets_.size() - 1;
+	unsigned int i;
+
+	for (i = h & mask; vertex_buckets_[i].id >= 0; i = (i + 1) & mask) {
+		if (vertex_buckets_[i].hash == h &&
+				vertices_[vertex_buckets_[i].id] == name) {
+			return vertex_buckets_[i].id;
 		}
 	}
 
-	return false;
+	vertex_buckets_[i].hash = h;
+	vertex_buckets_[i].id = vertices_.size();
+	vertices_.push_back(name);
+
+	return vertex_buckets_[i].id;
 }
 
-bool Graph::contains_edge(const std::string& name1,
-			  const std::string& name2) const
+int Graph::vertex_id(const std::string& name) const
 {
-	for(std::list<Edge *>::const_iterator eit = edges_.begin();
-					eit != edges_.end(); ++eit) {
-		if (*(*eit) == Edge(name1, name2, (*eit)->weight_)) {
-			return true;
+	uint32_t h = hashVertexName(name);
+	unsigned int mask = vertex_buckets_.size() - 1;
+
+	if (vertex_buckets_.empty()) {
+		return -1;
+	}
+
+	for (unsigned int i = h & mask; vertex_buckets_[i].id >= 0;
+			i = (i + 1) & mask) {
+		if (vertex_buckets_[i].hash == h &&
+				vertices_[vertex_buckets_[i].id] == name) {
+			return vertex_buckets_[i].id;
 		}
 	}
 
-	return false;
+	return -1;
 }
 
-void Graph::init_edges()
+bool Graph::contains_vertex(const std::string& name) const
 {
-	std::list<std::string>::const_iterator it;
-	std::list<FlowStateObject>::const_iterator flowIt;
+	return vertex_id(name) >= 0;
+}
 
-	for (it = vertices_.begin(); it != vertices_.end(); ++it) {
-		checked_vertices_.push_back(new CheckedVertex((*it)));
+static uint64_t linkKey(unsigned int id1, unsigned int id2)
+{
+	if (id1 > id2) {
+		std::swap(id1, id2);
 	}
 
-	CheckedVertex * origin = 0;
-	CheckedVertex * dest = 0;
-	for (flowIt = flow_state_objects_.begin();
-			flowIt != flow_state_objects_.end(); ++flowIt) {
-		if (!flowIt->state_up) {
-			continue;
-		}
+	return ((uint64_t) id1 << 32) | id2;
+}
 
-		LOG_IPCP_DBG("Processing flow state object: %s",
-				flowIt->object_name.c_str());
+Graph::LinkBucket * Graph::add_link(unsigned int id1, unsigned int id2)
+{
+	uint64_t key = linkKey(id1, id2);
+	unsigned int mask = link_buckets_.size() - 1;
+	unsigned int i;
 
-		origin = get_checked_vertex(flowIt->name);
-		if (origin == 0) {
-			LOG_IPCP_WARN("Could not find checked vertex for address %s",
-					flowIt->name.c_str());
-			continue;
+	for (i = hashLink(key) & mask; link_buckets_[i].used; i = (i + 1) & mask) {
+		if (link_buckets_[i].key == key) {
+			return &link_buckets_[i];
 		}
+	}
 
-		dest = get_checked_vertex(flowIt->neighbor_name);
-		if (dest == 0) {
-			LOG_IPCP_WARN("Could not find checked vertex for address %s",
-					flowIt->neighbor_name.c_str());
-			continue;
-		}
+	link_buckets_[i].key = key;
+	link_buckets_[i].used = true;
 
-		if (origin->connection_contains_name(dest->name_)
-				&& dest->connection_contains_name(origin->name_)) {
-			edges_.push_back(new Edge(origin->name_,
-						  dest->name_,
-						  flowIt->cost));
-			origin->connections.remove(dest->name_);
-			dest->connections.remove(origin->name_);
-		} else {
-			origin->connections.push_back(dest->name_);
-			dest->connections.push_back(origin->name_);
-		}
-	}
+	return &link_buckets_[i];
 }
 
-Graph::CheckedVertex * Graph::get_checked_vertex(const std::string& name) const
+const Graph::LinkBucket * Graph::find_link(unsigned int id1,
+					   unsigned int id2) const
 {
-	std::list<Graph::CheckedVertex *>::const_iterator it;
-	for (it = checked_vertices_.begin(); it != checked_vertices_.end(); ++it) {
-		if ((*it)->name_ == name) {
-			return (*it);
+	uint64_t key = linkKey(id1, id2);
+	unsigned int mask = link_buckets_.size() - 1;
+
+	for (unsigned int i = hashLink(key) & mask; link_buckets_[i].used;
+			i = (i + 1) & mask) {
+		if (link_buckets_[i].key == key) {
+			return &link_buckets_[i];
 		}
 	}
 
 	return 0;
 }
 
+bool Graph::contains_edge(const std::string& name1,
+			  const std::string& name2) const
+{
+	const LinkBucket * link;
+	int id1 = vertex_id(name1);
+	int id2 = vertex_id(name2);
+
+	if (id1 < 0 || id2 < 0) {
+		return false;
+	}
+
+	link = find_link(id1, id2);
+
+	return link && link->edge;
+}
+
 void Graph::print() const
 {
 	LOG_IPCP_INFO("Graph edges:");
 
-	for (std::list<Edge *>::const_iterator it = edges_.begin();
+	for (std::vector<Edge>::const_iterator it = edges_.begin();
 					it != edges_.end(); it++) {
-		const Edge& e = **it;
+		const Edge& e = *it;
 
 		LOG_IPCP_INFO("    (%s --> %s, %d)", e.name1_.c_str(),
 			      e.name2_.c_str(), e.weight_);
 	}
 }
 
-PredecessorInfo::PredecessorInfo(const std::string& nPredecessor)
+static bool compareVertexNames(const std::pair<const std::string *, unsigned int>& a,
+			       const std::pair<const std::string *, unsigned int>& b)
 {
-	predecessor_ = nPredecessor;
+	return *a.first < *b.first;
 }
 
-DijkstraAlgorithm::DijkstraAlgorithm()
+CompactGraph::CompactGraph(const Graph& graph)
+{
+	std::vector<std::pair<const std::string *, unsigned int> > vertices;
+	std::vector<std::pair<unsigned int, int> > links;
+	std::vector<unsigned int> next;
+	unsigned int i, j, k;
+
+	// Sort the vertices by name, remembering where each one was
+	vertices.reserve(graph.vertices_.size());
+	for (i = 0; i < graph.vertices_.size(); i++) {
+		vertices.push_back(std::make_pair(&graph.vertices_[i], i));
+	}
+	std::sort(vertices.begin(), vertices.end(), compareVertexNames);
+	names_.resize(vertices.size());
+	order_.resize(vertices.size());
+	for (i = 0; i < vertices.size(); i++) {
+		names_[i] = *vertices[i].first;
+		order_[vertices[i].second] = i;
+	}
+
+	// Count the edges of every vertex, then lay them out
+	offsets_.assign(names_.size() + 1, 0);
+	for (k = 0; k < graph.edge_ends_.size(); k++) {
+		offsets_[order_[graph.edge_ends_[k]] + 1]++;
+	}
+	for (i = 0; i < names_.size(); i++) {
+		offsets_[i + 1] += offsets_[i];
+	}
+
+	next.assign(offsets_.begin(), offsets_.end() - 1);
+	links.resize(offsets_.back());
+	for (k = 0; k < graph.edges_.size(); k++) {
+		i = order_[graph.edge_ends_[2 * k]];
+		j = order_[graph.edge_ends_[2 * k + 1]];
+		links[next[i]++] = std::make_pair(j, graph.edges_[k].weight_);
+		links[next[j]++] = std::make_pair(i, graph.edges_[k].weight_);
+	}
+
+	targets_.resize(links.size());
+	weights_.resize(links.size());
+	for (i = 0; i < names_.size(); i++) {
+		std::sort(links.begin() + offsets_[i],
+			  links.begin() + offsets_[i + 1]);
+	}
+	for (i = 0; i < links.size(); i++) {
+		targets_[i] = links[i].first;
+		weights_[i] = links[i].second;
+	}
+}
+
+int CompactGraph::id(const std::string& name) const
+{
+	std::vector<std::string>::const_iterator it;
+
+	it = std::lower_bound(names_.begin(), names_.end(), name);
+	if (it == names_.end() || *it != name) {
+		return -1;
+	}
+
+	return it - names_.begin();
+}
+
+void CompactGraph::swap(CompactGraph& other)
 {
+	names_.swap(other.names_);
+	order_.swap(other.order_);
+	offsets_.swap(other.offsets_);
+	targets_.swap(other.targets_);
+	weights_.swap(other.weights_);
 }
 
-void DijkstraAlgorithm::clear()
+DijkstraAlgorithm::DijkstraAlgorithm()
 {
-	unsettled_nodes_.clear();
-	settled_nodes_.clear();
-	predecessors_.clear();
-	distances_.clear();
+	source_ = -1;
 }
 
 void DijkstraAlgorithm::computeShortestDistances(const Graph& graph,
 						 const std::string& source_name,
 						 std::map<std::string, int>& distances)
 {
-	execute(graph, source_name);
+	CompactGraph compact(graph);
+	std::vector<int> tree_distances, tree_predecessors;
+	int source = compact.id(source_name);
 
-	// Write back the result
-	distances = distances_;
+	distances.clear();
+	if (source < 0) {
+		distances[source_name] = 0;
+		return;
+	}
 
-	clear();
+	shortestPaths(compact, source, tree_distances, tree_predecessors);
+
+	// Write back the result
+	for (unsigned int i = 0; i < compact.names_.size(); i++) {
+		if (tree_distances[i] != INT_MAX) {
+			distances[compact.names_[i]] = tree_distances[i];
+		}
+	}
 }
 
 void DijkstraAlgorithm::computeRoutingTable(const Graph& graph,
@@ -337,18 +482,75 @@ void DijkstraAlgorithm::computeRoutingTable(const Graph& graph,
 					    const std::string& source_name,
 					    std::list<rina::RoutingTableEntry *>& rt)
 {
-	std::list<std::string>::const_iterator it;
+	CompactGraph compact(graph);
+
+	graph_.swap(compact);
+	source_ = graph_.id(source_name);
+	if (source_ < 0) {
+		return;
+	}
+
+	shortestPaths(graph_, source_, distances_, predecessors_);
+	fillRoutingTable(graph_, source_, predecessors_, rt);
+}
+
+bool DijkstraAlgorithm::lastShortestDistances(const Graph& graph,
+					      const std::string& source_name,
+					      const CompactGraph *& compact,
+					      const std::vector<int> *& distances) const
+{
+	if (source_ < 0 || graph_.names_[source_] != source_name ||
+			graph_.names_.size() != graph.vertices_.size() ||
+			graph_.targets_.size() != 2 * graph.edges_.size()) {
+		return false;
+	}
+
+	compact = &graph_;
+	distances = &distances_;
+
+	return true;
+}
+
+void DijkstraAlgorithm::fillRoutingTable(const CompactGraph& compact,
+					 unsigned int source,
+					 const std::vector<int>& predecessors,
+					 std::list<rina::RoutingTableEntry *>& rt)
+{
+	std::vector<int> next_hops(compact.names_.size(), -1);
+	std::vector<int> path;
 	rina::RoutingTableEntry * entry;
 	rina::IPCPNameAddresses ipcpna;
+	int node;
 
-	execute(graph, source_name);
+	// A vertex is reached through the same neighbour of the source as
+	// its predecessor: climb the tree up to a vertex whose next hop is
+	// known, or to a neighbour of the source, then fill in the path
+	for (unsigned int i = 0; i < compact.names_.size(); i++) {
+		if (i == source || predecessors[i] < 0 || next_hops[i] >= 0) {
+			continue;
+		}
+
+		node = i;
+		while (next_hops[node] < 0 &&
+				predecessors[node] != (int) source) {
+			path.push_back(node);
+			node = predecessors[node];
+		}
+		if (next_hops[node] < 0) {
+			next_hops[node] = node;
+		}
+		for (; !path.empty(); path.pop_back()) {
+			next_hops[path.back()] = next_hops[node];
+		}
+	}
 
-	for (it = graph.vertices_.begin(); it != graph.vertices_.end(); ++it) {
-		if ((*it) != source_name) {
-			ipcpna.name = getNextHop((*it), source_name);
-			if (ipcpna.name != std::string()) {
+	for (unsigned int i = 0; i < compact.order_.size(); i++) {
+		if (compact.order_[i] != source) {
+			node = next_hops[compact.order_[i]];
+			if (node >= 0) {
+				ipcpna.name = compact.names_[node];
 				entry = new rina::RoutingTableEntry();
-				entry->destination.name = (*it);
+				entry->destination.name = compact.names_[compact.order_[i]];
 				entry->nextHopNames.push_back(rina::NHopAltList(ipcpna));
 				entry->qosId = 0;
 				entry->cost = 1;
@@ -358,146 +560,313 @@ void DijkstraAlgorithm::computeRoutingTable(const Graph& graph,
 			}
 		}
 	}
-
-	clear();
 }
 
-void DijkstraAlgorithm::execute(const Graph& graph, const std::string& source)
+void DijkstraAlgorithm::shortestPaths(const CompactGraph& graph,
+				      unsigned int source,
+				      std::vector<int>& distances,
+				      std::vector<int>& predecessors)
 {
-	distances_[source] = 0;
-	unsettled_nodes_.insert(source);
+	std::priority_queue<std::pair<int, unsigned int>,
+			    std::vector<std::pair<int, unsigned int> >,
+			    std::greater<std::pair<int, unsigned int> > > unsettled;
+	std::vector<bool> settled(graph.names_.size(), false);
+	unsigned int node, target, i;
+	int distance;
 
-	std::string node;
-	while (unsettled_nodes_.size() > 0) {
-		node = getMinimum();
-		settled_nodes_.insert(node);
-		unsettled_nodes_.erase(node);
-		findMinimalDistances(graph, node);
-	}
-}
+	distances.assign(graph.names_.size(), INT_MAX);
+	predecessors.assign(graph.names_.size(), -1);
 
-std::string DijkstraAlgorithm::getMinimum() const
-{
-	std::string minimum = std::string();
-	std::set<std::string>::iterator it;
+	// Ties between equally distant vertices go to the lowest id, that
+	// is the first name in alphabetical order
+	distances[source] = 0;
+	unsettled.push(std::make_pair(0, source));
+	while (!unsettled.empty()) {
+		node = unsettled.top().second;
+		unsettled.pop();
+		if (settled[node]) {
+			continue;
+		}
+		settled[node] = true;
 
-	for (it = unsettled_nodes_.begin(); it != unsettled_nodes_.end(); ++it) {
-		if (minimum == std::string()) {
-			minimum = (*it);
-		} else {
-			if (getShortestDistance((*it)) < getShortestDistance(minimum)) {
-				minimum = (*it);
+		for (i = graph.offsets_[node]; i < graph.offsets_[node + 1]; i++) {
+			target = graph.targets_[i];
+			if (settled[target]) {
+				continue;
+			}
+			distance = distances[node] + graph.weights_[i];
+			if (distances[target] > distance) {
+				distances[target] = distance;
+				predecessors[target] = node;
+				unsettled.push(std::make_pair(distance, target));
 			}
 		}
 	}
+}
+
+// Incremental Dijkstra algorithm
+IncrementalDijkstraAlgorithm::IncrementalDijkstraAlgorithm()
+{
+	incremental_ = false;
+}
 
-	return minimum;
+bool IncrementalDijkstraAlgorithm::incremental() const
+{
+	return incremental_;
 }
 
-int DijkstraAlgorithm::getShortestDistance(const std::string& destination) const
+void IncrementalDijkstraAlgorithm::computeRoutingTable(const Graph& graph,
+						       const std::list<FlowStateObject>& fsoList,
+						       const std::string& source_name,
+						       std::list<rina::RoutingTableEntry *>& rt)
 {
-	std::map<std::string, int>::const_iterator it;
-	int distance = INT_MAX;
+	CompactGraph compact(graph);
+	std::vector<LinkChange> changes;
+	int source = compact.id(source_name);
 
-	it = distances_.find(destination);
-	if (it != distances_.end()) {
-		distance = it->second;
+	incremental_ = source >= 0 && source == source_ &&
+		       diff(compact, changes);
+	if (incremental_) {
+		LOG_IPCP_DBG("Updating the shortest path tree with %u changed links",
+			     (unsigned int) changes.size());
+		update(compact, changes);
+	} else if (source >= 0) {
+		shortestPaths(compact, source, distances_, predecessors_);
 	}
 
-	return distance;
+	source_ = source;
+	graph_.swap(compact);
+
+	if (source >= 0) {
+		fillRoutingTable(graph_, source, predecessors_, rt);
+	}
 }
 
-void DijkstraAlgorithm::findMinimalDistances(const Graph& graph,
-					     const std::string& node)
+// Lists the links whose cost changed since the last computation, taking
+// the cheapest of parallel links. Returns false if the tree has to be
+// computed from scratch.
+bool IncrementalDijkstraAlgorithm::diff(const CompactGraph& graph,
+					std::vector<LinkChange>& changes) const
 {
-	std::list<std::string> adjacentNodes;
-	std::list<Edge *>::const_iterator edgeIt;
+	unsigned int i, j, i_end, j_end;
+	LinkChange change;
+
+	if (graph.names_ != graph_.names_) {
+		return false;
+	}
+
+	for (unsigned int u = 0; u < graph.names_.size(); u++) {
+		i = graph_.offsets_[u];
+		i_end = graph_.offsets_[u + 1];
+		j = graph.offsets_[u];
+		j_end = graph.offsets_[u + 1];
+
+		while (i < i_end || j < j_end) {
+			change.u = u;
+			change.old_weight = INT_MAX;
+			change.new_weight = INT_MAX;
+			if (j == j_end || (i < i_end &&
+					graph_.targets_[i] < graph.targets_[j])) {
+				change.v = graph_.targets_[i];
+			} else {
+				change.v = graph.targets_[j];
+			}
+
+			// Rows are sorted by cost within a neighbour
+			if (i < i_end && graph_.targets_[i] == change.v) {
+				change.old_weight = graph_.weights_[i];
+				while (i < i_end && graph_.targets_[i] == change.v) {
+					if (graph_.weights_[i++] <= 0) {
+						return false;
+					}
+				}
+			}
+			if (j < j_end && graph.targets_[j] == change.v) {
+				change.new_weight = graph.weights_[j];
+				while (j < j_end && graph.targets_[j] == change.v) {
+					if (graph.weights_[j++] <= 0) {
+						return false;
+					}
+				}
+			}
 
-	std::string target = std::string();
-	int shortestDistance;
-	for (edgeIt = graph.edges_.begin(); edgeIt != graph.edges_.end();
-			++edgeIt) {
-		if (isNeighbor((*edgeIt), node)) {
-			target = (*edgeIt)->getOtherEndpoint(node);
-			shortestDistance = getShortestDistance(node) + (*edgeIt)->weight_;
-			if (getShortestDistance(target) > shortestDistance) {
-				distances_[target] = shortestDistance;
-				predecessors_[target] = new PredecessorInfo(node);
-				unsettled_nodes_.insert(target);
+			if (u < change.v && change.old_weight != change.new_weight) {
+				changes.push_back(change);
 			}
 		}
 	}
-}
 
-bool DijkstraAlgorithm::isNeighbor(Edge * edge, const std::string& node) const
-{
-	if (edge->isVertexIn(node)) {
-		if (!isSettled(edge->getOtherEndpoint(node))) {
-			return true;
+	return changes.size() <=
+		graph.targets_.size() / 2 / FULL_SPF_LINKS_PER_CHANGE + 1;
+}
+
+void IncrementalDijkstraAlgorithm::update(const CompactGraph& graph,
+					  const std::vector<LinkChange>& changes)
+{
+	std::priority_queue<std::pair<int, unsigned int>,
+			    std::vector<std::pair<int, unsigned int> >,
+			    std::greater<std::pair<int, unsigned int> > > unsettled;
+	std::vector<int>& distances = distances_;
+	std::vector<int>& predecessors = predecessors_;
+	unsigned int vertices = graph.names_.size();
+	std::vector<int> first_child(vertices, -1);
+	std::vector<int> next_sibling(vertices, -1);
+	std::vector<bool> affected(vertices, false);
+	std::vector<bool> touched(vertices, false);
+	std::vector<unsigned int> stack, repick;
+	std::vector<LinkChange>::const_iterator it;
+	unsigned int node, target, i;
+	int distance;
+
+	for (node = 0; node < vertices; node++) {
+		if (predecessors[node] >= 0) {
+			next_sibling[node] = first_child[predecessors[node]];
+			first_child[predecessors[node]] = node;
 		}
 	}
 
-	return false;
-}
-
-bool DijkstraAlgorithm::isSettled(const std::string& node) const
-{
-	std::set<std::string>::iterator it;
+	// The subtree below a tree link that got more expensive or went
+	// away may have to be reached some other way
+	for (it = changes.begin(); it != changes.end(); ++it) {
+		if (it->new_weight <= it->old_weight) {
+			continue;
+		}
+		if (predecessors[it->v] == (int) it->u) {
+			stack.push_back(it->v);
+		} else if (predecessors[it->u] == (int) it->v) {
+			stack.push_back(it->u);
+		}
+	}
+	while (!stack.empty()) {
+		node = stack.back();
+		stack.pop_back();
+		if (affected[node]) {
+			continue;
+		}
+		affected[node] = true;
+		distances[node] = INT_MAX;
+		for (int c = first_child[node]; c >= 0; c = next_sibling[c]) {
+			stack.push_back(c);
+		}
+	}
 
-	for (it = settled_nodes_.begin(); it != settled_nodes_.end(); ++it) {
-		if ((*it) == node) {
-			return true;
+	// Their first estimate comes from the vertices not affected
+	for (node = 0; node < vertices; node++) {
+		if (!affected[node]) {
+			continue;
+		}
+		touched[node] = true;
+		for (i = graph.offsets_[node]; i < graph.offsets_[node + 1]; i++) {
+			target = graph.targets_[i];
+			if (affected[target] || distances[target] == INT_MAX) {
+				continue;
+			}
+			distance = distances[target] + graph.weights_[i];
+			if (distance < distances[node]) {
+				distances[node] = distance;
+			}
+		}
+		if (distances[node] != INT_MAX) {
+			unsettled.push(std::make_pair(distances[node], node));
 		}
 	}
 
-	return false;
-}
+	// Links that got cheaper or came up may bring vertices closer
+	for (it = changes.begin(); it != changes.end(); ++it) {
+		if (it->new_weight >= it->old_weight) {
+			continue;
+		}
+		for (int k = 0; k < 2; k++) {
+			node = k ? it->v : it->u;
+			target = k ? it->u : it->v;
+			if (distances[node] == INT_MAX) {
+				continue;
+			}
+			distance = distances[node] + it->new_weight;
+			if (distance < distances[target]) {
+				distances[target] = distance;
+				touched[target] = true;
+				unsettled.push(std::make_pair(distance, target));
+			}
+		}
+	}
 
-std::string DijkstraAlgorithm::getNextHop(const std::string& target,
-					  const std::string& source)
-{
-	std::map<std::string, PredecessorInfo *>::iterator it;
-	PredecessorInfo * step;
-	std::string nextHop = target;
+	// Propagate the new distances as Dijkstra does
+	while (!unsettled.empty()) {
+		distance = unsettled.top().first;
+		node = unsettled.top().second;
+		unsettled.pop();
+		if (distance > distances[node]) {
+			continue;
+		}
 
-	it = predecessors_.find(target);
-	if (it == predecessors_.end()) {
-		return std::string();
-	} else {
-		step = it->second;
+		for (i = graph.offsets_[node]; i < graph.offsets_[node + 1]; i++) {
+			target = graph.targets_[i];
+			distance = distances[node] + graph.weights_[i];
+			if (distance < distances[target]) {
+				distances[target] = distance;
+				touched[target] = true;
+				unsettled.push(std::make_pair(distance, target));
+			}
+		}
 	}
 
-	it = predecessors_.find(step->predecessor_);
-	while (it != predecessors_.end()) {
-		nextHop = step->predecessor_;
-		step = it->second;
-		if (step->predecessor_ == source) {
-			break;
+	// The predecessor of a vertex can only change if its distance, the
+	// distance of a neighbour or the cost of one of its links did
+	for (node = 0; node < vertices; node++) {
+		if (!touched[node]) {
+			continue;
 		}
+		repick.push_back(node);
+		for (i = graph.offsets_[node]; i < graph.offsets_[node + 1]; i++) {
+			repick.push_back(graph.targets_[i]);
+		}
+	}
+	for (it = changes.begin(); it != changes.end(); ++it) {
+		repick.push_back(it->u);
+		repick.push_back(it->v);
+	}
+	for (i = 0; i < repick.size(); i++) {
+		predecessors[repick[i]] = pickPredecessor(graph, repick[i]);
+	}
+}
+
+// Full Dijkstra sets the predecessor of a vertex when the first neighbour
+// on a shortest path to it is settled. With positive link costs vertices
+// are settled by distance and then by id, so this is the closest such
+// neighbour, and the one with the lowest id among equally close ones.
+int IncrementalDijkstraAlgorithm::pickPredecessor(const CompactGraph& graph,
+						  unsigned int node) const
+{
+	const std::vector<int>& distances = distances_;
+	unsigned int target, i;
+	int best = -1;
 
-		it = predecessors_.find(step->predecessor_);
+	if ((int) node == source_ || distances[node] == INT_MAX) {
+		return -1;
 	}
 
-	if (step->predecessor_ == target) {
-		return std::string();
+	for (i = graph.offsets_[node]; i < graph.offsets_[node + 1]; i++) {
+		target = graph.targets_[i];
+		if (distances[target] == INT_MAX ||
+				distances[target] + graph.weights_[i] != distances[node]) {
+			continue;
+		}
+		if (best < 0 || distances[target] < distances[best] ||
+				(distances[target] == distances[best] &&
+				 (int) target < best)) {
+			best = target;
+		}
 	}
 
-	return nextHop;
+	return best;
 }
 
 // ECMP Dijkstra algorithm
-ECMPDijkstraAlgorithm::ECMPDijkstraAlgorithm()
+ECMPDijkstraAlgorithm::ECMPDijkstraAlgorithm(bool weighted)
 {
-	t = NULL;
-}
-
-void ECMPDijkstraAlgorithm::clear()
-{
-	unsettled_nodes_.clear();
-	settled_nodes_.clear();
-	predecessors_.clear();
-	distances_.clear();
-	delete t;
+	weighted_ = weighted;
+	words_ = 0;
 }
 
 void ECMPDijkstraAlgorithm::computeShortestDistances(const Graph& graph,
@@ -507,9 +876,16 @@ void ECMPDijkstraAlgorithm::computeShortestDistances(const Graph& graph,
 	execute(graph, source_name);
 
 	// Write back the result
-	distances = distances_;
-
-	clear();
+	distances.clear();
+	if (source_ < 0) {
+		distances[source_name] = 0;
+		return;
+	}
+	for (unsigned int i = 0; i < graph_.names_.size(); i++) {
+		if (distances_[i] != INT_MAX) {
+			distances[graph_.names_[i]] = distances_[i];
+		}
+	}
 }
 
 void ECMPDijkstraAlgorithm::computeRoutingTable(const Graph& graph,
@@ -517,326 +893,599 @@ void ECMPDijkstraAlgorithm::computeRoutingTable(const Graph& graph,
 						const std::string& source_name,
 						std::list<rina::RoutingTableEntry *>& rt)
 {
-	std::list<std::string>::const_iterator it;
-	std::list<std::string>::const_iterator nextHopsIt;
-	std::list<std::string> nextHops;
 	rina::RoutingTableEntry * entry;
-	rina::IPCPNameAddresses ipcpna;
+	unsigned int node;
 
 	(void)fsoList; // avoid compiler barfs
 
 	execute(graph, source_name);
+	if (source_ < 0) {
+		return;
+	}
 
-	for(std::set<TreeNode *>::iterator it = t->chl.begin(); it != t->chl.end(); it++){
-		std::list<rina::RoutingTableEntry *>::iterator pos = findEntry(rt,
-									       (*it)->name);
-
-		if(pos != rt.end()){
-			ipcpna.name = (*it)->name;
-			(*pos)->nextHopNames.push_back(ipcpna);
-		}
-		else{
-			entry = new rina::RoutingTableEntry();
-		        entry->destination.name = (*it)->name;
-		        entry->qosId = 1;
-		        entry->cost = (*it)->metric;
-		        ipcpna.name = (*it)->name;
-			entry->nextHopNames.push_back(ipcpna);
-			LOG_IPCP_DBG("Added entry to routing table: destination %s, next-hop %s",
-                        entry->destination.name.c_str(), (*it)->name.c_str());
-			rt.push_back(entry);
+	for (unsigned int i = 0; i < graph_.order_.size(); i++) {
+		node = graph_.order_[i];
+		if (node == (unsigned int) source_ || distances_[node] == INT_MAX) {
+			continue;
 		}
-		addRecursive(rt, 1, (*it)->name, *it);
+
+		entry = new rina::RoutingTableEntry();
+		entry->destination.name = graph_.names_[node];
+		entry->qosId = 1;
+		entry->cost = distances_[node];
+		addNextHops(node, entry);
+		LOG_IPCP_DBG("Added entry to routing table: destination %s, %u next-hops",
+			     entry->destination.name.c_str(),
+			     (unsigned int) entry->nextHopNames.size());
+		rt.push_back(entry);
 	}
-	clear();
 }
 
-void ECMPDijkstraAlgorithm::addRecursive(std::list<rina::RoutingTableEntry *> &table,
-					 int qos,
-					 const std::string& next,
-					 TreeNode * node)
-{
-	rina::IPCPNameAddresses ipcpna;
-
-	for(std::set<TreeNode *>::iterator it = node->chl.begin(); it != node->chl.end(); it++){
-		std::list<rina::RoutingTableEntry *>::iterator pos = findEntry(table,
-									       (*it)->name);
-
+void ECMPDijkstraAlgorithm::execute(const Graph& graph,
+				    const std::string& source_name)
+{
+	std::priority_queue<std::pair<int, unsigned int>,
+			    std::vector<std::pair<int, unsigned int> >,
+			    std::greater<std::pair<int, unsigned int> > > unsettled;
+	CompactGraph compact(graph);
+	std::vector<bool> settled;
+	unsigned int node, target, i, j, w, neighbor;
+	uint32_t bits;
+	int distance;
+
+	graph_.swap(compact);
+	source_ = graph_.id(source_name);
+	neighbors_.clear();
+	if (source_ < 0) {
+		return;
+	}
 
-		if(pos != table.end()){
-			ipcpna.name = next;
-			(*pos)->nextHopNames.push_back(ipcpna);
-		}
-		else{
-			rina::RoutingTableEntry * entry = new rina::RoutingTableEntry();
-		        entry->destination.name = (*it)->name;
-		        entry->qosId = 1;
-		        entry->cost = (*it)->metric;
-		        ipcpna.name = next;
-			entry->nextHopNames.push_back(ipcpna);
-			LOG_IPCP_DBG("Added entry to routing table: destination %s, next-hop %s",
-                        entry->destination.name.c_str(), next.c_str());
-			table.push_back(entry);
+	// Targets come sorted by id, so parallel edges are together
+	for (i = graph_.offsets_[source_]; i < graph_.offsets_[source_ + 1]; i++) {
+		target = graph_.targets_[i];
+		if (target != (unsigned int) source_ &&
+				(neighbors_.empty() || neighbors_.back() != target)) {
+			neighbors_.push_back(target);
 		}
-		addRecursive(table, 1, next, *it);
 	}
-}
 
-std::list<rina::RoutingTableEntry *>::iterator ECMPDijkstraAlgorithm::findEntry(std::list<rina::RoutingTableEntry *> &table,
-										const std::string& name)
-{
-	std::list<rina::RoutingTableEntry *>::iterator it;
-	for(it = table.begin(); it != table.end(); it++)
-	{
-		if((*it)->destination.name == name){
-			return it;
-		}
+	words_ = (neighbors_.size() + 31) / 32;
+	distances_.assign(graph_.names_.size(), INT_MAX);
+	next_hops_.assign(graph_.names_.size() * words_, 0);
+	if (weighted_) {
+		paths_.assign(graph_.names_.size() * neighbors_.size(), 0);
+	} else {
+		paths_.clear();
 	}
-	return it;
-}
+	settled.assign(graph_.names_.size(), false);
 
-void ECMPDijkstraAlgorithm::execute(const Graph& graph,
-				    const std::string& source)
-{
-	distances_[source] = 0;
-	settled_nodes_.insert(source);
-	t = new TreeNode(source, 0);
-
-	std::list<Edge *>::const_iterator edgeIt;
-	int cost;
-	std::string target = std::string();
-	int shortestDistance;
-	for (edgeIt = graph.edges_.begin();
-			edgeIt != graph.edges_.end(); ++edgeIt) {
-		if (isNeighbor((*edgeIt), source)) {
-			target = (*edgeIt)->getOtherEndpoint(source);
-			distances_[target]=(*edgeIt)->weight_;
-			predecessors_[target].push_front(t);
-			unsettled_nodes_.insert(target);
-		}
-	}
-
-	while (unsettled_nodes_.size() > 0) {
-		std::set<std::string>::iterator it;
-		getMinimum();
-		for(it = minimum_nodes_.begin(); it != minimum_nodes_.end(); ++it){
-			settled_nodes_.insert(*it);
-
-			TreeNode * nt = new TreeNode(*it, distances_.find(*it)->second);
-			bool fPar = true;
-			for(std::list<TreeNode *>::iterator par = predecessors_.find(*it)->second.begin();
-					par != predecessors_.find(*it)->second.end(); ++par){
-				if(fPar){
-					(*par)->chldel.insert(nt);
-					fPar = false;
+	distances_[source_] = 0;
+	unsettled.push(std::make_pair(0, (unsigned int) source_));
+	while (!unsettled.empty()) {
+		node = unsettled.top().second;
+		unsettled.pop();
+		if (settled[node]) {
+			continue;
+		}
+		settled[node] = true;
+
+		for (i = graph_.offsets_[node]; i < graph_.offsets_[node + 1]; i++) {
+			target = graph_.targets_[i];
+			if (settled[target]) {
+				continue;
+			}
+			distance = distances_[node] + graph_.weights_[i];
+			if (distance > distances_[target]) {
+				continue;
+			}
+			if (distance < distances_[target]) {
+				distances_[target] = distance;
+				std::fill(next_hops_.begin() + target * words_,
+					  next_hops_.begin() + (target + 1) * words_, 0);
+				if (weighted_) {
+					std::fill(paths_.begin() + target * neighbors_.size(),
+						  paths_.begin() + (target + 1) * neighbors_.size(), 0);
 				}
-				(*par)->chl.insert(nt);
+				unsettled.push(std::make_pair(distance, target));
 			}
 
-			unsettled_nodes_.erase(*it);
-			findMinimalDistances(graph, nt);
-		}
-	}
-}
-
-void ECMPDijkstraAlgorithm::getMinimum()
-{
-	std::string minimum = std::string();
-	std::set<std::string>::iterator it;
-	minimum_nodes_.clear();
-	std::list<Edge *>::const_iterator edgeIt;
-	for (it = unsettled_nodes_.begin(); it != unsettled_nodes_.end(); ++it) {
-		if (minimum == std::string()) {
-			minimum_nodes_.insert(*it);
-			minimum = (*it);
-		} else {
-			if (getShortestDistance((*it)) < getShortestDistance(minimum)) {
-								
-				minimum = (*it);
-				minimum_nodes_.clear();
+			// An equally short path: the next hops of the source
+			// are its neighbours, the ones of any other vertex
+			// pass on to the vertices it is a predecessor of
+			if (node == (unsigned int) source_) {
+				neighbor = std::lower_bound(neighbors_.begin(),
+							    neighbors_.end(), target) -
+					   neighbors_.begin();
+				next_hops_[target * words_ + neighbor / 32] |=
+					(uint32_t) 1 << (neighbor % 32);
+				if (weighted_) {
+					paths_[target * neighbors_.size() + neighbor] += 1;
+				}
+				continue;
 			}
-			if (getShortestDistance((*it)) == getShortestDistance(minimum)) {
-								
-				minimum_nodes_.insert(*it);
+			for (w = 0; w < words_; w++) {
+				bits = next_hops_[node * words_ + w];
+				next_hops_[target * words_ + w] |= bits;
+				for (j = w * 32; weighted_ && bits; bits >>= 1, j++) {
+					if (bits & 1) {
+						paths_[target * neighbors_.size() + j] +=
+							paths_[node * neighbors_.size() + j];
+					}
+				}
 			}
 		}
 	}
 }
 
-int ECMPDijkstraAlgorithm::getShortestDistance(const std::string& destination) const
+static unsigned int greatestCommonDivisor(unsigned int a, unsigned int b)
 {
-	std::map<std::string, int>::const_iterator it;
-	int distance = INT_MAX;
+	unsigned int c;
 
-	it = distances_.find(destination);
-	if (it != distances_.end()) {
-		distance = it->second;
+	while (b) {
+		c = a % b;
+		a = b;
+		b = c;
 	}
 
-	return distance;
+	return a;
 }
 
-void ECMPDijkstraAlgorithm::findMinimalDistances(const Graph& graph,
-						 TreeNode * pred)
+void ECMPDijkstraAlgorithm::addNextHops(unsigned int node,
+					rina::RoutingTableEntry * entry) const
 {
-	std::list<std::string> adjacentNodes;
-	std::list<Edge *>::const_iterator edgeIt;
-	int cost;
-
-	std::string target = std::string();
-	int shortestDistance;
-	for (edgeIt = graph.edges_.begin(); edgeIt != graph.edges_.end();
-			++edgeIt) {
-		if (isNeighbor((*edgeIt), pred->name)) {
-			target = (*edgeIt)->getOtherEndpoint(pred->name);
-			cost = (*edgeIt)->weight_;
-			shortestDistance = getShortestDistance(pred->name) + cost;
-			if (shortestDistance < getShortestDistance(target)) {
-				distances_[target] = shortestDistance;
-				predecessors_[target].clear();
+	std::vector<std::pair<unsigned int, unsigned int> > next_hops;
+	rina::IPCPNameAddresses ipcpna;
+	unsigned int i, w, divisor = 0;
+	double most = 0;
+	uint32_t bits;
+
+	for (w = 0; w < words_; w++) {
+		bits = next_hops_[node * words_ + w];
+		for (i = w * 32; bits; bits >>= 1, i++) {
+			if (!(bits & 1)) {
+				continue;
 			}
-			if (shortestDistance == getShortestDistance(target)) {
-				predecessors_[target].push_front(pred);
-				unsettled_nodes_.insert(target);
+			next_hops.push_back(std::make_pair(i, 1));
+			if (weighted_) {
+				most = std::max(most, paths_[node * neighbors_.size() + i]);
 			}
 		}
 	}
-}
 
-bool ECMPDijkstraAlgorithm::isNeighbor(Edge * edge,
-				       const std::string& node) const
-{
-	if (edge->isVertexIn(node)) {
-		if (!isSettled(edge->getOtherEndpoint(node))) {
-			return true;
+	// Scale the shares of the paths so that the biggest is MAX_WEIGHT,
+	// then reduce them to lowest terms
+	if (weighted_) {
+		for (i = 0; i < next_hops.size(); i++) {
+			next_hops[i].second = (unsigned int) std::max(1.0,
+					MAX_WEIGHT * paths_[node * neighbors_.size() +
+							    next_hops[i].first] / most + 0.5);
+			divisor = greatestCommonDivisor(divisor, next_hops[i].second);
 		}
+	} else {
+		divisor = 1;
 	}
 
-	return false;
+	for (i = 0; i < next_hops.size(); i++) {
+		ipcpna.name = graph_.names_[neighbors_[next_hops[i].first]];
+		for (unsigned int j = 0; j < next_hops[i].second / divisor; j++) {
+			entry->nextHopNames.push_back(rina::NHopAltList(ipcpna));
+		}
+	}
 }
 
-bool ECMPDijkstraAlgorithm::isSettled(const std::string& node) const
+//Class RoutingWorkerPool
+RoutingWorkerPool::RoutingWorkerPool(unsigned int workers)
 {
-	std::set<std::string>::iterator it;
+	rina::ThreadAttributes thread_attrs;
 
-	for (it = settled_nodes_.begin();
-			it != settled_nodes_.end(); ++it) {
-		if ((*it) == node) {
-			return true;
-		}
-	}
+	task_ = 0;
+	arg_ = 0;
+	tasks_ = 0;
+	next_ = 0;
+	done_ = 0;
+	stop_ = false;
 
-	return false;
+	thread_attrs.setJoinable();
+	for (unsigned int i = 0; i < workers; i++) {
+		threads_.push_back(new rina::Thread(work, this, &thread_attrs));
+		threads_.back()->start();
+	}
 }
 
-//Class IResiliencyAlgorithm
-IResiliencyAlgorithm::IResiliencyAlgorithm(IRoutingAlgorithm& ra)
-						: routing_algorithm(ra)
+RoutingWorkerPool::~RoutingWorkerPool()
 {
+	void * status;
+
+	cond_.lock();
+	stop_ = true;
+	cond_.broadcast();
+	cond_.unlock();
+
+	for (unsigned int i = 0; i < threads_.size(); i++) {
+		threads_[i]->join(&status);
+		delete threads_[i];
+	}
 }
 
-//Class LoopFreeAlternateAlgorithm
-LoopFreeAlternateAlgorithm::LoopFreeAlternateAlgorithm(IRoutingAlgorithm& ra)
-						: IResiliencyAlgorithm(ra)
+unsigned int RoutingWorkerPool::workers() const
 {
+	return threads_.size();
 }
 
-void LoopFreeAlternateAlgorithm::extendRoutingTableEntry(
-			std::list<rina::RoutingTableEntry *>& rt,
-			const std::string& target_name,
-			const std::string& nexthop)
+bool RoutingWorkerPool::runNextTask()
 {
-	std::list<rina::RoutingTableEntry *>::iterator rit;
-	bool found = false;
-	rina::IPCPNameAddresses ipcpna;
+	unsigned int index;
 
-	// Find the involved routing table entry
-	for (rit = rt.begin(); rit != rt.end(); rit++) {
-		if ((*rit)->destination.name == target_name) {
-			break;
+	if (next_ >= tasks_) {
+		return false;
+	}
+
+	index = next_++;
+	cond_.unlock();
+	task_(arg_, index);
+	cond_.lock();
+	if (++done_ == tasks_) {
+		cond_.broadcast();
+	}
+
+	return true;
+}
+
+void * RoutingWorkerPool::work(void * arg)
+{
+	RoutingWorkerPool * pool = (RoutingWorkerPool *) arg;
+
+	pool->cond_.lock();
+	while (!pool->stop_) {
+		if (!pool->runNextTask()) {
+			pool->cond_.doWait();
 		}
 	}
+	pool->cond_.unlock();
 
-	if (rit == rt.end()) {
-		LOG_WARN("LFA: Couldn't find routing table entry for "
-			 "target name %s", target_name.c_str());
-		return;
+	return 0;
+}
+
+void RoutingWorkerPool::run(void (*task)(void * arg, unsigned int index),
+			    void * arg, unsigned int tasks)
+{
+	cond_.lock();
+	task_ = task;
+	arg_ = arg;
+	tasks_ = tasks;
+	next_ = 0;
+	done_ = 0;
+	if (tasks > 1) {
+		cond_.broadcast();
 	}
 
+	while (done_ < tasks_) {
+		if (!runNextTask()) {
+			cond_.doWait();
+		}
+	}
+	cond_.unlock();
+}
+
+//Class IResiliencyAlgorithm
+IResiliencyAlgorithm::IResiliencyAlgorithm(IRoutingAlgorithm& ra)
+						: routing_algorithm(ra)
+{
+}
+
+static unsigned int defaultWorkers(int workers)
+{
+	long cpus;
+
+	if (workers >= 0) {
+		return workers;
+	}
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpus > 1 ? cpus - 1 : 0;
+}
+
+//Class LoopFreeAlternateAlgorithm
+LoopFreeAlternateAlgorithm::LoopFreeAlternateAlgorithm(IRoutingAlgorithm& ra,
+						       int workers)
+				: IResiliencyAlgorithm(ra),
+				  workers_(defaultWorkers(workers))
+{
+}
+
+void LoopFreeAlternateAlgorithm::extendRoutingTableEntry(
+			rina::RoutingTableEntry * entry,
+			const std::string& nexthop)
+{
+	rina::IPCPNameAddresses ipcpna;
+
 	// Assume unicast and try to extend the routing table entry
 	// with the new alternative 'nexthop'
-	rina::NHopAltList& altlist = (*rit)->nextHopNames.front();
+	rina::NHopAltList& altlist = entry->nextHopNames.front();
 
 	for (std::list<rina::IPCPNameAddresses>::iterator
 			hit = altlist.alts.begin();
 				hit != altlist.alts.end(); hit++) {
 		if (hit->name == nexthop) {
 			// The nexthop is already in the alternatives
-			found = true;
-			break;
+			return;
 		}
 	}
 
-	if (!found) {
-		ipcpna.name = nexthop;
-		altlist.alts.push_back(ipcpna);
-		LOG_DBG("Node %s selected as LFA node towards the "
-			 "destination node %s", nexthop.c_str(), target_name.c_str());
-	}
+	ipcpna.name = nexthop;
+	altlist.alts.push_back(ipcpna);
+	LOG_DBG("Node %s selected as LFA node towards the "
+		"destination node %s", nexthop.c_str(),
+		entry->destination.name.c_str());
+}
+
+void LoopFreeAlternateAlgorithm::computeNeighborTree(void * arg,
+						     unsigned int index)
+{
+	NeighborTree& tree = (*(std::vector<NeighborTree> *) arg)[index];
+	std::vector<int> predecessors;
+
+	DijkstraAlgorithm::shortestPaths(*tree.graph, tree.neighbor,
+					 tree.distances, predecessors);
 }
 
 void LoopFreeAlternateAlgorithm::fortifyRoutingTable(const Graph& graph,
 						     const std::string& source_name,
 						     std::list<rina::RoutingTableEntry *>& rt)
 {
-	std::map<std::string, std::map< std::string, int > > neighbors_dist_trees;
-	std::map<std::string, int> src_dist_tree;
+	std::vector<NeighborTree> neighbors_dist_trees;
+	std::vector<rina::RoutingTableEntry *> entries;
+	std::list<rina::RoutingTableEntry *>::iterator rit;
+	std::vector<int> own_distances, predecessors;
+	const std::vector<int> * src_dist_tree;
+	const CompactGraph * compact;
+	CompactGraph own_graph;
+	unsigned int target, i;
+	int source, id;
+
+	// Reuse the tree the routing table was computed with, if possible
+	if (routing_algorithm.lastShortestDistances(graph, source_name,
+						    compact, src_dist_tree)) {
+		source = compact->id(source_name);
+	} else {
+		CompactGraph copy(graph);
 
-	// TODO avoid this, can be computed when invoke computeRoutingTable()
-	routing_algorithm.computeShortestDistances(graph, source_name, src_dist_tree);
+		own_graph.swap(copy);
+		compact = &own_graph;
+		source = compact->id(source_name);
+		if (source < 0) {
+			return;
+		}
+		DijkstraAlgorithm::shortestPaths(*compact, source,
+						 own_distances, predecessors);
+		src_dist_tree = &own_distances;
+	}
+
+	// The neighbours are the targets of the links of the source, which
+	// come sorted by name, once each
+	for (i = compact->offsets_[source]; i < compact->offsets_[source + 1]; i++) {
+		target = compact->targets_[i];
+		if (target == (unsigned int) source ||
+				(!neighbors_dist_trees.empty() &&
+				 neighbors_dist_trees.back().neighbor == target)) {
+			continue;
+		}
+		neighbors_dist_trees.push_back(NeighborTree());
+		neighbors_dist_trees.back().graph = compact;
+		neighbors_dist_trees.back().neighbor = target;
+	}
+	if (neighbors_dist_trees.empty()) {
+		return;
+	}
+	workers_.run(computeNeighborTree, &neighbors_dist_trees,
+		     neighbors_dist_trees.size());
 
-	// Collect all the neighbors, and for each one use the routing algorithm to
-	// compute the shortest distance map rooted at that neighbor
-	for (std::list<std::string>::const_iterator it = graph.vertices_.begin();
-						it != graph.vertices_.end(); ++it) {
-		if ((*it) != source_name && graph.contains_edge(source_name, *it)) {
-			neighbors_dist_trees[*it] = std::map<std::string, int>();
-			routing_algorithm.computeShortestDistances(graph,
-						*it, neighbors_dist_trees[*it]);
+	entries.assign(compact->names_.size(), 0);
+	for (rit = rt.begin(); rit != rt.end(); ++rit) {
+		id = compact->id((*rit)->destination.name);
+		if (id >= 0 && !(*rit)->nextHopNames.empty()) {
+			entries[id] = *rit;
 		}
 	}
 
-	// For each node X other than than the source node
-	for (std::list<std::string>::const_iterator it = graph.vertices_.begin();
-						it != graph.vertices_.end(); ++it) {
-		if ((*it) == source_name) {
+	// For each node X other than the source node, reachable from it
+	for (i = 0; i < compact->order_.size(); i++) {
+		target = compact->order_[i];
+		if (target == (unsigned int) source ||
+				(*src_dist_tree)[target] == INT_MAX) {
+			continue;
+		}
+
+		if (!entries[target]) {
+			LOG_WARN("LFA: Couldn't find routing table entry for "
+				 "target name %s", compact->names_[target].c_str());
 			continue;
 		}
 
 		// For each neighbor of the source node, excluding X
-		for (std::map<std::string, std::map<std::string, int> >::iterator
+		for (std::vector<NeighborTree>::const_iterator
 			nit = neighbors_dist_trees.begin();
 				nit != neighbors_dist_trees.end(); nit++) {
-			// If this neighbor is a LFA node for the current
-			// destination (*it) extend the routing table to take it
-			// into account
-			std::map< std::string, int>& neigh_dist_map = nit->second;
-			std::string neigh = nit->first;
-
-			if (neigh == *it) {
+			if (nit->neighbor == target) {
 				continue;
 			}
 
 			// dist(neigh, target) < dist(neigh, source) + dist(source, target)
-			if (neigh_dist_map[*it] < src_dist_tree[neigh] + src_dist_tree[*it]) {
-				//LOG_DBG("Node %u is a possible LFA for destination %u",
-				//	neigh, *it);
-				extendRoutingTableEntry(rt, *it, neigh);
+			if (nit->distances[target] < (*src_dist_tree)[nit->neighbor] +
+					(*src_dist_tree)[target]) {
+				extendRoutingTableEntry(entries[target],
+							compact->names_[nit->neighbor]);
 			}
 		}
 	}
 }
 
+//Class QoSCubeRoutingAlgorithm
+static IRoutingAlgorithm * createRoutingAlgorithm(const std::string& name,
+						  bool incremental)
+{
+	if (name == LinkStateRoutingPolicy::DIJKSTRA_ALG && incremental) {
+		return new IncrementalDijkstraAlgorithm();
+	} else if (name == LinkStateRoutingPolicy::DIJKSTRA_ALG) {
+		return new DijkstraAlgorithm();
+	} else if (name == LinkStateRoutingPolicy::ECMP_DIJKSTRA_ALG) {
+		return new ECMPDijkstraAlgorithm();
+	} else if (name == LinkStateRoutingPolicy::UCMP_DIJKSTRA_ALG) {
+		return new ECMPDijkstraAlgorithm(true);
+	}
+
+	throw rina::Exception("Unsupported routing algorithm");
+}
+
+QoSCubeRoutingAlgorithm::QoSCubeRoutingAlgorithm(const std::string& algorithm,
+						 bool incremental,
+						 int workers)
+				: algorithm_(algorithm),
+				  incremental_(incremental),
+				  workers_(defaultWorkers(workers))
+{
+	// Fail now rather than on the first cube
+	delete createRoutingAlgorithm(algorithm_, incremental_);
+}
+
+QoSCubeRoutingAlgorithm::~QoSCubeRoutingAlgorithm()
+{
+	for (unsigned int i = 0; i < metrics_.size(); i++) {
+		delete metrics_[i]->algorithm;
+		delete metrics_[i];
+	}
+}
+
+void QoSCubeRoutingAlgorithm::addQoSCube(unsigned int qos_id,
+					 int cost_scale,
+					 int hop_cost)
+{
+	unsigned int i;
+
+	for (i = 0; i < metrics_.size(); i++) {
+		if (metrics_[i]->cost_scale == cost_scale &&
+				metrics_[i]->hop_cost == hop_cost) {
+			break;
+		}
+	}
+
+	if (i == metrics_.size()) {
+		Metric * metric = new Metric();
+
+		metric->cost_scale = cost_scale;
+		metric->hop_cost = hop_cost;
+		metric->algorithm = createRoutingAlgorithm(algorithm_,
+							   incremental_);
+		metric->failed = false;
+		metrics_.push_back(metric);
+	}
+
+	cubes_.push_back(std::make_pair(qos_id, i));
+}
+
+unsigned int QoSCubeRoutingAlgorithm::metrics() const
+{
+	return metrics_.size();
+}
+
+const Graph& QoSCubeRoutingAlgorithm::weigh(const Graph& graph, Metric& metric)
+{
+	if (metric.cost_scale == 1 && metric.hop_cost == 0) {
+		return graph;
+	}
+
+	metric.graph = graph;
+	for (unsigned int i = 0; i < metric.graph.edges_.size(); i++) {
+		Edge& edge = metric.graph.edges_[i];
+
+		edge.weight_ = metric.cost_scale * edge.weight_ + metric.hop_cost;
+	}
+
+	return metric.graph;
+}
+
+void QoSCubeRoutingAlgorithm::computeMetric(void * arg, unsigned int index)
+{
+	Computation * computation = (Computation *) arg;
+	Metric * metric = computation->algorithm->metrics_[index];
+
+	metric->failed = false;
+	try {
+		metric->algorithm->computeRoutingTable(weigh(*computation->graph,
+							     *metric),
+						       *computation->fsos,
+						       *computation->source,
+						       metric->rt);
+	} catch (rina::Exception &e) {
+		metric->failed = true;
+	}
+}
+
+void QoSCubeRoutingAlgorithm::computeRoutingTable(const Graph& graph,
+						  const std::list<FlowStateObject>& fsoList,
+						  const std::string& source_name,
+						  std::list<rina::RoutingTableEntry *>& rt)
+{
+	std::list<rina::RoutingTableEntry *>::iterator it;
+	std::vector<bool> taken(metrics_.size(), false);
+	rina::RoutingTableEntry * entry;
+	Computation computation;
+	Metric * metric;
+
+	if (metrics_.empty()) {
+		return;
+	}
+
+	computation.algorithm = this;
+	computation.graph = &graph;
+	computation.fsos = &fsoList;
+	computation.source = &source_name;
+	workers_.run(computeMetric, &computation, metrics_.size());
+
+	// The first cube of every metric takes its entries, and the others
+	// get copies of them
+	for (unsigned int i = 0; i < cubes_.size(); i++) {
+		metric = metrics_[cubes_[i].second];
+		if (metric->failed) {
+			LOG_IPCP_ERR("Could not compute the routing table of QoS cube %u",
+				     cubes_[i].first);
+			continue;
+		}
+
+		for (it = metric->rt.begin(); it != metric->rt.end(); ++it) {
+			entry = taken[cubes_[i].second] ? new rina::RoutingTableEntry(**it) : *it;
+			entry->qosId = cubes_[i].first;
+			rt.push_back(entry);
+		}
+		taken[cubes_[i].second] = true;
+	}
+
+	for (unsigned int i = 0; i < metrics_.size(); i++) {
+		if (!taken[i]) {
+			for (it = metrics_[i]->rt.begin();
+					it != metrics_[i]->rt.end(); ++it) {
+				delete *it;
+			}
+		}
+		metrics_[i]->rt.clear();
+	}
+}
+
+void QoSCubeRoutingAlgorithm::computeShortestDistances(const Graph& graph,
+						       const std::string& source_name,
+						       std::map<std::string, int>& distances)
+{
+	Metric * metric;
+
+	if (cubes_.empty()) {
+		return;
+	}
+
+	metric = metrics_[cubes_.front().second];
+	metric->algorithm->computeShortestDistances(weigh(graph, *metric),
+						    source_name, distances);
+}
+
 // CLASS FlowStateObject
 FlowStateObject::FlowStateObject()
 {
@@ -844,6 +1493,8 @@ FlowStateObject::FlowStateObject()
 	state_up = false;
 	seq_num = 0;
 	age = 0;
+	birth = 0;
+	expiry = -1;
 	modified = false;
 	avoid_port = 0;
 	being_erased = true;
@@ -862,6 +1513,8 @@ FlowStateObject::FlowStateObject(const std::string& name_,
 	state_up = up;
 	seq_num = sequence_number;
 	age = age_;
+	birth = 0;
+	expiry = -1;
 	std::stringstream ss;
 	ss << FlowStateRIBObject::object_name_prefix
 	   << getKey();
@@ -935,60 +1588,495 @@ void FlowStateObject::set_addresses(const std::list<unsigned int>& addresses_)
 	}
 }
 
-void FlowStateObject::add_neighboraddress(unsigned int neighbor_address)
+void FlowStateObject::add_neighboraddress(unsigned int neighbor_address)
+{
+	if (!contains_neighboraddress(neighbor_address))
+		neighbor_addresses.push_back(neighbor_address);
+}
+
+void FlowStateObject::remove_neighboraddress(unsigned int address)
+{
+	std::list<unsigned int>::iterator it;
+	for (it = neighbor_addresses.begin();
+			it != neighbor_addresses.end(); ++it) {
+		if (*it == address) {
+			neighbor_addresses.erase(it);
+			return;
+		}
+	}
+}
+
+bool FlowStateObject::contains_neighboraddress(unsigned int address) const
+{
+	std::list<unsigned int>::const_iterator it;
+	for (it = neighbor_addresses.begin();
+			it != neighbor_addresses.end(); ++it) {
+		if (*it == address) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FlowStateObject::set_neighboraddresses(const std::list<unsigned int>& addresses_)
+{
+	neighbor_addresses.clear();
+	for(std::list<unsigned int>::const_iterator it = addresses_.begin();
+			it != addresses_.end(); ++it) {
+		neighbor_addresses.push_back(*it);
+	}
+}
+
+void FlowStateObject::deprecateObject(unsigned int max_age)
+{
+	LOG_IPCP_INFO("Object %s deprecated", object_name.c_str());
+	state_up = false;
+	age = max_age +1 ;
+	seq_num++;
+	modified = true;
+}
+
+const std::string FlowStateObject::getKey() const
+{
+	std::stringstream ss;
+	ss << name << "-" << neighbor_name;
+	return ss.str();
+}
+
+// CLASS FlowStateObjectSummary
+FlowStateObjectSummary::FlowStateObjectSummary()
+{
+	after = 0;
+	last = UINT64_MAX;
+	complete = false;
+}
+
+// CLASS FlowStateMessages
+FlowStateMessages::FlowStateMessages()
+{
+	objects = 0;
+}
+
+// CLASS FlowStateAges
+FlowStateAges::FlowStateAges()
+{
+	pulse_ = 0;
+	max_age_ = UINT_MAX;
+}
+
+void FlowStateAges::set_maximum_age(unsigned int max_age)
+{
+	max_age_ = max_age;
+}
+
+unsigned int FlowStateAges::get_maximum_age() const
+{
+	return max_age_;
+}
+
+void FlowStateAges::schedule(FlowStateObject * fso, int64_t expiry)
+{
+	if (fso->expiry >= 0)
+		buckets_[fso->expiry].erase(fso);
+
+	buckets_[expiry].insert(fso);
+	fso->expiry = expiry;
+}
+
+void FlowStateAges::setAge(FlowStateObject * fso, unsigned int age)
+{
+	int64_t expiry;
+
+	fso->age = age;
+	fso->birth = pulse_ - age;
+
+	// A later expiry is noticed when the current bucket comes due
+	expiry = fso->birth + max_age_;
+	if (fso->expiry < 0 || expiry < fso->expiry)
+		schedule(fso, expiry);
+}
+
+unsigned int FlowStateAges::getAge(const FlowStateObject& fso) const
+{
+	int64_t age = pulse_ - fso.birth;
+
+	return age < UINT_MAX ? age : UINT_MAX;
+}
+
+void FlowStateAges::objectRemoved(FlowStateObject * fso)
+{
+	BucketMap::iterator it;
+
+	if (fso->expiry < 0)
+		return;
+
+	it = buckets_.find(fso->expiry);
+	if (it != buckets_.end()) {
+		it->second.erase(fso);
+		if (it->second.empty())
+			buckets_.erase(it);
+	}
+	fso->expiry = -1;
+}
+
+void FlowStateAges::increment(std::list<FlowStateObject *>& expired)
+{
+	pulse_++;
+
+	while (!buckets_.empty() && buckets_.begin()->first <= pulse_) {
+		std::set<FlowStateObject *> bucket;
+		std::set<FlowStateObject *>::iterator it;
+
+		bucket.swap(buckets_.begin()->second);
+		buckets_.erase(buckets_.begin());
+
+		for (it = bucket.begin(); it != bucket.end(); ++it) {
+			(*it)->expiry = -1;
+			if (getAge(**it) >= max_age_)
+				expired.push_back(*it);
+			else
+				schedule(*it, (*it)->birth + max_age_);
+		}
+	}
+}
+
+// CLASS FlowStateDeltas
+FlowStateDeltas::FlowStateDeltas()
+{
+}
+
+uint64_t FlowStateDeltas::fingerprint(const FlowStateObject& fso)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (std::string::size_type i = 0; i < fso.object_name.size(); i++) {
+		hash ^= (unsigned char) fso.object_name[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash ? hash : 1;
+}
+
+void FlowStateDeltas::objectAdded(FlowStateObject * fso)
+{
+	Entry& entry = objects_[fingerprint(*fso)];
+
+	if (entry.fso) {
+		LOG_IPCP_WARN("Objects %s and %s have the same fingerprint",
+			      entry.fso->object_name.c_str(),
+			      fso->object_name.c_str());
+		return;
+	}
+
+	entry.fso = fso;
+}
+
+void FlowStateDeltas::objectRemoved(FlowStateObject * fso)
+{
+	ObjectMap::iterator it = objects_.find(fingerprint(*fso));
+
+	// Its fingerprint stays in dirty_ until the next messages
+	if (it != objects_.end() && it->second.fso == fso)
+		objects_.erase(it);
+}
+
+void FlowStateDeltas::addPort(int port)
+{
+	unsigned int slot;
+
+	if (slots_.find(port) != slots_.end())
+		return;
+
+	if (free_slots_.empty()) {
+		slot = slots_.size();
+	} else {
+		slot = free_slots_.back();
+		free_slots_.pop_back();
+	}
+	slots_[port] = slot;
+}
+
+void FlowStateDeltas::removePort(std::map<int, unsigned int>::iterator it)
+{
+	std::vector<uint64_t>::iterator dt;
+
+	for (dt = dirty_.begin(); dt != dirty_.end(); ++dt) {
+		ObjectMap::iterator ot = objects_.find(*dt);
+
+		if (ot != objects_.end())
+			setPending(ot, it->second, false);
+	}
+
+	free_slots_.push_back(it->second);
+	slots_.erase(it);
+}
+
+void FlowStateDeltas::setPorts(const std::list<int>& ports)
+{
+	std::map<int, unsigned int>::iterator it;
+	std::list<int>::const_iterator jt;
+
+	for (it = slots_.begin(); it != slots_.end();) {
+		if (std::find(ports.begin(), ports.end(), it->first) ==
+				ports.end())
+			removePort(it++);
+		else
+			++it;
+	}
+
+	for (jt = ports.begin(); jt != ports.end(); ++jt) {
+		addPort(*jt);
+	}
+}
+
+void FlowStateDeltas::setPending(ObjectMap::iterator it, unsigned int slot,
+				 bool pending)
+{
+	Entry& entry = it->second;
+
+	if (!pending) {
+		if (slot < entry.pending.size())
+			entry.pending[slot] = false;
+		return;
+	}
+
+	if (slot >= entry.pending.size())
+		entry.pending.resize(slot + 1, false);
+	entry.pending[slot] = true;
+	if (!entry.dirty) {
+		entry.dirty = true;
+		dirty_.push_back(it->first);
+	}
+}
+
+void FlowStateDeltas::objectModified(FlowStateObject * fso, int avoid_port)
+{
+	ObjectMap::iterator it = objects_.find(fingerprint(*fso));
+	std::map<int, unsigned int>::iterator st;
+
+	if (it == objects_.end() || it->second.fso != fso)
+		return;
+
+	for (st = slots_.begin(); st != slots_.end(); ++st) {
+		setPending(it, st->second, st->first != avoid_port);
+	}
+}
+
+void FlowStateDeltas::setPending(FlowStateObject * fso, int port, bool pending)
+{
+	ObjectMap::iterator it = objects_.find(fingerprint(*fso));
+	std::map<int, unsigned int>::iterator st = slots_.find(port);
+
+	if (it != objects_.end() && it->second.fso == fso &&
+			st != slots_.end())
+		setPending(it, st->second, pending);
+}
+
+void FlowStateDeltas::setAllPending(int port)
+{
+	std::map<int, unsigned int>::iterator st = slots_.find(port);
+
+	if (st == slots_.end())
+		return;
+
+	for (ObjectMap::iterator it = objects_.begin(); it != objects_.end();
+			++it) {
+		setPending(it, st->second, true);
+	}
+}
+
+void FlowStateDeltas::getMessages(int port, unsigned int max_objects,
+				  FlowStateMessages& messages)
+{
+	FlowStateObjectListEncoder encoder;
+	std::vector<std::pair<int, unsigned int> > targets;
+	std::vector<std::vector<unsigned int> > objects;
+	std::vector<ObjectMap::iterator> entries;
+	std::vector<unsigned int> uses;
+	std::vector<std::string> encoded;
+	std::map<int, unsigned int>::iterator st;
+	std::vector<uint64_t> still_dirty;
+
+	for (st = slots_.begin(); st != slots_.end(); ++st) {
+		if (port < 0 || st->first == port)
+			targets.push_back(*st);
+	}
+
+	// The objects to send on every target port, in fingerprint order
+	std::sort(dirty_.begin(), dirty_.end());
+	objects.resize(targets.size());
+	for (unsigned int i = 0; i < dirty_.size(); i++) {
+		ObjectMap::iterator it = objects_.find(dirty_[i]);
+		unsigned int sent = 0;
+
+		// Removed, or added again after being removed
+		if (it == objects_.end() || !it->second.dirty ||
+				(i > 0 && dirty_[i] == dirty_[i - 1]))
+			continue;
+
+		std::vector<bool>& pending = it->second.pending;
+
+		for (unsigned int t = 0; t < targets.size(); t++) {
+			unsigned int slot = targets[t].second;
+
+			if (slot < pending.size() && pending[slot]) {
+				objects[t].push_back(entries.size());
+				pending[slot] = false;
+				sent++;
+			}
+		}
+		if (sent) {
+			entries.push_back(it);
+			uses.push_back(sent);
+		}
+
+		if (std::find(pending.begin(), pending.end(), true) !=
+				pending.end())
+			still_dirty.push_back(dirty_[i]);
+		else
+			it->second.dirty = false;
+	}
+	dirty_.swap(still_dirty);
+
+	encoded.resize(entries.size());
+	for (unsigned int t = 0; t < targets.size(); t++) {
+		std::list<unsigned int>& positions =
+			messages.ports[targets[t].first];
+		std::string group;
+		unsigned int listed = 0;
+		unsigned int u;
+
+		if (objects[t].empty()) {
+			messages.ports.erase(targets[t].first);
+			continue;
+		}
+
+		// Reuse the groups of a port with the same objects to send
+		for (u = 0; u < t; u++) {
+			if (objects[u] == objects[t])
+				break;
+		}
+		if (u < t) {
+			positions = messages.ports[targets[u].first];
+			continue;
+		}
+
+		for (unsigned int i = 0; i < objects[t].size(); i++) {
+			unsigned int entry = objects[t][i];
+			std::string& object = encoded[entry];
+
+			// Objects sent on a single port are not worth keeping
+			if (uses[entry] == 1) {
+				encoder.append(*entries[entry]->second.fso, group);
+				messages.objects++;
+			} else {
+				if (object.empty()) {
+					encoder.append(*entries[entry]->second.fso,
+						       object);
+					messages.objects++;
+				}
+				group += object;
+			}
+
+			if (++listed == max_objects) {
+				positions.push_back(messages.messages.size());
+				messages.messages.push_back(group);
+				group.clear();
+				listed = 0;
+			}
+		}
+		if (listed > 0) {
+			positions.push_back(messages.messages.size());
+			messages.messages.push_back(group);
+		}
+	}
+}
+
+void FlowStateDeltas::getSummaries(unsigned int max_objects,
+				   std::list<FlowStateObjectSummary>& summaries) const
 {
-	if (!contains_neighboraddress(neighbor_address))
-		neighbor_addresses.push_back(neighbor_address);
-}
+	FlowStateObjectSummary summary;
+	unsigned int listed = 0;
 
-void FlowStateObject::remove_neighboraddress(unsigned int address)
-{
-	std::list<unsigned int>::iterator it;
-	for (it = neighbor_addresses.begin();
-			it != neighbor_addresses.end(); ++it) {
-		if (*it == address) {
-			neighbor_addresses.erase(it);
-			return;
+	summary.complete = true;
+	for (ObjectMap::const_iterator it = objects_.begin();
+			it != objects_.end(); ++it) {
+		if (max_objects > 0 && listed == max_objects) {
+			summary.last = summary.objects.back().first;
+			summaries.push_back(summary);
+			summary.after = summary.last;
+			summary.last = UINT64_MAX;
+			summary.objects.clear();
+			listed = 0;
 		}
+
+		summary.objects.push_back(std::make_pair(it->first,
+							 it->second.fso->seq_num));
+		listed++;
 	}
+
+	// The last summary reaches the end, even if it is empty
+	summaries.push_back(summary);
 }
 
-bool FlowStateObject::contains_neighboraddress(unsigned int address) const
+void FlowStateDeltas::processSummary(const FlowStateObjectSummary& summary,
+				     int port,
+				     FlowStateObjectSummary& request)
 {
-	std::list<unsigned int>::const_iterator it;
-	for (it = neighbor_addresses.begin();
-			it != neighbor_addresses.end(); ++it) {
-		if (*it == address) {
-			return true;
+	std::list<std::pair<uint64_t, unsigned int> >::const_iterator st;
+	ObjectMap::iterator it, end;
+	unsigned int slot;
+
+	addPort(port);
+	slot = slots_[port];
+	request.complete = false;
+
+	// The neighbor lacks the objects in the range it did not list, the
+	// listed ones are sorted out below
+	if (summary.complete && summary.after < summary.last) {
+		it = objects_.upper_bound(summary.after);
+		end = objects_.upper_bound(summary.last);
+		for (; it != end; ++it) {
+			setPending(it, slot, true);
 		}
 	}
 
-	return false;
-}
+	for (st = summary.objects.begin(); st != summary.objects.end(); ++st) {
+		it = objects_.find(st->first);
+		if (it == objects_.end()) {
+			if (st->second > 0)
+				request.objects.push_back(std::make_pair(st->first,
+									 0));
+			continue;
+		}
 
-void FlowStateObject::set_neighboraddresses(const std::list<unsigned int>& addresses_)
-{
-	neighbor_addresses.clear();
-	for(std::list<unsigned int>::const_iterator it = addresses_.begin();
-			it != addresses_.end(); ++it) {
-		neighbor_addresses.push_back(*it);
+		setPending(it, slot, it->second.fso->seq_num > st->second);
+		if (it->second.fso->seq_num < st->second)
+			request.objects.push_back(std::make_pair(st->first,
+						  it->second.fso->seq_num));
 	}
 }
 
-void FlowStateObject::deprecateObject(unsigned int max_age)
+unsigned int FlowStateDeltas::pending(int port) const
 {
-	LOG_IPCP_INFO("Object %s deprecated", object_name.c_str());
-	state_up = false;
-	age = max_age +1 ;
-	seq_num++;
-	modified = true;
-}
+	std::map<int, unsigned int>::const_iterator st = slots_.find(port);
+	std::vector<uint64_t>::const_iterator dt;
+	unsigned int result = 0;
 
-const std::string FlowStateObject::getKey() const
-{
-	std::stringstream ss;
-	ss << name << "-" << neighbor_name;
-	return ss.str();
+	if (st == slots_.end())
+		return 0;
+
+	for (dt = dirty_.begin(); dt != dirty_.end(); ++dt) {
+		ObjectMap::const_iterator it = objects_.find(*dt);
+
+		if (it != objects_.end() &&
+				st->second < it->second.pending.size() &&
+				it->second.pending[st->second])
+			result++;
+	}
+
+	return result;
 }
 
 // CLASS FlowStateRIBObject
@@ -1026,6 +2114,9 @@ FlowStateObjects::FlowStateObjects(LinkStateRoutingPolicy * ps)
 	IPCPRIBDaemon* rib_daemon = (IPCPRIBDaemon*)IPCPFactory::getIPCP()
 		->get_rib_daemon();
 	rib_daemon->addObjRIB(FlowStateRIBObjects::object_name, &rib_objects);
+	rib_objects = new FlowStateSummaryRIBObject(ps);
+	rib_daemon->addObjRIB(FlowStateSummaryRIBObject::object_name,
+			      &rib_objects);
 	wait_until_remove_object = 0;
 }
 
@@ -1039,6 +2130,7 @@ FlowStateObjects::~FlowStateObjects()
 	objects.clear();
 	IPCPRIBDaemon* rib_daemon = (IPCPRIBDaemon*)IPCPFactory::getIPCP()
 		->get_rib_daemon();
+	rib_daemon->removeObjRIB(FlowStateSummaryRIBObject::object_name);
 	rib_daemon->removeObjRIB(FlowStateRIBObjects::object_name);
 }
 
@@ -1078,13 +2170,13 @@ void FlowStateObjects::addAddressToFSOs(const std::string& name,
 					&& it->second->neighbor_name == name) {
 				it->second->add_neighboraddress(address);
 				it->second->modified = true;
-				it->second->age = 0;
+				ages_.setAge(it->second, 0);
 				it->second->seq_num = it->second->seq_num + 1;
 			}
 		} else if (it->second->name == name) {
 			it->second->add_address(address);
 			it->second->modified = true;
-			it->second->age = 0;
+			ages_.setAge(it->second, 0);
 			it->second->seq_num = it->second->seq_num + 1;
 		}
 	}
@@ -1106,13 +2198,13 @@ void FlowStateObjects::removeAddressFromFSOs(const std::string& name,
 					&& it->second->neighbor_name == name) {
 				it->second->remove_neighboraddress(address);
 				it->second->modified = true;
-				it->second->age = 0;
+				ages_.setAge(it->second, 0);
 				it->second->seq_num = it->second->seq_num + 1;
 			}
 		} else if (it->second->name == name) {
 			it->second->remove_address(address);
 			it->second->modified = true;
-			it->second->age = 0;
+			ages_.setAge(it->second, 0);
 			it->second->seq_num = it->second->seq_num + 1;
 		}
 	}
@@ -1131,16 +2223,18 @@ void FlowStateObjects::addCheckedObject(const FlowStateObject& object)
 
 	fso->set_addresses(object.addresses);
 	fso->set_neighboraddresses(object.neighbor_addresses);
+	fso->avoid_port = object.avoid_port;
 
 	objects[object.object_name] = fso;
+	deltas_.objectAdded(fso);
+	ages_.setAge(fso, object.age);
 	rina::rib::RIBObj* rib_obj = new FlowStateRIBObject(fso);
 	IPCPRIBDaemon* rib_daemon = (IPCPRIBDaemon*)IPCPFactory::getIPCP()->get_rib_daemon();
 	rib_daemon->addObjRIB(fso->object_name, &rib_obj);
 	modified_ = true;
 }
 
-void FlowStateObjects::deprecateObject(const std::string& fqn, 
-				       unsigned int max_age)
+void FlowStateObjects::deprecateObject(const std::string& fqn)
 {
 	rina::ScopedLock g(lock);
 
@@ -1148,13 +2242,25 @@ void FlowStateObjects::deprecateObject(const std::string& fqn,
 			objects.find(fqn);
 	if(it != objects.end())
 	{
-		it->second->deprecateObject(max_age);
+		deprecateCheckedObject(it->second);
 	}
 }
 
+void FlowStateObjects::deprecateObject(FlowStateObject * fso)
+{
+	rina::ScopedLock g(lock);
+
+	deprecateCheckedObject(fso);
+}
+
+void FlowStateObjects::deprecateCheckedObject(FlowStateObject * fso)
+{
+	fso->deprecateObject(ages_.get_maximum_age());
+	ages_.setAge(fso, fso->age);
+}
+
 void FlowStateObjects::deprecateObjects(const std::string& neigh_name,
-		      	      	        const std::string& name,
-		     	     	        unsigned int max_age)
+		      	      	        const std::string& name)
 {
 	rina::ScopedLock g(lock);
 
@@ -1163,7 +2269,7 @@ void FlowStateObjects::deprecateObjects(const std::string& neigh_name,
 			++it) {
 		if (it->second->neighbor_name == neigh_name &&
 				it->second->name == name) {
-			it->second->deprecateObject(max_age);
+			deprecateCheckedObject(it->second);
 			modified_ = true;
 		}
 	}
@@ -1188,7 +2294,6 @@ void FlowStateObjects::updateCost(const std::string& neigh_name,
 }
 
 void FlowStateObjects::deprecateObjectsWithName(const std::string& name,
-						unsigned int max_age,
 						bool neighbor)
 {
 	rina::ScopedLock g(lock);
@@ -1198,11 +2303,11 @@ void FlowStateObjects::deprecateObjectsWithName(const std::string& name,
 	for (it = objects.begin(); it != objects.end();
 			++it) {
 		if (!neighbor && it->second->name == name) {
-			it->second->deprecateObject(max_age);
+			deprecateCheckedObject(it->second);
 			modified_ = true;
 		} else if (neighbor && it->second->neighbor_name == name &&
 				it->second->name == my_name) {
-			it->second->deprecateObject(max_age);
+			deprecateCheckedObject(it->second);
 			modified_ = true;
 		}
 	}
@@ -1220,11 +2325,43 @@ void FlowStateObjects::removeObject(const std::string& fqn)
 	if (it == objects.end())
 		return;
 
+	removeCheckedObject(it);
+}
+
+void FlowStateObjects::removeExpiredObjects(const std::list<std::string>& fqns)
+{
+	rina::ScopedLock g(lock);
+	std::map<std::string, FlowStateObject*>::iterator it;
+	unsigned int removed = 0;
+
+	for (std::list<std::string>::const_iterator jt = fqns.begin();
+			jt != fqns.end(); ++jt) {
+		it = objects.find(*jt);
+
+		// Updated since it expired
+		if (it == objects.end() || !it->second->being_erased)
+			continue;
+
+		removeCheckedObject(it);
+		removed++;
+	}
+
+	LOG_IPCP_DBG("Removed %u expired objects out of %u", removed,
+		     fqns.size());
+
+	if (removed > 0)
+		modified_ = true;
+}
+
+void FlowStateObjects::removeCheckedObject(std::map<std::string, FlowStateObject*>::iterator it)
+{
 	IPCPRIBDaemon* rib_daemon = (IPCPRIBDaemon*) IPCPFactory::getIPCP()->get_rib_daemon();
 	rib_daemon->removeObjRIB(it->second->object_name);
 
-	objects.erase(it);
+	deltas_.objectRemoved(it->second);
+	ages_.objectRemoved(it->second);
 	delete it->second;
+	objects.erase(it);
 }
 
 FlowStateObject* FlowStateObjects::getObject(const std::string& fqn)
@@ -1244,50 +2381,55 @@ void FlowStateObjects::has_modified(bool modified)
 	modified_ = modified;
 }
 
-void FlowStateObjects::getModifiedFSOs(std::list<FlowStateObject *>& result)
+void FlowStateObjects::getAllFSOs(std::list<FlowStateObject>& result)
 {
 	rina::ScopedLock g(lock);
 
 	for (std::map<std::string, FlowStateObject*>::iterator it
-		= objects.begin(); it != objects.end();++it)
+			= objects.begin(); it != objects.end();++it)
 	{
-		if (it->second->modified)
-		{
-			result.push_back(it->second);
-		}
+		it->second->age = ages_.getAge(*it->second);
+		result.push_back(*(it->second));
 	}
 }
 
-void FlowStateObjects::getAllFSOs(std::list<FlowStateObject>& result)
+void FlowStateObjects::incrementAge(rina::Timer* timer)
 {
 	rina::ScopedLock g(lock);
+	std::list<FlowStateObject *> expired;
+	std::list<std::string> fqns;
 
-	for (std::map<std::string, FlowStateObject*>::iterator it
-			= objects.begin(); it != objects.end();++it)
-	{
-		result.push_back(*(it->second));
+	ages_.increment(expired);
+	for (std::list<FlowStateObject *>::iterator it = expired.begin();
+			it != expired.end(); ++it) {
+		if ((*it)->being_erased)
+			continue;
+
+		LOG_IPCP_DBG("Object to erase age: %d", ages_.getAge(**it));
+		(*it)->being_erased = true;
+		fqns.push_back((*it)->object_name);
 	}
+
+	if (fqns.empty())
+		return;
+
+	KillFlowStateObjectTimerTask* ksttask =
+		new KillFlowStateObjectTimerTask(ps_, fqns);
+	timer->scheduleTask(ksttask, wait_until_remove_object);
 }
 
-void FlowStateObjects::incrementAge(unsigned int max_age, rina::Timer* timer)
+void FlowStateObjects::setAge(FlowStateObject * fso, unsigned int age)
 {
 	rina::ScopedLock g(lock);
 
-	for (std::map<std::string, FlowStateObject *>::iterator
-		it = objects.begin(); it != objects.end(); ++it) 
-	{
-		if (it->second->age < UINT_MAX)
-			it->second->age = it->second->age + 1;
+	ages_.setAge(fso, age);
+}
 
-		if (it->second->age >= max_age && !it->second->being_erased) {
-			LOG_IPCP_DBG("Object to erase age: %d", it->second->age);
-			it->second->being_erased = true;
-			KillFlowStateObjectTimerTask* ksttask =
-				new KillFlowStateObjectTimerTask(ps_, it->second->object_name);
+void FlowStateObjects::set_maximum_age(unsigned int max_age)
+{
+	rina::ScopedLock g(lock);
 
-			timer->scheduleTask(ksttask, wait_until_remove_object);
-		}
-	}
+	ages_.set_maximum_age(max_age);
 }
 
 void FlowStateObjects::updateObject(const std::string& fqn, 
@@ -1300,7 +2442,7 @@ void FlowStateObjects::updateObject(const std::string& fqn,
 		return;
 
 	FlowStateObject* obj = it->second;
-	obj->age = 0;
+	ages_.setAge(obj, 0);
 	obj->avoid_port = avoid_port_;
 	obj->being_erased = false;
 	obj->state_up = true;
@@ -1319,6 +2461,7 @@ void FlowStateObjects::encodeAllFSOs(rina::ser_obj_t& obj)
 		for (std::map<std::string, FlowStateObject*>::iterator it
 			= objects.begin(); it != objects.end();++it)
 		{
+			it->second->age = ages_.getAge(*it->second);
 			result.push_back(*(it->second));
 		}
 		encoder.encode(result, obj);
@@ -1330,29 +2473,75 @@ void FlowStateObjects::encodeAllFSOs(rina::ser_obj_t& obj)
 	}
 }
 
-void FlowStateObjects::getAllFSOsForPropagation(std::list< std::list<FlowStateObject> >& fsos,
-						unsigned int max_objects)
+void FlowStateObjects::setPending(const std::string& fqn, int port,
+				  bool pending)
 {
 	rina::ScopedLock g(lock);
-	std::list<FlowStateObject> fsolist;
+	std::map<std::string, FlowStateObject*>::iterator it =
+		objects.find(fqn);
 
-	if (objects.empty())
-		return;
+	if (it != objects.end())
+		deltas_.setPending(it->second, port, pending);
+}
+
+void FlowStateObjects::prepareForPropagation(const std::list<int>& ports,
+					     unsigned int max_objects,
+					     FlowStateMessages& messages)
+{
+	rina::ScopedLock g(lock);
 
+	deltas_.setPorts(ports);
 	for (std::map<std::string, FlowStateObject*>::iterator it
-			= objects.begin(); it != objects.end();++it)
+			= objects.begin(); it != objects.end(); ++it)
 	{
-		if (fsolist.size() == max_objects) {
-			fsos.push_back(fsolist);
-			fsolist.clear();
-		}
+		it->second->age = ages_.getAge(*it->second);
+		if (!it->second->modified)
+			continue;
 
-		fsolist.push_back(*(it->second));
+		LOG_DBG("Propagation: Check modified object %s with age %d and status %d",
+			it->second->object_name.c_str(),
+			it->second->age,
+			it->second->state_up);
+
+		deltas_.objectModified(it->second, it->second->avoid_port);
+		it->second->modified = false;
+		it->second->avoid_port = FlowStateManager::NO_AVOID_PORT;
 	}
 
-	if (fsolist.size() != 0) {
-		fsos.push_back(fsolist);
+	deltas_.getMessages(-1, max_objects, messages);
+}
+
+void FlowStateObjects::getAllFSOsForPropagation(int port,
+						unsigned int max_objects,
+						FlowStateMessages& messages)
+{
+	rina::ScopedLock g(lock);
+
+	for (std::map<std::string, FlowStateObject*>::iterator it
+			= objects.begin(); it != objects.end(); ++it)
+	{
+		it->second->age = ages_.getAge(*it->second);
 	}
+	deltas_.addPort(port);
+	deltas_.setAllPending(port);
+	deltas_.getMessages(port, max_objects, messages);
+}
+
+void FlowStateObjects::getSummaries(unsigned int max_objects,
+				    std::list<FlowStateObjectSummary>& summaries)
+{
+	rina::ScopedLock g(lock);
+
+	deltas_.getSummaries(max_objects, summaries);
+}
+
+void FlowStateObjects::processSummary(const FlowStateObjectSummary& summary,
+				      int port,
+				      FlowStateObjectSummary& request)
+{
+	rina::ScopedLock g(lock);
+
+	deltas_.processSummary(summary, port, request);
 }
 
 bool FlowStateObjects::is_modified() const
@@ -1399,6 +2588,31 @@ void FlowStateRIBObjects::write(const rina::cdap_rib::con_handle_t &con,
 			   con.port_id);
 }
 
+//Class FlowStateSummaryRIBObject
+const std::string FlowStateSummaryRIBObject::clazz_name = "FlowStateObjectSummary";
+const std::string FlowStateSummaryRIBObject::object_name = "/resalloc/fsos/summary";
+
+FlowStateSummaryRIBObject::FlowStateSummaryRIBObject(LinkStateRoutingPolicy* ps) :
+		rina::rib::RIBObj(clazz_name)
+{
+	ps_ = ps;
+}
+
+void FlowStateSummaryRIBObject::write(const rina::cdap_rib::con_handle_t &con,
+				      const std::string& fqn,
+				      const std::string& clas,
+				      const rina::cdap_rib::filt_info_t &filt,
+				      const int invoke_id,
+				      const rina::ser_obj_t &obj_req,
+				      rina::ser_obj_t &obj_reply,
+				      rina::cdap_rib::res_info_t& res)
+{
+	FlowStateObjectSummaryEncoder encoder;
+	FlowStateObjectSummary summary;
+	encoder.decode(obj_req, summary);
+	ps_->processSummary(summary, con.port_id);
+}
+
 // CLASS FlowStateManager
 const int FlowStateManager::NO_AVOID_PORT = -1;
 const long FlowStateManager::WAIT_UNTIL_REMOVE_OBJECT = 23000;
@@ -1409,6 +2623,7 @@ FlowStateManager::FlowStateManager(rina::Timer *new_timer,
 {
 	maximum_age = max_age;
 	fsos = new FlowStateObjects(ps);
+	fsos->set_maximum_age(max_age);
 	timer = new_timer;
 }
 
@@ -1440,13 +2655,14 @@ bool FlowStateManager::addNewFSO(const std::string& name,
 
 	newObject.set_addresses(addresses);
 	newObject.set_neighboraddresses(neighbor_addresses);
+	newObject.avoid_port = avoid_port;
 
 	return fsos->addObject(newObject);
 }
 
 void FlowStateManager::deprecateObject(std::string fqn)
 {
-	fsos->deprecateObject(fqn, maximum_age);
+	fsos->deprecateObject(fqn);
 }
 
 void FlowStateManager::removeAddressFromFSOs(const std::string& name,
@@ -1458,7 +2674,7 @@ void FlowStateManager::removeAddressFromFSOs(const std::string& name,
 
 void FlowStateManager::incrementAge()
 {
-	fsos->incrementAge(maximum_age, timer);
+	fsos->incrementAge(timer);
 }
 
 void FlowStateManager::updateObjects(const std::list<FlowStateObject>& newObjects,
@@ -1494,14 +2710,14 @@ void FlowStateManager::updateObjects(const std::list<FlowStateObject>& newObject
 						     obj_to_up->seq_num);
 					obj_to_up->seq_num = newIt->seq_num+ 1;
 					obj_to_up->avoid_port = NO_AVOID_PORT;
-					obj_to_up->age = 0;
+					fsos->setAge(obj_to_up, 0);
 					obj_to_up->cost = newIt->cost;
 				} else {
 					obj_to_up->avoid_port = avoidPort;
 					if (newIt->age >= maximum_age) {
-						obj_to_up->deprecateObject(maximum_age);
+						fsos->deprecateObject(obj_to_up);
 					} else {
-						obj_to_up->age = 0;
+						fsos->setAge(obj_to_up, 0);
 						obj_to_up->seq_num = newIt->seq_num;
 						obj_to_up->set_addresses(newIt->addresses);
 						obj_to_up->set_neighboraddresses(newIt->neighbor_addresses);
@@ -1511,6 +2727,12 @@ void FlowStateManager::updateObjects(const std::list<FlowStateObject>& newObject
 
 				obj_to_up->modified = true;
 				fsos->has_modified(true);
+			} else {
+				//1.2 Otherwise the neighbor has it already, or
+				//needs the newer version
+				fsos->setPending(obj_to_up->object_name,
+						 avoidPort,
+						 newIt->seq_num < obj_to_up->seq_num);
 			}
 		}
 		//2. If the object does not exist create
@@ -1529,57 +2751,16 @@ void FlowStateManager::updateObjects(const std::list<FlowStateObject>& newObject
 	}
 }
 
-void FlowStateManager::prepareForPropagation(std::map<int, std::list< std::list<FlowStateObject> > >&  to_propagate,
-					     unsigned int max_objects) const
+void FlowStateManager::prepareForPropagation(const std::list<int>& ports,
+					     unsigned int max_objects,
+					     FlowStateMessages& messages) const
 {
-	std::list<FlowStateObject> newfsolist;
-	bool added = false;
-
-	//1 Get the FSOs to propagate
-	std::list<FlowStateObject *> modifiedFSOs;
-	fsos->getModifiedFSOs(modifiedFSOs);
-
-	//2 add each modified object to its port list
-	for (std::list<FlowStateObject*>::iterator it = modifiedFSOs.begin();
-			it != modifiedFSOs.end(); ++it)
-	{
-		LOG_DBG("Propagation: Check modified object %s with age %d and status %d",
-			(*it)->object_name.c_str(),
-			(*it)->age,
-			(*it)->state_up);
-
-		for(std::map<int, std::list< std::list<FlowStateObject> > >::iterator it2 =
-				to_propagate.begin(); it2 != to_propagate.end(); ++it2)
-		{
-			if(it2->first != (*it)->avoid_port)
-			{
-				added = false;
-				newfsolist.clear();
-
-				for(std::list< std::list<FlowStateObject> >::iterator it3 = it2->second.begin();
-						it3 != it2->second.end(); ++it3) {
-					if (it3->size() < max_objects) {
-						it3->push_back(**it);
-						added = true;
-						break;
-					}
-				}
-
-				if (!added) {
-					newfsolist.push_back(**it);
-					it2->second.push_back(newfsolist);
-				}
-			}
-		}
-
-		(*it)->modified = false;
-		(*it)->avoid_port = NO_AVOID_PORT;
-	}
+	fsos->prepareForPropagation(ports, max_objects, messages);
 }
 
-void FlowStateManager::removeObject(const std::string& fqn)
+void FlowStateManager::removeExpiredObjects(const std::list<std::string>& fqns)
 {
-	fsos->removeObject(fqn);
+	fsos->removeExpiredObjects(fqns);
 }
 
 void FlowStateManager::encodeAllFSOs(rina::ser_obj_t& obj) const
@@ -1590,6 +2771,7 @@ void FlowStateManager::encodeAllFSOs(rina::ser_obj_t& obj) const
 void FlowStateManager::set_maximum_age(unsigned int max_age)
 {
 	maximum_age = max_age;
+	fsos->set_maximum_age(max_age);
 }
 
 void FlowStateManager::set_wait_until_remove_object(unsigned int wait_object)
@@ -1602,20 +2784,34 @@ void FlowStateManager::getAllFSOs(std::list<FlowStateObject>& list) const
 	fsos->getAllFSOs(list);
 }
 
-void FlowStateManager::getAllFSOsForPropagation(std::list< std::list<FlowStateObject> >& fsolist,
-						unsigned int max_objects)
+void FlowStateManager::getAllFSOsForPropagation(int port,
+						unsigned int max_objects,
+						FlowStateMessages& messages)
+{
+	fsos->getAllFSOsForPropagation(port, max_objects, messages);
+}
+
+void FlowStateManager::getSummaries(unsigned int max_objects,
+				    std::list<FlowStateObjectSummary>& summaries) const
+{
+	fsos->getSummaries(max_objects, summaries);
+}
+
+void FlowStateManager::processSummary(const FlowStateObjectSummary& summary,
+				      int port,
+				      FlowStateObjectSummary& request)
 {
-	fsos->getAllFSOsForPropagation(fsolist, max_objects);
+	fsos->processSummary(summary, port, request);
 }
 
 void FlowStateManager::deprecateObjectsNeighbor(const std::string& neigh_name,
                                                 const std::string& name,
 						bool both)
 {
-	fsos->deprecateObjects(neigh_name, name, maximum_age);
+	fsos->deprecateObjects(neigh_name, name);
 
 	if (both) {
-		fsos->deprecateObjects(name, neigh_name, maximum_age);
+		fsos->deprecateObjects(name, neigh_name);
 	}
 }
 
@@ -1663,15 +2859,16 @@ void ComputeRoutingTimerTask::run()
 	lsr_policy_->timer_->scheduleTask(task, delay_);
 }
 
-KillFlowStateObjectTimerTask::KillFlowStateObjectTimerTask(LinkStateRoutingPolicy *ps, std::string fqn)
+KillFlowStateObjectTimerTask::KillFlowStateObjectTimerTask(LinkStateRoutingPolicy *ps,
+							   const std::list<std::string>& fqns)
 {
 	ps_ = ps;
-	fqn_ = fqn;
+	fqns_ = fqns;
 }
 
 void KillFlowStateObjectTimerTask::run()
 {
-	ps_->removeFlowStateObject(fqn_);
+	ps_->removeFlowStateObjects(fqns_);
 }
 
 PropagateFSODBTimerTask::PropagateFSODBTimerTask(
@@ -1737,7 +2934,14 @@ const std::string LinkStateRoutingPolicy::ROUTING_ALGORITHM = "routingAlgorithm"
 const int LinkStateRoutingPolicy::MAXIMUM_BUFFER_SIZE = 4096;
 const std::string LinkStateRoutingPolicy::DIJKSTRA_ALG = "Dijkstra";
 const std::string LinkStateRoutingPolicy::ECMP_DIJKSTRA_ALG = "ECMPDijkstra";
+const std::string LinkStateRoutingPolicy::UCMP_DIJKSTRA_ALG = "UCMPDijkstra";
 const std::string LinkStateRoutingPolicy::MAXIMUM_OBJECTS_PER_ROUTING_UPDATE = "maxObjectsPerUpdate";
+const std::string LinkStateRoutingPolicy::INCREMENTAL_SPF = "incrementalSPF";
+const std::string LinkStateRoutingPolicy::FSO_SUMMARIES = "fsoSummaries";
+const std::string LinkStateRoutingPolicy::QOS_CUBE_ROUTING = "qosCubeRouting";
+const std::string LinkStateRoutingPolicy::ROUTING_WORKERS = "routingWorkers";
+const std::string LinkStateRoutingPolicy::QOS_CUBE_COST_SCALE = "qosCubeCostScale.";
+const std::string LinkStateRoutingPolicy::QOS_CUBE_HOP_COST = "qosCubeHopCost.";
 
 LinkStateRoutingPolicy::LinkStateRoutingPolicy(IPCProcess * ipcp)
 {
@@ -1749,6 +2953,7 @@ LinkStateRoutingPolicy::LinkStateRoutingPolicy(IPCProcess * ipcp)
 	db_ = 0;
 	wait_until_deprecate_address_ = 0;
 	max_objects_per_rupdate_ = MAX_OBJECTS_PER_ROUTING_UPDATE_DEFAULT;
+	fso_summaries_ = false;
 
 	subscribeToEvents();
 	timer_ = new rina::Timer();
@@ -1784,6 +2989,9 @@ void LinkStateRoutingPolicy::set_dif_configuration(
 {
 	std::string routing_alg;
         rina::PolicyConfig psconf;
+        bool incremental = false;
+        bool qos_cube_routing = false;
+        int workers = -1;
         long delay;
 
         psconf = dif_configuration.routing_configuration_.policy_set_;;
@@ -1795,15 +3003,38 @@ void LinkStateRoutingPolicy::set_dif_configuration(
         	routing_alg = DIJKSTRA_ALG;
         }
 
-        if (routing_alg == DIJKSTRA_ALG) {
-        	routing_algorithm_ = new DijkstraAlgorithm();
-                LOG_IPCP_DBG("Using Dijkstra as routing algorithm");
-        } else if (routing_alg == ECMP_DIJKSTRA_ALG)  {
-                routing_algorithm_ = new ECMPDijkstraAlgorithm();
-                LOG_IPCP_DBG("Using ECMP Dijkstra as routing algorithm");
+        try {
+        	incremental = psconf.get_param_value_as_bool(INCREMENTAL_SPF);
+        } catch (rina::Exception &e) {
+        }
+
+        try {
+        	qos_cube_routing = psconf.get_param_value_as_bool(QOS_CUBE_ROUTING);
+        } catch (rina::Exception &e) {
+        }
+
+        try {
+        	workers = psconf.get_param_value_as_int(ROUTING_WORKERS);
+        } catch (rina::Exception &e) {
+        }
+
+        if (qos_cube_routing &&
+        		dif_configuration.efcp_configuration_.qos_cubes_.empty()) {
+        	LOG_IPCP_WARN("No QoS cubes to compute routing tables for");
+        	qos_cube_routing = false;
+        }
+
+        if (qos_cube_routing) {
+        	routing_algorithm_ = createQoSCubeRoutingAlgorithm(psconf,
+        			dif_configuration.efcp_configuration_.qos_cubes_,
+        			routing_alg, incremental, workers);
         } else {
-        	throw rina::Exception("Unsupported routing algorithm");
+        	routing_algorithm_ = createRoutingAlgorithm(routing_alg,
+        						    incremental);
         }
+        LOG_IPCP_DBG("Using %s%s as routing algorithm%s",
+        	     incremental ? "incremental " : "", routing_alg.c_str(),
+        	     qos_cube_routing ? " for every QoS cube" : "");
 #if 0
 	resiliency_algorithm_ = new LoopFreeAlternateAlgorithm(*routing_algorithm_);
 #endif
@@ -1863,8 +3094,55 @@ void LinkStateRoutingPolicy::set_dif_configuration(
 		} catch (rina::Exception &e) {
 			max_objects_per_rupdate_ = MAX_OBJECTS_PER_ROUTING_UPDATE_DEFAULT;
 		}
+
+		// All the IPC Processes of the DIF have to understand summaries
+		try {
+			fso_summaries_ = psconf.get_param_value_as_bool(FSO_SUMMARIES);
+		} catch (rina::Exception &e) {
+			fso_summaries_ = false;
+		}
+	}
+
+}
+
+IRoutingAlgorithm * LinkStateRoutingPolicy::createQoSCubeRoutingAlgorithm(
+		const rina::PolicyConfig& psconf,
+		const std::list<rina::QoSCube*>& cubes,
+		const std::string& routing_alg,
+		bool incremental,
+		int workers)
+{
+	std::list<rina::QoSCube*>::const_iterator it;
+	QoSCubeRoutingAlgorithm * algorithm;
+	int cost_scale, hop_cost;
+
+	algorithm = new QoSCubeRoutingAlgorithm(routing_alg, incremental,
+						workers);
+	for (it = cubes.begin(); it != cubes.end(); ++it) {
+		std::stringstream ss;
+
+		ss << (*it)->id_;
+		try {
+			cost_scale = psconf.get_param_value_as_int(
+					QOS_CUBE_COST_SCALE + ss.str());
+		} catch (rina::Exception &e) {
+			cost_scale = 1;
+		}
+		try {
+			hop_cost = psconf.get_param_value_as_int(
+					QOS_CUBE_HOP_COST + ss.str());
+		} catch (rina::Exception &e) {
+			hop_cost = 0;
+		}
+
+		algorithm->addQoSCube((*it)->id_, cost_scale, hop_cost);
+		LOG_IPCP_DBG("Routing QoS cube %u with link cost %d * cost + %d",
+			     (*it)->id_, cost_scale, hop_cost);
 	}
+	LOG_IPCP_DBG("Computing %u routing tables for %u QoS cubes",
+		     algorithm->metrics(), cubes.size());
 
+	return algorithm;
 }
 
 void LinkStateRoutingPolicy::eventHappened(rina::InternalEvent * event)
@@ -1984,7 +3262,7 @@ void LinkStateRoutingPolicy::processNeighborAddedEvent(rina::NeighborAddedEvent
 				event->neighbor_.get_name().processName,
 				neigh_addresses,
 				1,
-				portId);
+				fso_summaries_ ? FlowStateManager::NO_AVOID_PORT : portId);
 	} catch (rina::Exception &e) {
 		LOG_IPCP_ERR("Could not allocate the flow, no neighbor found");
 	}
@@ -1994,30 +3272,23 @@ void LinkStateRoutingPolicy::processNeighborAddedEvent(rina::NeighborAddedEvent
 				ipc_process_->get_name(), 10000);
 	}
 
-	std::list< std::list<FlowStateObject> > all_fsos;
-	FlowStateObjectListEncoder encoder;
-	db_->getAllFSOsForPropagation(all_fsos, max_objects_per_rupdate_);
-	for (std::list< std::list<FlowStateObject> >::iterator it = all_fsos.begin();
-			it != all_fsos.end(); ++it) {
-		try {
-			rina::cdap_rib::obj_info_t obj;
-			rina::cdap_rib::con_handle_t con;
-			obj.class_ = FlowStateRIBObjects::clazz_name;
-			obj.name_ = FlowStateRIBObjects::object_name;
-			encoder.encode(*it, obj.value_);
-			obj.inst_ = 0;
-			rina::cdap_rib::flags_t flags;
-			rina::cdap_rib::filt_info_t filt;
-			con.port_id = portId;
-			if (obj.value_.size_ != 0)
-				rib_daemon_->getProxy()->remote_write(con,
-						obj,
-						flags,
-						filt,
-						0);
-		} catch (rina::Exception &e) {
-			LOG_IPCP_ERR("Problems encoding and sending CDAP message: %s", e.what());
+	// The enrollee sends a summary of its objects, and the neighbor sends
+	// back the ones it lacks and asks for the ones it is missing. Without
+	// summaries both send all their objects.
+	if (fso_summaries_ && event->enrollee_) {
+		std::list<FlowStateObjectSummary> summaries;
+		std::list<FlowStateObjectSummary>::iterator it;
+
+		db_->getSummaries(MAX_OBJECTS_PER_SUMMARY, summaries);
+		for (it = summaries.begin(); it != summaries.end(); ++it) {
+			sendSummary(*it, portId);
 		}
+	} else if (!fso_summaries_) {
+		FlowStateMessages messages;
+
+		db_->getAllFSOsForPropagation(portId, max_objects_per_rupdate_,
+					      messages);
+		sendMessages(messages);
 	}
 
 	//Force a routing table update
@@ -2032,55 +3303,79 @@ void LinkStateRoutingPolicy::propagateFSDB()
 	//1 Get the active N-1 flows
 	std::list<rina::FlowInformation> nMinusOneFlows =
 			ipc_process_->resource_allocator_->get_n_minus_one_flow_manager()->getAllNMinusOneFlowInformation();
-	//2 Initialize the map
-	std::map <int, std::list< std::list<FlowStateObject> > > objectsToSend;
+	std::list<int> ports;
 	for(std::list<rina::FlowInformation>::iterator it = nMinusOneFlows.begin();
 		it != nMinusOneFlows.end(); ++it) 
 	{
-		objectsToSend[it->portId] = std::list< std::list<FlowStateObject> >();
+		ports.push_back(it->portId);
 	}
 
-	//3 Get the objects to send
-	db_->prepareForPropagation(objectsToSend, max_objects_per_rupdate_);
+	//2 Get the objects to send, encoded once for all the ports
+	FlowStateMessages messages;
+	db_->prepareForPropagation(ports, max_objects_per_rupdate_, messages);
 
-	if (objectsToSend.size() == 0) {
-		return;
-	}
+	//3 Send them
+	sendMessages(messages);
+}
 
-	FlowStateObjectListEncoder encoder;
+void LinkStateRoutingPolicy::sendMessages(const FlowStateMessages& messages)
+{
+	std::map<int, std::list<unsigned int> >::const_iterator it;
+	std::list<unsigned int>::const_iterator jt;
 	rina::cdap_rib::con_handle_t con;
-	for (std::map<int, std::list< std::list<FlowStateObject> > >::iterator it = objectsToSend.begin();
-		it != objectsToSend.end(); ++it)
-
-	{
-		if (it->second.size() == 0)
-			continue;
 
-		for (std::list< std::list<FlowStateObject> >::iterator it2 = it->second.begin();
-				it2 != it->second.end(); ++it2) {
+	for (it = messages.ports.begin(); it != messages.ports.end(); ++it) {
+		con.port_id = it->first;
+		for (jt = it->second.begin(); jt != it->second.end(); ++jt) {
+			const std::string& message = messages.messages[*jt];
 			rina::cdap_rib::flags flags;
 			rina::cdap_rib::filt_info_t filter;
-			try
-			{
-				rina::cdap_rib::object_info obj;
-				obj.class_ = FlowStateRIBObjects::clazz_name;
-				obj.name_ = FlowStateRIBObjects::object_name;
-				encoder.encode(*it2, obj.value_);
-				con.port_id = it->first;
+			rina::cdap_rib::object_info obj;
+
+			obj.class_ = FlowStateRIBObjects::clazz_name;
+			obj.name_ = FlowStateRIBObjects::object_name;
+			obj.inst_ = 0;
+			rina::SerObjLoan value(obj.value_,
+					       (const unsigned char *) message.data(),
+					       message.size());
+			try {
 				rib_daemon_->getProxy()->remote_write(con,
 						obj,
 						flags,
 						filter,
 						0);
-			}
-			catch (rina::Exception &e)
-			{
+			} catch (rina::Exception &e) {
 				LOG_IPCP_ERR("Errors sending message: %s", e.what());
 			}
 		}
 	}
 }
 
+void LinkStateRoutingPolicy::sendSummary(const FlowStateObjectSummary& summary,
+					 int port)
+{
+	FlowStateObjectSummaryEncoder encoder;
+	rina::cdap_rib::con_handle_t con;
+	rina::cdap_rib::flags flags;
+	rina::cdap_rib::filt_info_t filter;
+	rina::cdap_rib::object_info obj;
+
+	obj.class_ = FlowStateSummaryRIBObject::clazz_name;
+	obj.name_ = FlowStateSummaryRIBObject::object_name;
+	obj.inst_ = 0;
+	con.port_id = port;
+	try {
+		encoder.encode(summary, obj.value_);
+		rib_daemon_->getProxy()->remote_write(con,
+				obj,
+				flags,
+				filter,
+				0);
+	} catch (rina::Exception &e) {
+		LOG_IPCP_ERR("Problems encoding and sending CDAP message: %s", e.what());
+	}
+}
+
 void LinkStateRoutingPolicy::updateAge()
 {
 	rina::ScopedLock g(lock_);
@@ -2200,21 +3495,21 @@ void LinkStateRoutingPolicy::_routingTableUpdate()
 	db_->getAllFSOs(flow_state_objects);
 
 	// Build a graph out of the FSO database
-	Graph graph(flow_state_objects);
+	graph_.set_flow_state_objects(flow_state_objects);
 
 	// Invoke the routing algorithm to compute the routing table
 	// Main arguments are the graph and the source vertex.
 	// The list of FSOs may be useless, but has been left there
 	// for the moment (and it is currently unused by the Dijkstra
 	// algorithm).
-	routing_algorithm_->computeRoutingTable(graph,
+	routing_algorithm_->computeRoutingTable(graph_,
 						flow_state_objects,
 						my_name,
 						rt);
 
 	// Run the resiliency algorithm, if any, to extend the routing table
 	if (resiliency_algorithm_) {
-		resiliency_algorithm_->fortifyRoutingTable(graph,
+		resiliency_algorithm_->fortifyRoutingTable(graph_,
 							   my_name,
 							   rt);
 	}
@@ -2246,10 +3541,21 @@ void LinkStateRoutingPolicy::updateObjects(const std::list<FlowStateObject>& new
 			   avoidPort);
 }
 
-void LinkStateRoutingPolicy::removeFlowStateObject(const std::string& fqn)
+void LinkStateRoutingPolicy::processSummary(const FlowStateObjectSummary& summary,
+					    int port)
+{
+	rina::ScopedLock g(lock_);
+	FlowStateObjectSummary request;
+
+	db_->processSummary(summary, port, request);
+	if (!request.objects.empty())
+		sendSummary(request, port);
+}
+
+void LinkStateRoutingPolicy::removeFlowStateObjects(const std::list<std::string>& fqns)
 {
 	rina::ScopedLock g(lock_);
-	db_->removeObject(fqn);
+	db_->removeExpiredObjects(fqns);
 }
 
 // CLASS FlowStateObjectEncoder
@@ -2336,6 +3642,25 @@ void FlowStateObjectListEncoder::encode(const std::list<FlowStateObject> &obj,
 	gpb.SerializeToArray(serobj.message_, serobj.size_);
 }
 
+void FlowStateObjectListEncoder::append(const FlowStateObject &obj,
+					std::string& group)
+{
+	rina::messages::flowStateObject_t gpb;
+	unsigned int size;
+
+	fso_helpers::toGPB(obj, gpb);
+	size = gpb.ByteSize();
+
+	// A flow_state_objects field of the group: tag, length and object
+	group += (char) (rina::messages::flowStateObjectGroup_t::kFlowStateObjectsFieldNumber << 3 | 2);
+	while (size >= 0x80) {
+		group += (char) (size | 0x80);
+		size >>= 7;
+	}
+	group += (char) size;
+	gpb.AppendToString(&group);
+}
+
 void FlowStateObjectListEncoder::decode(const rina::ser_obj_t &serobj,
 					std::list<FlowStateObject> &des_obj)
 {
@@ -2353,4 +3678,39 @@ void FlowStateObjectListEncoder::decode(const rina::ser_obj_t &serobj,
 	}
 }
 
+void FlowStateObjectSummaryEncoder::encode(const FlowStateObjectSummary &obj,
+					   rina::ser_obj_t& serobj)
+{
+	rina::messages::flowStateObjectSummary_t gpb;
+	std::list<std::pair<uint64_t, unsigned int> >::const_iterator it;
+
+	gpb.set_after(obj.after);
+	gpb.set_last(obj.last);
+	gpb.set_complete(obj.complete);
+	for (it = obj.objects.begin(); it != obj.objects.end(); ++it) {
+		gpb.add_fingerprints(it->first);
+		gpb.add_sequence_numbers(it->second);
+	}
+
+	serobj.size_ = gpb.ByteSize();
+	serobj.message_ = new unsigned char[serobj.size_];
+	gpb.SerializeToArray(serobj.message_, serobj.size_);
+}
+
+void FlowStateObjectSummaryEncoder::decode(const rina::ser_obj_t &serobj,
+					   FlowStateObjectSummary &des_obj)
+{
+	rina::messages::flowStateObjectSummary_t gpb;
+	gpb.ParseFromArray(serobj.message_, serobj.size_);
+
+	des_obj.after = gpb.after();
+	des_obj.last = gpb.last();
+	des_obj.complete = gpb.complete();
+	for (int i = 0; i < gpb.fingerprints_size() &&
+			i < gpb.sequence_numbers_size(); i++) {
+		des_obj.objects.push_back(std::make_pair(gpb.fingerprints(i),
+							 gpb.sequence_numbers(i)));
+	}
+}
+
 }// namespace rinad
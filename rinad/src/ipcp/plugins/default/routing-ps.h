@@ -25,6 +25,7 @@
 
 #include <set>
 #include <stdint.h>
+#include <vector>
 #include <librina/internal-events.h>
 #include <librina/timer.h>
 
@@ -32,37 +33,6 @@
 
 namespace rinad {
 
-struct TreeNode {
-    std::string name;
-    int metric;
-    std::set<TreeNode*> chldel;
-    std::set<TreeNode*> chl;
-    TreeNode(){
-            name = std::string();
-            metric = UINT16_MAX;
-    }
-    TreeNode(const std::string &_name, const int &_metric){
-        name = _name;
-        metric = _metric;
-    }
-    bool operator == (const TreeNode &b) const
-    {
-        return name == b.name;
-    }
-    bool operator < (const TreeNode &b) const
-    {
-        return name < b.name;
-    }
-
-    ~TreeNode(){
-	std::set<TreeNode*>::iterator c;
-        for(c=chldel.begin(); c != chldel.end(); ++c){
-            delete *c;
-        }
-    }
-
-};
-
 class LinkStateRoutingPolicy;
 
 class LinkStateRoutingPs: public IRoutingPs {
@@ -86,8 +56,8 @@ public:
 	     const std::string& name2,
 	     int weight);
 	bool isVertexIn(const std::string& name) const;
-	std::string getOtherEndpoint(const std::string& name);
-	std::list<std::string> getEndpoints();
+	std::string getOtherEndpoint(const std::string& name) const;
+	std::list<std::string> getEndpoints() const;
 	bool operator==(const Edge & other) const;
 	bool operator!=(const Edge & other) const;
 	const std::string toString() const;
@@ -98,51 +68,77 @@ public:
 };
 
 class FlowStateObject;
+
+/// The N-1 flows that are up in both directions, built from the flow state
+/// objects in time linear in their number. Vertices are found by name and
+/// edges by their ends through open addressing hash tables, and a graph
+/// can be rebuilt in place, reusing its memory.
 class Graph {
 public:
 	Graph(const std::list<FlowStateObject>& flow_state_objects);
 	Graph();
-	~Graph();
 
-	std::list<Edge *> edges_;
-	std::list<std::string> vertices_;
+	/// Edges, in the order of the flow state objects that completed them
+	std::vector<Edge> edges_;
+	/// Vertices, in the order of the flow state objects they appear in
+	std::vector<std::string> vertices_;
+	/// Positions in vertices_ of the ends of every edge, two per edge
+	std::vector<unsigned int> edge_ends_;
 
 	void set_flow_state_objects(const std::list<FlowStateObject>& flow_state_objects);
 	bool contains_vertex(const std::string& name) const;
 	bool contains_edge(const std::string& name1,
 			   const std::string& name2) const;
+	/// Returns the position of the vertex called name, -1 if there is none
+	int vertex_id(const std::string& name) const;
 
 	void print() const;
 
 private:
-	struct CheckedVertex {
-		std::string name_;
-		int port_id_;
-		std::list<std::string> connections;
-
-		CheckedVertex(const std::string& name) {
-			name_ = name;
-			port_id_ = 0;
-		}
-
-		bool connection_contains_name(const std::string& name) {
-			std::list<std::string>::iterator it;
-			for(it = connections.begin(); it != connections.end(); ++it) {
-				if ((*it) == name) {
-					return true;
-				}
-			}
-
-			return false;
-		}
+	struct VertexBucket {
+		uint32_t hash;
+		int id;
+		VertexBucket() : hash(0), id(-1) {};
 	};
 
-	std::list<FlowStateObject> flow_state_objects_;
-	std::list<CheckedVertex *> checked_vertices_;
+	/// A pair of vertices, with its ids as key, the lowest first
+	struct LinkBucket {
+		uint64_t key;
+		bool used;
+		/// Only one of the two flow state objects is up so far
+		bool half;
+		bool edge;
+		LinkBucket() : key(0), used(false), half(false), edge(false) {};
+	};
 
-	void init_vertices();
-	CheckedVertex * get_checked_vertex(const std::string& name) const;
-	void init_edges();
+	std::vector<VertexBucket> vertex_buckets_;
+	std::vector<LinkBucket> link_buckets_;
+
+	unsigned int add_vertex(const std::string& name);
+	const LinkBucket * find_link(unsigned int id1, unsigned int id2) const;
+	LinkBucket * add_link(unsigned int id1, unsigned int id2);
+};
+
+/// Integer indexed copy of a Graph, built once per route computation.
+/// Vertex ids follow the alphabetical order of the vertex names, and
+/// order_ has the ids in the order of Graph::vertices_. The edges of
+/// vertex v are stored in compressed sparse row form: its neighbours are
+/// targets_[offsets_[v]] ... targets_[offsets_[v + 1] - 1], sorted by id
+/// and then by cost, reached with the costs in weights_.
+class CompactGraph {
+public:
+	CompactGraph() {};
+	CompactGraph(const Graph& graph);
+
+	/// Returns the id of the vertex called name, -1 if there is none
+	int id(const std::string& name) const;
+	void swap(CompactGraph& other);
+
+	std::vector<std::string> names_;
+	std::vector<unsigned int> order_;
+	std::vector<unsigned int> offsets_;
+	std::vector<unsigned int> targets_;
+	std::vector<int> weights_;
 };
 
 class IRoutingAlgorithm {
@@ -161,14 +157,16 @@ public:
 	virtual void computeShortestDistances(const Graph& graph,
 					      const std::string& source_name,
 				              std::map<std::string, int>& distances) = 0;
-};
-
-/// Contains the information of a predecessor, needed by the Dijkstra Algorithm
-class PredecessorInfo {
-public:
-	PredecessorInfo(const std::string& nPredecessor);
 
-	std::string predecessor_;
+	//Return the graph and the distances from the source used by the last
+	//computeRoutingTable call, if the algorithm keeps them and that call
+	//was for source_name on this graph
+	virtual bool lastShortestDistances(const Graph& graph,
+					   const std::string& source_name,
+					   const CompactGraph *& compact,
+					   const std::vector<int> *& distances) const {
+		return false;
+	};
 };
 
 /// The routing algorithm used to compute the PDU forwarding table is a Shortest
@@ -185,29 +183,91 @@ public:
 	void computeShortestDistances(const Graph& graph,
 				      const std::string& source_name,
 				      std::map<std::string, int>& distances);
+	bool lastShortestDistances(const Graph& graph,
+				   const std::string& source_name,
+				   const CompactGraph *& compact,
+				   const std::vector<int> *& distances) const;
+
+	/// Computes the distance from source to every vertex, INT_MAX if
+	/// not reached, and the vertex each shortest path comes from, -1
+	/// for the source and the vertices not reached. Only reads graph,
+	/// so it can run for several sources at once.
+	static void shortestPaths(const CompactGraph& graph,
+				  unsigned int source,
+				  std::vector<int>& distances,
+				  std::vector<int>& predecessors);
+
+protected:
+	/// Graph, source and shortest path tree of the last routing table
+	/// computation
+	CompactGraph graph_;
+	int source_;
+	std::vector<int> distances_;
+	std::vector<int> predecessors_;
+
+	void fillRoutingTable(const CompactGraph& compact,
+			      unsigned int source,
+			      const std::vector<int>& predecessors,
+			      std::list<rina::RoutingTableEntry *>& rt);
+};
+
+/// Dijkstra that keeps the shortest path tree of the last routing table
+/// computation. When only a few links have changed since, it repairs the
+/// distances of the subtrees hanging from the links whose cost went up and
+/// of the vertices that got closer through the links whose cost went down,
+/// as in the dynamic SPT algorithm of Ramalingam and Reps, and then picks
+/// again the predecessors around them. The tree is always the one a full
+/// computation would produce. It falls back to a full computation when the
+/// source or the set of vertices changes, when a link costs 0, or when more
+/// than one link in FULL_SPF_LINKS_PER_CHANGE (plus one) has changed.
+class IncrementalDijkstraAlgorithm : public DijkstraAlgorithm {
+public:
+	static const unsigned int FULL_SPF_LINKS_PER_CHANGE = 10;
+
+	IncrementalDijkstraAlgorithm();
+	void computeRoutingTable(const Graph& graph,
+	 	 	    	 const std::list<FlowStateObject>& fsoList,
+				 const std::string& source_name,
+				 std::list<rina::RoutingTableEntry *>& rt);
+
+	/// True if the last routing table was computed incrementally
+	bool incremental() const;
+
 private:
-	std::set<std::string> settled_nodes_;
-	std::set<std::string> unsettled_nodes_;
-	std::map<std::string, PredecessorInfo *> predecessors_;
-	std::map<std::string, int> distances_;
-
-	void execute(const Graph& graph, const std::string& source);
-	std::string getMinimum() const;
-	void findMinimalDistances (const Graph& graph, const std::string& node);
-	int getShortestDistance(const std::string& destination) const;
-	bool isNeighbor(Edge * edge, const std::string& node) const;
-	bool isSettled(const std::string& node) const;
-	std::string getNextHop(const std::string& name, const std::string& sourceName);
-	void clear();
+	/// A link whose cost changed, INT_MAX if it is not in a graph
+	struct LinkChange {
+		unsigned int u, v;
+		int old_weight, new_weight;
+	};
+
+	bool incremental_;
+
+	bool diff(const CompactGraph& graph, std::vector<LinkChange>& changes) const;
+	void update(const CompactGraph& graph,
+		    const std::vector<LinkChange>& changes);
+	int pickPredecessor(const CompactGraph& graph, unsigned int node) const;
 };
 
 /// The routing algorithm used to compute the PDU forwarding table is a Shortest
 /// Path First (SPF) algorithm using ECMP approach. Instances of the algorithm 
 /// are run independently and concurrently by all IPC processes in their forwarding 
 /// table generator component, upon detection of an N-1 flow allocation/deallocation/state change.
-class ECMPDijkstraAlgorithm : public IRoutingAlgorithm {
+/// Equal Cost MultiPath Dijkstra: the routing table entry of a destination
+/// has a next hop for every neighbour of the source that starts a shortest
+/// path to it. The next hops of a vertex are kept as a bitset over the
+/// neighbours of the source, the union of the ones of the vertices it is
+/// equally close through. Those are all settled before it, so a single SPF
+/// pass computes every set. When weighted, every next hop appears in the
+/// entry as many times as its share of the shortest paths to the
+/// destination, in lowest terms and up to MAX_WEIGHT times, so that the
+/// multipath PDU forwarding table policy splits the flows in that ratio
+/// (Unequal Cost MultiPath). The default PDU forwarding table policy keeps
+/// each port-id once, and so does not take weighted tables.
+class ECMPDijkstraAlgorithm : public DijkstraAlgorithm {
 public:
-	ECMPDijkstraAlgorithm();
+	static const unsigned int MAX_WEIGHT = 16;
+
+	ECMPDijkstraAlgorithm(bool weighted = false);
 	void computeRoutingTable(const Graph& graph,
 	 	 	    	 const std::list<FlowStateObject>& fsoList,
 				 const std::string& source_name,
@@ -217,26 +277,46 @@ public:
 				      std::map<std::string, int>& distances);
 
 private:
-	std::set<std::string> settled_nodes_;
-	std::set<std::string> unsettled_nodes_;
-	std::set<std::string> minimum_nodes_;
-	std::map<std::string, std::list<TreeNode *> > predecessors_;
-	std::map<std::string, int> distances_;
-	TreeNode* t;
-	void execute(const Graph& graph,
-		     const std::string& source);
-	void addRecursive(std::list<rina::RoutingTableEntry *> &table,
-			  int qos,
-			  const std::string& next,
-			  TreeNode * node);
-	std::list<rina::RoutingTableEntry *>::iterator findEntry(std::list<rina::RoutingTableEntry *> &table,
-							    	 const std::string& name);
-	void getMinimum();
-	void findMinimalDistances (const Graph& graph, TreeNode * pred);
-	int getShortestDistance(const std::string& destination) const;
-	bool isNeighbor(Edge * edge, const std::string& node) const;
-	bool isSettled(const std::string& node) const;
-	void clear();
+	bool weighted_;
+
+	/// The neighbours of the source, by id, and for every vertex the
+	/// words_ words of the bitset of the ones that start a shortest path
+	/// to it and, if weighted, how many shortest paths start through
+	/// each of them
+	std::vector<unsigned int> neighbors_;
+	unsigned int words_;
+	std::vector<uint32_t> next_hops_;
+	std::vector<double> paths_;
+
+	void execute(const Graph& graph, const std::string& source_name);
+	void addNextHops(unsigned int node, rina::RoutingTableEntry * entry) const;
+};
+
+/// A fixed set of threads that run a batch of tasks, numbered from 0, in
+/// parallel. The caller of run() takes tasks too, and gets control back
+/// once all of them have finished. Tasks must not throw.
+class RoutingWorkerPool {
+public:
+	RoutingWorkerPool(unsigned int workers);
+	~RoutingWorkerPool();
+
+	void run(void (*task)(void * arg, unsigned int index), void * arg,
+		 unsigned int tasks);
+	unsigned int workers() const;
+
+private:
+	static void * work(void * arg);
+	/// Runs the next task if there is one, called with the lock held
+	bool runNextTask();
+
+	rina::ConditionVariable cond_;
+	std::vector<rina::Thread *> threads_;
+	void (*task_)(void * arg, unsigned int index);
+	void * arg_;
+	unsigned int tasks_;
+	unsigned int next_;
+	unsigned int done_;
+	bool stop_;
 };
 
 class IResiliencyAlgorithm {
@@ -255,18 +335,94 @@ protected:
 	IRoutingAlgorithm& routing_algorithm;
 };
 
+/// Adds to the routing table entry of every destination X the neighbours
+/// N of the source that are loop free alternates towards it, that is
+/// dist(N, X) < dist(N, source) + dist(source, X). The distances from the
+/// source come from the last routing table computation when the routing
+/// algorithm keeps them, and those from the neighbours are computed by a
+/// pool of workers, one neighbour at a time.
 class LoopFreeAlternateAlgorithm : public IResiliencyAlgorithm {
 public:
-	LoopFreeAlternateAlgorithm(IRoutingAlgorithm& ra);
+	/// workers < 0 means one worker for every online CPU but the one
+	/// of the caller
+	LoopFreeAlternateAlgorithm(IRoutingAlgorithm& ra, int workers = -1);
 	void fortifyRoutingTable(const Graph& graph,
 				 const std::string& source_name,
 				 std::list<rina::RoutingTableEntry *>& rt);
 private:
-	void extendRoutingTableEntry(std::list<rina::RoutingTableEntry *>& rt,
-				     const std::string& target_name,
+	/// The distances from one neighbour of the source
+	struct NeighborTree {
+		const CompactGraph * graph;
+		unsigned int neighbor;
+		std::vector<int> distances;
+	};
+
+	RoutingWorkerPool workers_;
+
+	static void computeNeighborTree(void * arg, unsigned int index);
+	void extendRoutingTableEntry(rina::RoutingTableEntry * entry,
 				     const std::string& nexthop);
 };
 
+/// Computes a routing table for every QoS cube of the DIF, costing each
+/// link cost_scale * cost + hop_cost with the metric of the cube, and
+/// merges them into one whose entries carry the qos-id of their cube.
+/// Cubes with the same metric share one computation, and the computations
+/// of the different metrics run in parallel on a pool of workers.
+class QoSCubeRoutingAlgorithm : public IRoutingAlgorithm {
+public:
+	/// The algorithm used for every metric, as the routingAlgorithm
+	/// parameter of the policy. workers < 0 means one worker for every
+	/// online CPU but the one of the caller.
+	QoSCubeRoutingAlgorithm(const std::string& algorithm, bool incremental,
+				int workers = -1);
+	~QoSCubeRoutingAlgorithm();
+
+	void addQoSCube(unsigned int qos_id, int cost_scale, int hop_cost);
+	void computeRoutingTable(const Graph& graph,
+	 	 	    	 const std::list<FlowStateObject>& fsoList,
+				 const std::string& source_name,
+				 std::list<rina::RoutingTableEntry *>& rt);
+
+	/// With the metric of the first QoS cube
+	void computeShortestDistances(const Graph& graph,
+				      const std::string& source_name,
+				      std::map<std::string, int>& distances);
+
+	unsigned int metrics() const;
+
+private:
+	struct Metric {
+		int cost_scale;
+		int hop_cost;
+		IRoutingAlgorithm * algorithm;
+		/// The graph with the link costs of the metric, unless they
+		/// are the advertised ones
+		Graph graph;
+		std::list<rina::RoutingTableEntry *> rt;
+		bool failed;
+	};
+
+	/// The computation in progress
+	struct Computation {
+		QoSCubeRoutingAlgorithm * algorithm;
+		const Graph * graph;
+		const std::list<FlowStateObject> * fsos;
+		const std::string * source;
+	};
+
+	std::string algorithm_;
+	bool incremental_;
+	std::vector<Metric *> metrics_;
+	/// The qos-id of every cube and the position of its metric in metrics_
+	std::vector<std::pair<unsigned int, unsigned int> > cubes_;
+	RoutingWorkerPool workers_;
+
+	/// The graph with the link costs of the metric
+	static const Graph& weigh(const Graph& graph, Metric& metric);
+	static void computeMetric(void * arg, unsigned int index);
+};
+
 /// The object exchanged between IPC Processes to disseminate the state of
 /// one N-1 flow supporting the IPC Processes in the DIF. This is the RIB
 /// target object when the PDU Forwarding Table Generator wants to send
@@ -307,9 +463,16 @@ public:
 	// Flow up (true) or down (false)
 	bool state_up;
 
-	// Age of this FSO (in seconds)
+	// Age of this FSO (in seconds), brought up to date by the FSDB when
+	// the object is read out of it
 	unsigned int age;
 
+	// The age timer pulse in which the FSO had age 0
+	int64_t birth;
+
+	// The age timer pulse of the expiry bucket of the FSO, -1 if none
+	int64_t expiry;
+
 	// The port_id assigned by the neighbor IPC Process to the N-1 flow
 	unsigned int cost;
 
@@ -332,6 +495,152 @@ public:
 	std::list<unsigned int> neighbor_addresses;
 };
 
+/// The ages of the flow state objects, kept as the age timer pulse in
+/// which every object had age 0 instead of being incremented every pulse.
+/// Objects are bucketed by the pulse in which they reach the maximum age,
+/// so every pulse only looks at the objects that may expire. An object
+/// whose age is reset stays in its bucket, and is moved to a later one when
+/// the bucket comes due. Not thread safe, the flow state objects that own it
+/// serialize the calls.
+class FlowStateAges {
+public:
+	FlowStateAges();
+
+	/// Objects already scheduled keep the expiry of the previous maximum
+	/// age until it comes due
+	void set_maximum_age(unsigned int max_age);
+	unsigned int get_maximum_age() const;
+
+	/// Sets the age of the object, scheduling it to expire when it
+	/// reaches the maximum age
+	void setAge(FlowStateObject * fso, unsigned int age);
+
+	/// The age of the object in the current pulse
+	unsigned int getAge(const FlowStateObject& fso) const;
+
+	void objectRemoved(FlowStateObject * fso);
+
+	/// Advances one pulse, and appends to expired the objects that have
+	/// reached the maximum age since their buckets last came due
+	void increment(std::list<FlowStateObject *>& expired);
+
+private:
+	typedef std::map<int64_t, std::set<FlowStateObject *> > BucketMap;
+
+	int64_t pulse_;
+	unsigned int max_age_;
+	BucketMap buckets_;
+
+	void schedule(FlowStateObject * fso, int64_t expiry);
+};
+
+/// The sequence numbers of the flow state objects with fingerprints in a
+/// range, like the sequence number PDUs of IS-IS. A complete summary lists
+/// all the objects of the sender in the range, so that the receiver can
+/// tell which ones the sender is missing. A partial summary only lists some
+/// objects, to request the ones the sender has older versions of.
+class FlowStateObjectSummary {
+public:
+	FlowStateObjectSummary();
+
+	// The range of fingerprints (after, last] of the summary
+	uint64_t after;
+	uint64_t last;
+
+	// All the objects of the sender in the range are listed
+	bool complete;
+
+	// Fingerprints of the objects and their sequence numbers, 0 if missing
+	std::list<std::pair<uint64_t, unsigned int> > objects;
+};
+
+/// The encoded flow state object groups of a propagation round. Ports
+/// with the same objects to send share the same messages.
+class FlowStateMessages {
+public:
+	FlowStateMessages();
+
+	std::vector<std::string> messages;
+
+	// The positions in messages of the ones to send on each port
+	std::map<int, std::list<unsigned int> > ports;
+
+	// Objects encoded, once whatever the number of ports they go to
+	unsigned int objects;
+};
+
+/// The flow state objects that every neighbor is yet to receive, kept as
+/// a bit per object and port like the send routing message flags of IS-IS.
+/// Objects are identified by the 64 bit hash of their name, which summaries
+/// carry instead of the names. Not thread safe, the flow state objects that
+/// own it serialize the calls.
+class FlowStateDeltas {
+public:
+	FlowStateDeltas();
+
+	void objectAdded(FlowStateObject * fso);
+	void objectRemoved(FlowStateObject * fso);
+
+	/// Starts tracking the objects to send on port
+	void addPort(int port);
+
+	/// Stops tracking the ports not in ports and starts tracking the new ones
+	void setPorts(const std::list<int>& ports);
+
+	/// The object has to be sent on all the ports but avoid_port
+	void objectModified(FlowStateObject * fso, int avoid_port);
+
+	/// Sets whether the object has to be sent on port
+	void setPending(FlowStateObject * fso, int port, bool pending);
+
+	/// All the objects have to be sent on port
+	void setAllPending(int port);
+
+	/// Encodes the objects to send on port, or on all the ports if port
+	/// is negative, in groups of up to max_objects objects and forgets
+	/// them. Every object is encoded once, and ports with the same objects
+	/// to send get the same groups.
+	void getMessages(int port, unsigned int max_objects,
+			 FlowStateMessages& messages);
+
+	/// Complete summaries of all the objects, of up to max_objects each
+	void getSummaries(unsigned int max_objects,
+			  std::list<FlowStateObjectSummary>& summaries) const;
+
+	/// Marks the objects that the neighbor on port lacks, and fills
+	/// request with the ones it has newer versions of
+	void processSummary(const FlowStateObjectSummary& summary, int port,
+			    FlowStateObjectSummary& request);
+
+	unsigned int pending(int port) const;
+
+	/// The FNV-1a hash of the name of the object, never 0
+	static uint64_t fingerprint(const FlowStateObject& fso);
+
+private:
+	struct Entry {
+		Entry() : fso(0), dirty(false) {};
+
+		FlowStateObject * fso;
+		/// Bit i is set if the object has to be sent on the port of
+		/// slot i
+		std::vector<bool> pending;
+		/// The object is in dirty_
+		bool dirty;
+	};
+	typedef std::map<uint64_t, Entry> ObjectMap;
+
+	ObjectMap objects_;
+	/// The slot of the pending bits of every port
+	std::map<int, unsigned int> slots_;
+	std::vector<unsigned int> free_slots_;
+	/// Fingerprints of the objects that may have pending bits set
+	std::vector<uint64_t> dirty_;
+
+	void setPending(ObjectMap::iterator it, unsigned int slot, bool pending);
+	void removePort(std::map<int, unsigned int>::iterator it);
+};
+
 class FlowStateManager;
 /// A single flow state object
 class FlowStateRIBObject: public rina::rib::RIBObj {
@@ -350,14 +659,16 @@ public:
 };
 
 class FlowStateObjects;
+/// Removes the objects that expired in the same age timer pulse
 class KillFlowStateObjectTimerTask : public rina::TimerTask {
 public:
-	KillFlowStateObjectTimerTask(LinkStateRoutingPolicy *ps, std::string fqn);
+	KillFlowStateObjectTimerTask(LinkStateRoutingPolicy *ps,
+				     const std::list<std::string>& fqns);
 	~KillFlowStateObjectTimerTask() throw(){};
 	void run();
 
 private:
-	std::string fqn_;
+	std::list<std::string> fqns_;
 	LinkStateRoutingPolicy* ps_;
 };
 
@@ -374,35 +685,54 @@ public:
 				   unsigned int address,
 				   bool neighbor);
 	bool addObject(const FlowStateObject& object);
-	void deprecateObject(const std::string& fqn, 
-			     unsigned int max_age);
+	void deprecateObject(const std::string& fqn);
+	void deprecateObject(FlowStateObject * fso);
 	void deprecateObjects(const std::string& neigh_name,
-			      const std::string& name,
-			      unsigned int max_age);
+			      const std::string& name);
 	void updateCost(const std::string& neigh_name,
 			      const std::string& name,
 			      unsigned int cost);
 	void deprecateObjectsWithName(const std::string& name,
-				      unsigned int max_age,
 				      bool neighbor);
 	FlowStateObject * getObject(const std::string& fqn);
-	void getModifiedFSOs(std::list<FlowStateObject *>& result);
 	void getAllFSOs(std::list<FlowStateObject>& result);
-	void incrementAge(unsigned int max_age,
-			  rina::Timer* timer);
+	/// Advances the age of all the objects by one pulse, and schedules
+	/// the removal of the ones that reach the maximum age
+	void incrementAge(rina::Timer* timer);
+	void setAge(FlowStateObject * fso, unsigned int age);
+	void set_maximum_age(unsigned int max_age);
 	void updateObject(const std::string& fqn, 
 			  unsigned int avoid_port);
 	void encodeAllFSOs(rina::ser_obj_t& obj);
-	void getAllFSOsForPropagation(std::list< std::list<FlowStateObject> >& fsos,
-				      unsigned int max_objects);
+	/// Sets whether the neighbor on port is yet to receive the object
+	void setPending(const std::string& fqn, int port, bool pending);
+	/// Hands the modified objects to the ports but the ones they came
+	/// from, and encodes the objects to send on every port
+	void prepareForPropagation(const std::list<int>& ports,
+				   unsigned int max_objects,
+				   FlowStateMessages& messages);
+	/// Encodes all the objects, to send them on port
+	void getAllFSOsForPropagation(int port,
+				      unsigned int max_objects,
+				      FlowStateMessages& messages);
+	void getSummaries(unsigned int max_objects,
+			  std::list<FlowStateObjectSummary>& summaries);
+	void processSummary(const FlowStateObjectSummary& summary, int port,
+			    FlowStateObjectSummary& request);
 	bool is_modified() const;
 	void has_modified(bool modified);
 	void set_wait_until_remove_object(unsigned int wait_object);
 	void removeObject(const std::string& fqn);
+	/// Removes the objects that are still being erased, in one pass
+	void removeExpiredObjects(const std::list<std::string>& fqns);
 
 private:
 	void addCheckedObject(const FlowStateObject& object);
+	void deprecateCheckedObject(FlowStateObject * fso);
+	void removeCheckedObject(std::map<std::string, FlowStateObject*>::iterator it);
 	std::map<std::string,FlowStateObject*> objects;
+	FlowStateDeltas deltas_;
+	FlowStateAges ages_;
 	//Signals a modification in the FlowStateDB
 	bool modified_;
 	LinkStateRoutingPolicy * ps_;
@@ -442,6 +772,26 @@ private:
 	LinkStateRoutingPolicy * ps_;
 };
 
+/// The summary of the flow state objects of a neighbor, written to ask
+/// for the objects it has newer versions of than the IPC Process
+class FlowStateSummaryRIBObject: public rina::rib::RIBObj {
+public:
+	FlowStateSummaryRIBObject(LinkStateRoutingPolicy * ps);
+	void write(const rina::cdap_rib::con_handle_t &con,
+		   const std::string& fqn,
+		   const std::string& clas,
+		   const rina::cdap_rib::filt_info_t &filt,
+		   const int invoke_id,
+		   const rina::ser_obj_t &obj_req,
+		   rina::ser_obj_t &obj_reply,
+		   rina::cdap_rib::res_info_t& res);
+
+	const static std::string clazz_name;
+	const static std::string object_name;
+private:
+	LinkStateRoutingPolicy * ps_;
+};
+
 /// The subset of the RIB that contains all the Flow State objects known by the IPC Process.
 /// It exists only in the PDU forwarding table generator. It is used as an input to calculate
 /// the routing and forwarding tables. The FSDB is generated by the operations on FSOs received
@@ -482,19 +832,23 @@ public:
 	void updateCost(const std::string& neigh_name,
 			const std::string& name,
 			unsigned int cost);
-	std::map <int, std::list<FlowStateObject*> > prepareForPropagation
-	        (const std::list<rina::FlowInformation>& flows);
 	void incrementAge();
 	void updateObjects(const std::list<FlowStateObject>& newObjects,
 			   unsigned int avoidPort);
-	void prepareForPropagation(std::map<int, std::list< std::list<FlowStateObject> > >& to_propagate,
-				   unsigned int max_objects) const;
+	void prepareForPropagation(const std::list<int>& ports,
+				   unsigned int max_objects,
+				   FlowStateMessages& messages) const;
 	void encodeAllFSOs(rina::ser_obj_t& obj) const;
 	void getAllFSOs(std::list<FlowStateObject>& list) const;
 	bool tableUpdate() const;
-	void removeObject(const std::string& fqn);
-	void getAllFSOsForPropagation(std::list< std::list<FlowStateObject> >& fsos,
-				      unsigned int max_objects);
+	void removeExpiredObjects(const std::list<std::string>& fqns);
+	void getAllFSOsForPropagation(int port,
+				      unsigned int max_objects,
+				      FlowStateMessages& messages);
+	void getSummaries(unsigned int max_objects,
+			  std::list<FlowStateObjectSummary>& summaries) const;
+	void processSummary(const FlowStateObjectSummary& summary, int port,
+			    FlowStateObjectSummary& request);
 
 	//Force a routing table update;
 	void force_table_update();
@@ -590,6 +944,13 @@ public:
 	static const std::string WAIT_UNTIL_DEPRECATE_OLD_ADDRESS;
 	static const std::string ROUTING_ALGORITHM;
 	static const std::string MAXIMUM_OBJECTS_PER_ROUTING_UPDATE;
+	static const std::string INCREMENTAL_SPF;
+	static const std::string FSO_SUMMARIES;
+	static const std::string QOS_CUBE_ROUTING;
+	static const std::string ROUTING_WORKERS;
+	/// Followed by the qos-id of the cube
+	static const std::string QOS_CUBE_COST_SCALE;
+	static const std::string QOS_CUBE_HOP_COST;
 
         static const int PULSES_UNTIL_FSO_EXPIRATION_DEFAULT = 100000;
         static const int WAIT_UNTIL_READ_CDAP_DEFAULT = 5001;
@@ -600,8 +961,10 @@ public:
         static const long WAIT_UNTIL_REMOVE_OBJECT_DEFAULT = 2300;
         static const long WAIT_UNTIL_DEPRECATE_OLD_ADDRESS_DEFAULT = 10000;
         static const unsigned int MAX_OBJECTS_PER_ROUTING_UPDATE_DEFAULT = 15;
+        static const unsigned int MAX_OBJECTS_PER_SUMMARY = 350;
         static const std::string DIJKSTRA_ALG;
         static const std::string ECMP_DIJKSTRA_ALG;
+        static const std::string UCMP_DIJKSTRA_ALG;
 
 	LinkStateRoutingPolicy(IPCProcess * ipcp);
 	~LinkStateRoutingPolicy();
@@ -646,7 +1009,11 @@ public:
 	void updateObjects(const std::list<FlowStateObject>& newObjects,
 			   unsigned int avoidPort);
 
-	void removeFlowStateObject(const std::string& fqn);
+	/// Sends the objects the neighbor on port lacks in the next
+	/// propagation, and asks it for the ones it has newer versions of
+	void processSummary(const FlowStateObjectSummary& summary, int port);
+
+	void removeFlowStateObjects(const std::list<std::string>& fqns);
 
 	rina::Timer *timer_;
 private:
@@ -658,12 +1025,24 @@ private:
 	unsigned int wait_until_deprecate_address_;
 	unsigned int maximum_age_;
 	unsigned int max_objects_per_rupdate_;
+	/// Send new neighbors summaries of the flow state objects instead
+	/// of all of them
+	bool fso_summaries_;
 	bool test_;
 	FlowStateManager *db_;
+	/// Rebuilt in place from the flow state objects on every routing
+	/// table update
+	Graph graph_;
 	rina::Lockable lock_;
 
 	void subscribeToEvents();
 
+	IRoutingAlgorithm * createQoSCubeRoutingAlgorithm(const rina::PolicyConfig& psconf,
+							  const std::list<rina::QoSCube*>& cubes,
+							  const std::string& routing_alg,
+							  bool incremental,
+							  int workers);
+
 	/// The Resource Allocator has deallocated an existing N-1 flow dedicated to data
 	/// transfer. If there is a pending flow allocation over this N-1 flow, it has to
 	/// be erased from the list of pending flow allocations. Otherwise, the Flow State
@@ -699,6 +1078,10 @@ private:
 
 	void processNeighborAddressChangeEvent(rina::NeighborAddressChangeEvent * event);
 
+	void sendMessages(const FlowStateMessages& messages);
+
+	void sendSummary(const FlowStateObjectSummary& summary, int port);
+
 	void printNhopTable(std::list<rina::RoutingTableEntry *>& rt);
 
 	void populateAddresses(std::list<rina::RoutingTableEntry *>& rt,
@@ -721,6 +1104,18 @@ public:
 		rina::ser_obj_t& serobj);
 	void decode(const rina::ser_obj_t &serobj, 
 		std::list<FlowStateObject> &des_obj);
+	/// Appends obj to the encoded group, so that the encoding of an
+	/// object can be reused in many groups
+	void append(const FlowStateObject &obj, std::string& group);
+};
+
+class FlowStateObjectSummaryEncoder:
+	public rina::Encoder<FlowStateObjectSummary> {
+public:
+	void encode(const FlowStateObjectSummary &obj,
+		rina::ser_obj_t& serobj);
+	void decode(const rina::ser_obj_t &serobj,
+		FlowStateObjectSummary &des_obj);
 };
 
 }
@@ -0,0 +1,254 @@
+//
+// Synthetic topologies for the link-state routing benchmarks
+//
+// Every generator appends the N-1 flows between numbered IPCPs of a
+// topology to a vector of links, with a fixed seed, so that all runs and
+// all benchmarks use the same graphs.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#ifndef IPCP_ROUTING_TOPOLOGIES_HH
+#define IPCP_ROUTING_TOPOLOGIES_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "routing-ps.h"
+
+inline std::string ipcp_name(int i)
+{
+	std::stringstream ss;
+
+	ss << "ipcp-" << i;
+	return ss.str();
+}
+
+struct Link {
+	int a, b;
+	unsigned int cost;
+	bool up;
+};
+
+// A ring where every IPCP also has a chord to a random IPCP
+inline void ring_with_chords(int ipcps, std::vector<Link>& links)
+{
+	unsigned int seed = ipcps;
+	Link link;
+
+	link.up = true;
+	for (int i = 0; i < ipcps; i++) {
+		link.a = i;
+		link.b = (i + 1) % ipcps;
+		link.cost = 1 + rand_r(&seed) % 4;
+		links.push_back(link);
+		link.b = rand_r(&seed) % ipcps;
+		link.cost = 1 + rand_r(&seed) % 4;
+		links.push_back(link);
+	}
+}
+
+// A square grid with unit costs, where IPCP i is in row i / side
+inline void grid(int ipcps, std::vector<Link>& links)
+{
+	int side = 1;
+	Link link;
+
+	while ((side + 1) * (side + 1) <= ipcps) {
+		side++;
+	}
+
+	link.cost = 1;
+	link.up = true;
+	for (int i = 0; i < side * side; i++) {
+		link.a = i;
+		if (i % side < side - 1) {
+			link.b = i + 1;
+			links.push_back(link);
+		}
+		if (i / side < side - 1) {
+			link.b = i + side;
+			links.push_back(link);
+		}
+	}
+}
+
+// The biggest k-ary fat tree with unit costs of up to ipcps IPCPs, hosts
+// included: (k/2)^2 core switches, k pods of k/2 aggregation and k/2 edge
+// switches, and k/2 hosts per edge switch. Core switch c is linked to the
+// aggregation switch c / (k/2) of every pod.
+inline void fat_tree(int ipcps, std::vector<Link>& links)
+{
+	int k = 2, half, cores, pod, agg, edge, hosts;
+	Link link;
+
+	while (5 * (k + 2) * (k + 2) / 4 + (k + 2) * (k + 2) * (k + 2) / 4 <= ipcps) {
+		k += 2;
+	}
+	half = k / 2;
+	cores = half * half;
+	hosts = cores + k * k;
+
+	link.cost = 1;
+	link.up = true;
+	for (int p = 0; p < k; p++) {
+		pod = cores + p * k;
+		for (int a = 0; a < half; a++) {
+			agg = pod + a;
+			for (int c = 0; c < half; c++) {
+				link.a = a * half + c;
+				link.b = agg;
+				links.push_back(link);
+			}
+			for (int e = 0; e < half; e++) {
+				link.a = agg;
+				link.b = pod + half + e;
+				links.push_back(link);
+			}
+		}
+		for (int e = 0; e < half; e++) {
+			edge = pod + half + e;
+			for (int h = 0; h < half; h++) {
+				link.a = edge;
+				link.b = hosts + (p * half + e) * half + h;
+				links.push_back(link);
+			}
+		}
+	}
+}
+
+// IPCPs at random points of the unit square, linked to the ones closer
+// than the radius that gives them degree neighbours on average, with
+// costs from 1 to 4 growing with the distance
+inline void random_geometric(int ipcps, int degree, std::vector<Link>& links)
+{
+	unsigned int seed = ipcps;
+	double radius = std::sqrt(degree / (M_PI * ipcps));
+	int side = (int) (1 / radius);
+	std::vector<std::vector<int> > cells(side * side);
+	std::vector<double> x(ipcps), y(ipcps);
+	int cx, cy, nx, ny;
+	double dx, dy, d;
+	Link link;
+
+	link.up = true;
+	for (int i = 0; i < ipcps; i++) {
+		x[i] = rand_r(&seed) / (RAND_MAX + 1.0);
+		y[i] = rand_r(&seed) / (RAND_MAX + 1.0);
+		cells[(int) (y[i] * side) * side + (int) (x[i] * side)].push_back(i);
+	}
+
+	// Cells are at least radius wide, so neighbours are in adjacent cells
+	for (int i = 0; i < ipcps; i++) {
+		cx = x[i] * side;
+		cy = y[i] * side;
+		for (ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, side - 1); ny++) {
+			for (nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, side - 1); nx++) {
+				const std::vector<int>& cell = cells[ny * side + nx];
+
+				for (unsigned int j = 0; j < cell.size(); j++) {
+					if (cell[j] <= i) {
+						continue;
+					}
+					dx = x[i] - x[cell[j]];
+					dy = y[i] - y[cell[j]];
+					d = std::sqrt(dx * dx + dy * dy);
+					if (d >= radius) {
+						continue;
+					}
+					link.a = i;
+					link.b = cell[j];
+					link.cost = 1 + (unsigned int) (4 * d / radius);
+					links.push_back(link);
+				}
+			}
+		}
+	}
+}
+
+// A Barabasi-Albert graph: every IPCP links to m of the previous ones,
+// picked with a probability proportional to their degree, with costs
+// from 1 to 4
+inline void scale_free(int ipcps, int m, std::vector<Link>& links)
+{
+	unsigned int seed = ipcps;
+	std::vector<int> ends, targets;
+	Link link;
+	int target;
+
+	link.up = true;
+	for (int i = 1; i <= m && i < ipcps; i++) {
+		for (int j = 0; j < i; j++) {
+			link.a = i;
+			link.b = j;
+			link.cost = 1 + rand_r(&seed) % 4;
+			links.push_back(link);
+			ends.push_back(i);
+			ends.push_back(j);
+		}
+	}
+
+	for (int i = m + 1; i < ipcps; i++) {
+		targets.clear();
+		while ((int) targets.size() < m) {
+			target = ends[rand_r(&seed) % ends.size()];
+			if (std::find(targets.begin(), targets.end(),
+				      target) == targets.end()) {
+				targets.push_back(target);
+			}
+		}
+		for (int j = 0; j < m; j++) {
+			link.a = i;
+			link.b = targets[j];
+			link.cost = 1 + rand_r(&seed) % 4;
+			links.push_back(link);
+			ends.push_back(i);
+			ends.push_back(targets[j]);
+		}
+	}
+}
+
+// Adds the flow state objects of both ends of every N-1 flow
+inline void flow_state_objects(const std::vector<Link>& links,
+			       std::list<rinad::FlowStateObject>& fsos)
+{
+	std::vector<Link>::const_iterator it;
+
+	for (it = links.begin(); it != links.end(); ++it) {
+		fsos.push_back(rinad::FlowStateObject(ipcp_name(it->a),
+						      ipcp_name(it->b),
+						      it->cost, it->up, 1, 1));
+		fsos.push_back(rinad::FlowStateObject(ipcp_name(it->b),
+						      ipcp_name(it->a),
+						      it->cost, it->up, 1, 1));
+	}
+}
+
+inline void free_routing_table(std::list<rina::RoutingTableEntry *>& rt)
+{
+	std::list<rina::RoutingTableEntry *>::iterator it;
+
+	for (it = rt.begin(); it != rt.end(); ++it) {
+		delete *it;
+	}
+	rt.clear();
+}
+
+#endif
@@ -20,11 +20,15 @@
 // MA  02110-1301  USA
 //
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 
 #define IPCP_MODULE "lsr-tests"
 #include "../../ipcp-logging.h"
 
+#include "ipcp/resource-allocator.h"
 #include "routing-ps.h"
 
 int ipcp_id = 1;
@@ -419,9 +423,9 @@ int Graph_Contruct2Nodes_True() {
     	return -1;
     }
 
-    std::list<rinad::Edge*>::const_iterator it;
+    std::vector<rinad::Edge>::const_iterator it;
     for (it = g.edges_.begin(); it != g.edges_.end(); ++it) {
-    	if (!(*it)->isVertexIn("a") || !(*it)->isVertexIn("b")) {
+    	if (!it->isVertexIn("a") || !it->isVertexIn("b")) {
     		return -1;
     	}
     }
@@ -508,6 +512,44 @@ int Graph_ContructTriangleGraph_True() {
 	return 0;
 }
 
+// Rebuilding a graph in place, with different flow state objects, gives
+// the same graph as building it from scratch
+int Graph_RebuildInPlace_True() {
+	std::list<rinad::FlowStateObject> objects;
+	rinad::Graph g;
+
+	objects.push_back(rinad::FlowStateObject("a", "b", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("b", "a", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("b", "c", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("c", "b", 1, true, 1, 1));
+	g.set_flow_state_objects(objects);
+	if (g.edges_.size() != 2 || !g.contains_edge("c", "b")) {
+		return -1;
+	}
+
+	objects.clear();
+	objects.push_back(rinad::FlowStateObject("d", "a", 3, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("a", "d", 3, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("a", "c", 2, false, 1, 1));
+	objects.push_back(rinad::FlowStateObject("c", "a", 2, true, 1, 1));
+	g.set_flow_state_objects(objects);
+
+	rinad::Graph fresh(objects);
+	if (g.vertices_ != fresh.vertices_ || g.vertices_.size() != 3 ||
+			g.vertices_[0] != "d" || g.edges_.size() != 1 ||
+			g.edges_[0] != fresh.edges_[0] ||
+			g.edges_[0].weight_ != 3) {
+		return -1;
+	}
+
+	if (g.contains_vertex("b") || g.contains_edge("b", "c") ||
+			g.contains_edge("a", "c") || !g.contains_edge("a", "d")) {
+		return -1;
+	}
+
+	return 0;
+}
+
 int test_graph () {
 	int result = 0;
 
@@ -553,6 +595,13 @@ int test_graph () {
 	}
 	LOG_IPCP_INFO("Graph_ContructTriangleGraph_True test passed");
 
+	result = Graph_RebuildInPlace_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("Graph_RebuildInPlace_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("Graph_RebuildInPlace_True test passed");
+
 	return result;
 }
 
@@ -741,15 +790,199 @@ int getRoutingTable_MoreGraphEntries_True(bool lfa) {
 		std::cout << "}" << std::endl;
 	}
 
-	if (lfa) {
+	if (lfa && result == 0) {
+		std::map<std::string, std::string> exp_alts;
+
+		// The next hop first, then the other loop free alternates
+		exp_alts["b"] = "b";
+		exp_alts["c"] = "c";
+		exp_alts["d"] = "d";
+		exp_alts["e"] = "b d";
+		exp_alts["f"] = "c d";
+		exp_alts["g"] = "b c d";
+
 		resalg = new rinad::LoopFreeAlternateAlgorithm(*routingAlgorithm);
 		resalg->fortifyRoutingTable(graph, "a", rtable);
+		delete resalg;
+
+		for (std::list<rina::RoutingTableEntry *>::iterator
+				rit = rtable.begin(); rit != rtable.end(); rit++) {
+			const rina::NHopAltList& alts = (*rit)->nextHopNames.front();
+			std::string names;
+
+			for (std::list<rina::IPCPNameAddresses>::const_iterator
+				lit = alts.alts.begin(); lit != alts.alts.end(); lit++) {
+				names += (names.empty() ? "" : " ") + lit->name;
+			}
+			if (names != exp_alts[(*rit)->destination.name]) {
+				std::cout << "LFA next hops towards "
+					  << (*rit)->destination.name << ": "
+					  << names << std::endl;
+				result = -1;
+			}
+		}
+	}
+
+	delete routingAlgorithm;
+	return result;
+}
+
+// In a grid with unit costs, ties between equally short paths go to the
+// neighbour settled first, that is the one with the lowest name
+int getRoutingTable_GridTies_True() {
+	std::list<rinad::FlowStateObject> objects;
+	rinad::IRoutingAlgorithm * routingAlgorithm;
+	std::list<rina::RoutingTableEntry *> rtable;
+	std::list<rina::RoutingTableEntry *>::iterator it;
+	std::map<std::string, int> distances;
+	std::string name;
+	int result = 0;
+
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			std::stringstream ss, right, down;
+
+			ss << "n" << i << j;
+			right << "n" << i << j + 1;
+			down << "n" << i + 1 << j;
+			if (j < 3) {
+				objects.push_back(rinad::FlowStateObject(ss.str(),
+						right.str(), 1, true, 1, 1));
+				objects.push_back(rinad::FlowStateObject(right.str(),
+						ss.str(), 1, true, 1, 1));
+			}
+			if (i < 3) {
+				objects.push_back(rinad::FlowStateObject(ss.str(),
+						down.str(), 1, true, 1, 1));
+				objects.push_back(rinad::FlowStateObject(down.str(),
+						ss.str(), 1, true, 1, 1));
+			}
+		}
+	}
+
+	rinad::Graph graph(objects);
+	routingAlgorithm = new rinad::DijkstraAlgorithm();
+
+	routingAlgorithm->computeRoutingTable(graph, objects, "n00", rtable);
+	if (rtable.size() != 15) {
+		result = -1;
+	}
+
+	for (it = rtable.begin(); it != rtable.end(); ++it) {
+		name = (*it)->destination.name;
+		if ((*it)->nextHopNames.front().alts.front().name !=
+				(name[2] == '0' ? "n10" : "n01")) {
+			LOG_IPCP_ERR("Wrong next hop towards %s", name.c_str());
+			result = -1;
+		}
+		delete *it;
+	}
+
+	routingAlgorithm->computeShortestDistances(graph, "n00", distances);
+	if (distances.size() != 16 || distances["n33"] != 6 ||
+			distances["n00"] != 0) {
+		result = -1;
 	}
 
 	delete routingAlgorithm;
 	return result;
 }
 
+// Compares the first next hop of two routing tables, and frees them
+static bool sameRoutingTables(std::list<rina::RoutingTableEntry *>& rt1,
+			      std::list<rina::RoutingTableEntry *>& rt2)
+{
+	std::list<rina::RoutingTableEntry *>::iterator it1, it2;
+	bool same = rt1.size() == rt2.size();
+
+	for (it1 = rt1.begin(), it2 = rt2.begin(); same && it1 != rt1.end();
+			++it1, ++it2) {
+		same = (*it1)->destination.name == (*it2)->destination.name &&
+			(*it1)->nextHopNames.front().alts.front().name ==
+			(*it2)->nextHopNames.front().alts.front().name;
+	}
+
+	for (it1 = rt1.begin(); it1 != rt1.end(); ++it1)
+		delete *it1;
+	for (it2 = rt2.begin(); it2 != rt2.end(); ++it2)
+		delete *it2;
+	rt1.clear();
+	rt2.clear();
+
+	return same;
+}
+
+// Changes the cost or the state of a few random links of a ring with
+// chords, one round after another, and checks that the incremental
+// algorithm computes the same routing tables as a full computation
+int getRoutingTable_IncrementalSameAsFull_True() {
+	const int ipcps = 60;
+	const int links = 2 * ipcps;
+	int ends[links][2], costs[links];
+	bool up[links];
+	rinad::DijkstraAlgorithm full;
+	rinad::IncrementalDijkstraAlgorithm incremental;
+	std::list<rina::RoutingTableEntry *> rt1, rt2;
+	unsigned int seed = 1;
+	int incremental_rounds = 0;
+
+	for (int i = 0; i < links; i++) {
+		ends[i][0] = i % ipcps;
+		ends[i][1] = i < ipcps ? (i + 1) % ipcps : rand_r(&seed) % ipcps;
+		costs[i] = 1 + rand_r(&seed) % 4;
+		up[i] = true;
+	}
+
+	for (int round = 0; round < 300; round++) {
+		std::list<rinad::FlowStateObject> objects;
+		std::stringstream source;
+
+		for (int i = 0; i < links; i++) {
+			std::stringstream a, b;
+
+			a << "ipcp-" << ends[i][0];
+			b << "ipcp-" << ends[i][1];
+			objects.push_back(rinad::FlowStateObject(a.str(), b.str(),
+					costs[i], up[i], 1, 1));
+			objects.push_back(rinad::FlowStateObject(b.str(), a.str(),
+					costs[i], up[i], 1, 1));
+		}
+		rinad::Graph graph(objects);
+
+		// Move to another source once in a while
+		source << "ipcp-" << round / 100;
+		full.computeRoutingTable(graph, objects, source.str(), rt1);
+		incremental.computeRoutingTable(graph, objects, source.str(), rt2);
+		if (!sameRoutingTables(rt1, rt2)) {
+			LOG_IPCP_ERR("Different routing tables in round %d", round);
+			return -1;
+		}
+		if (incremental.incremental()) {
+			incremental_rounds++;
+		}
+
+		// Mostly single link changes, sometimes a burst of them
+		int changes = round % 50 == 49 ? links / 2 : 1 + round % 3;
+		for (int j = 0; j < changes; j++) {
+			int i = rand_r(&seed) % links;
+
+			if (rand_r(&seed) % 3 == 0) {
+				up[i] = !up[i];
+			} else {
+				costs[i] = 1 + rand_r(&seed) % 4;
+			}
+		}
+	}
+
+	if (incremental_rounds < 250) {
+		LOG_IPCP_ERR("Only %d rounds were computed incrementally",
+			     incremental_rounds);
+		return -1;
+	}
+
+	return 0;
+}
+
 void populateAddresses(std::list<rina::RoutingTableEntry *>& rt,
 		      const std::list<rinad::FlowStateObject>& fsos)
 {
@@ -769,23 +1002,23 @@ void populateAddresses(std::list<rina::RoutingTableEntry *>& rt,
 		++jt;
 
 		while (jt != fsos.end()) {
-			if (it->get_name() == jt->get_neighborname() &&
-					it->get_neighborname() ==  jt->get_name()) {
+			if (it->name == jt->neighbor_name &&
+					it->neighbor_name ==  jt->name) {
 
-				aux = it->get_addresses();
+				aux = it->addresses;
 				for (kt = aux.begin(); kt != aux.end(); ++kt) {
 					if (jt->contains_neighboraddress(*kt))
 						addresses.push_back(*kt);
 				}
-				name_address_map[it->get_name()] = addresses;
+				name_address_map[it->name] = addresses;
 				addresses.clear();
 
-				aux = it->get_neighboraddresses();
+				aux = it->neighbor_addresses;
 				for (kt = aux.begin(); kt != aux.end(); ++kt) {
 					if (jt->contains_address(*kt))
 						addresses.push_back(*kt);
 				}
-				name_address_map[it->get_neighborname()] = addresses;
+				name_address_map[it->neighbor_name] = addresses;
 				addresses.clear();
 
 				break;
@@ -879,6 +1112,57 @@ int getRoutingTable_Addresses_True() {
 	return result;
 }
 
+// a reaches c through b with the advertised costs, and directly with the
+// hop count. Cubes 1 and 3 share the advertised costs.
+int getRoutingTable_QoSCubes_True() {
+	std::list<rinad::FlowStateObject> objects;
+	std::list<rina::RoutingTableEntry *> rtable;
+	std::list<rina::RoutingTableEntry *>::iterator it;
+	rinad::QoSCubeRoutingAlgorithm algorithm(
+			rinad::LinkStateRoutingPolicy::DIJKSTRA_ALG, false, 2);
+	std::map<std::pair<unsigned int, std::string>, std::string> next_hops;
+	int result = 0;
+
+	objects.push_back(rinad::FlowStateObject("a", "b", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("b", "a", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("b", "c", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("c", "b", 1, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("a", "c", 10, true, 1, 1));
+	objects.push_back(rinad::FlowStateObject("c", "a", 10, true, 1, 1));
+
+	algorithm.addQoSCube(1, 1, 0);
+	algorithm.addQoSCube(2, 0, 1);
+	algorithm.addQoSCube(3, 1, 0);
+	if (algorithm.metrics() != 2) {
+		LOG_IPCP_ERR("%u metrics instead of 2", algorithm.metrics());
+		return -1;
+	}
+
+	for (int round = 0; round < 2; round++) {
+		algorithm.computeRoutingTable(rinad::Graph(objects), objects,
+					      "a", rtable);
+		for (it = rtable.begin(); it != rtable.end(); ++it) {
+			next_hops[std::make_pair((*it)->qosId,
+						 (*it)->destination.name)] =
+				(*it)->nextHopNames.front().alts.front().name;
+			delete *it;
+		}
+
+		if (rtable.size() != 6 || next_hops.size() != 6 ||
+				next_hops[std::make_pair(1u, std::string("c"))] != "b" ||
+				next_hops[std::make_pair(2u, std::string("c"))] != "c" ||
+				next_hops[std::make_pair(3u, std::string("c"))] != "b" ||
+				next_hops[std::make_pair(2u, std::string("b"))] != "b") {
+			LOG_IPCP_ERR("Wrong routing table in round %d", round);
+			result = -1;
+		}
+		rtable.clear();
+		next_hops.clear();
+	}
+
+	return result;
+}
+
 int test_dijkstra() {
 	int result = 0;
 
@@ -924,6 +1208,19 @@ int test_dijkstra() {
 	}
 	LOG_IPCP_INFO("getPDUTForwardingTable_MoreGraphEntriesLFA_True test passed");
 
+	result = getRoutingTable_GridTies_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("getRoutingTable_GridTies_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("getRoutingTable_GridTies_True test passed");
+
+	result = getRoutingTable_IncrementalSameAsFull_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("getRoutingTable_IncrementalSameAsFull_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("getRoutingTable_IncrementalSameAsFull_True test passed");
 
 	result = getRoutingTable_Addresses_True();
 	if (result < 0) {
@@ -932,6 +1229,13 @@ int test_dijkstra() {
 	}
 	LOG_IPCP_INFO("getRoutingTable_Addresses_True test passed");
 
+	result = getRoutingTable_QoSCubes_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("getRoutingTable_QoSCubes_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("getRoutingTable_QoSCubes_True test passed");
+
 	return result;
 }
 
@@ -1094,6 +1398,68 @@ int getRoutingTable_MultipathGraphRoutesTest() {
 	return result;
 }
 
+int getRoutingTable_WeightedMultipath_True() {
+	int result = 0;
+	std::list<rina::RoutingTableEntry *> rtable;
+	std::list<rinad::FlowStateObject> objects;
+	std::map<std::string, unsigned int> hops;
+
+	/*      -- b -- d --
+	*     /      \ /     \
+	*   a         X       f
+	*     \      / \     /
+	*      -- c -- e --
+	*
+	* b reaches f through d and e, c only through e: two shortest
+	* paths start through b and one through c
+	*/
+	const char * links[][2] = {{"a", "b"}, {"a", "c"}, {"b", "d"},
+				   {"b", "e"}, {"c", "e"}, {"d", "f"},
+				   {"e", "f"}};
+	for (unsigned int i = 0; i < sizeof(links) / sizeof(links[0]); i++) {
+		objects.push_back(rinad::FlowStateObject(links[i][0], links[i][1],
+							 1, true, 1, 1));
+		objects.push_back(rinad::FlowStateObject(links[i][1], links[i][0],
+							 1, true, 1, 1));
+	}
+
+	rinad::ECMPDijkstraAlgorithm ecmp;
+	rinad::ECMPDijkstraAlgorithm ucmp(true);
+	rinad::Graph graph(objects);
+
+	ecmp.computeRoutingTable(graph, objects, "a", rtable);
+	if (rtable.size() != 5) {
+		result = -1;
+	}
+	std::list<rina::RoutingTableEntry *>::iterator it;
+	for (it = rtable.begin(); it != rtable.end(); ++it) {
+		if ((*it)->destination.name == "f" &&
+				((*it)->nextHopNames.size() != 2 || (*it)->cost != 3)) {
+			result = -1;
+		}
+		delete *it;
+	}
+	rtable.clear();
+
+	ucmp.computeRoutingTable(graph, objects, "a", rtable);
+	for (it = rtable.begin(); it != rtable.end(); ++it) {
+		std::list<rina::NHopAltList>::const_iterator jt;
+
+		if ((*it)->destination.name == "f") {
+			for (jt = (*it)->nextHopNames.begin();
+					jt != (*it)->nextHopNames.end(); ++jt) {
+				hops[jt->alts.front().name]++;
+			}
+		}
+		delete *it;
+	}
+	if (hops.size() != 2 || hops["b"] != 2 || hops["c"] != 1) {
+		result = -1;
+	}
+
+	return result;
+}
+
 int test_mp_dijkstra() {
 	int result = 0;
 
@@ -1117,6 +1483,436 @@ int test_mp_dijkstra() {
 		return result;
 	}
 	LOG_IPCP_INFO("getRoutingTable_MultipathGraphMultipleLinkCosts test passed");
+
+	result = getRoutingTable_WeightedMultipath_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("getRoutingTable_WeightedMultipath_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("getRoutingTable_WeightedMultipath_True test passed");
+	return result;
+}
+
+static void addObject(std::map<std::string, rinad::FlowStateObject *>& objects,
+		      rinad::FlowStateDeltas& deltas,
+		      const std::string& name, const std::string& neighbor,
+		      unsigned int seq_num)
+{
+	rinad::FlowStateObject * fso =
+		new rinad::FlowStateObject(name, neighbor, 1, true, seq_num, 0);
+
+	objects[fso->object_name] = fso;
+	deltas.objectAdded(fso);
+}
+
+static void freeObjects(std::map<std::string, rinad::FlowStateObject *>& objects)
+{
+	std::map<std::string, rinad::FlowStateObject *>::iterator it;
+
+	for (it = objects.begin(); it != objects.end(); ++it) {
+		delete it->second;
+	}
+	objects.clear();
+}
+
+// Decodes the groups at positions, adding the keys of their objects to keys
+static int decodeMessages(const rinad::FlowStateMessages& messages,
+			  const std::list<unsigned int>& positions,
+			  std::list<std::string>& keys)
+{
+	std::list<unsigned int>::const_iterator it;
+	rinad::FlowStateObjectListEncoder encoder;
+
+	for (it = positions.begin(); it != positions.end(); ++it) {
+		const std::string& message = messages.messages[*it];
+		std::list<rinad::FlowStateObject> decoded;
+		std::list<rinad::FlowStateObject>::iterator jt;
+		rina::ser_obj_t group, encoded;
+		rina::SerObjLoan value(group,
+				       (const unsigned char *) message.data(),
+				       message.size());
+
+		// The group is as if its objects were encoded together
+		encoder.decode(group, decoded);
+		encoder.encode(decoded, encoded);
+		if (message != std::string((const char *) encoded.message_,
+					   encoded.size_))
+			return -1;
+
+		for (jt = decoded.begin(); jt != decoded.end(); ++jt) {
+			keys.push_back(jt->getKey());
+		}
+	}
+
+	keys.sort();
+	return 0;
+}
+
+int FlowStateDeltas_SharedMessages_True() {
+	std::map<std::string, rinad::FlowStateObject *> objects;
+	std::map<std::string, rinad::FlowStateObject *>::iterator it;
+	std::list<std::string> keys1, keys2, expected;
+	std::list<int> ports;
+	rinad::FlowStateDeltas deltas;
+	rinad::FlowStateMessages messages;
+	int result = 0;
+
+	addObject(objects, deltas, "a", "b", 1);
+	addObject(objects, deltas, "b", "a", 1);
+	addObject(objects, deltas, "b", "c", 2);
+	addObject(objects, deltas, "c", "b", 3);
+	addObject(objects, deltas, "c", "d", 1);
+
+	ports.push_back(1);
+	ports.push_back(2);
+	ports.push_back(3);
+	deltas.setPorts(ports);
+
+	// The first object came from port 2, the others are new
+	for (it = objects.begin(); it != objects.end(); ++it) {
+		deltas.objectModified(it->second,
+				      it == objects.begin() ? 2 : -1);
+		expected.push_back(it->second->getKey());
+	}
+	deltas.getMessages(-1, 2, messages);
+
+	// Ports 1 and 3 share their groups of 2, 2 and 1 objects
+	if (messages.objects != 5 || messages.ports.size() != 3 ||
+			messages.ports[1].size() != 3 ||
+			messages.ports[3] != messages.ports[1] ||
+			messages.ports[2].size() != 2) {
+		freeObjects(objects);
+		return -1;
+	}
+
+	if (decodeMessages(messages, messages.ports[1], keys1) ||
+			decodeMessages(messages, messages.ports[2], keys2)) {
+		result = -1;
+	}
+	expected.sort();
+	if (keys1 != expected) {
+		result = -1;
+	}
+	expected.remove("a-b");
+	if (keys2 != expected) {
+		result = -1;
+	}
+
+	// Nothing else to send until objects are modified again
+	if (deltas.pending(1) || deltas.pending(2) || deltas.pending(3)) {
+		result = -1;
+	}
+
+	freeObjects(objects);
+	return result;
+}
+
+int FlowStateDeltas_Summaries_True() {
+	std::map<std::string, rinad::FlowStateObject *> local, neighbor;
+	std::list<rinad::FlowStateObjectSummary> summaries;
+	std::list<rinad::FlowStateObjectSummary>::iterator it;
+	std::list<std::pair<uint64_t, unsigned int> >::iterator jt;
+	rinad::FlowStateObjectSummaryEncoder encoder;
+	rinad::FlowStateDeltas deltas, neighbor_deltas;
+	rinad::FlowStateObjectSummary request, reply;
+	rinad::FlowStateMessages messages;
+	std::list<std::string> sent, expected;
+	int result = 0;
+
+	addObject(local, deltas, "a", "b", 1);
+	addObject(local, deltas, "b", "a", 2);
+	addObject(local, deltas, "c", "a", 3);
+	addObject(local, deltas, "d", "a", 4);
+
+	// The neighbor lacks a-b, has a newer b-a, the same c-a, an older
+	// d-a and an object we lack, e-a
+	addObject(neighbor, neighbor_deltas, "b", "a", 3);
+	addObject(neighbor, neighbor_deltas, "c", "a", 3);
+	addObject(neighbor, neighbor_deltas, "d", "a", 1);
+	addObject(neighbor, neighbor_deltas, "e", "a", 1);
+
+	neighbor_deltas.getSummaries(2, summaries);
+	if (summaries.size() != 2 ||
+			summaries.front().last != summaries.back().after ||
+			summaries.back().last != UINT64_MAX) {
+		result = -1;
+	}
+
+	for (it = summaries.begin(); it != summaries.end(); ++it) {
+		rinad::FlowStateObjectSummary decoded;
+		rina::ser_obj_t summary;
+
+		encoder.encode(*it, summary);
+		encoder.decode(summary, decoded);
+		deltas.processSummary(decoded, 1, request);
+	}
+
+	// Send a-b and d-a, and ask for b-a and e-a
+	deltas.getMessages(1, 15, messages);
+	expected.push_back("a-b");
+	expected.push_back("d-a");
+	if (decodeMessages(messages, messages.ports[1], sent) ||
+			sent != expected) {
+		result = -1;
+	}
+
+	if (request.complete || request.objects.size() != 2) {
+		result = -1;
+	}
+	for (jt = request.objects.begin(); jt != request.objects.end(); ++jt) {
+		rinad::FlowStateObject * fso = jt->second ?
+			local["/resalloc/fsos/key=b-a"] :
+			neighbor["/resalloc/fsos/key=e-a"];
+
+		if (jt->first != rinad::FlowStateDeltas::fingerprint(*fso) ||
+				(jt->second != 0 && jt->second != 2)) {
+			result = -1;
+		}
+	}
+
+	// The neighbor sends what was asked for
+	neighbor_deltas.processSummary(request, 1, reply);
+	if (neighbor_deltas.pending(1) != 2 || !reply.objects.empty()) {
+		result = -1;
+	}
+
+	freeObjects(local);
+	freeObjects(neighbor);
+	return result;
+}
+
+static int expectExpired(rinad::FlowStateAges& ages, const std::string& names)
+{
+	std::list<rinad::FlowStateObject *> expired;
+	std::list<rinad::FlowStateObject *>::iterator it;
+	std::string result;
+
+	ages.increment(expired);
+	for (it = expired.begin(); it != expired.end(); ++it) {
+		result += (*it)->name;
+	}
+	std::sort(result.begin(), result.end());
+
+	if (result != names) {
+		LOG_IPCP_ERR("Expired '%s' instead of '%s'", result.c_str(),
+			     names.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+int FlowStateAges_BucketedExpiry_True() {
+	rinad::FlowStateObject a("a", "x", 1, true, 1, 0);
+	rinad::FlowStateObject b("b", "x", 1, true, 1, 0);
+	rinad::FlowStateObject c("c", "x", 1, true, 1, 0);
+	rinad::FlowStateObject d("d", "x", 1, true, 1, 0);
+	rinad::FlowStateObject e("e", "x", 1, true, 1, 0);
+	rinad::FlowStateAges ages;
+
+	ages.set_maximum_age(3);
+	ages.setAge(&a, 0);
+	ages.setAge(&b, 2);
+	ages.setAge(&c, 0);
+	ages.setAge(&d, 5);
+
+	// b reaches the maximum age, d had already reached it
+	if (expectExpired(ages, "bd") < 0)
+		return -1;
+
+	// c is refreshed, so it stays when its bucket comes due
+	ages.setAge(&c, 0);
+	if (expectExpired(ages, "") < 0)
+		return -1;
+	if (expectExpired(ages, "a") < 0)
+		return -1;
+	if (ages.getAge(a) != 3 || ages.getAge(c) != 2) {
+		LOG_IPCP_ERR("Wrong ages %u and %u", ages.getAge(a),
+			     ages.getAge(c));
+		return -1;
+	}
+
+	// Deprecated objects expire in the next pulse
+	ages.setAge(&c, 4);
+	ages.setAge(&e, 0);
+	if (expectExpired(ages, "c") < 0)
+		return -1;
+
+	// Removed objects never expire, expired ones expire once
+	ages.objectRemoved(&e);
+	for (int i = 0; i < 5; i++) {
+		if (expectExpired(ages, "") < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int test_flow_state_deltas() {
+	int result = 0;
+
+	result = FlowStateDeltas_SharedMessages_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("FlowStateDeltas_SharedMessages_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("FlowStateDeltas_SharedMessages_True test passed");
+
+	result = FlowStateDeltas_Summaries_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("FlowStateDeltas_Summaries_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("FlowStateDeltas_Summaries_True test passed");
+
+	result = FlowStateAges_BucketedExpiry_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("FlowStateAges_BucketedExpiry_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("FlowStateAges_BucketedExpiry_True test passed");
+
+	return result;
+}
+
+static rina::PDUForwardingTableEntry * pduftEntry(unsigned int address,
+						   unsigned int port1,
+						   unsigned int port2 = 0)
+{
+	rina::PDUForwardingTableEntry * entry =
+		new rina::PDUForwardingTableEntry();
+
+	entry->address = address;
+	entry->qosId = 1;
+	entry->portIdAltlists.push_back(rina::PortIdAltlist(port1));
+	if (port2)
+		entry->portIdAltlists.push_back(rina::PortIdAltlist(port2));
+
+	return entry;
+}
+
+// Checks and frees the entries, described as address:port,port;...
+static int expectEntries(std::list<rina::PDUForwardingTableEntry *>& entries,
+			 const std::string& expected)
+{
+	std::list<rina::PDUForwardingTableEntry *>::iterator it;
+	std::list<rina::PortIdAltlist>::iterator jt;
+	std::stringstream ss;
+
+	for (it = entries.begin(); it != entries.end(); ++it) {
+		ss << (*it)->address << ":";
+		for (jt = (*it)->portIdAltlists.begin();
+				jt != (*it)->portIdAltlists.end(); ++jt) {
+			ss << (jt == (*it)->portIdAltlists.begin() ? "" : ",")
+			   << jt->alts.front();
+		}
+		ss << ";";
+		delete *it;
+	}
+	entries.clear();
+
+	if (ss.str() != expected) {
+		LOG_IPCP_ERR("Entries '%s' instead of '%s'", ss.str().c_str(),
+			     expected.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+static void freeEntries(std::list<rina::PDUForwardingTableEntry *>& entries)
+{
+	for (std::list<rina::PDUForwardingTableEntry *>::iterator it =
+			entries.begin(); it != entries.end(); ++it) {
+		delete *it;
+	}
+	entries.clear();
+}
+
+int PDUFTDeltas_OnlyChanges_True() {
+	std::list<rina::PDUForwardingTableEntry *> pduft, to_add, to_remove;
+	rinad::PDUFTDeltas deltas;
+	int result = 0;
+
+	pduft.push_back(pduftEntry(1, 10));
+	pduft.push_back(pduftEntry(2, 10, 11));
+	pduft.push_back(pduftEntry(3, 12));
+
+	// The first table is added whole
+	if (deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "1:10;2:10,11;3:12;") < 0 ||
+			expectEntries(to_remove, "") < 0)
+		result = -1;
+	freeEntries(pduft);
+
+	// 2 moves from 10 to 13, 3 is gone, 4 is new. Only the first
+	// alternative of every list counts.
+	pduft.push_back(pduftEntry(1, 10));
+	pduft.back()->portIdAltlists.front().add_alt(20);
+	pduft.push_back(pduftEntry(2, 13, 11));
+	pduft.push_back(pduftEntry(4, 12));
+	if (deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "2:13;4:12;") < 0 ||
+			expectEntries(to_remove, "2:10;3:12;") < 0)
+		result = -1;
+
+	// Nothing changed
+	if (deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "") < 0 ||
+			expectEntries(to_remove, "") < 0)
+		result = -1;
+
+	// A weight of 2 for port 10 of 1, and back, replace the table
+	pduft.front()->portIdAltlists.push_back(rina::PortIdAltlist(10));
+	if (!deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "") < 0 ||
+			expectEntries(to_remove, "") < 0)
+		result = -1;
+	pduft.push_back(pduftEntry(5, 14));
+	pduft.front()->portIdAltlists.pop_back();
+	if (!deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "") < 0 ||
+			expectEntries(to_remove, "") < 0)
+		result = -1;
+
+	// Other changes of a weighted entry are sent as such
+	pduft.front()->portIdAltlists.push_back(rina::PortIdAltlist(10));
+	deltas.update(pduft, to_add, to_remove);
+	pduft.back()->portIdAltlists.front().alts.front() = 15;
+	pduft.front()->portIdAltlists.push_back(rina::PortIdAltlist(16));
+	if (deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "1:16;5:15;") < 0 ||
+			expectEntries(to_remove, "5:14;") < 0)
+		result = -1;
+
+	// After a reset the table is replaced
+	deltas.reset();
+	if (!deltas.update(pduft, to_add, to_remove) ||
+			expectEntries(to_add, "") < 0 ||
+			expectEntries(to_remove, "") < 0)
+		result = -1;
+
+	// And every other update with a replace period of 2
+	deltas.set_replace_period(2);
+	if (deltas.update(pduft, to_add, to_remove) ||
+			!deltas.update(pduft, to_add, to_remove) ||
+			deltas.update(pduft, to_add, to_remove))
+		result = -1;
+	freeEntries(pduft);
+
+	return result;
+}
+
+int test_pduft_deltas() {
+	int result = 0;
+
+	result = PDUFTDeltas_OnlyChanges_True();
+	if (result < 0) {
+		LOG_IPCP_ERR("PDUFTDeltas_OnlyChanges_True test failed");
+		return result;
+	}
+	LOG_IPCP_INFO("PDUFTDeltas_OnlyChanges_True test passed");
+
 	return result;
 }
 
@@ -1145,6 +1941,20 @@ int main()
 	}
 	LOG_IPCP_INFO("test_dijkstra tests passed");
 
+	result = test_flow_state_deltas();
+	if (result < 0) {
+		LOG_IPCP_ERR("test_flow_state_deltas tests failed");
+		return result;
+	}
+	LOG_IPCP_INFO("test_flow_state_deltas tests passed");
+
+	result = test_pduft_deltas();
+	if (result < 0) {
+		LOG_IPCP_ERR("test_pduft_deltas tests failed");
+		return result;
+	}
+	LOG_IPCP_INFO("test_pduft_deltas tests passed");
+
 	result = test_mp_dijkstra();
 	if (result < 0) {
 		LOG_IPCP_ERR("test_mp_dijkstra tests failed");
@@ -20,6 +20,7 @@
 // MA  02110-1301  USA
 //
 
+#include <algorithm>
 #include <sstream>
 
 #include <librina/internal-events.h>
@@ -29,6 +30,7 @@
 #include "ipcp-logging.h"
 #include "resource-allocator.h"
 #include "utils.h"
+#include "common/encoders/RoutingForwarding.pb.h"
 
 namespace rinad {
 
@@ -106,8 +108,30 @@ void QoSCubesRIBObject::create(const rina::cdap_rib::con_handle_t &con,
 }
 
 //Class RMTN1Flow
-void RMTN1Flow::sync_with_kernel()
+// Copies the RMT counters exported by the kernel into the N-1 flow
+static void set_n1_flow_stats(RMTN1Flow * flow,
+			      const KernelStats::Record& record)
 {
+	flow->queued_pdus = record.values[0];
+	flow->dropped_pdus = record.values[1];
+	flow->error_pdus = record.values[2];
+	flow->tx_pdus = record.values[3];
+	flow->rx_pdus = record.values[4];
+	flow->tx_bytes = record.values[5];
+	flow->rx_bytes = record.values[6];
+}
+
+void RMTN1Flow::sync_with_kernel(const KernelStats& stats)
+{
+	const KernelStats::Record * record;
+
+	if (stats.available) {
+		record = stats.get_n1_port(port_id);
+		if (record)
+			set_n1_flow_stats(this, *record);
+		return;
+	}
+
 	SysfsHelper::get_rmt_queued_pdus(ipcp_id, port_id, queued_pdus);
 	SysfsHelper::get_rmt_drop_pdus(ipcp_id, port_id, dropped_pdus);
 	SysfsHelper::get_rmt_error_pdus(ipcp_id, port_id, error_pdus);
@@ -117,22 +141,73 @@ void RMTN1Flow::sync_with_kernel()
 	SysfsHelper::get_rmt_tx_bytes(ipcp_id, port_id, tx_bytes);
 }
 
+// Class RMTN1FlowEncoder
+void RMTN1FlowEncoder::encode(const RMTN1Flow &obj, rina::ser_obj_t& serobj)
+{
+	rina::messages::rmt_n1_flow_t gpb;
+
+	gpb.set_port_id(obj.port_id);
+	gpb.set_enabled(obj.enabled);
+	gpb.set_queued_pdus(obj.queued_pdus);
+	gpb.set_dropped_pdus(obj.dropped_pdus);
+	gpb.set_error_pdus(obj.error_pdus);
+	gpb.set_tx_pdus(obj.tx_pdus);
+	gpb.set_rx_pdus(obj.rx_pdus);
+	gpb.set_tx_bytes(obj.tx_bytes);
+	gpb.set_rx_bytes(obj.rx_bytes);
+
+	serobj.size_ = gpb.ByteSize();
+	serobj.message_ = new unsigned char[serobj.size_];
+	gpb.SerializeToArray(serobj.message_, serobj.size_);
+}
+
+void RMTN1FlowEncoder::decode(const rina::ser_obj_t &serobj,
+			      RMTN1Flow &des_obj)
+{
+	rina::messages::rmt_n1_flow_t gpb;
+
+	gpb.ParseFromArray(serobj.message_, serobj.size_);
+
+	des_obj.port_id = gpb.port_id();
+	des_obj.enabled = gpb.enabled();
+	des_obj.queued_pdus = gpb.queued_pdus();
+	des_obj.dropped_pdus = gpb.dropped_pdus();
+	des_obj.error_pdus = gpb.error_pdus();
+	des_obj.tx_pdus = gpb.tx_pdus();
+	des_obj.rx_pdus = gpb.rx_pdus();
+	des_obj.tx_bytes = gpb.tx_bytes();
+	des_obj.rx_bytes = gpb.rx_bytes();
+}
+
 // Class RMTN1Flow RIB object
 const std::string RMTN1FlowRIBObj::class_name = "RMTN1Flow";
 const std::string RMTN1FlowRIBObj::object_name_prefix = "/rmt/n1flows/port_id=";
 
-RMTN1FlowRIBObj::RMTN1FlowRIBObj(RMTN1Flow * flow)
+RMTN1FlowRIBObj::RMTN1FlowRIBObj(RMTN1Flow * flow,
+				 KernelStatsCache * stats)
 	: rina::rib::RIBObj(class_name)
 {
 	n1_flow = flow;
+	kernel_stats = stats;
+}
+
+void RMTN1FlowRIBObj::refresh_stats() const
+{
+	KernelStats::Record record;
+
+	if (kernel_stats && kernel_stats->get_n1_port(n1_flow->port_id, record))
+		set_n1_flow_stats(n1_flow, record);
 }
 
 const std::string RMTN1FlowRIBObj::get_displayable_value() const
 {
 	std::stringstream ss;
+
+	refresh_stats();
+
 	ss << "Port-id: " << n1_flow->port_id << "; Enabled: " << n1_flow->enabled
 	   << "; Queued pdus: " << n1_flow->queued_pdus << "; Dropped pdus: " << n1_flow->dropped_pdus
-	   << "; Error pdus: " << n1_flow->dropped_pdus << std::endl;
+	   << "; Error pdus: " << n1_flow->error_pdus << std::endl;
 	ss << "Tx: " << n1_flow->tx_bytes << " (bytes),  " << n1_flow->tx_pdus << " (pdus); "
 	   << "Rx: " << n1_flow->rx_bytes << " (bytes), " << n1_flow->rx_pdus << " (pdus)";
 	return ss.str();
@@ -146,7 +221,11 @@ void RMTN1FlowRIBObj::read(const rina::cdap_rib::con_handle_t &con,
 			   rina::cdap_rib::obj_info_t &obj_reply,
 			   rina::cdap_rib::res_info_t& res)
 {
-	//TODO
+	RMTN1FlowEncoder encoder;
+
+	refresh_stats();
+	encoder.encode(*n1_flow, obj_reply.value_);
+
 	res.code_ = rina::cdap_rib::CDAP_SUCCESS;
 }
 
@@ -156,7 +235,7 @@ const std::string NextHopTEntryRIBObj::parent_object_name = "/resalloc/nhopt";
 const std::string NextHopTEntryRIBObj::class_name = "NextHopTableEntry";
 const std::string NextHopTEntryRIBObj::object_name_prefix = "/resalloc/nhopt/key=";
 
-NextHopTEntryRIBObj::NextHopTEntryRIBObj(rina::RoutingTableEntry* entry)
+NextHopTEntryRIBObj::NextHopTEntryRIBObj(const rina::RoutingTableEntry& entry)
 	: rina::rib::RIBObj(class_name), rt_entry(entry)
 {
 }
@@ -164,14 +243,14 @@ NextHopTEntryRIBObj::NextHopTEntryRIBObj(rina::RoutingTableEntry* entry)
 const std::string NextHopTEntryRIBObj::get_displayable_value() const
 {
 	std::stringstream ss;
-	ss << "Destination name: " << rt_entry->destination.name
-	   << "; Addresses: " << rt_entry->destination.get_addresses_as_string()
-	   << "; QoS-id: " << rt_entry->qosId
-	   << "; Cost: " << rt_entry->cost
+	ss << "Destination name: " << rt_entry.destination.name
+	   << "; Addresses: " << rt_entry.destination.get_addresses_as_string()
+	   << "; QoS-id: " << rt_entry.qosId
+	   << "; Cost: " << rt_entry.cost
 	   << "; Next hop addresses: ";
-	std::list<rina::NHopAltList>::iterator it;
-	for (it = rt_entry->nextHopNames.begin(); it !=
-			rt_entry->nextHopNames.end(); ++it) {
+	std::list<rina::NHopAltList>::const_iterator it;
+	for (it = rt_entry.nextHopNames.begin(); it !=
+			rt_entry.nextHopNames.end(); ++it) {
 		ss << it->alts.front().name << " "
 		   << it->alts.front().get_addresses_as_string() << "/ ";
 	}
@@ -186,10 +265,8 @@ void NextHopTEntryRIBObj::read(const rina::cdap_rib::con_handle_t &con,
 			       rina::cdap_rib::obj_info_t &obj_reply,
 			       rina::cdap_rib::res_info_t& res)
 {
-	if (rt_entry) {
-		encoders::RoutingTableEntryEncoder encoder;
-		encoder.encode(*rt_entry, obj_reply.value_);
-	}
+	encoders::RoutingTableEntryEncoder encoder;
+	encoder.encode(rt_entry, obj_reply.value_);
 
 	res.code_ = rina::cdap_rib::CDAP_SUCCESS;
 }
@@ -200,7 +277,7 @@ const std::string PDUFTEntryRIBObj::parent_object_name = "/resalloc/pduft";
 const std::string PDUFTEntryRIBObj::class_name = "PDUForwardingTableEntry";
 const std::string PDUFTEntryRIBObj::object_name_prefix = "/resalloc/pduft/key=";
 
-PDUFTEntryRIBObj::PDUFTEntryRIBObj(rina::PDUForwardingTableEntry* entry)
+PDUFTEntryRIBObj::PDUFTEntryRIBObj(const rina::PDUForwardingTableEntry& entry)
 	: rina::rib::RIBObj(class_name), ft_entry(entry)
 {
 }
@@ -208,12 +285,12 @@ PDUFTEntryRIBObj::PDUFTEntryRIBObj(rina::PDUForwardingTableEntry* entry)
 const std::string PDUFTEntryRIBObj::get_displayable_value() const
 {
 	std::stringstream ss;
-	ss << "Destination address: " << ft_entry->address
-	   << "; QoS-id: " << ft_entry->qosId
+	ss << "Destination address: " << ft_entry.address
+	   << "; QoS-id: " << ft_entry.qosId
 	   << "; Port-ids to be forwarded: ";
-	std::list<rina::PortIdAltlist>::iterator it;
-	for (it = ft_entry->portIdAltlists.begin(); it !=
-			ft_entry->portIdAltlists.end(); ++it) {
+	std::list<rina::PortIdAltlist>::const_iterator it;
+	for (it = ft_entry.portIdAltlists.begin(); it !=
+			ft_entry.portIdAltlists.end(); ++it) {
 		ss << it->alts.front() << "/ ";
 	}
 	return ss.str();
@@ -227,14 +304,150 @@ void PDUFTEntryRIBObj::read(const rina::cdap_rib::con_handle_t &con,
 			    rina::cdap_rib::obj_info_t &obj_reply,
 			    rina::cdap_rib::res_info_t& res)
 {
-	if (ft_entry) {
-		encoders::PDUForwardingTableEntryEncoder encoder;
-		encoder.encode(*ft_entry, obj_reply.value_);
-	}
+	encoders::PDUForwardingTableEntryEncoder encoder;
+	encoder.encode(ft_entry, obj_reply.value_);
 
 	res.code_ = rina::cdap_rib::CDAP_SUCCESS;
 }
 
+//Class PDUFTDeltas
+bool PDUFTDeltas::Port::operator<(const Port& other) const
+{
+	if (address != other.address)
+		return address < other.address;
+	if (qos_id != other.qos_id)
+		return qos_id < other.qos_id;
+	return port_id < other.port_id;
+}
+
+PDUFTDeltas::PDUFTDeltas()
+{
+	replace_ = false;
+	replace_period_ = 0;
+	updates_ = 0;
+}
+
+void PDUFTDeltas::append(std::list<rina::PDUForwardingTableEntry *>& entries,
+			 const Port& port)
+{
+	rina::PDUForwardingTableEntry * entry;
+
+	// Ports come sorted, so the ones of an entry come in a row
+	if (entries.empty() || entries.back()->address != port.address ||
+			entries.back()->qosId != port.qos_id) {
+		entry = new rina::PDUForwardingTableEntry();
+		entry->address = port.address;
+		entry->qosId = port.qos_id;
+		entries.push_back(entry);
+	}
+
+	entries.back()->portIdAltlists.push_back(rina::PortIdAltlist(port.port_id));
+}
+
+bool PDUFTDeltas::update(const std::list<rina::PDUForwardingTableEntry *>& pduft,
+			 std::list<rina::PDUForwardingTableEntry *>& to_add,
+			 std::list<rina::PDUForwardingTableEntry *>& to_remove)
+{
+	std::list<rina::PDUForwardingTableEntry *>::const_iterator it;
+	std::list<rina::PortIdAltlist>::const_iterator jt;
+	std::list<rina::PDUForwardingTableEntry *> added, removed;
+	std::vector<Port>::iterator pt, ct, pn, cn;
+	std::vector<Port> current;
+	bool replace = replace_;
+	Port port;
+
+	if (replace_period_ && ++updates_ >= replace_period_)
+		replace = true;
+
+	current.reserve(previous_.size());
+	for (it = pduft.begin(); it != pduft.end(); ++it) {
+		port.address = (*it)->address;
+		port.qos_id = (*it)->qosId;
+		for (jt = (*it)->portIdAltlists.begin();
+				jt != (*it)->portIdAltlists.end(); ++jt) {
+			if (jt->alts.empty())
+				continue;
+			port.port_id = jt->alts.front();
+			current.push_back(port);
+		}
+	}
+	// Repeated port-ids are the weights of weighted multipath entries
+	std::sort(current.begin(), current.end());
+
+	if (replace) {
+		previous_.swap(current);
+		replace_ = false;
+		updates_ = 0;
+		return true;
+	}
+
+	pt = previous_.begin();
+	ct = current.begin();
+	while (pt != previous_.end() || ct != current.end()) {
+		if (ct == current.end() ||
+				(pt != previous_.end() && *pt < *ct))
+			port = *pt;
+		else
+			port = *ct;
+
+		//The copies of the port-id, its weight, come in a row
+		for (pn = pt; pn != previous_.end() && !(port < *pn); ++pn)
+			;
+		for (cn = ct; cn != current.end() && !(port < *cn); ++cn)
+			;
+
+		//A port-id added or removed once is the same for every PFF
+		//policy. A weight change is not: the default one does not
+		//count repeated port-ids, so removing one copy would remove
+		//the port-id. Replace the table instead, which passes every
+		//entry with its weights at once.
+		if ((pn - pt) > 1 || (cn - ct) > 1) {
+			if ((pn - pt) != (cn - ct)) {
+				freeEntries(added);
+				freeEntries(removed);
+				previous_.swap(current);
+				updates_ = 0;
+				return true;
+			}
+		} else if (pn != pt && cn == ct) {
+			append(removed, port);
+		} else if (pn == pt && cn != ct) {
+			append(added, port);
+		}
+
+		pt = pn;
+		ct = cn;
+	}
+
+	previous_.swap(current);
+	to_add.splice(to_add.end(), added);
+	to_remove.splice(to_remove.end(), removed);
+
+	return false;
+}
+
+void PDUFTDeltas::freeEntries(std::list<rina::PDUForwardingTableEntry *>& entries)
+{
+	std::list<rina::PDUForwardingTableEntry *>::iterator it;
+
+	for (it = entries.begin(); it != entries.end(); ++it) {
+		delete *it;
+	}
+	entries.clear();
+}
+
+void PDUFTDeltas::reset()
+{
+	previous_.clear();
+	replace_ = true;
+}
+
+void PDUFTDeltas::set_replace_period(unsigned int period)
+{
+	replace_period_ = period;
+	updates_ = 0;
+}
+
 //Class NMinusOneFlowManager
 NMinusOneFlowManager::NMinusOneFlowManager()
 {
@@ -449,13 +662,13 @@ void ResourceAllocator::eventHappened(rina::InternalEvent * event)
 	}
 }
 
-void ResourceAllocator::sync_with_kernel()
+void ResourceAllocator::sync_with_kernel(const KernelStats& stats)
 {
 	std::map<int, RMTN1Flow*>::iterator iterator;
 
 	n1_flows_lock.lock();
 	for(iterator = n1_flows.begin(); iterator != n1_flows.end(); ++iterator) {
-		iterator->second->sync_with_kernel();
+		iterator->second->sync_with_kernel(stats);
 	}
 	n1_flows_lock.unlock();
 }
@@ -468,7 +681,8 @@ void ResourceAllocator::nMinusOneFlowAllocated(rina::NMinusOneFlowAllocatedEvent
 	n1_flows[flow->port_id] = flow;
 	n1_flows_lock.unlock();
 
-	rina::rib::RIBObj * rib_obj = new RMTN1FlowRIBObj(flow);
+	rina::rib::RIBObj * rib_obj = new RMTN1FlowRIBObj(flow,
+							     ipcp->kernel_stats_);
 	std::stringstream ss;
 	ss << RMTN1FlowRIBObj::object_name_prefix
 	   << flowEvent->flow_information_.portId;
@@ -518,11 +732,21 @@ void ResourceAllocator::subscribeToEvents()
 
 void ResourceAllocator::set_dif_configuration(const rina::DIFConfiguration& dif_configuration)
 {
-	std::string ps_name = dif_configuration.ra_configuration_.pduftg_conf_.policy_set_.name_;
-	if (set_pduft_gen_policy_set(ps_name) != 0) {
+	const rina::PolicyConfig& psconf =
+		dif_configuration.ra_configuration_.pduftg_conf_.policy_set_;
+	std::list<rina::PolicyParameter>::const_iterator pit;
+
+	if (set_pduft_gen_policy_set(psconf.name_) != 0) {
 		throw rina::Exception("Cannot create PDU Forwarding Table Generator policy-set");
 	}
 
+	for (pit = psconf.parameters_.begin();
+			pit != psconf.parameters_.end(); ++pit) {
+		if (pduft_gen_ps->set_policy_set_param(pit->name_, pit->value_))
+			LOG_IPCP_WARN("Unknown PDU Forwarding Table Generator parameter %s",
+				      pit->name_.c_str());
+	}
+
 	if (n_minus_one_flow_manager_) {
 		n_minus_one_flow_manager_->set_dif_configuration(dif_configuration);
 	}
@@ -605,78 +829,141 @@ std::list<rina::PDUForwardingTableEntry> ResourceAllocator::get_pduft_entries()
 	return result;
 }
 
+static bool same_pduft_entry(const rina::PDUForwardingTableEntry& a,
+			     const rina::PDUForwardingTableEntry& b)
+{
+	std::list<rina::PortIdAltlist>::const_iterator it, jt;
+
+	if (a != b || a.portIdAltlists.size() != b.portIdAltlists.size())
+		return false;
+
+	for (it = a.portIdAltlists.begin(), jt = b.portIdAltlists.begin();
+			it != a.portIdAltlists.end(); ++it, ++jt) {
+		if (it->alts != jt->alts)
+			return false;
+	}
+
+	return true;
+}
+
 /// This operation takes ownership of the entries
-void ResourceAllocator::set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft_entries)
+void ResourceAllocator::set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft_entries,
+					  bool replaced)
 {
-	rina::PDUForwardingTableEntry * pdufte;
-	std::map<std::string, rina::PDUForwardingTableEntry *>::iterator it;
+	std::map<std::string, rina::PDUForwardingTableEntry *> current, kept;
+	std::map<std::string, rina::PDUForwardingTableEntry *>::iterator it, jt;
 	std::list<rina::PDUForwardingTableEntry*>::const_iterator it2;
-	rina::rib::RIBObj * ribObj;
-	std::string obj_name;
+	std::list<std::pair<std::string, rina::rib::RIBObj*> > to_add;
+	std::list<std::pair<std::string, rina::rib::RIBObj*> >::iterator it3;
+	std::list<std::string> to_remove;
 	std::stringstream ss;
 
 	rina::WriteScopedLock g(pduft_lock);
 
-	//1 Scrap the old entries
-	for (it = pduft.begin(); it != pduft.end(); ++it) {
-		try {
-			rib_daemon_->removeObjRIB(it->first);
-		} catch (rina::Exception &e) {
-			LOG_WARN("Problems removing RIB obj: %s", e.what());
-		}
-
-		pdufte = it->second;
-		delete pdufte;
-		pdufte = 0;
-	}
-
-	pduft.clear();
-
-	//2 Add the new entries
+	//1 Key the new entries
 	for (it2 = pduft_entries.begin();
 			it2 != pduft_entries.end(); ++it2) {
 		ss << PDUFTEntryRIBObj::object_name_prefix;
 		ss << (*it2)->getKey();
-		obj_name = ss.str();
+		if (!current.insert(std::make_pair(ss.str(), *it2)).second)
+			delete *it2;
 		ss.str(std::string());
 		ss.clear();
+	}
+
+	//2 Keep the entries that did not change, scrap the others
+	for (it = pduft.begin(); it != pduft.end(); ++it) {
+		jt = current.find(it->first);
+		if (jt != current.end() &&
+				same_pduft_entry(*it->second, *jt->second)) {
+			delete jt->second;
+			current.erase(jt);
+			kept.insert(*it);
+			continue;
+		}
 
+		to_remove.push_back(it->first);
+		delete it->second;
+	}
+	pduft.swap(kept);
+
+	for (jt = current.begin(); jt != current.end(); ++jt) {
+		to_add.push_back(std::make_pair(jt->first,
+				 (rina::rib::RIBObj*) new PDUFTEntryRIBObj(*jt->second)));
+	}
+
+	//3 Replace the changed ones in the RIB at once, so that readers never
+	//see a partial table
+	if (!to_remove.empty() || !to_add.empty()) {
 		try {
-			ribObj = new PDUFTEntryRIBObj(*it2);
-			rib_daemon_->addObjRIB(obj_name, &ribObj);
+			rib_daemon_->updateObjsRIB(to_remove, to_add);
 		} catch (rina::Exception &e) {
-			//LOG_WARN("Problems adding RIB obj: %s", e.what());
+			LOG_WARN("Problems updating RIB objs: %s", e.what());
+		}
+	}
+
+	jt = current.begin();
+	for (it3 = to_add.begin(); it3 != to_add.end(); ++it3, ++jt) {
+		//Not added to the RIB
+		if (it3->second) {
+			delete it3->second;
+			delete jt->second;
 			continue;
 		}
 
-		pduft[obj_name] = *it2;
+		pduft[it3->first] = jt->second;
 	}
 
-	//3 Update temp entries
-	update_temp_entries();
+	//4 Update temp entries
+	update_temp_entries(replaced);
 }
 
-void ResourceAllocator::update_temp_entries()
+void ResourceAllocator::update_temp_entries(bool replaced)
 {
 	std::list<rina::PDUForwardingTableEntry*>::iterator it;
-	std::list<rina::PDUForwardingTableEntry*> to_add;
+	std::list<rina::PDUForwardingTableEntry*> to_add, to_remove;
+
+	//Replacing the kernel table flushed the temp entries
+	if (replaced)
+		temp_entries_in_kernel.clear();
 
-	for(it = temp_entries.begin(); it != temp_entries.end(); ++it) {
+	it = temp_entries.begin();
+	while (it != temp_entries.end()) {
 		if (!entry_is_in_pduft((*it)->address)) {
-			to_add.push_back(*it);
+			//Add it only if the kernel does not have it, adding
+			//the same port again would raise its weight
+			if (!temp_entries_in_kernel.count((*it)->address))
+				to_add.push_back(*it);
+			++it;
+			continue;
 		}
-	}
 
-	if (to_add.size() == 0) {
-		return;
+		//The routing policy provides the entry now, scrap the
+		//temporary one unless the routing one uses the same port
+		if (temp_entries_in_kernel.erase((*it)->address) &&
+				!entry_is_in_pduft(**it))
+			to_remove.push_back(*it);
+		else
+			delete *it;
+		it = temp_entries.erase(it);
 	}
 
 	try {
-		rina::kernelIPCProcess->modifyPDUForwardingTableEntries(to_add, 0);
+		if (!to_add.empty()) {
+			rina::kernelIPCProcess->modifyPDUForwardingTableEntries(to_add, 0);
+			for (it = to_add.begin(); it != to_add.end(); ++it)
+				temp_entries_in_kernel.insert((*it)->address);
+		}
+		if (!to_remove.empty())
+			rina::kernelIPCProcess->modifyPDUForwardingTableEntries(to_remove, 1);
 	} catch (rina::Exception & e) {
-		LOG_IPCP_ERR("Error adding entries to PDU Forwarding Table in the kernel: %s",
+		LOG_IPCP_ERR("Error updating temporary entries of PDU Forwarding Table in the kernel: %s",
 				e.what());
 	}
+
+	for (it = to_remove.begin(); it != to_remove.end(); ++it) {
+		delete *it;
+	}
 }
 
 std::list<rina::RoutingTableEntry> ResourceAllocator::get_rt_entries()
@@ -695,26 +982,19 @@ std::list<rina::RoutingTableEntry> ResourceAllocator::get_rt_entries()
 
 void ResourceAllocator::set_rt_entries(const std::list<rina::RoutingTableEntry*>& rt_entries)
 {
-	rina::RoutingTableEntry * rte;
 	std::map<std::string, rina::RoutingTableEntry *>::iterator it;
 	std::list<rina::RoutingTableEntry*>::const_iterator it2;
-	rina::rib::RIBObj * ribObj;
-	std::string obj_name;
+	std::list<std::pair<std::string, rina::rib::RIBObj*> > to_add;
+	std::list<std::pair<std::string, rina::rib::RIBObj*> >::iterator it3;
+	std::list<std::string> to_remove;
 	std::stringstream ss;
 
 	rina::WriteScopedLock g(rt_lock);
 
 	//1 Scrap the old entries
 	for (it = rt.begin(); it != rt.end(); ++it) {
-		try {
-			rib_daemon_->removeObjRIB(it->first);
-		} catch (rina::Exception &e) {
-			LOG_WARN("Problems removing RIB obj: %s", e.what());
-		}
-
-		rte = it->second;
-		delete rte;
-		rte = 0;
+		to_remove.push_back(it->first);
+		delete it->second;
 	}
 
 	rt.clear();
@@ -724,19 +1004,31 @@ void ResourceAllocator::set_rt_entries(const std::list<rina::RoutingTableEntry*>
 			it2 != rt_entries.end(); ++it2) {
 		ss << NextHopTEntryRIBObj::object_name_prefix;
 		ss << (*it2)->getKey();
-		obj_name = ss.str();
+		to_add.push_back(std::make_pair(ss.str(),
+				 (rina::rib::RIBObj*) new NextHopTEntryRIBObj(**it2)));
 		ss.str(std::string());
 		ss.clear();
+	}
 
-		try {
-			ribObj = new NextHopTEntryRIBObj(*it2);
-			rib_daemon_->addObjRIB(obj_name, &ribObj);
-		} catch (rina::Exception &e) {
-			LOG_WARN("Problems adding RIB obj: %s", e.what());
+	//3 Replace them in the RIB at once
+	try {
+		rib_daemon_->updateObjsRIB(to_remove, to_add);
+	} catch (rina::Exception &e) {
+		LOG_WARN("Problems updating RIB objs: %s", e.what());
+	}
+
+	it2 = rt_entries.begin();
+	for (it3 = to_add.begin(); it3 != to_add.end(); ++it3, ++it2) {
+		//Not added to the RIB
+		if (it3->second) {
+			LOG_WARN("Problems adding RIB obj %s",
+				 it3->first.c_str());
+			delete it3->second;
+			delete *it2;
 			continue;
 		}
 
-		rt[obj_name] = *it2;
+		rt[it3->first] = *it2;
 	}
 }
 
@@ -799,6 +1091,27 @@ bool ResourceAllocator::entry_is_in_pduft(unsigned int dest_address)
 	return false;
 }
 
+bool ResourceAllocator::entry_is_in_pduft(const rina::PDUForwardingTableEntry& entry)
+{
+	std::map<std::string, rina::PDUForwardingTableEntry*>::iterator it;
+	std::list<rina::PortIdAltlist>::iterator jt;
+	unsigned int port_id = entry.portIdAltlists.front().alts.front();
+
+	for (it = pduft.begin(); it != pduft.end(); ++it) {
+		if (it->second->address != entry.address ||
+				it->second->qosId != entry.qosId)
+			continue;
+
+		for (jt = it->second->portIdAltlists.begin();
+				jt != it->second->portIdAltlists.end(); ++jt) {
+			if (!jt->alts.empty() && jt->alts.front() == port_id)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 void ResourceAllocator::add_temp_pduft_entry(unsigned int dest_address, int port_id)
 {
 	std::list<unsigned int>::iterator it2;
@@ -822,6 +1135,7 @@ void ResourceAllocator::add_temp_pduft_entry(unsigned int dest_address, int port
 
 	try {
 		rina::kernelIPCProcess->modifyPDUForwardingTableEntries(to_add, 0);
+		temp_entries_in_kernel.insert(dest_address);
 	} catch (rina::Exception & e) {
 		LOG_IPCP_ERR("Error adding entry to PDU Forwarding Table in the kernel: %s",
 				e.what());
@@ -831,6 +1145,7 @@ void ResourceAllocator::add_temp_pduft_entry(unsigned int dest_address, int port
 void ResourceAllocator::remove_temp_pduft_entry(unsigned int dest_address)
 {
 	std::list<rina::PDUForwardingTableEntry*>::iterator it;
+	std::list<rina::PDUForwardingTableEntry*> to_remove;
 	rina::PDUForwardingTableEntry * entry;
 
 	rina::WriteScopedLock g(pduft_lock);
@@ -841,12 +1156,31 @@ void ResourceAllocator::remove_temp_pduft_entry(unsigned int dest_address)
 	    if (entry->address == dest_address) {
 		    it = temp_entries.erase(it);
 		    LOG_IPCP_DBG("Deleting temp entry %s", entry->toString().c_str());
-		    delete entry;
-		    entry = 0;
+		    to_remove.push_back(entry);
 	    } else {
 	        ++it;
 	    }
 	}
+
+	//Only remove it from the kernel if it got there
+	if (!temp_entries_in_kernel.erase(dest_address)) {
+		for (it = to_remove.begin(); it != to_remove.end(); ++it) {
+			delete *it;
+		}
+		return;
+	}
+
+	//The forwarding table is no longer flushed on every update
+	try {
+		rina::kernelIPCProcess->modifyPDUForwardingTableEntries(to_remove, 1);
+	} catch (rina::Exception & e) {
+		LOG_IPCP_ERR("Error removing entry from PDU Forwarding Table in the kernel: %s",
+				e.what());
+	}
+
+	for (it = to_remove.begin(); it != to_remove.end(); ++it) {
+		delete *it;
+	}
 }
 
 } //namespace rinad
@@ -23,6 +23,9 @@
 #ifndef IPCP_RESOURCE_ALLOCATOR_HH
 #define IPCP_RESOURCE_ALLOCATOR_HH
 
+#include <set>
+#include <vector>
+
 #include "ipcp/components.h"
 
 namespace rinad {
@@ -80,7 +83,7 @@ public:
 		dropped_pdus(0), error_pdus(0), tx_pdus(0),
 		rx_pdus(0), tx_bytes(0), rx_bytes(0) { };
 
-	void sync_with_kernel();
+	void sync_with_kernel(const KernelStats& stats);
 
 	unsigned short ipcp_id;
 	int port_id;
@@ -94,9 +97,16 @@ public:
 	unsigned long rx_bytes;
 };
 
+/// Encoder of the counters of an RMTN1Flow
+class RMTN1FlowEncoder: public rina::Encoder<RMTN1Flow> {
+public:
+	void encode(const RMTN1Flow &obj, rina::ser_obj_t& serobj);
+	void decode(const rina::ser_obj_t &serobj, RMTN1Flow &des_obj);
+};
+
 class RMTN1FlowRIBObj: public rina::rib::RIBObj {
 public:
-	RMTN1FlowRIBObj(RMTN1Flow * flow);
+	RMTN1FlowRIBObj(RMTN1Flow * flow, KernelStatsCache * kernel_stats);
 	const std::string get_displayable_value() const;
 
 	const std::string& get_class() const {
@@ -116,11 +126,15 @@ public:
 
 private:
 	RMTN1Flow * n1_flow;
+	KernelStatsCache * kernel_stats;
+
+	/// Copies the cached kernel counters into n1_flow
+	void refresh_stats() const;
 };
 
 class NextHopTEntryRIBObj: public rina::rib::RIBObj {
 public:
-	NextHopTEntryRIBObj(rina::RoutingTableEntry* entry);
+	NextHopTEntryRIBObj(const rina::RoutingTableEntry& entry);
 	const std::string get_displayable_value() const;
 
 	const std::string& get_class() const {
@@ -141,12 +155,13 @@ public:
 	const static std::string object_name_prefix;
 
 private:
-	rina::RoutingTableEntry * rt_entry;
+	//A copy, for readers of the RIB may outlive the entry
+	rina::RoutingTableEntry rt_entry;
 };
 
 class PDUFTEntryRIBObj: public rina::rib::RIBObj {
 public:
-	PDUFTEntryRIBObj(rina::PDUForwardingTableEntry* entry);
+	PDUFTEntryRIBObj(const rina::PDUForwardingTableEntry& entry);
 	const std::string get_displayable_value() const;
 
 	const std::string& get_class() const {
@@ -167,7 +182,58 @@ public:
 	const static std::string object_name_prefix;
 
 private:
-	rina::PDUForwardingTableEntry * ft_entry;
+	//A copy, for readers of the RIB may outlive the entry
+	rina::PDUForwardingTableEntry ft_entry;
+};
+
+/// The changes to make to the PDU forwarding table in the kernel to go
+/// from the previous table to a new one. The kernel only keeps the first
+/// alternative of every port-id alternative list of an entry, so those are
+/// the port-ids compared. A port-id repeated in an entry counts as many
+/// times as it appears, which is its weight in the multipath policy;
+/// changing a weight replaces the table, so that the changes only ever
+/// add or remove a port-id once.
+class PDUFTDeltas {
+public:
+	PDUFTDeltas();
+
+	/// Compares pduft with the previous table, appending to to_add the
+	/// entries with the port-ids new in pduft and to to_remove the ones
+	/// with the port-ids gone from it. Their entries belong to the caller.
+	/// Returns true if the kernel table has to be replaced by pduft
+	/// instead, after a reset or a weight change.
+	bool update(const std::list<rina::PDUForwardingTableEntry *>& pduft,
+		    std::list<rina::PDUForwardingTableEntry *>& to_add,
+		    std::list<rina::PDUForwardingTableEntry *>& to_remove);
+
+	/// Forgets the previous table, for the kernel failed to apply the
+	/// changes to it
+	void reset();
+
+	/// Replaces the kernel table every period updates even if they
+	/// succeeded, since the kernel does not report the changes it failed
+	/// to apply. 0 disables it.
+	void set_replace_period(unsigned int period);
+
+private:
+	/// The address, qos-id and port-id of every port-id of an entry
+	struct Port {
+		unsigned int address;
+		unsigned int qos_id;
+		unsigned int port_id;
+
+		bool operator<(const Port& other) const;
+	};
+
+	/// The port-ids of the previous table, sorted, repeated ones included
+	std::vector<Port> previous_;
+	bool replace_;
+	unsigned int replace_period_;
+	unsigned int updates_;
+
+	static void append(std::list<rina::PDUForwardingTableEntry *>& entries,
+			   const Port& port);
+	static void freeEntries(std::list<rina::PDUForwardingTableEntry *>& entries);
 };
 
 class NMinusOneFlowManager: public INMinusOneFlowManager {
@@ -208,7 +274,8 @@ public:
 
 	std::list<rina::PDUForwardingTableEntry> get_pduft_entries();
 	/// This operation takes ownership of the entries
-	void set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft);
+	void set_pduft_entries(const std::list<rina::PDUForwardingTableEntry*>& pduft,
+			       bool replaced);
 
 	std::list<rina::RoutingTableEntry> get_rt_entries();
 	/// This operation takes ownership of the entries
@@ -225,7 +292,7 @@ public:
 
 	void eventHappened(rina::InternalEvent * event);
 
-	void sync_with_kernel();
+	void sync_with_kernel(const KernelStats& stats);
 
 private:
 	/// Create initial RIB objects
@@ -243,13 +310,16 @@ private:
 
 	bool contains_temp_entry(unsigned int dest_address);
 	bool entry_is_in_pduft(unsigned int dest_address);
-	void update_temp_entries(void);
+	bool entry_is_in_pduft(const rina::PDUForwardingTableEntry& entry);
+	void update_temp_entries(bool replaced);
 
 	INMinusOneFlowManager * n_minus_one_flow_manager_;
 	IPCPRIBDaemon * rib_daemon_;
 	rina::Lockable lock;
 
 	std::list<rina::PDUForwardingTableEntry*> temp_entries;
+	/// The destinations of the temporary entries in the kernel table
+	std::set<unsigned int> temp_entries_in_kernel;
 	std::map<std::string, rina::PDUForwardingTableEntry *> pduft;
 	rina::ReadWriteLockable pduft_lock;
 
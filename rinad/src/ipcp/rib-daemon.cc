@@ -23,6 +23,13 @@
 #define IPCP_MODULE "rib-daemon"
 #include "ipcp-logging.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <librina/cdap_v2.h>
 #include <librina/common.h>
 #include <librina/rib_v2.h>
@@ -31,6 +38,8 @@
 #include "common/encoder.h"
 #include "enrollment-task.h"
 
+// Events handled per wake up of the internal flow SDU reactor
+#define MAX_REACTOR_EVENTS 64
 
 namespace rinad {
 
@@ -44,6 +53,7 @@ class IPCPCDAPIOHandler : public rina::cdap::CDAPIOHandler
 {
  public:
 	IPCPCDAPIOHandler(IPCPRIBDaemonImpl * ribd) : rib_daemon(ribd) {};
+	~IPCPCDAPIOHandler();
 	void send(const rina::cdap::cdap_m_t &m_sent,
 		  const rina::cdap_rib::con_handle_t& con_handle);
 
@@ -51,7 +61,16 @@ class IPCPCDAPIOHandler : public rina::cdap::CDAPIOHandler
 			     unsigned int handle,
 			     rina::cdap_rib::cdap_dest_t cdap_dest);
 
+	/// Forgets the lock of a CDAP session that is gone
+	void remove_session_lock(int port_id);
+
  private:
+	struct SessionLock {
+		rina::Lockable lock;
+		/// The map and the senders using it, the last one deletes it
+		unsigned int references;
+	};
+
 	void invoke_callback(rina::cdap_rib::con_handle_t& con_handle,
 			     const rina::cdap::cdap_m_t& m_rcv,
 			     bool is_auth_message);
@@ -62,30 +81,75 @@ class IPCPCDAPIOHandler : public rina::cdap::CDAPIOHandler
 	void forward_adata_msg(const rina::ser_obj_t &message,
 			       unsigned int address);
 
-        // Lock to control that when sending a message requiring
-	// a reply the CDAP Session manager has been updated before
-	// receiving the response message
-        rina::Lockable atomic_send_lock_;
+	SessionLock * acquire_session_lock(int port_id);
+	void release_session_lock(SessionLock * session_lock);
+
+        // Lock per CDAP session to control that when sending a message
+	// requiring a reply the CDAP Session manager has been updated
+	// before receiving the response message, and that the messages of
+	// a session are queued in the order they are encoded
+        std::map<int, SessionLock *> session_locks_;
+        rina::Lockable session_locks_lock_;
         IPCPRIBDaemonImpl * rib_daemon;
 };
 
-void IPCPCDAPIOHandler::__send_message(const rina::cdap_rib::con_handle_t & con_handle,
-				       const rina::ser_obj_t& sdu)
+IPCPCDAPIOHandler::~IPCPCDAPIOHandler()
 {
-	int fd = 0;
-	int ret;
+	std::map<int, SessionLock *>::iterator it;
 
-	fd = rib_daemon->get_fd(con_handle.port_id);
-	if (fd > 0) {
-		//Write to internal reliable N-flow
-		LOG_IPCP_DBG("About to write %d bytes on fd %d from pointer %p",
-				sdu.size_, fd, sdu.message_);
+	for (it = session_locks_.begin(); it != session_locks_.end(); ++it) {
+		delete it->second;
+	}
+}
 
-		ret = write(fd, sdu.message_, sdu.size_);
-		if (ret != sdu.size_) {
-			LOG_IPCP_WARN("Partial write: %d of %d", ret, sdu.size_);
-		}
-	}else {
+IPCPCDAPIOHandler::SessionLock * IPCPCDAPIOHandler::acquire_session_lock(int port_id)
+{
+	std::map<int, SessionLock *>::iterator it;
+	SessionLock * session_lock;
+
+	rina::ScopedLock g(session_locks_lock_);
+
+	it = session_locks_.find(port_id);
+	if (it != session_locks_.end()) {
+		session_lock = it->second;
+	} else {
+		session_lock = new SessionLock();
+		session_lock->references = 1;
+		session_locks_[port_id] = session_lock;
+	}
+
+	session_lock->references++;
+	return session_lock;
+}
+
+void IPCPCDAPIOHandler::release_session_lock(SessionLock * session_lock)
+{
+	rina::ScopedLock g(session_locks_lock_);
+
+	if (--session_lock->references == 0)
+		delete session_lock;
+}
+
+void IPCPCDAPIOHandler::remove_session_lock(int port_id)
+{
+	std::map<int, SessionLock *>::iterator it;
+
+	rina::ScopedLock g(session_locks_lock_);
+
+	it = session_locks_.find(port_id);
+	if (it == session_locks_.end())
+		return;
+
+	if (--it->second->references == 0)
+		delete it->second;
+	session_locks_.erase(it);
+}
+
+void IPCPCDAPIOHandler::__send_message(const rina::cdap_rib::con_handle_t & con_handle,
+				       const rina::ser_obj_t& sdu)
+{
+	//Queue on the internal reliable N-flow, written by flush_sdus
+	if (!rib_daemon->queue_sdu(con_handle.port_id, sdu)) {
 		//Write to N-1 flow
 		rina::kernelIPCProcess->writeMgmgtSDUToPortId(sdu.message_,
 				sdu.size_,
@@ -107,6 +171,7 @@ void IPCPCDAPIOHandler::forward_adata_msg(const rina::ser_obj_t &message,
 	}
 
 	__send_message(con, message);
+	rib_daemon->flush_sdus(con.port_id);
 
 	LOG_IPCP_DBG("Forwarded A-DATA message to IPCP address %u through port-id %u",
 		     address, con.port_id);
@@ -117,9 +182,8 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 {
 	rina::ser_obj_t sdu;
 	rina::cdap::cdap_m_t a_data_m;
-	int fd = 0;
+	SessionLock * session_lock = 0;
 
-	atomic_send_lock_.lock();
 	try {
 		if (con_handle.cdap_dest == rina::cdap_rib::CDAP_DEST_ADATA) {
 			rina::cdap::ADataObject adata;
@@ -145,6 +209,7 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 			manager_->encodeCDAPMessage(a_data_m, sdu);
 
 			__send_message(con_handle, sdu);
+			rib_daemon->flush_sdus(con_handle.port_id);
 
 			LOG_IPCP_DBG("Sent A-Data CDAP message to address %u via port-id %u: \n%s",
 				     con_handle.address,
@@ -155,6 +220,8 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 										true);
 			}
 		} else if (con_handle.cdap_dest == rina::cdap_rib::CDAP_DEST_PORT) {
+			session_lock = acquire_session_lock(con_handle.port_id);
+			session_lock->lock.lock();
 			manager_->encodeNextMessageToBeSent(m_sent,
 							    sdu,
 							    con_handle.port_id);
@@ -168,6 +235,11 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 
 			manager_->messageSent(m_sent,
 					     con_handle.port_id);
+			session_lock->lock.unlock();
+			release_session_lock(session_lock);
+			session_lock = 0;
+
+			rib_daemon->flush_sdus(con_handle.port_id);
 		} else if (con_handle.cdap_dest == rina::cdap_rib::CDAP_DEST_IPCM) {
 			manager_->encodeCDAPMessage(m_sent, sdu);
 			rina::extendedIPCManager->forwardCDAPResponse(con_handle.fwd_mgs_seqn,
@@ -177,6 +249,13 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 				     m_sent.to_string().c_str());
 		}
 	} catch (rina::Exception &e) {
+		// Whatever got queued before the failure still goes out
+		if (session_lock) {
+			session_lock->lock.unlock();
+			release_session_lock(session_lock);
+			rib_daemon->flush_sdus(con_handle.port_id);
+		}
+
 		if (m_sent.invoke_id_ != 0 && m_sent.is_request_message()) {
 			manager_->get_invoke_id_manager()->freeInvokeId(m_sent.invoke_id_,
 									false);
@@ -189,13 +268,10 @@ void IPCPCDAPIOHandler::send(const rina::cdap::cdap_m_t& m_sent,
 			rinad::IPCPFactory::getIPCP()->enrollment_task_->clean_state(con_handle.port_id);
 		}
 
-		atomic_send_lock_.unlock();
-
 		throw e;
 	}
 
 	LOG_IPCP_INFO("Send message at %d", rina::Time::get_time_in_ms());
-	atomic_send_lock_.unlock();
 }
 
 void IPCPCDAPIOHandler::process_message(rina::ser_obj_t &message,
@@ -203,12 +279,14 @@ void IPCPCDAPIOHandler::process_message(rina::ser_obj_t &message,
 		     	     	        rina::cdap_rib::cdap_dest_t cdap_dest)
 {
 	rina::cdap::cdap_m_t m_rcv;
+	// The object value is not copied, it points into message
+	rina::SerObjLoan value(m_rcv.obj_value_);
 
 	LOG_IPCP_INFO("Received message at %d", rina::Time::get_time_in_ms());
 
 	if (cdap_dest == rina::cdap_rib::CDAP_DEST_IPCM) {
 		try {
-			manager_->decodeCDAPMessage(message, m_rcv);
+			manager_->decodeCDAPMessage(message, m_rcv, value);
 			rina::cdap_rib::con_handle_t con_handle;
 			con_handle.cdap_dest = rina::cdap_rib::CDAP_DEST_IPCM;
 			con_handle.fwd_mgs_seqn = handle;
@@ -225,20 +303,27 @@ void IPCPCDAPIOHandler::process_message(rina::ser_obj_t &message,
 	}
 
 	//1 Decode the message and obtain the CDAP session descriptor
-	atomic_send_lock_.lock();
-	try {
-		manager_->messageReceived(message, m_rcv, handle);
-	} catch (rina::Exception &e) {
-		atomic_send_lock_.unlock();
-		throw e;
+	{
+		SessionLock * session_lock = acquire_session_lock(handle);
+
+		session_lock->lock.lock();
+		try {
+			manager_->messageReceived(message, m_rcv, value, handle);
+		} catch (rina::Exception &e) {
+			session_lock->lock.unlock();
+			release_session_lock(session_lock);
+			throw e;
+		}
+		session_lock->lock.unlock();
+		release_session_lock(session_lock);
 	}
-	atomic_send_lock_.unlock();
 
 	//2 If it is an A-Data PDU extract the real message and either forward or process it
 	if (m_rcv.obj_name_ == rina::cdap::ADataObject::A_DATA_OBJECT_NAME) {
 		rina::cdap::ADataObject a_data_obj;
 		encoders::ADataObjectEncoder encoder;
 		rina::cdap::cdap_m_t inner_m;
+		rina::SerObjLoan inner_value(inner_m.obj_value_);
 
 		encoder.decode(m_rcv.obj_value_, a_data_obj);
 		if (a_data_obj.dest_address_ != IPCPFactory::getIPCP()->get_active_address()) {
@@ -246,7 +331,8 @@ void IPCPCDAPIOHandler::process_message(rina::ser_obj_t &message,
 			return;
 		}
 
-		manager_->decodeCDAPMessage(a_data_obj.encoded_cdap_message_, inner_m);
+		manager_->decodeCDAPMessage(a_data_obj.encoded_cdap_message_,
+					    inner_m, inner_value);
 		if (inner_m.invoke_id_ != 0) {
 			if (inner_m.is_request_message()){
 				manager_->get_invoke_id_manager()->reserveInvokeId(inner_m.invoke_id_,
@@ -293,11 +379,8 @@ void IPCPCDAPIOHandler::invoke_callback(rina::cdap_rib::con_handle_t& con_handle
 	obj.class_ = m_rcv.obj_class_;
 	obj.inst_ = m_rcv.obj_inst_;
 	obj.name_ = m_rcv.obj_name_;
-	obj.value_.size_ = m_rcv.obj_value_.size_;
-	obj.value_.message_ = new unsigned char[obj.value_.size_];
-	memcpy(obj.value_.message_,
-	       m_rcv.obj_value_.message_,
-	       m_rcv.obj_value_.size_);
+	// The callbacks only see the value while m_rcv is alive
+	rina::SerObjLoan value(obj.value_, m_rcv.obj_value_);
 	// Filter
 	rina::cdap_rib::filt_info_t filt;
 	filt.filter_ = m_rcv.filter_;
@@ -461,72 +544,396 @@ void RIBDaemonRO::read(const rina::cdap_rib::con_handle_t &con,
         res.code_ = rina::cdap_rib::CDAP_SUCCESS;
 }
 
-// Class InternalFlowSDUReader
-InternalFlowSDUReader::InternalFlowSDUReader(rina::ThreadAttributes * threadAttributes,
-					     int port_id,
-					     int fd_,
-					     int cdaps)
+// Class InternalFlowSDUReactor
+InternalFlowSDUReactor::InternalFlowSDUReactor(rina::ThreadAttributes * threadAttributes)
 		: rina::SimpleThread(threadAttributes)
 {
-	portid = port_id;
-	fd = fd_;
-	cdap_session = cdaps;
+	struct epoll_event event;
+
+	stopping_ = false;
+	next_id_ = 1;
+
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd_ < 0) {
+		LOG_IPCP_ERR("Could not create epoll instance: %d", errno);
+		throw rina::Exception("Could not create epoll instance");
+	}
+
+	// Id 0 is the wake up of stop()
+	wakeup_fd_ = eventfd(0, EFD_CLOEXEC);
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u64 = 0;
+	if (wakeup_fd_ < 0 ||
+			epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) < 0) {
+		LOG_IPCP_ERR("Could not watch the wake up eventfd: %d", errno);
+		if (wakeup_fd_ >= 0)
+			close(wakeup_fd_);
+		close(epoll_fd_);
+		throw rina::Exception("Could not watch the wake up eventfd");
+	}
 }
 
-int InternalFlowSDUReader::run()
+InternalFlowSDUReactor::~InternalFlowSDUReactor() throw()
 {
-	rina::ser_obj_t message;
-	rina::cdap_rib::con_handle_t con_handle;
+	std::map<unsigned int, std::vector<unsigned char *> >::iterator it;
+	std::map<uint64_t, Connection *>::iterator jt;
 
-	message.message_ = new unsigned char[5000];
-	int bytes_read = 0;
-	bool keep_going = true;
-
-	LOG_IPCP_DBG("Internal flow SDU reader of port-id %d starting. "
-		     "Attached to CDAP session %d",
-		     portid, cdap_session);
+	for (it = buffers_.begin(); it != buffers_.end(); ++it) {
+		for (unsigned int i = 0; i < it->second.size(); i++) {
+			delete[] it->second[i];
+		}
+	}
+	for (jt = connections_.begin(); jt != connections_.end(); ++jt) {
+		delete jt->second;
+	}
 
-	while(keep_going) {
-		bytes_read = read(fd, message.message_, 5000);
-		LOG_IPCP_DBG("Got message %d bytes of port-id %d, "
-				"handling to CDAP Provider",
-				bytes_read,
-				portid);
+	close(wakeup_fd_);
+	close(epoll_fd_);
+}
 
-		if (bytes_read < 0) {
+int InternalFlowSDUReactor::run()
+{
+	struct epoll_event events[MAX_REACTOR_EVENTS];
+	Connection * connection;
+	uint64_t wakeups;
+	int n;
+
+	LOG_IPCP_DBG("Internal flow SDU reactor starting");
+
+	while (true) {
+		n = epoll_wait(epoll_fd_, events, MAX_REACTOR_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			LOG_IPCP_ERR("Problems waiting for internal flows: %d", errno);
 			break;
 		}
 
-		//Instruct CDAP provider to process the CACEP message
-		try{
-			message.size_ = bytes_read;
-			rina::cdap::getProvider()->process_message(message,
-								   cdap_session);
-		} catch(rina::Exception &e){
-			LOG_ERR("Problems processing message from port-id %d and CDAP session id %d: %s",
-				portid, cdap_session, e.what());
-			if (std::string(e.what()).find("M_CONNECT received on an") != std::string::npos) {
-				LOG_IPCP_WARN("Closing CDAP session on port-id %u", cdap_session);
-				con_handle.port_id = cdap_session;
-				rinad::IPCPFactory::getIPCP()->enrollment_task_->release(0, con_handle);
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.u64 == 0) {
+				if (read(wakeup_fd_, &wakeups, sizeof(wakeups)) < 0) {
+					LOG_IPCP_WARN("Could not read the wake up eventfd: %d",
+						      errno);
+				}
+				continue;
 			}
+
+			// Flows removed since epoll_wait returned are gone
+			connection = acquire(events[i].data.u64);
+			if (!connection)
+				continue;
+			if (events[i].events & EPOLLOUT)
+				writable(connection);
+			if (events[i].events & ~EPOLLOUT)
+				read_sdu(connection);
+			release(connection);
 		}
+
+		rina::ScopedLock g(connections_lock_);
+		if (stopping_)
+			break;
 	}
 
-	LOG_DBG("Internal flow SDU Reader of port-id %d terminating", portid);
+	LOG_IPCP_DBG("Internal flow SDU reactor terminating");
 
 	return 0;
 }
 
+void InternalFlowSDUReactor::read_sdu(Connection * connection)
+{
+	rina::cdap_rib::con_handle_t con_handle;
+	std::vector<unsigned char *>& free_buffers = buffers_[connection->max_sdu_size];
+	unsigned char * buffer;
+	int bytes_read;
+
+	if (free_buffers.empty()) {
+		buffer = new unsigned char[connection->max_sdu_size];
+	} else {
+		buffer = free_buffers.back();
+		free_buffers.pop_back();
+	}
+
+	bytes_read = read(connection->fd, buffer, connection->max_sdu_size);
+	if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		free_buffers.push_back(buffer);
+		return;
+	}
+	LOG_IPCP_DBG("Got message %d bytes of port-id %d, "
+		     "handling to CDAP Provider",
+		     bytes_read,
+		     connection->port_id);
+
+	// The flow has been deallocated (SDUs are never empty), stop watching
+	// it until it is removed
+	if (bytes_read <= 0) {
+		LOG_IPCP_DBG("Internal flow of port-id %d is gone",
+			     connection->port_id);
+		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, NULL);
+		free_buffers.push_back(buffer);
+		return;
+	}
+
+	//Instruct CDAP provider to process the CACEP message
+	try {
+		rina::ser_obj_t message;
+		rina::SerObjLoan loan(message, buffer, bytes_read);
+
+		rina::cdap::getProvider()->process_message(message,
+							   connection->cdap_session);
+	} catch(rina::Exception &e) {
+		LOG_ERR("Problems processing message from port-id %d and CDAP session id %d: %s",
+			connection->port_id, connection->cdap_session, e.what());
+		if (std::string(e.what()).find("M_CONNECT received on an") != std::string::npos) {
+			LOG_IPCP_WARN("Closing CDAP session on port-id %u",
+				      connection->cdap_session);
+			con_handle.port_id = connection->cdap_session;
+			rinad::IPCPFactory::getIPCP()->enrollment_task_->release(0, con_handle);
+		}
+	}
+
+	free_buffers.push_back(buffer);
+}
+
+void InternalFlowSDUReactor::add(int port_id, int fd, int cdap_session,
+				 unsigned int max_sdu_size)
+{
+	std::map<int, Connection *>::iterator it;
+	struct epoll_event event;
+	Connection * connection;
+
+	rina::ScopedLock g(connections_lock_);
+
+	it = sessions_.find(cdap_session);
+	if (it != sessions_.end()) {
+		__remove(it->second);
+	}
+
+	connection = new Connection();
+	connection->id = next_id_++;
+	connection->port_id = port_id;
+	connection->fd = fd;
+	connection->cdap_session = cdap_session;
+	connection->max_sdu_size = max_sdu_size;
+	connection->references = 1;
+	connection->writing = false;
+	connection->blocked = false;
+	connection->removed = false;
+
+	// Writes that would block wait for EPOLLOUT instead
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+		LOG_IPCP_ERR("Could not make the internal flow of port-id %d non-blocking: %d",
+			     port_id, errno);
+		delete connection;
+		return;
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u64 = connection->id;
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+		LOG_IPCP_ERR("Could not watch the internal flow of port-id %d: %d",
+			     port_id, errno);
+		delete connection;
+		return;
+	}
+
+	connections_[connection->id] = connection;
+	sessions_[cdap_session] = connection;
+
+	LOG_IPCP_DBG("Reading internal flow of port-id %d, attached to CDAP session %d",
+		     port_id, cdap_session);
+}
+
+void InternalFlowSDUReactor::remove(int port_id)
+{
+	std::map<int, Connection *>::iterator it;
+
+	rina::ScopedLock g(connections_lock_);
+
+	for (it = sessions_.begin(); it != sessions_.end(); ++it) {
+		if (it->second->port_id == port_id) {
+			__remove(it->second);
+			return;
+		}
+	}
+}
+
+void InternalFlowSDUReactor::__remove(Connection * connection)
+{
+	// The fd may be closed already, which removes it from epoll too
+	connection->lock.lock();
+	connection->removed = true;
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, NULL);
+	connection->lock.unlock();
+	connections_.erase(connection->id);
+	sessions_.erase(connection->cdap_session);
+	if (--connection->references == 0)
+		delete connection;
+}
+
+void InternalFlowSDUReactor::stop()
+{
+	uint64_t wakeup = 1;
+
+	connections_lock_.lock();
+	stopping_ = true;
+	connections_lock_.unlock();
+
+	if (write(wakeup_fd_, &wakeup, sizeof(wakeup)) < 0) {
+		LOG_IPCP_ERR("Could not wake up the internal flow SDU reactor: %d",
+			     errno);
+	}
+}
+
+InternalFlowSDUReactor::Connection * InternalFlowSDUReactor::acquire(uint64_t id)
+{
+	std::map<uint64_t, Connection *>::iterator it;
+
+	rina::ScopedLock g(connections_lock_);
+
+	it = connections_.find(id);
+	if (it == connections_.end())
+		return 0;
+
+	it->second->references++;
+	return it->second;
+}
+
+InternalFlowSDUReactor::Connection * InternalFlowSDUReactor::acquire_session(int cdap_session)
+{
+	std::map<int, Connection *>::iterator it;
+
+	rina::ScopedLock g(connections_lock_);
+
+	it = sessions_.find(cdap_session);
+	if (it == sessions_.end())
+		return 0;
+
+	it->second->references++;
+	return it->second;
+}
+
+void InternalFlowSDUReactor::release(Connection * connection)
+{
+	rina::ScopedLock g(connections_lock_);
+
+	if (--connection->references == 0)
+		delete connection;
+}
+
+bool InternalFlowSDUReactor::queue(int cdap_session, const rina::ser_obj_t& sdu)
+{
+	Connection * connection = acquire_session(cdap_session);
+
+	if (!connection)
+		return false;
+
+	connection->lock.lock();
+	connection->queue.push_back(std::vector<unsigned char>(sdu.message_,
+							       sdu.message_ + sdu.size_));
+	connection->lock.unlock();
+
+	release(connection);
+
+	return true;
+}
+
+void InternalFlowSDUReactor::flush(int cdap_session)
+{
+	Connection * connection = acquire_session(cdap_session);
+
+	if (!connection)
+		return;
+
+	write_sdus(connection);
+	release(connection);
+}
+
+void InternalFlowSDUReactor::write_sdus(Connection * connection)
+{
+	struct epoll_event event;
+	std::vector<unsigned char> sdu;
+	int ret, error;
+
+	connection->lock.lock();
+	if (connection->writing || connection->blocked) {
+		connection->lock.unlock();
+		return;
+	}
+
+	// Write without the lock, so that other senders can keep queueing
+	connection->writing = true;
+	while (!connection->queue.empty()) {
+		sdu.swap(connection->queue.front());
+		connection->queue.pop_front();
+		connection->lock.unlock();
+
+		//Write to internal reliable N-flow
+		LOG_IPCP_DBG("About to write %d bytes on fd %d",
+			     (int) sdu.size(), connection->fd);
+		ret = write(connection->fd, &sdu[0], sdu.size());
+		error = errno;
+
+		connection->lock.lock();
+		if (ret < 0 && (error == EAGAIN || error == EWOULDBLOCK)) {
+			// The flow is full: keep the SDU first in the queue
+			// and have the reactor write the rest
+			connection->queue.push_front(std::vector<unsigned char>());
+			connection->queue.front().swap(sdu);
+			connection->blocked = true;
+			if (!connection->removed) {
+				memset(&event, 0, sizeof(event));
+				event.events = EPOLLIN | EPOLLOUT;
+				event.data.u64 = connection->id;
+				epoll_ctl(epoll_fd_, EPOLL_CTL_MOD,
+					  connection->fd, &event);
+			}
+			break;
+		}
+		if (ret != (int) sdu.size()) {
+			LOG_IPCP_WARN("Partial write: %d of %d", ret, (int) sdu.size());
+		}
+	}
+	connection->writing = false;
+	connection->lock.unlock();
+}
+
+void InternalFlowSDUReactor::writable(Connection * connection)
+{
+	struct epoll_event event;
+
+	connection->lock.lock();
+	connection->blocked = false;
+	if (!connection->removed) {
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.u64 = connection->id;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+	}
+	connection->lock.unlock();
+
+	write_sdus(connection);
+}
+
 //Class IPCPRIBDaemonImpl
 IPCPRIBDaemonImpl::IPCPRIBDaemonImpl(rina::cacep::AppConHandlerInterface *app_con_callback)
 {
 	n_minus_one_flow_manager_ = 0;
+	iflow_sdu_reactor = 0;
 	initialize_rib_daemon(app_con_callback);
 }
 
 IPCPRIBDaemonImpl::~IPCPRIBDaemonImpl()
 {
+	void * status;
+
+	if (iflow_sdu_reactor) {
+		iflow_sdu_reactor->stop();
+		iflow_sdu_reactor->join(&status);
+		delete iflow_sdu_reactor;
+	}
+
 	rina::rib::fini();
 }
 
@@ -623,6 +1030,7 @@ void IPCPRIBDaemonImpl::eventHappened(rina::InternalEvent * event)
 void IPCPRIBDaemonImpl::nMinusOneFlowDeallocated(int portId)
 {
         rina::cdap::getProvider()->get_session_manager()->removeCDAPSession(portId);
+        io_handler->remove_session_lock(portId);
 }
 
 void IPCPRIBDaemonImpl::nMinusOneFlowAllocated(rina::NMinusOneFlowAllocatedEvent * event)
@@ -664,75 +1072,65 @@ void IPCPRIBDaemonImpl::removeObjRIB(const std::string& fqn)
 	ribd->removeObjRIB(rib, fqn);
 }
 
+void IPCPRIBDaemonImpl::updateObjsRIB(const std::list<std::string>& to_remove,
+				      std::list<std::pair<std::string, rina::rib::RIBObj*> >& to_add)
+{
+	ribd->updateObjsRIB(rib, to_remove, to_add);
+}
+
 void IPCPRIBDaemonImpl::start_internal_flow_sdu_reader(int port_id,
 						       int fd,
-						       int cdap_session)
+						       int cdap_session,
+						       unsigned int max_sdu_size)
 {
 	rina::ThreadAttributes thread_attrs;
-	std::stringstream ss;
-	InternalFlowSDUReader * reader = 0;
 
 	rina::ScopedLock g(iflow_readers_lock);
 
-	fds[cdap_session] = fd;
+	if (!iflow_sdu_reactor) {
+		thread_attrs.setJoinable();
+		thread_attrs.setName("Internal Flow SDU Reactor");
+		iflow_sdu_reactor = new InternalFlowSDUReactor(&thread_attrs);
+		iflow_sdu_reactor->start();
+	}
 
-	thread_attrs.setJoinable();
-	ss << "Internal Flow SDU Reader of port-id " << port_id;
-	thread_attrs.setName(ss.str());
-	reader = new InternalFlowSDUReader(&thread_attrs, port_id, fd, cdap_session);
-	reader->start();
+	if (max_sdu_size == 0)
+		max_sdu_size = IPCProcess::DEFAULT_MAX_SDU_SIZE_IN_BYTES;
 
-	iflow_sdu_readers[port_id] = reader;
+	iflow_sdu_reactor->add(port_id, fd, cdap_session, max_sdu_size);
 }
 
 void IPCPRIBDaemonImpl::stop_internal_flow_sdu_reader(int port_id)
 {
-	rina::TimerTask * timer_task = new StopInternalFlowReaderTimerTask(this, port_id);
-	timer.scheduleTask(timer_task, 0);
-}
-
-int IPCPRIBDaemonImpl::get_fd(unsigned int cdap_session)
-{
-	std::map<int, int>::iterator it;
-
 	rina::ScopedLock g(iflow_readers_lock);
 
-	it = fds.find(cdap_session);
-	if (it != fds.end()) {
-		return it->second;
-	}
-
-	return -1;
+	if (iflow_sdu_reactor)
+		iflow_sdu_reactor->remove(port_id);
 }
 
-void IPCPRIBDaemonImpl::__stop_internal_flow_sdu_reader(int port_id)
+bool IPCPRIBDaemonImpl::queue_sdu(unsigned int cdap_session,
+				  const rina::ser_obj_t& sdu)
 {
-	std::map<int, InternalFlowSDUReader *>::iterator it;
-	void * status;
-	InternalFlowSDUReader * reader;
+	InternalFlowSDUReactor * reactor;
 
-	rina::ScopedLock g(iflow_readers_lock);
+	iflow_readers_lock.lock();
+	reactor = iflow_sdu_reactor;
+	iflow_readers_lock.unlock();
 
-	it = iflow_sdu_readers.find(port_id);
-	if (it != iflow_sdu_readers.end()) {
-		reader = it->second;
-		iflow_sdu_readers.erase(it);
-		fds.erase(reader->cdap_session);
-		reader->join(&status);
-		delete reader;
-	}
+	return reactor && reactor->queue(cdap_session, sdu);
 }
 
-// Class StopInternalFlowReaderTimerTask
-StopInternalFlowReaderTimerTask::StopInternalFlowReaderTimerTask(IPCPRIBDaemonImpl * ribd, int pid)
+void IPCPRIBDaemonImpl::flush_sdus(unsigned int cdap_session)
 {
-	rib_daemon = ribd;
-	port_id = pid;
-}
+	InternalFlowSDUReactor * reactor;
 
-void StopInternalFlowReaderTimerTask::run()
-{
-	rib_daemon->__stop_internal_flow_sdu_reader(port_id);
+	iflow_readers_lock.lock();
+	reactor = iflow_sdu_reactor;
+	iflow_readers_lock.unlock();
+
+	// The reactor lives as long as the RIB daemon
+	if (reactor)
+		reactor->flush(cdap_session);
 }
 
 void IPCPRIBDaemonImpl::processReadManagementSDUEvent(const rina::ReadMgmtSDUResponseEvent& event)
@@ -23,6 +23,11 @@
 #ifndef IPCP_RIB_DAEMON_HH
 #define IPCP_RIB_DAEMON_HH
 
+#include <list>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
 #include <librina/cdap_v2.h>
 #include <librina/concurrency.h>
 
@@ -56,23 +61,75 @@ private:
         rina::rib::rib_handle_t rib;
 };
 
-/// Reads layer management SDUs from internal flows
-class InternalFlowSDUReader : public rina::SimpleThread
+/// Reads the layer management SDUs of all the internal flows from a single
+/// thread, waiting for them with epoll, into pooled buffers of the maximum
+/// SDU size of each flow, and passes them to the CDAP provider. It also
+/// keeps a send queue per internal flow: senders append their SDUs to it,
+/// and the one that finds nobody writing writes them all out, so that
+/// senders to different neighbours never wait for each other. The flows
+/// are non-blocking: when one is full its queue waits for the reactor to
+/// see it writable, so a slow neighbour never stops the reads of the
+/// others.
+class InternalFlowSDUReactor : public rina::SimpleThread
 {
 public:
-	InternalFlowSDUReader(rina::ThreadAttributes * threadAttributes,
-			      int port_id,
-			      int fd_,
-			      int cdap_session);
-	~InternalFlowSDUReader() throw() {};
+	InternalFlowSDUReactor(rina::ThreadAttributes * threadAttributes);
+	~InternalFlowSDUReactor() throw();
 	int run();
 
-	int portid;
-	int cdap_session;
-	int fd;
+	/// Starts reading the internal flow of a CDAP session
+	void add(int port_id, int fd, int cdap_session,
+		 unsigned int max_sdu_size);
+	/// Stops reading the internal flow and drops its send queue
+	void remove(int port_id);
+	/// Makes run() return
+	void stop();
+
+	/// Appends a copy of sdu to the send queue of the internal flow of
+	/// cdap_session. Returns false if the session has no internal flow.
+	bool queue(int cdap_session, const rina::ser_obj_t& sdu);
+	/// Writes the SDUs queued for cdap_session, unless another thread
+	/// is already at it or the flow is full
+	void flush(int cdap_session);
+
+private:
+	struct Connection {
+		uint64_t id;
+		int port_id;
+		int fd;
+		int cdap_session;
+		unsigned int max_sdu_size;
+		/// Threads using the connection, which is deleted by the
+		/// last one once it is removed
+		unsigned int references;
+		bool writing;
+		/// The flow was full, the reactor waits for it to be writable
+		bool blocked;
+		bool removed;
+		std::list<std::vector<unsigned char> > queue;
+		rina::Lockable lock;
+	};
+
+	int epoll_fd_;
+	int wakeup_fd_;
+	bool stopping_;
+	uint64_t next_id_;
+	/// By id, which is what epoll reports, and by CDAP session
+	std::map<uint64_t, Connection *> connections_;
+	std::map<int, Connection *> sessions_;
+	rina::Lockable connections_lock_;
+	/// Free read buffers by size, only used by the reactor thread
+	std::map<unsigned int, std::vector<unsigned char *> > buffers_;
+
+	Connection * acquire(uint64_t id);
+	Connection * acquire_session(int cdap_session);
+	void release(Connection * connection);
+	void __remove(Connection * connection);
+	void read_sdu(Connection * connection);
+	void write_sdus(Connection * connection);
+	void writable(Connection * connection);
 };
 
-class StopInternalFlowReaderTimerTask;
 class IPCPCDAPIOHandler;
 
 ///Full implementation of the RIB Daemon
@@ -88,16 +145,21 @@ public:
         const rina::rib::rib_handle_t & get_rib_handle();
         int64_t addObjRIB(const std::string& fqn, rina::rib::RIBObj** obj);
         void removeObjRIB(const std::string& fqn);
+        void updateObjsRIB(const std::list<std::string>& to_remove,
+        		   std::list<std::pair<std::string, rina::rib::RIBObj*> >& to_add);
         void start_internal_flow_sdu_reader(int port_id,
         				    int fd,
-					    int cdap_session);
+					    int cdap_session,
+					    unsigned int max_sdu_size);
         void stop_internal_flow_sdu_reader(int port_id);
         void processReadManagementSDUEvent(const rina::ReadMgmtSDUResponseEvent& event);
-        int get_fd(unsigned int cdap_session);
 
-private:
-        friend class StopInternalFlowReaderTimerTask;
+        /// Queues the SDU on the internal flow of the CDAP session, to be
+        /// written by flush_sdus. Returns false if there is no such flow.
+        bool queue_sdu(unsigned int cdap_session, const rina::ser_obj_t& sdu);
+        void flush_sdus(unsigned int cdap_session);
 
+private:
 	//Handle to the RIB
 	rina::rib::rib_handle_t rib;
 	rina::Timer timer;
@@ -105,12 +167,8 @@ private:
         rina::Thread * management_sdu_reader_;
         IPCPCDAPIOHandler * io_handler;
 
-        /// Lock to control that when sending a message requiring a reply the
-        /// CDAP Session manager has been updated before receiving the response message
-        rina::Lockable atomic_send_lock_;
-
-        std::map<int, InternalFlowSDUReader *> iflow_sdu_readers;
-        std::map<int, int> fds;
+        /// Started with the first internal flow
+        InternalFlowSDUReactor * iflow_sdu_reactor;
         rina::Lockable iflow_readers_lock;
 
         void initialize_rib_daemon(rina::cacep::AppConHandlerInterface *app_con_callback);
@@ -121,24 +179,12 @@ private:
         /// any CDAP sessions over it should be terminated.
         void nMinusOneFlowDeallocated(int portId);
         void nMinusOneFlowAllocated(rina::NMinusOneFlowAllocatedEvent * event);
-
-        void __stop_internal_flow_sdu_reader(int port_id);
 };
 
 /// The RIB Daemon will start a thread that continuously tries to retrieve management
 /// SDUs directed to this IPC Process
 void * doManagementSDUReaderWork(void* data);
 
-class StopInternalFlowReaderTimerTask: public rina::TimerTask {
-public:
-	StopInternalFlowReaderTimerTask(IPCPRIBDaemonImpl * ribd, int pid);
-	void run();
-
-private:
-	IPCPRIBDaemonImpl * rib_daemon;
-	int port_id;
-};
-
 } //namespace rinad
 
 #endif //IPCP_RIB_DAEMON_HH
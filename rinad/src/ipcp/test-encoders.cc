@@ -31,6 +31,7 @@
 #include "common/encoder.h"
 #include "ipcp/enrollment-task.h"
 #include "ipcp/flow-allocator.h"
+#include "ipcp/resource-allocator.h"
 
 int ipcp_id = 1;
 
@@ -668,6 +669,46 @@ bool test_pduft_entry() {
     return true;
 }
 
+bool test_rmt_n1_flow() {
+    rinad::RMTN1FlowEncoder encoder;
+    rinad::RMTN1Flow flow(7, 1);
+    rinad::RMTN1Flow recovered_obj(0, 1);
+    rina::ser_obj_t encoded_obj;
+
+    flow.enabled = false;
+    flow.queued_pdus = 3;
+    flow.dropped_pdus = 4;
+    flow.error_pdus = 5;
+    flow.tx_pdus = 600;
+    flow.rx_pdus = 700;
+    flow.tx_bytes = 5000000000UL;
+    flow.rx_bytes = 6000000000UL;
+
+    encoder.encode(flow, encoded_obj);
+    encoder.decode(encoded_obj, recovered_obj);
+
+    if (flow.port_id != recovered_obj.port_id)
+        return false;
+
+    if (flow.enabled != recovered_obj.enabled)
+        return false;
+
+    if (flow.queued_pdus != recovered_obj.queued_pdus ||
+            flow.dropped_pdus != recovered_obj.dropped_pdus ||
+            flow.error_pdus != recovered_obj.error_pdus)
+        return false;
+
+    if (flow.tx_pdus != recovered_obj.tx_pdus ||
+            flow.rx_pdus != recovered_obj.rx_pdus)
+        return false;
+
+    if (flow.tx_bytes != recovered_obj.tx_bytes ||
+            flow.rx_bytes != recovered_obj.rx_bytes)
+        return false;
+
+    LOG_IPCP_INFO("RMT N-1 Flow Encoder tested successfully");
+    return true;
+}
 
 bool test_ribobjectdatalist() {
     rinad::encoders::RIBObjectDataListEncoder encoder;
@@ -808,6 +849,12 @@ int main()
 		return -1;
 	}
 
+	result = test_rmt_n1_flow();
+	if (!result) {
+		LOG_IPCP_ERR("Problems testing RMT N-1 Flow Encoder");
+		return -1;
+	}
+
         result = test_ribobjectdatalist();
         if (!result) {
                 LOG_IPCP_ERR("Problems testing RIBObjectDataList Encoder");
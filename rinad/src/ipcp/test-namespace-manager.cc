@@ -0,0 +1,149 @@
+//
+// test-namespace-manager
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301  USA
+//
+
+#include <list>
+#include <map>
+#include <set>
+
+#define IPCP_MODULE "namespace-manager-tests"
+
+#include "ipcp-logging.h"
+
+#include "ipcp/namespace-manager.h"
+
+int ipcp_id = 1;
+
+typedef std::map<std::set<int>, rinad::DFTUpdateQueue::Batch> batches_t;
+
+static rina::DirectoryForwardingTableEntry dft_entry(unsigned int address)
+{
+	rina::DirectoryForwardingTableEntry entry;
+
+	entry.ap_naming_info_ = rina::ApplicationProcessNamingInformation("app", "1");
+	entry.address_ = address;
+
+	return entry;
+}
+
+static std::list<int> neighs(int port_id)
+{
+	std::list<int> result;
+
+	result.push_back(port_id);
+
+	return result;
+}
+
+/// Counts the pending creates and deletes of key in all the batches
+static void count_updates(const batches_t& batches, const std::string& key,
+			  int& creates, int& deletes)
+{
+	batches_t::const_iterator it;
+
+	creates = 0;
+	deletes = 0;
+	for (it = batches.begin(); it != batches.end(); ++it) {
+		creates += it->second.created.count(key);
+		deletes += it->second.deleted.count(key);
+	}
+}
+
+bool test_creates_with_different_exclusions()
+{
+	rinad::DFTUpdateQueue queue;
+	std::list<rina::DirectoryForwardingTableEntry> created;
+	batches_t batches;
+	std::string key = dft_entry(0).getKey();
+	int creates, deletes;
+
+	created.push_back(dft_entry(1));
+	queue.add(created, std::list<std::string>(), neighs(1));
+	created.clear();
+	created.push_back(dft_entry(2));
+	queue.add(created, std::list<std::string>(), neighs(2));
+	queue.take(batches);
+
+	count_updates(batches, key, creates, deletes);
+	if (creates != 1 || deletes != 0) {
+		LOG_IPCP_ERR("Key in %d creates and %d deletes", creates, deletes);
+		return false;
+	}
+
+	std::set<int> excluded;
+	excluded.insert(2);
+	if (batches[excluded].created.count(key) == 0 ||
+			batches[excluded].created[key].address_ != 2) {
+		LOG_IPCP_ERR("The last create does not win");
+		return false;
+	}
+
+	if (!queue.empty()) {
+		LOG_IPCP_ERR("Batches still pending after take");
+		return false;
+	}
+
+	return true;
+}
+
+bool test_create_then_delete()
+{
+	rinad::DFTUpdateQueue queue;
+	std::list<rina::DirectoryForwardingTableEntry> created;
+	std::list<std::string> deleted;
+	batches_t batches;
+	std::string key = dft_entry(0).getKey();
+	int creates, deletes;
+
+	created.push_back(dft_entry(1));
+	queue.add(created, std::list<std::string>(), neighs(1));
+	deleted.push_back(key);
+	queue.add(std::list<rina::DirectoryForwardingTableEntry>(),
+		  deleted, neighs(2));
+	created.clear();
+	created.push_back(dft_entry(3));
+	queue.add(created, std::list<std::string>(), neighs(3));
+	queue.add(std::list<rina::DirectoryForwardingTableEntry>(),
+		  deleted, neighs(4));
+	queue.take(batches);
+
+	count_updates(batches, key, creates, deletes);
+	if (creates != 0 || deletes != 1) {
+		LOG_IPCP_ERR("Key in %d creates and %d deletes", creates, deletes);
+		return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	bool result = test_creates_with_different_exclusions();
+	if (!result) {
+		LOG_IPCP_ERR("Problems testing creates of a DFT entry excluding different neighbors");
+		return -1;
+	}
+
+	result = test_create_then_delete();
+	if (!result) {
+		LOG_IPCP_ERR("Problems testing creates and deletes of a DFT entry");
+		return -1;
+	}
+
+	return 0;
+}
@@ -21,10 +21,14 @@
 #define IPCP_MODULE "utils"
 #include "ipcp-logging.h"
 
+#include <cerrno>
 #include <cstdlib>
+#include <fcntl.h>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <time.h>
+#include <unistd.h>
 
 #include "utils.h"
 
@@ -173,6 +177,7 @@ const std::string SysfsHelper::ipcp_prefix = "/sys/rina/ipcps/";
 const std::string SysfsHelper::connections = "/connections/";
 const std::string SysfsHelper::rmt_ports = "/rmt/n1_ports/";
 const std::string SysfsHelper::separator = "/";
+const std::string SysfsHelper::stats = "/stats";
 
 int SysfsHelper::get_dtp_tx_bytes(int ipcp_id,
 				  int src_cep_id,
@@ -357,4 +362,141 @@ int SysfsHelper::get_rmt_rx_bytes(int ipcp_id,
 	return get_value_as_ulong(file_name, value);
 }
 
+//Class KernelStats
+int KernelStats::read(int ipcp_id)
+{
+	std::stringstream ss;
+	Record records[128];
+	ssize_t bytes;
+	int fd;
+
+	connections.clear();
+	n1_ports.clear();
+	available = false;
+
+	ss << SysfsHelper::ipcp_prefix << ipcp_id << SysfsHelper::stats;
+	fd = open(ss.str().c_str(), O_RDONLY);
+	if (fd < 0) {
+		LOG_IPCP_DBG("Problems opening file: %s", ss.str().c_str());
+		return -1;
+	}
+
+	// The kernel only returns whole records, up to a page per read
+	for (;;) {
+		bytes = ::read(fd, records, sizeof(records));
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			break;
+
+		for (unsigned int i = 0; i < bytes / sizeof(Record); i++) {
+			if (records[i].type == CONNECTION)
+				connections[records[i].id] = records[i];
+			else if (records[i].type == N1_PORT)
+				n1_ports[records[i].id] = records[i];
+		}
+	}
+	close(fd);
+
+	if (bytes < 0) {
+		LOG_IPCP_DBG("Problems reading file: %s", ss.str().c_str());
+		return -1;
+	}
+
+	available = true;
+
+	return 0;
+}
+
+const KernelStats::Record * KernelStats::get_connection(int src_cep_id) const
+{
+	std::map<int, Record>::const_iterator it = connections.find(src_cep_id);
+
+	return it == connections.end() ? NULL : &it->second;
+}
+
+const KernelStats::Record * KernelStats::get_n1_port(int port_id) const
+{
+	std::map<int, Record>::const_iterator it = n1_ports.find(port_id);
+
+	return it == n1_ports.end() ? NULL : &it->second;
+}
+
+//Class KernelStatsCache
+const unsigned int KernelStatsCache::DEFAULT_TTL_IN_MS = 1000;
+
+static unsigned long long monotonic_time_ms()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+KernelStatsCache::KernelStatsCache(int id)
+{
+	ipcp_id = id;
+	ttl_ms = DEFAULT_TTL_IN_MS;
+	read_time_ms = 0;
+}
+
+void KernelStatsCache::set_ttl(unsigned int ttl)
+{
+	rina::ScopedLock g(lock);
+
+	ttl_ms = ttl;
+}
+
+void KernelStatsCache::refresh()
+{
+	unsigned long long now = monotonic_time_ms();
+
+	// Failed reads are cached too, so that a kernel without the
+	// counters is not asked again on every lookup
+	if (read_time_ms && now - read_time_ms < ttl_ms)
+		return;
+
+	stats.read(ipcp_id);
+	read_time_ms = now;
+}
+
+bool KernelStatsCache::get_connection(int src_cep_id, KernelStats::Record& record)
+{
+	rina::ScopedLock g(lock);
+	const KernelStats::Record * cached;
+
+	refresh();
+	cached = stats.get_connection(src_cep_id);
+	if (!cached)
+		return false;
+
+	record = *cached;
+	return true;
+}
+
+bool KernelStatsCache::get_n1_port(int port_id, KernelStats::Record& record)
+{
+	rina::ScopedLock g(lock);
+	const KernelStats::Record * cached;
+
+	refresh();
+	cached = stats.get_n1_port(port_id);
+	if (!cached)
+		return false;
+
+	record = *cached;
+	return true;
+}
+
+void KernelStatsCache::update(const KernelStats& new_stats)
+{
+	rina::ScopedLock g(lock);
+
+	if (!new_stats.available)
+		return;
+
+	stats = new_stats;
+	read_time_ms = monotonic_time_ms();
+}
+
 } //namespace rinad
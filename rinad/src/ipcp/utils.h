@@ -21,8 +21,78 @@
 #ifndef IPCP_UTILS_HH
 #define IPCP_UTILS_HH
 
+#include <map>
+#include <stdint.h>
+#include <string>
+
+#include <librina/concurrency.h>
+
 namespace rinad {
 
+/// The DTP and RMT counters of an IPC Process, read at once from its
+/// "stats" sysfs file instead of one sysfs file per counter
+class KernelStats {
+public:
+	/// Counters of a connection or an N-1 port, same layout as the
+	/// kernel struct ipcp_stats_record
+	struct Record {
+		uint32_t type;
+		int32_t id;
+		/// Connection: tx_bytes, rx_bytes, tx_pdus, rx_pdus,
+		/// drop_pdus, err_pdus. N-1 port: queued_pdus, drop_pdus,
+		/// err_pdus, tx_pdus, rx_pdus, tx_bytes, rx_bytes
+		uint32_t values[7];
+	};
+
+	enum RecordType {
+		CONNECTION = 1,
+		N1_PORT
+	};
+
+	KernelStats() : available(false) { };
+
+	/// Returns -1 if the file cannot be read, e.g. with an older kernel
+	int read(int ipcp_id);
+	const Record * get_connection(int src_cep_id) const;
+	const Record * get_n1_port(int port_id) const;
+
+	/// True if the last read succeeded
+	bool available;
+
+private:
+	std::map<int, Record> connections;
+	std::map<int, Record> n1_ports;
+};
+
+/// Keeps the KernelStats of an IPC Process for a short time, so that RIB
+/// objects can fetch their counters when they are read instead of relying
+/// on the periodic sync with the kernel
+class KernelStatsCache {
+public:
+	static const unsigned int DEFAULT_TTL_IN_MS;
+
+	KernelStatsCache(int ipcp_id);
+	void set_ttl(unsigned int ttl_ms);
+
+	/// Copy the counters of a connection or an N-1 port into record,
+	/// re-reading them if they are older than the TTL. Return false if
+	/// the kernel does not export them.
+	bool get_connection(int src_cep_id, KernelStats::Record& record);
+	bool get_n1_port(int port_id, KernelStats::Record& record);
+
+	/// Replace the cached counters with the ones of a periodic sync
+	void update(const KernelStats& stats);
+
+private:
+	void refresh();
+
+	rina::Lockable lock;
+	int ipcp_id;
+	unsigned int ttl_ms;
+	unsigned long long read_time_ms;
+	KernelStats stats;
+};
+
 class SysfsHelper {
 public:
 	static int get_value_as_string(std::string& file_name, std::string & value);
@@ -35,6 +105,7 @@ public:
 	const static std::string connections;
 	const static std::string separator;
 	const static std::string rmt_ports;
+	const static std::string stats;
 
 	static int get_dtp_tx_bytes(int ipcp_id,
 				    int src_cep_id,